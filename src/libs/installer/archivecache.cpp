@@ -0,0 +1,284 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivecache.h"
+
+#include "constants.h"
+#include "packagemanagercore.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QTemporaryFile>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::ArchiveCache
+    \inmodule QtInstallerFramework
+    \brief The ArchiveCache class stores downloaded archives between runs of the installer and
+        maintenance tool, keyed by their SHA-1 checksum.
+
+    Archives are only inserted after their checksum has been verified, and an entry appears in the
+    cache directory only once it is complete, so that several installer processes can share one
+    cache. Whenever the cache is larger than maximumSize(), the least recently used entries are
+    removed by evict(). Entries looked up or inserted through this instance are never evicted by
+    it, as they might still be in use.
+*/
+
+static const qint64 scDefaultMaximumSize = Q_INT64_C(1024) * 1024 * 1024;
+
+/*!
+    Creates a disabled cache.
+*/
+ArchiveCache::ArchiveCache()
+    : m_maximumSize(0)
+{
+}
+
+/*!
+    Creates a cache storing its entries in \a path. If the entries take up more than
+    \a maximumSize bytes, the least recently used ones are removed. The value \c 0 disables the
+    size limit.
+*/
+ArchiveCache::ArchiveCache(const QString &path, qint64 maximumSize)
+    : m_path(path)
+    , m_maximumSize(qMax<qint64>(0, maximumSize))
+{
+}
+
+/*!
+    Returns the archive cache configured for \a core by the \c LocalCachePath and
+    \c LocalCacheSizeLimit values. The cache is disabled if no local cache path is set.
+*/
+ArchiveCache ArchiveCache::fromCore(PackageManagerCore *core)
+{
+    const QString cachePath = core->value(scLocalCachePath);
+    if (cachePath.isEmpty())
+        return ArchiveCache();
+
+    bool ok = false;
+    qint64 maximumSize = core->value(scLocalCacheSizeLimit).toLongLong(&ok);
+    if (!ok)
+        maximumSize = scDefaultMaximumSize;
+    return ArchiveCache(QDir(cachePath).filePath(QLatin1String("archives")), maximumSize);
+}
+
+/*!
+    Returns \c true if the cache has a directory to store its entries in.
+*/
+bool ArchiveCache::isEnabled() const
+{
+    return !m_path.isEmpty();
+}
+
+/*!
+    Returns the directory of the cache entries.
+*/
+QString ArchiveCache::path() const
+{
+    return m_path;
+}
+
+/*!
+    Returns the maximum number of bytes taken up by the cache entries, or \c 0 if there is no limit.
+*/
+qint64 ArchiveCache::maximumSize() const
+{
+    return m_maximumSize;
+}
+
+/*!
+    Returns \c true if the archive with the checksum \a sha1 is in the cache. Unlike lookup(),
+    this does not mark the entry as recently used.
+*/
+bool ArchiveCache::contains(const QByteArray &sha1) const
+{
+    const QByteArray key = normalizedKey(sha1);
+    return isEnabled() && !key.isEmpty() && QFileInfo(entryPath(key)).isFile();
+}
+
+/*!
+    Returns the file name of the archive with the checksum \a sha1, or an empty string if it is not
+    in the cache. The entry is marked as recently used.
+*/
+QString ArchiveCache::lookup(const QByteArray &sha1) const
+{
+    const QByteArray key = normalizedKey(sha1);
+    if (!isEnabled() || key.isEmpty())
+        return QString();
+
+    const QString fileName = entryPath(key);
+    if (!QFileInfo(fileName).isFile())
+        return QString();
+
+    m_usedKeys.insert(key);
+    touch(fileName);
+    return fileName;
+}
+
+/*!
+    Inserts the file \a fileName with the checksum \a sha1 into the cache and returns the file name
+    of the cache entry, or an empty string if the file could not be inserted. The file is moved into
+    the cache if possible, so the caller must use the returned file name afterwards.
+*/
+QString ArchiveCache::insert(const QByteArray &sha1, const QString &fileName)
+{
+    const QByteArray key = normalizedKey(sha1);
+    if (!isEnabled() || key.isEmpty() || !QDir().mkpath(m_path))
+        return QString();
+
+    const QString target = entryPath(key);
+    m_usedKeys.insert(key);
+    if (QFileInfo(target).isFile()) {
+        touch(target);
+        return target;
+    }
+
+    // Move the file next to the entry first, which copies it if it is on another file system, and
+    // then rename it. The last step is atomic and fails if another process inserted the same
+    // archive meanwhile.
+    QString temporaryName;
+    {
+        QTemporaryFile temporary(target + QLatin1String(".XXXXXX"));
+        if (temporary.open())
+            temporaryName = temporary.fileName();
+    }
+    if (temporaryName.isEmpty() || !QFile::rename(fileName, temporaryName)) {
+        qWarning() << "Cannot insert" << fileName << "into the archive cache" << m_path;
+        m_usedKeys.remove(key);
+        return QString();
+    }
+
+    if (QFile::rename(temporaryName, target))
+        return target;
+
+    if (QFileInfo(target).isFile()) {
+        QFile::remove(temporaryName);
+        return target;
+    }
+
+    qWarning() << "Cannot insert" << fileName << "into the archive cache" << m_path;
+    QFile::rename(temporaryName, fileName);
+    m_usedKeys.remove(key);
+    return QString();
+}
+
+/*!
+    Inserts the archive \a data with the checksum \a sha1 into the cache and returns the file name
+    of the cache entry, or an empty string if the data could not be written.
+*/
+QString ArchiveCache::insert(const QByteArray &sha1, const QByteArray &data)
+{
+    const QByteArray key = normalizedKey(sha1);
+    if (!isEnabled() || key.isEmpty() || !QDir().mkpath(m_path))
+        return QString();
+
+    const QString target = entryPath(key);
+    m_usedKeys.insert(key);
+    if (QFileInfo(target).isFile()) {
+        touch(target);
+        return target;
+    }
+
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Cannot insert" << target << "into the archive cache:" << file.errorString();
+        m_usedKeys.remove(key);
+        return QString();
+    }
+    return target;
+}
+
+/*!
+    Removes the least recently used entries until the cache entries take up no more than
+    maximumSize() bytes. Entries used through this instance are kept.
+*/
+void ArchiveCache::evict()
+{
+    if (!isEnabled() || m_maximumSize == 0)
+        return;
+
+    // oldest first, skipping the partial inserts of other processes
+    QFileInfoList entries;
+    qint64 size = 0;
+    foreach (const QFileInfo &entry, QDir(m_path).entryInfoList(QDir::Files, QDir::Time
+            | QDir::Reversed)) {
+        if (normalizedKey(entry.fileName().toLatin1()).isEmpty())
+            continue;
+        entries.append(entry);
+        size += entry.size();
+    }
+
+    foreach (const QFileInfo &entry, entries) {
+        if (size <= m_maximumSize)
+            break;
+        if (m_usedKeys.contains(entry.fileName().toLatin1()))
+            continue;
+        if (QFile::remove(entry.filePath()))
+            size -= entry.size();
+    }
+}
+
+/*!
+    Returns \a sha1 as lower case hexadecimal key, or an empty byte array if it is not a valid
+    SHA-1 checksum.
+*/
+QByteArray ArchiveCache::normalizedKey(const QByteArray &sha1)
+{
+    const QByteArray key = sha1.trimmed().toLower();
+    if (key.size() != 40)
+        return QByteArray();
+    foreach (const char c, key) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+            return QByteArray();
+    }
+    return key;
+}
+
+QString ArchiveCache::entryPath(const QByteArray &key) const
+{
+    return m_path + QLatin1Char('/') + QString::fromLatin1(key);
+}
+
+void ArchiveCache::touch(const QString &fileName) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,10,0)
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadWrite | QIODevice::Append))
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+#else
+    // without a way to update the modification time, entries are evicted in insertion order
+    Q_UNUSED(fileName)
+#endif
+}
+
+} // namespace QInstaller
@@ -0,0 +1,73 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef ARCHIVECACHE_H
+#define ARCHIVECACHE_H
+
+#include "installer_global.h"
+
+#include <QtCore/QSet>
+#include <QtCore/QString>
+
+namespace QInstaller {
+
+class PackageManagerCore;
+
+class INSTALLER_EXPORT ArchiveCache
+{
+public:
+    ArchiveCache();
+    explicit ArchiveCache(const QString &path, qint64 maximumSize = 0);
+
+    static ArchiveCache fromCore(PackageManagerCore *core);
+
+    bool isEnabled() const;
+    QString path() const;
+    qint64 maximumSize() const;
+
+    bool contains(const QByteArray &sha1) const;
+    QString lookup(const QByteArray &sha1) const;
+    QString insert(const QByteArray &sha1, const QString &fileName);
+    QString insert(const QByteArray &sha1, const QByteArray &data);
+    void evict();
+
+    static QByteArray normalizedKey(const QByteArray &sha1);
+
+private:
+    QString entryPath(const QByteArray &key) const;
+    void touch(const QString &fileName) const;
+
+private:
+    QString m_path;
+    qint64 m_maximumSize;
+    mutable QSet<QByteArray> m_usedKeys;
+};
+
+} // namespace QInstaller
+
+#endif // ARCHIVECACHE_H
@@ -0,0 +1,361 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivedelta.h"
+
+#include "errors.h"
+#include "fileio.h"
+#include "fileutils.h"
+#include "lib7z_create.h"
+#include "lib7z_extract.h"
+#include "utils.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::ArchiveDelta
+    \inmodule QtInstallerFramework
+    \brief The ArchiveDelta class describes the delta of a downloadable archive against the same
+        archive of a previous version of the component.
+
+    A delta archive is a 7z archive containing only the files that were added or changed since
+    the base version, together with a manifest listing every file of the new archive and its
+    SHA-1 checksum. The new archive is reconstructed by reconstruct() from the delta and the
+    files of the base version that are still installed. Each reconstructed file is verified
+    against the manifest, so that a locally modified installation is never mixed into the
+    new archive.
+
+    Deltas are advertised in the \c DeltaArchives element of \c Updates.xml as a comma separated
+    list of \c {archive:baseVersion:sha1} entries, as returned by toString().
+*/
+
+static const QLatin1String scManifestName(".installerfw-delta");
+
+// Returns the absolute paths of the entries directly inside directory, so that an archive
+// created from them contains the content of directory without the directory itself.
+static QStringList topLevelEntries(const QString &directory)
+{
+    QStringList entries;
+    const QDir dir(directory);
+    foreach (const QString &entry, dir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot
+        | QDir::Hidden | QDir::System)) {
+            entries.append(dir.absoluteFilePath(entry));
+    }
+    return entries;
+}
+
+// Returns false if path is absolute or points outside of the directory it is relative to.
+static bool isRelativeInside(const QString &path)
+{
+    const QString cleanPath = QDir::cleanPath(path);
+    return !cleanPath.isEmpty() && !QDir::isAbsolutePath(cleanPath)
+        && cleanPath != QLatin1String("..") && !cleanPath.startsWith(QLatin1String("../"));
+}
+
+static void extractTo(const QString &archive, const QString &directory)
+{
+    QFile file(archive);
+    openForRead(&file);
+    Lib7z::extractArchive(&file, directory);
+}
+
+static void checkTemporaryDirectory(const QTemporaryDir &directory)
+{
+    if (!directory.isValid())
+        throw Error(ArchiveDelta::tr("Cannot create temporary directory."));
+}
+
+/*!
+    Creates a delta of the archive \a archive against its base version \a baseVersion. \a sha1
+    is the checksum of the delta archive itself.
+*/
+ArchiveDelta::ArchiveDelta(const QString &archive, const QString &baseVersion, const QByteArray &sha1)
+    : m_archive(archive)
+    , m_baseVersion(baseVersion)
+    , m_sha1(sha1)
+{
+}
+
+/*!
+    Returns \c true if the archive name, the base version and the checksum of the delta are set.
+*/
+bool ArchiveDelta::isValid() const
+{
+    return !m_archive.isEmpty() && !m_baseVersion.isEmpty() && !m_sha1.isEmpty();
+}
+
+/*!
+    Returns the name of the archive without the version prefix, as listed in the
+    \c DownloadableArchives element.
+*/
+QString ArchiveDelta::archive() const
+{
+    return m_archive;
+}
+
+/*!
+    Returns the version of the component the delta applies to.
+*/
+QString ArchiveDelta::baseVersion() const
+{
+    return m_baseVersion;
+}
+
+/*!
+    Returns the hex encoded SHA-1 checksum of the delta archive.
+*/
+QByteArray ArchiveDelta::sha1() const
+{
+    return m_sha1;
+}
+
+/*!
+    Returns the directory the base version of the archive was extracted to, or an empty string
+    if it is not known.
+*/
+QString ArchiveDelta::baseDirectory() const
+{
+    return m_baseDirectory;
+}
+
+/*!
+    Sets the \a directory the base version of the archive was extracted to.
+*/
+void ArchiveDelta::setBaseDirectory(const QString &directory)
+{
+    m_baseDirectory = directory;
+}
+
+/*!
+    Returns the suffix appended to the file name of the full archive to get the file name of
+    the delta archive in the repository.
+*/
+QString ArchiveDelta::suffix() const
+{
+    return QLatin1String(".delta-") + m_baseVersion;
+}
+
+/*!
+    Returns the delta as an entry of the \c DeltaArchives element.
+*/
+QString ArchiveDelta::toString() const
+{
+    return QStringList({ m_archive, m_baseVersion, QString::fromLatin1(m_sha1) })
+        .join(QLatin1Char(':'));
+}
+
+/*!
+    Returns the deltas listed in \a value, the content of a \c DeltaArchives element. Malformed
+    entries are skipped.
+*/
+QList<ArchiveDelta> ArchiveDelta::fromString(const QString &value)
+{
+    QList<ArchiveDelta> deltas;
+    foreach (const QString &entry, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        const QStringList parts = entry.trimmed().split(QLatin1Char(':'));
+        const ArchiveDelta delta = parts.count() == 3
+            ? ArchiveDelta(parts.at(0), parts.at(1), parts.at(2).toLatin1().toLower())
+            : ArchiveDelta();
+        if (delta.isValid())
+            deltas.append(delta);
+        else
+            qDebug().noquote() << "Ignoring malformed delta archive entry" << entry;
+    }
+    return deltas;
+}
+
+/*!
+    Returns the \c DeltaArchives element content listing \a deltas.
+*/
+QString ArchiveDelta::toString(const QList<ArchiveDelta> &deltas)
+{
+    QStringList entries;
+    foreach (const ArchiveDelta &delta, deltas)
+        entries.append(delta.toString());
+    return entries.join(QLatin1Char(','));
+}
+
+/*!
+    Writes the delta of \a archive against \a baseArchive to \a deltaArchive. Files and symbolic
+    links that are new or differ from the ones in \a baseArchive are stored in the delta, all
+    others are only listed in its manifest.
+
+    Throws QInstaller::Error if one of the archives cannot be read or written.
+*/
+void ArchiveDelta::create(const QString &baseArchive, const QString &archive, const QString &deltaArchive)
+{
+    QTemporaryDir baseDir;
+    QTemporaryDir newDir;
+    QTemporaryDir stageDir;
+    checkTemporaryDirectory(baseDir);
+    checkTemporaryDirectory(newDir);
+    checkTemporaryDirectory(stageDir);
+
+    const QDir base(baseDir.path());
+    const QDir current(newDir.path());
+    const QDir stage(stageDir.path());
+
+    extractTo(baseArchive, base.path());
+    extractTo(archive, current.path());
+
+    QStringList entries;
+    QDirIterator it(current.path(), QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+        | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(current.relativeFilePath(it.next()));
+    entries.sort();
+
+    QByteArray manifest;
+    foreach (const QString &entry, entries) {
+        const QFileInfo fi(current.filePath(entry));
+        if (fi.isSymLink()) {
+            manifest += "L " + entry.toUtf8() + '\n';
+        } else if (fi.isDir()) {
+            manifest += "D " + entry.toUtf8() + '\n';
+            continue;
+        } else {
+            const QByteArray sha1 = calculateHash(fi.filePath(), QCryptographicHash::Sha1).toHex();
+            if (sha1.isEmpty())
+                throw Error(tr("Cannot read \"%1\".").arg(QDir::toNativeSeparators(fi.filePath())));
+            manifest += "F " + sha1 + ' ' + entry.toUtf8() + '\n';
+
+            const QFileInfo baseFi(base.filePath(entry));
+            if (baseFi.isFile() && !baseFi.isSymLink() && baseFi.size() == fi.size()
+                && calculateHash(baseFi.filePath(), QCryptographicHash::Sha1).toHex() == sha1) {
+                    continue;   // unchanged, taken from the installation of the base version
+            }
+        }
+
+        // moving keeps symbolic links and permissions as they were extracted
+        mkpath(QFileInfo(stage.filePath(entry)).path());
+        if (!QFile::rename(fi.filePath(), stage.filePath(entry))) {
+            throw Error(tr("Cannot move \"%1\" to \"%2\".").arg(QDir::toNativeSeparators(fi.filePath()),
+                QDir::toNativeSeparators(stage.filePath(entry))));
+        }
+    }
+
+    QFile manifestFile(stage.filePath(scManifestName));
+    openForWrite(&manifestFile);
+    blockingWrite(&manifestFile, manifest);
+    manifestFile.close();
+
+    Lib7z::createArchive(deltaArchive, topLevelEntries(stage.path()), Lib7z::TmpFile::No);
+}
+
+/*!
+    Reconstructs \a archive from \a deltaArchive and the unchanged files installed to
+    \a baseDirectory. Every file of the reconstructed archive is verified against the checksum
+    listed in the manifest of the delta. The archive is stored without compression, as it is
+    only extracted once right after.
+
+    Throws QInstaller::Error if the delta cannot be read, a file is missing from the
+    installation, or a checksum does not match.
+*/
+void ArchiveDelta::reconstruct(const QString &deltaArchive, const QString &baseDirectory,
+    const QString &archive)
+{
+    QTemporaryDir stageDir;
+    checkTemporaryDirectory(stageDir);
+    const QDir stage(stageDir.path());
+    const QDir base(baseDirectory);
+
+    extractTo(deltaArchive, stage.path());
+
+    QFile manifestFile(stage.filePath(scManifestName));
+    if (!manifestFile.open(QIODevice::ReadOnly)) {
+        throw Error(tr("Cannot find the manifest in delta archive \"%1\".")
+            .arg(QDir::toNativeSeparators(deltaArchive)));
+    }
+    const QList<QByteArray> lines = manifestFile.readAll().split('\n');
+    manifestFile.close();
+    manifestFile.remove();
+
+    foreach (const QByteArray &line, lines) {
+        if (line.isEmpty())
+            continue;
+
+        QByteArray sha1;
+        QString entry;
+        const char type = line.at(0);
+        if (type == 'F') {
+            sha1 = line.mid(2, 40);
+            entry = QString::fromUtf8(line.mid(43));
+        } else {
+            entry = QString::fromUtf8(line.mid(2));
+        }
+
+        if (!isRelativeInside(entry))
+            throw Error(tr("Invalid file name \"%1\" in delta archive.").arg(entry));
+
+        const QString target = stage.filePath(entry);
+        switch (type) {
+        case 'D':
+            mkpath(target);
+            break;
+        case 'L':
+            if (!QFileInfo(target).isSymLink())
+                throw Error(tr("Cannot find symbolic link \"%1\" in delta archive.").arg(entry));
+            break;
+        case 'F': {
+            if (!QFileInfo::exists(target)) {
+                const QString source = base.filePath(entry);
+                if (!QFileInfo(source).isFile()) {
+                    throw Error(tr("Cannot find unchanged file \"%1\" in the installation.")
+                        .arg(QDir::toNativeSeparators(source)));
+                }
+                mkpath(QFileInfo(target).path());
+                QFile file(source);
+                if (!file.copy(target)) {
+                    throw Error(tr("Cannot copy file \"%1\" to \"%2\": %3").arg(
+                        QDir::toNativeSeparators(source), QDir::toNativeSeparators(target),
+                        file.errorString()));
+                }
+            }
+            if (calculateHash(target, QCryptographicHash::Sha1).toHex() != sha1) {
+                throw Error(tr("Checksum mismatch of \"%1\" while applying delta archive.")
+                    .arg(entry));
+            }
+            break;
+        }
+        default:
+            throw Error(tr("Invalid entry \"%1\" in delta archive.").arg(QString::fromUtf8(line)));
+        }
+    }
+
+    Lib7z::createArchive(archive, topLevelEntries(stage.path()), Lib7z::TmpFile::No,
+        Lib7z::Compression::Non);
+}
+
+} // namespace QInstaller
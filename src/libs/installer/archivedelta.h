@@ -0,0 +1,76 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef ARCHIVEDELTA_H
+#define ARCHIVEDELTA_H
+
+#include "installer_global.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT ArchiveDelta
+{
+    Q_DECLARE_TR_FUNCTIONS(QInstaller::ArchiveDelta)
+
+public:
+    ArchiveDelta() = default;
+    ArchiveDelta(const QString &archive, const QString &baseVersion, const QByteArray &sha1);
+
+    bool isValid() const;
+    QString archive() const;
+    QString baseVersion() const;
+    QByteArray sha1() const;
+
+    QString baseDirectory() const;
+    void setBaseDirectory(const QString &directory);
+
+    QString suffix() const;
+    QString toString() const;
+
+    static QList<ArchiveDelta> fromString(const QString &value);
+    static QString toString(const QList<ArchiveDelta> &deltas);
+
+    static void create(const QString &baseArchive, const QString &archive, const QString &deltaArchive);
+    static void reconstruct(const QString &deltaArchive, const QString &baseDirectory,
+        const QString &archive);
+
+private:
+    QString m_archive;
+    QString m_baseVersion;
+    QByteArray m_sha1;
+    QString m_baseDirectory;
+};
+
+} // namespace QInstaller
+
+#endif // ARCHIVEDELTA_H
@@ -0,0 +1,325 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivefilelist.h"
+
+#include "constants.h"
+#include "fileutils.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QtEndian>
+
+namespace {
+
+const quint32 FileListMagic = 0x49464c31; // "IFL1"
+const int HeaderSize = 2 * sizeof(quint32);
+const int FlushSize = 64 * 1024;
+
+void appendVarInt(QByteArray *data, quint32 value)
+{
+    while (value >= 0x80) {
+        data->append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data->append(char(value));
+}
+
+bool readVarInt(const uchar **data, const uchar *end, quint32 *value)
+{
+    *value = 0;
+    for (int shift = 0; *data < end && shift < 35; shift += 7) {
+        const uchar byte = *(*data)++;
+        *value |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::ArchiveFileListWriter
+    \inmodule QtInstallerFramework
+    \brief The ArchiveFileListWriter class writes the list of files extracted from an archive.
+
+    The paths are appended one by one while the archive is extracted and written to disk in
+    blocks, so the memory used does not grow with the size of the archive. Paths inside the
+    target directory are stored relative to it, which keeps the installation relocatable. Each
+    path only stores the part that differs from the previous path, and paths extracted one after
+    the other mostly share their directory.
+
+    The file starts with a magic number and the number of paths, followed by one record per path:
+    the length of the prefix shared with the previous path, the length of the remaining part, and
+    the remaining part, all UTF-8 encoded. Lengths are stored as variable-length integers.
+*/
+
+/*!
+    Creates a writer that stores paths relative to \a targetDir.
+*/
+ArchiveFileListWriter::ArchiveFileListWriter(const QString &targetDir)
+    : m_targetDir(QDir::cleanPath(targetDir))
+    , m_count(0)
+    , m_failed(false)
+{
+}
+
+/*!
+    Destroys the writer and closes the file.
+*/
+ArchiveFileListWriter::~ArchiveFileListWriter()
+{
+    if (m_file.isOpen())
+        close();
+}
+
+/*!
+    Creates the file \a fileName and writes the header. Returns \c true on success.
+*/
+bool ArchiveFileListWriter::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly))
+        return false;
+
+    m_count = 0;
+    m_failed = false;
+    m_previous.clear();
+    m_buffer.resize(HeaderSize);
+    qToLittleEndian<quint32>(FileListMagic, reinterpret_cast<uchar *>(m_buffer.data()));
+    qToLittleEndian<quint32>(0, reinterpret_cast<uchar *>(m_buffer.data()) + sizeof(quint32));
+    return true;
+}
+
+/*!
+    Returns \c true if the file is open for writing.
+*/
+bool ArchiveFileListWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+/*!
+    Appends \a path to the list. Does nothing if the file is not open.
+*/
+void ArchiveFileListWriter::append(const QString &path)
+{
+    if (!m_file.isOpen())
+        return;
+
+    QString cleanPath = QDir::cleanPath(path);
+    if (!m_targetDir.isEmpty() && cleanPath.startsWith(m_targetDir + QLatin1Char('/')))
+        cleanPath = cleanPath.mid(m_targetDir.size() + 1);
+
+    const QByteArray current = cleanPath.toUtf8();
+    const int length = qMin(current.size(), m_previous.size());
+    int prefix = 0;
+    while (prefix < length && current.at(prefix) == m_previous.at(prefix))
+        ++prefix;
+
+    appendVarInt(&m_buffer, quint32(prefix));
+    appendVarInt(&m_buffer, quint32(current.size() - prefix));
+    m_buffer.append(current.constData() + prefix, current.size() - prefix);
+    m_previous = current;
+    ++m_count;
+
+    if (m_buffer.size() >= FlushSize)
+        flush();
+}
+
+/*!
+    Writes the remaining paths and the number of paths, and closes the file. Returns \c true if
+    all paths were written.
+*/
+bool ArchiveFileListWriter::close()
+{
+    if (!m_file.isOpen())
+        return false;
+
+    flush();
+    uchar count[sizeof(quint32)];
+    qToLittleEndian<quint32>(m_count, count);
+    if (!m_file.seek(sizeof(quint32))
+            || m_file.write(reinterpret_cast<const char *>(count), sizeof(count)) != sizeof(count)) {
+        m_failed = true;
+    }
+    m_file.close();
+    m_previous.clear();
+    return !m_failed;
+}
+
+/*!
+    Returns the number of paths appended.
+*/
+quint32 ArchiveFileListWriter::count() const
+{
+    return m_count;
+}
+
+/*!
+    Returns the name of the file written.
+*/
+QString ArchiveFileListWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+/*!
+    Returns a description of the last error that occurred.
+*/
+QString ArchiveFileListWriter::errorString() const
+{
+    return m_file.errorString();
+}
+
+bool ArchiveFileListWriter::flush()
+{
+    if (m_file.write(m_buffer) != m_buffer.size())
+        m_failed = true;
+    m_buffer.clear();
+    return !m_failed;
+}
+
+/*!
+    \class QInstaller::ArchiveFileListReader
+    \inmodule QtInstallerFramework
+    \brief The ArchiveFileListReader class reads the list of files extracted from an archive.
+
+    The file written by ArchiveFileListWriter is mapped into memory if possible and decoded one
+    path at a time. Lists written by earlier versions of the installer as a serialized string
+    list are read as a whole.
+*/
+
+/*!
+    Creates a reader that resolves relative paths against \a targetDir.
+*/
+ArchiveFileListReader::ArchiveFileListReader(const QString &targetDir)
+    : m_targetDir(QDir::cleanPath(targetDir))
+    , m_data(nullptr)
+    , m_end(nullptr)
+    , m_legacyIndex(-1)
+    , m_count(0)
+{
+}
+
+/*!
+    Destroys the reader and closes the file.
+*/
+ArchiveFileListReader::~ArchiveFileListReader()
+{
+    m_file.close();
+}
+
+/*!
+    Opens the file \a fileName and reads the header. Returns \c true on success.
+*/
+bool ArchiveFileListReader::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        m_contents = m_file.readAll();
+        m_data = reinterpret_cast<const uchar *>(m_contents.constData());
+    }
+    m_end = m_data + size;
+
+    if (size < HeaderSize || qFromLittleEndian<quint32>(m_data) != FileListMagic)
+        return readLegacyList();
+
+    m_count = qFromLittleEndian<quint32>(m_data + sizeof(quint32));
+    m_data += HeaderSize;
+    return true;
+}
+
+/*!
+    Returns the number of paths in the list.
+*/
+quint32 ArchiveFileListReader::count() const
+{
+    return m_count;
+}
+
+/*!
+    Reads the next path into \a path. Returns \c false if there are no more paths or the list is
+    corrupt.
+*/
+bool ArchiveFileListReader::next(QString *path)
+{
+    if (m_legacyIndex >= 0) {
+        if (m_legacyIndex >= m_legacyList.count())
+            return false;
+        *path = m_legacyList.at(m_legacyIndex++);
+        return true;
+    }
+
+    quint32 prefix = 0;
+    quint32 length = 0;
+    if (!readVarInt(&m_data, m_end, &prefix) || !readVarInt(&m_data, m_end, &length))
+        return false;
+    if (prefix > quint32(m_previous.size()) || length > quint32(m_end - m_data))
+        return false;
+
+    m_previous.truncate(int(prefix));
+    m_previous.append(reinterpret_cast<const char *>(m_data), int(length));
+    m_data += length;
+
+    const QString current = QString::fromUtf8(m_previous);
+    *path = QDir::isRelativePath(current) ? m_targetDir + QLatin1Char('/') + current : current;
+    return true;
+}
+
+/*!
+    Returns a description of the last error that occurred.
+*/
+QString ArchiveFileListReader::errorString() const
+{
+    return m_file.errorString();
+}
+
+bool ArchiveFileListReader::readLegacyList()
+{
+    m_file.seek(0);
+    QDataStream in(&m_file);
+    in >> m_legacyList;
+    for (int i = 0; i < m_legacyList.count(); ++i) {
+        m_legacyList.replace(i, replacePath(m_legacyList.at(i), QLatin1String(scRelocatable),
+            m_targetDir));
+    }
+    m_legacyIndex = 0;
+    m_count = quint32(m_legacyList.count());
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,98 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef ARCHIVEFILELIST_H
+#define ARCHIVEFILELIST_H
+
+#include "installer_global.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT ArchiveFileListWriter
+{
+    Q_DISABLE_COPY(ArchiveFileListWriter)
+
+public:
+    explicit ArchiveFileListWriter(const QString &targetDir);
+    ~ArchiveFileListWriter();
+
+    bool open(const QString &fileName);
+    bool isOpen() const;
+    void append(const QString &path);
+    bool close();
+
+    quint32 count() const;
+    QString fileName() const;
+    QString errorString() const;
+
+private:
+    bool flush();
+
+private:
+    QFile m_file;
+    QString m_targetDir;
+    QByteArray m_buffer;
+    QByteArray m_previous;
+    quint32 m_count;
+    bool m_failed;
+};
+
+class INSTALLER_EXPORT ArchiveFileListReader
+{
+    Q_DISABLE_COPY(ArchiveFileListReader)
+
+public:
+    explicit ArchiveFileListReader(const QString &targetDir);
+    ~ArchiveFileListReader();
+
+    bool open(const QString &fileName);
+    quint32 count() const;
+    bool next(QString *path);
+    QString errorString() const;
+
+private:
+    bool readLegacyList();
+
+private:
+    QFile m_file;
+    QString m_targetDir;
+    const uchar *m_data;
+    const uchar *m_end;
+    QByteArray m_contents;
+    QByteArray m_previous;
+    QStringList m_legacyList;
+    int m_legacyIndex;
+    quint32 m_count;
+};
+
+} // namespace QInstaller
+
+#endif // ARCHIVEFILELIST_H
@@ -33,8 +33,66 @@
 #include "fileio.h"
 #include "fileutils.h"
 
+#include <QDataStream>
+#include <QHash>
+
+#include <algorithm>
+
 namespace QInstaller {
 
+namespace {
+
+enum struct LoggedOperation : quint8
+{
+    Binary,
+    Xml
+};
+
+enum struct LoggedValue : quint8
+{
+    String,
+    StringList,
+    Variant
+};
+
+class StringTable
+{
+public:
+    quint32 insert(const QString &string)
+    {
+        const QHash<QString, quint32>::const_iterator it = m_index.constFind(string);
+        if (it != m_index.constEnd())
+            return it.value();
+
+        const quint32 index = m_strings.count();
+        m_strings.append(string);
+        m_index.insert(string, index);
+        return index;
+    }
+
+    QStringList strings() const
+    {
+        return m_strings;
+    }
+
+private:
+    QStringList m_strings;
+    QHash<QString, quint32> m_index;
+};
+
+QString readString(QDataStream &stream, const QStringList &strings)
+{
+    quint32 index;
+    stream >> index;
+    if (index >= quint32(strings.count())) {
+        throw Error(QCoreApplication::translate("BinaryContent",
+            "Invalid string index %1 in the operation log.").arg(index));
+    }
+    return strings.at(index);
+}
+
+} // namespace
+
 /*!
     \class QInstaller::BinaryContent
     \inmodule QtInstallerFramework
@@ -201,16 +259,7 @@ void BinaryContent::readBinaryContent(QFile *file, QList<OperationBlob> *operati
             throw Error(QCoreApplication::translate("BinaryContent",
                 "Cannot seek to %1 to read the operation data.").arg(posOfOperationsBlock));
         }
-        // read the operations count
-        qint64 operationsCount = QInstaller::retrieveInt64(file);
-        // read the operations
-        for (int i = 0; i < operationsCount; ++i) {
-            const QString name = QInstaller::retrieveString(file);
-            const QString xml = QInstaller::retrieveString(file);
-            operations->append(OperationBlob(name, xml));
-        }
-        // operations count
-        Q_UNUSED(QInstaller::retrieveInt64(file)) // read it, but deliberately not used
+        BinaryContent::readOperations(file, operations);
     }
 
     if (manager) {    // read the collection index and data
@@ -269,12 +318,7 @@ void BinaryContent::writeBinaryContent(QFile *out, const QList<OperationBlob> &o
     localManager.removeCollection("QResources");
 
     // operations
-    QInstaller::appendInt64(out, operations.count());
-    foreach (const OperationBlob &operation, operations) {
-        QInstaller::appendString(out, operation.name);
-        QInstaller::appendString(out, operation.xml);
-    }
-    QInstaller::appendInt64(out, operations.count());
+    BinaryContent::writeOperations(out, operations);
     const Range<qint64> operationsSegment = Range<qint64>::fromStartAndEnd(pos, out->pos());
 
     // resource collections data and index
@@ -297,4 +341,172 @@ void BinaryContent::writeBinaryContent(QFile *out, const QList<OperationBlob> &o
     QInstaller::appendInt64(out, magicCookie);
 }
 
+/*!
+    Reads the performed operations from \a in and appends them to \a operations. Both the binary
+    operation log and the operations saved as XML by older versions are read. Throws Error on
+    failure.
+
+    The binary operation log starts with OperationLogMarker in place of the operations count,
+    followed by the format version and the log itself. All strings of the log, such as operation
+    names, arguments, value names, and string values, are stored once in a table in front of the
+    operations and referenced by index.
+*/
+void BinaryContent::readOperations(QFileDevice *in, QList<OperationBlob> *operations)
+{
+    const qint64 operationsCount = QInstaller::retrieveInt64(in);
+    if (operationsCount != OperationLogMarker) {
+        // operations saved as XML
+        for (qint64 i = 0; i < operationsCount; ++i) {
+            const QString name = QInstaller::retrieveString(in);
+            const QString xml = QInstaller::retrieveString(in);
+            operations->append(OperationBlob(name, xml));
+        }
+        Q_UNUSED(QInstaller::retrieveInt64(in)) // read it, but deliberately not used
+        return;
+    }
+
+    const qint64 version = QInstaller::retrieveInt64(in);
+    if (version != OperationLogVersion) {
+        throw Error(QCoreApplication::translate("BinaryContent",
+            "Unsupported operation log version %1.").arg(version));
+    }
+
+    const QByteArray log = QInstaller::retrieveByteArray(in);
+    QDataStream stream(log);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 count;
+    stream >> count;
+    QStringList strings;
+    strings.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString string;
+        stream >> string;
+        strings.append(string);
+    }
+
+    stream >> count;
+    operations->reserve(operations->count() + count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        const QString name = readString(stream, strings);
+
+        quint8 type;
+        stream >> type;
+        if (LoggedOperation(type) == LoggedOperation::Xml) {
+            QString xml;
+            stream >> xml;
+            operations->append(OperationBlob(name, xml));
+            continue;
+        }
+
+        quint32 argumentsCount;
+        stream >> argumentsCount;
+        QStringList arguments;
+        for (quint32 j = 0; j < argumentsCount && stream.status() == QDataStream::Ok; ++j)
+            arguments.append(readString(stream, strings));
+
+        quint32 valuesCount;
+        stream >> valuesCount;
+        QVariantMap values;
+        for (quint32 j = 0; j < valuesCount && stream.status() == QDataStream::Ok; ++j) {
+            const QString key = readString(stream, strings);
+            stream >> type;
+            switch (LoggedValue(type)) {
+            case LoggedValue::String:
+                values.insert(key, readString(stream, strings));
+                break;
+            case LoggedValue::StringList: {
+                quint32 listCount;
+                stream >> listCount;
+                QStringList list;
+                for (quint32 k = 0; k < listCount && stream.status() == QDataStream::Ok; ++k)
+                    list.append(readString(stream, strings));
+                values.insert(key, list);
+            }   break;
+            default: {
+                QVariant value;
+                stream >> value;
+                values.insert(key, value);
+            }   break;
+            }
+        }
+        operations->append(OperationBlob(name, arguments, values));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        throw Error(QCoreApplication::translate("BinaryContent",
+            "Cannot read the operation log."));
+    }
+    Q_UNUSED(QInstaller::retrieveInt64(in)) // read it, but deliberately not used
+}
+
+/*!
+    Writes \a operations to \a out. If all operations are held as XML, they are written in the
+    format read by older versions. Otherwise, the binary operation log is written. Throws Error on
+    failure.
+
+    \sa readOperations()
+*/
+void BinaryContent::writeOperations(QFileDevice *out, const QList<OperationBlob> &operations)
+{
+    const bool xmlOnly = std::all_of(operations.constBegin(), operations.constEnd(),
+        [](const OperationBlob &operation) { return operation.isXml(); });
+    if (xmlOnly) {
+        QInstaller::appendInt64(out, operations.count());
+        foreach (const OperationBlob &operation, operations) {
+            QInstaller::appendString(out, operation.name);
+            QInstaller::appendString(out, operation.xml);
+        }
+        QInstaller::appendInt64(out, operations.count());
+        return;
+    }
+
+    StringTable strings;
+    QByteArray records;
+    QDataStream stream(&records, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    foreach (const OperationBlob &operation, operations) {
+        stream << strings.insert(operation.name);
+        if (operation.isXml()) {
+            stream << quint8(LoggedOperation::Xml) << operation.xml;
+            continue;
+        }
+
+        stream << quint8(LoggedOperation::Binary) << quint32(operation.arguments.count());
+        foreach (const QString &argument, operation.arguments)
+            stream << strings.insert(argument);
+
+        stream << quint32(operation.values.count());
+        for (QVariantMap::const_iterator it = operation.values.constBegin();
+                it != operation.values.constEnd(); ++it) {
+            stream << strings.insert(it.key());
+            if (it.value().type() == QVariant::String) {
+                stream << quint8(LoggedValue::String) << strings.insert(it.value().toString());
+            } else if (it.value().type() == QVariant::StringList) {
+                const QStringList list = it.value().toStringList();
+                stream << quint8(LoggedValue::StringList) << quint32(list.count());
+                foreach (const QString &string, list)
+                    stream << strings.insert(string);
+            } else {
+                stream << quint8(LoggedValue::Variant) << it.value();
+            }
+        }
+    }
+
+    QByteArray log;
+    QDataStream header(&log, QIODevice::WriteOnly);
+    header.setVersion(QDataStream::Qt_5_0);
+    const QStringList table = strings.strings();
+    header << quint32(table.count());
+    foreach (const QString &string, table)
+        header << string;
+    header << quint32(operations.count());
+    log.append(records);
+
+    QInstaller::appendInt64(out, OperationLogMarker);
+    QInstaller::appendInt64(out, OperationLogVersion);
+    QInstaller::appendByteArray(out, log);
+    QInstaller::appendInt64(out, operations.count());
+}
+
 } // namespace QInstaller
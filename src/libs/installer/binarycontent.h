@@ -34,6 +34,7 @@
 
 QT_BEGIN_NAMESPACE
 class QFile;
+class QFileDevice;
 QT_END_NAMESPACE
 
 namespace QInstaller {
@@ -52,6 +53,10 @@ public:
     static const quint64 MagicCookie = 0xc2630a1c99d668f8LL;  // binary
     static const quint64 MagicCookieDat = 0xc2630a1c99d668f9LL; // data
 
+    // written instead of the operations count in front of the binary operation log
+    static const qint64 OperationLogMarker = -1;
+    static const qint64 OperationLogVersion = 1;
+
     static qint64 findMagicCookie(QFile *file, quint64 magicCookie);
     static BinaryLayout binaryLayout(QFile *file, quint64 magicCookie);
 
@@ -66,6 +71,9 @@ public:
                                 const ResourceCollectionManager &manager,
                                 qint64 magicMarker,
                                 quint64 magicCookie);
+
+    static void readOperations(QFileDevice *in, QList<OperationBlob> *operations);
+    static void writeOperations(QFileDevice *out, const QList<OperationBlob> &operations);
 };
 
 } // namespace QInstaller
@@ -40,8 +40,11 @@ namespace QInstaller {
 /*!
     \class QInstaller::OperationBlob
     \inmodule QtInstallerFramework
-    \brief The OperationBlob class is a textual representation of an operation that can be
+    \brief The OperationBlob class is a serialized representation of an operation that can be
         instantiated and executed by the Qt Installer Framework.
+
+    An operation blob either holds the XML representation of the operation, as written by older
+    versions of the framework, or the arguments and values as stored in the binary operation log.
 */
 
 /*!
@@ -51,6 +54,20 @@ namespace QInstaller {
     \a x for the XML representation of the operation.
 */
 
+/*!
+    \fn OperationBlob::OperationBlob(const QString &n, const QStringList &a, const QVariantMap &v)
+
+    Constructs the operation blob with the name \a n, the arguments \a a, and the values \a v of
+    the operation, as returned by KDUpdater::UpdateOperation::toBinary().
+*/
+
+/*!
+    \fn OperationBlob::isXml() const
+
+    Returns \c true if the blob holds the XML representation of the operation; otherwise returns
+    \c false.
+*/
+
 /*!
     \variable QInstaller::OperationBlob::name
     \brief The name of the operation.
@@ -61,6 +78,16 @@ namespace QInstaller {
     \brief The XML representation of the operation.
 */
 
+/*!
+    \variable QInstaller::OperationBlob::arguments
+    \brief The arguments of the operation, if the blob was read from the binary operation log.
+*/
+
+/*!
+    \variable QInstaller::OperationBlob::values
+    \brief The values of the operation, if the blob was read from the binary operation log.
+*/
+
 /*!
     \class QInstaller::Resource
     \inmodule QtInstallerFramework
@@ -72,6 +99,10 @@ namespace QInstaller {
 
     The resource name can be set at any time using setName() or during construction. The segment
     supplied during construction represents the offset and size of the resource inside the file.
+
+    A resource can also wrap data that is held in memory, for example an archive that was
+    downloaded without being written to disk. If possible, the segment of a file is memory mapped
+    while the resource is open, so that reading does not need to seek the underlying file.
 */
 
 /*!
@@ -93,6 +124,8 @@ Resource::Resource(const QString &path)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_inMemory(false)
+    , m_map(nullptr)
 {
 }
 
@@ -103,6 +136,8 @@ Resource::Resource(const QString &path, const QByteArray &name)
     : m_file(path)
     , m_name(name)
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_inMemory(false)
+    , m_map(nullptr)
 {
 }
 
@@ -113,6 +148,20 @@ Resource::Resource(const QString &path, const Range<qint64> &segment)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(segment)
+    , m_inMemory(false)
+    , m_map(nullptr)
+{
+}
+
+/*!
+    Creates a resource providing the in-memory \a data identified by \a name.
+*/
+Resource::Resource(const QByteArray &name, const QByteArray &data)
+    : m_name(name)
+    , m_segment(Range<qint64>::fromStartAndLength(0, data.size()))
+    , m_data(data)
+    , m_inMemory(true)
+    , m_map(nullptr)
 {
 }
 
@@ -158,9 +207,14 @@ bool Resource::open()
     if (isOpen())
         return false;
 
-    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
-        setErrorString(m_file.errorString());
-        return false;
+    if (!m_inMemory) {
+        if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+            setErrorString(m_file.errorString());
+            return false;
+        }
+        // falls back to seeking and reading the file if mapping is not possible
+        if (m_segment.length() > 0)
+            m_map = m_file.map(m_segment.start(), m_segment.length(), QFileDevice::NoOptions);
     }
 
     if (!QIODevice::open(QIODevice::ReadOnly)) {
@@ -174,7 +228,12 @@ bool Resource::open()
  */
 void Resource::close()
 {
-    m_file.close();
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (!m_inMemory)
+        m_file.close();
     QIODevice::close();
 }
 
@@ -196,6 +255,16 @@ qint64 Resource::readData(char* data, qint64 maxSize)
     if (maxSize <= 0)
         return 0;
 
+    if (m_inMemory) {
+        memcpy(data, m_data.constData() + pos(), maxSize);
+        return maxSize;
+    }
+
+    if (m_map) {
+        memcpy(data, m_map + pos(), maxSize);
+        return maxSize;
+    }
+
     const qint64 p = m_file.pos();
     m_file.seek(m_segment.start() + pos());
     const qint64 amountRead = m_file.read(data, maxSize);
@@ -36,14 +36,21 @@
 #include <QtCore/private/qfsfileengine_p.h>
 #include <QList>
 #include <QSharedPointer>
+#include <QStringList>
+#include <QVariantMap>
 
 namespace QInstaller {
 
 struct OperationBlob {
     OperationBlob(const QString &n, const QString &x)
         : name(n), xml(x) {}
+    OperationBlob(const QString &n, const QStringList &a, const QVariantMap &v)
+        : name(n), arguments(a), values(v) {}
+    bool isXml() const { return !xml.isNull(); }
     QString name;
     QString xml;
+    QStringList arguments;
+    QVariantMap values;
 };
 
 
@@ -56,6 +63,7 @@ public:
     explicit Resource(const QString &path);
     Resource(const QString &path, const QByteArray &name);
     Resource(const QString &path, const Range<qint64> &segment);
+    Resource(const QByteArray &name, const QByteArray &data);
     ~Resource();
 
     bool open();
@@ -84,6 +92,9 @@ private:
     QFSFileEngine m_file;
     QByteArray m_name;
     Range<qint64> m_segment;
+    QByteArray m_data;
+    bool m_inMemory;
+    uchar *m_map;
 };
 
 
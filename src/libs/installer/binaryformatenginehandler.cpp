@@ -47,8 +47,11 @@ namespace QInstaller {
 */
 QAbstractFileEngine *BinaryFormatEngineHandler::create(const QString &fileName) const
 {
-    return fileName.startsWith(QLatin1String("installer://"), Qt::CaseInsensitive )
-        ? new BinaryFormatEngine(m_resources, fileName) : nullptr;
+    if (!fileName.startsWith(QLatin1String("installer://"), Qt::CaseInsensitive))
+        return nullptr;
+
+    QMutexLocker _(&m_mutex);
+    return new BinaryFormatEngine(m_resources, fileName);
 }
 
 /*!
@@ -56,6 +59,7 @@ QAbstractFileEngine *BinaryFormatEngineHandler::create(const QString &fileName)
 */
 void BinaryFormatEngineHandler::clear()
 {
+    QMutexLocker _(&m_mutex);
     m_resources.clear();
 }
 
@@ -73,6 +77,7 @@ BinaryFormatEngineHandler *BinaryFormatEngineHandler::instance()
 */
 void BinaryFormatEngineHandler::registerResources(const QList<ResourceCollection> &collections)
 {
+    QMutexLocker _(&m_mutex);
     foreach (const ResourceCollection &collection, collections) {
         if (ProductKeyCheck::instance()->isValidPackage(QString::fromUtf8(collection.name())))
             m_resources.insert(collection.name(), collection);
@@ -104,9 +109,39 @@ BinaryFormatEngineHandler::registerResource(const QString &fileName, const QStri
     if (!ProductKeyCheck::instance()->isValidPackage(QString::fromUtf8(collectionName)))
         return;
 
+    QMutexLocker _(&m_mutex);
     m_resources[collectionName].setName(collectionName);
     m_resources[collectionName].appendResource(QSharedPointer<Resource>(new Resource(resourcePath,
         resourceName)));
 }
 
+/*!
+    \overload
+
+    Registers the in-memory \a data as resource in a resource collection specified by \a fileName.
+    This is used for archives that were downloaded without being written to disk.
+*/
+void BinaryFormatEngineHandler::registerResource(const QString &fileName, const QByteArray &data)
+{
+    static const QChar sep = QChar::fromLatin1('/');
+    static const QString prefix = QString::fromLatin1("installer://");
+    Q_ASSERT(fileName.toLower().startsWith(prefix));
+
+    // cut the prefix
+    QString path = fileName.mid(prefix.length());
+    while (path.endsWith(sep))
+        path.chop(1);
+
+    const QByteArray resourceName = path.section(sep, 1, 1).toUtf8();
+    const QByteArray collectionName = path.section(sep, 0, 0).toUtf8();
+
+    if (!ProductKeyCheck::instance()->isValidPackage(QString::fromUtf8(collectionName)))
+        return;
+
+    QMutexLocker _(&m_mutex);
+    m_resources[collectionName].setName(collectionName);
+    m_resources[collectionName].appendResource(QSharedPointer<Resource>(new Resource(resourceName,
+        data)));
+}
+
 } // namespace QInstaller
@@ -31,6 +31,7 @@
 
 #include "binaryformat.h"
 
+#include <QtCore/QMutex>
 #include <QtCore/private/qabstractfileengine_p.h>
 
 namespace QInstaller {
@@ -47,12 +48,15 @@ public:
 
     void registerResources(const QList<ResourceCollection> &collections);
     void registerResource(const QString &fileName, const QString &resourcePath);
+    void registerResource(const QString &fileName, const QByteArray &data);
 
 private:
     BinaryFormatEngineHandler() {}
     ~BinaryFormatEngineHandler() {}
 
 private:
+    // engines are created from worker threads while archives are still being registered
+    mutable QMutex m_mutex;
     QHash<QByteArray, ResourceCollection> m_resources;
 };
 
@@ -313,6 +313,7 @@ void Component::loadDataFromPackage(const Package &package)
     setValue(scInheritVersion, package.data(scInheritVersion).toString());
     setValue(scDependencies, package.data(scDependencies).toString());
     setValue(scDownloadableArchives, package.data(scDownloadableArchives).toString());
+    setValue(scDeltaArchives, package.data(scDeltaArchives).toString());
     setValue(scVirtual, package.data(scVirtual).toString());
     setValue(scSortingPriority, package.data(scSortingPriority).toString());
 
@@ -415,8 +416,29 @@ void Component::setValue(const QString &key, const QString &value)
     if (d->m_vars.value(key) == normalizedValue)
         return;
 
-    if (key == scName)
+    if (key == scName) {
         d->m_componentName = normalizedValue;
+        d->m_core->invalidateComponentIndex();
+    }
+    if (key == scDependencies) {
+        d->m_dependencies = normalizedValue.split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+        d->m_core->invalidateComponentIndex();
+    }
+    if (key == scAutoDependOn) {
+        d->m_autoDependencies = normalizedValue.split(QInstaller::commaRegExp(),
+            QString::SkipEmptyParts);
+        d->m_autoDependOn.clear();
+        foreach (const QString &component, d->m_autoDependencies) {
+            QString name;
+            QString version;
+            PackageManagerCore::parseNameAndVersion(component, &name, &version);
+            d->m_autoDependOn.insert(name, version);
+        }
+    }
+    if (key == scVersion)
+        d->m_versionKey = KDUpdater::VersionKey(normalizedValue);
+    if (key == scReplaces)
+        d->m_replaces = normalizedValue.split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
     if (key == scCheckable)
         this->setCheckable(normalizedValue.toLower() == scTrue);
     if (key == scExpandedByDefault)
@@ -470,6 +492,7 @@ void Component::appendComponent(Component *component)
         parent->removeComponent(component);
     component->d->m_parentComponent = this;
     setTristate(d->m_childComponents.count() > 0);
+    d->m_core->invalidateComponentIndex();
 }
 
 /*!
@@ -482,6 +505,7 @@ void Component::removeComponent(Component *component)
         component->d->m_parentComponent = 0;
         d->m_childComponents.removeAll(component);
         d->m_allChildComponents.removeAll(component);
+        d->m_core->invalidateComponentIndex();
     }
 }
 
@@ -1246,7 +1270,15 @@ void Component::addDependency(const QString &newDependency)
 
 QStringList Component::dependencies() const
 {
-    return d->m_vars.value(scDependencies).split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+    return d->m_dependencies;
+}
+
+/*!
+    Returns the version of the component, parsed for comparison with other versions.
+*/
+KDUpdater::VersionKey Component::versionKey() const
+{
+    return d->m_versionKey;
 }
 
 /*!
@@ -1267,7 +1299,15 @@ void Component::addAutoDependOn(const QString &newDependOn)
 
 QStringList Component::autoDependencies() const
 {
-    return d->m_vars.value(scAutoDependOn).split(QInstaller::commaRegExp(), QString::SkipEmptyParts);
+    return d->m_autoDependencies;
+}
+
+/*!
+    Returns the names of the components this component replaces.
+*/
+QStringList Component::replaces() const
+{
+    return d->m_replaces;
 }
 
 /*!
@@ -1289,56 +1329,40 @@ bool Component::isAutoDependOn(const QHash<QString, Component *> &componentsToIn
 {
     // If there is no auto depend on value or the value is empty, we have nothing todo. The component does
     // not need to be installed as an auto dependency.
-    QStringList autoDependOnList = autoDependencies();
-    if (autoDependOnList.isEmpty())
+    if (d->m_autoDependOn.isEmpty())
         return false;
 
-    QHash<QString, QString> autoDependOn;
-    foreach (const QString &component, autoDependOnList) {
-        QString name;
-        QString version;
-        PackageManagerCore::parseNameAndVersion(component, &name, &version);
-        autoDependOn.insert(name, version);
-    }
-
     // If there is an essential update and autodepend on is not for essential
     // update component, do not add the autodependency to an installed component as
     // essential updates needs to be installed first, otherwise non-essential components
     // will be installed
     if (packageManagerCore()->foundEssentialUpdate()) {
-        if (autoDependOn.keys().toSet().intersects(componentsToInstall.keys().toSet()))
-            return true;
+        foreach (const QString &name, d->m_autoDependOn.keys()) {
+            if (componentsToInstall.contains(name))
+                return true;
+        }
         return false;
     }
 
-    auto resolve = [&autoDependOn](const QString &name, const QString &version) -> bool {
-        if (autoDependOn.contains(name)) {
-            QString requiredVersion = autoDependOn.value(name);
-            if (requiredVersion.isEmpty() ||
-                    PackageManagerCore::versionMatches(version, requiredVersion)) {
-                autoDependOn.remove(name);
-                if (autoDependOn.isEmpty()) {
-                    // If all components in the isAutoDependOn field are already installed or selected for
-                    // installation, this component needs to be installed as well.
-                    return true;
-                }
-            }
-        }
-        return false;
+    auto resolved = [](const QString &version, const QString &requiredVersion) -> bool {
+        return requiredVersion.isEmpty() || PackageManagerCore::versionMatches(version, requiredVersion);
     };
 
-    foreach (Component *component, componentsToInstall) {
-        if (resolve(component->name(), component->value(scVersion)))
-            return true;
-    }
-
+    // If all components in the isAutoDependOn field are already installed or selected for
+    // installation, this component needs to be installed as well.
     const LocalPackagesHash installedPackages = d->m_core->localInstalledPackages();
-    foreach (const KDUpdater::LocalPackage &package, installedPackages) {
-        if (resolve(package.name, package.version))
-            return true;
-    }
+    for (auto it = d->m_autoDependOn.constBegin(); it != d->m_autoDependOn.constEnd(); ++it) {
+        const Component *const component = componentsToInstall.value(it.key());
+        if (component && resolved(component->value(scVersion), it.value()))
+            continue;
 
-    return false;
+        const auto package = installedPackages.constFind(it.key());
+        if (package != installedPackages.constEnd() && resolved(package->version, it.value()))
+            continue;
+
+        return false;
+    }
+    return true;
 }
 
 bool Component::isDefault() const
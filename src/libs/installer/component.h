@@ -184,8 +184,10 @@ public:
 
     Q_INVOKABLE void addDependency(const QString &newDependency);
     QStringList dependencies() const;
+    KDUpdater::VersionKey versionKey() const;
     Q_INVOKABLE void addAutoDependOn(const QString &newDependOn);
     QStringList autoDependencies() const;
+    QStringList replaces() const;
 
     void languageChanged();
     QString localTempPath() const;
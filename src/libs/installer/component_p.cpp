@@ -31,6 +31,7 @@
 #include "component.h"
 #include "packagemanagercore.h"
 
+#include <QAtomicInt>
 #include <QWidget>
 
 namespace QInstaller {
@@ -74,6 +75,9 @@ ScriptEngine *ComponentPrivate::scriptEngine() const
 
 // -- ComponentModelHelper
 
+// incremented whenever the checked state of any component is set
+static QAtomicInt checkStateRevisionCounter;
+
 ComponentModelHelper::ComponentModelHelper()
 {
     setCheckState(Qt::Unchecked);
@@ -261,6 +265,16 @@ void ComponentModelHelper::setCheckState(Qt::CheckState state)
     setData(state, Qt::CheckStateRole);
 }
 
+/*!
+    Returns a number that changes whenever the checked state of any component is set, no matter
+    whether through setCheckState() or setData(). Comparing it to a previously returned value
+    tells whether check states might have changed in between.
+*/
+int ComponentModelHelper::checkStateRevision()
+{
+    return checkStateRevisionCounter.load();
+}
+
 /*!
     Returns the component's data for the given role, or an invalid QVariant if there is no data for role.
 */
@@ -274,6 +288,8 @@ QVariant ComponentModelHelper::data(int role) const
 */
 void ComponentModelHelper::setData(const QVariant &value, int role)
 {
+    if (role == Qt::CheckStateRole)
+        checkStateRevisionCounter.ref();
     m_values.insert((role == Qt::EditRole ? Qt::DisplayRole : role), value);
 }
 
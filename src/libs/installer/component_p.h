@@ -70,6 +70,12 @@ public:
     QString m_localTempPath;
     QJSValue m_scriptContext;
     QHash<QString, QString> m_vars;
+    // parsed from m_vars whenever the corresponding value changes
+    QStringList m_dependencies;
+    QStringList m_autoDependencies;
+    QHash<QString, QString> m_autoDependOn;
+    QStringList m_replaces;
+    KDUpdater::VersionKey m_versionKey;
     QList<Component*> m_childComponents;
     QList<Component*> m_allChildComponents;
     QStringList m_downloadableArchives;
@@ -143,6 +149,7 @@ public:
 
     Qt::CheckState checkState() const;
     void setCheckState(Qt::CheckState state);
+    static int checkStateRevision();
 
     QVariant data(int role = Qt::UserRole + 1) const;
     void setData(const QVariant &value, int role = Qt::UserRole + 1);
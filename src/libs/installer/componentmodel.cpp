@@ -32,6 +32,8 @@
 #include "packagemanagercore.h"
 #include <QIcon>
 
+#include <algorithm>
+
 namespace QInstaller {
 
 /*!
@@ -99,6 +101,8 @@ ComponentModel::ComponentModel(int columns, PackageManagerCore *core)
     : QAbstractItemModel(core)
     , m_core(core)
     , m_modelState(DefaultChecked)
+    , m_checkedStateDifference(0)
+    , m_checkStateRevision(0)
 {
     m_headerData.insert(0, columns, QVariant());
     connect(this, &QAbstractItemModel::modelReset, this, &ComponentModel::slotModelReset);
@@ -260,11 +264,10 @@ bool ComponentModel::setData(const QModelIndex &index, const QVariant &value, in
             newValue = (oldValue == Qt::Checked) ? Qt::Unchecked : Qt::Checked;
         }
         QSet<QModelIndex> changed = updateCheckedState(nodes << component, newValue);
-        foreach (const QModelIndex &index, changed) {
-            emit dataChanged(index, index);
+        foreach (const QModelIndex &index, changed)
             emit checkStateChanged(index);
-        }
         updateAndEmitModelState();     // update the internal state
+        emitDataChanged(changed);
     } else {
         component->setData(value, role);
         emit dataChanged(index, index);
@@ -397,6 +400,7 @@ void ComponentModel::setRootComponents(QList<QInstaller::Component*> rootCompone
 
     m_uncheckable.clear();
     m_indexByNameCache.clear();
+    m_childCheckStates.clear();
     m_rootComponentList.clear();
     m_modelState = DefaultChecked;
 
@@ -407,6 +411,7 @@ void ComponentModel::setRootComponents(QList<QInstaller::Component*> rootCompone
     m_initialCheckedState[Qt::Unchecked] = ComponentSet();
     m_initialCheckedState[Qt::PartiallyChecked] = ComponentSet();
     m_currentCheckedState = m_initialCheckedState;  // both should be equal
+    m_checkedStateDifference = 0;
 
     // show virtual components only in case we run as updater or if the core engine is set to show them
     const bool showVirtuals = m_core->isUpdater() || m_core->virtualComponentsVisible();
@@ -449,11 +454,10 @@ void ComponentModel::setCheckedState(QInstaller::ComponentModel::ModelStateFlag
         return;
 
     // notify about changes done to the model
-    foreach (const QModelIndex &index, changed) {
-        emit dataChanged(index, index);
+    foreach (const QModelIndex &index, changed)
         emit checkStateChanged(index);
-    }
     updateAndEmitModelState();     // update the internal state
+    emitDataChanged(changed);
 }
 
 
@@ -482,6 +486,7 @@ void ComponentModel::slotModelReset()
     }
 
     m_currentCheckedState = m_initialCheckedState;
+    m_checkedStateDifference = 0;
     updateAndEmitModelState();     // update the internal state
 }
 
@@ -497,7 +502,7 @@ void ComponentModel::onVirtualStateChanged()
 void ComponentModel::updateAndEmitModelState()
 {
     m_modelState = ComponentModel::DefaultChecked;
-    if (m_initialCheckedState != m_currentCheckedState)
+    if (m_checkedStateDifference != 0)
         m_modelState = ComponentModel::PartiallyChecked;
 
     if (checked().count() == 0 && partially().count() == 0) {
@@ -511,15 +516,34 @@ void ComponentModel::updateAndEmitModelState()
     }
 
     emit checkStateChanged(m_modelState);
+}
 
-    foreach (const Component *component, m_rootComponentList) {
-        emit dataChanged(indexFromComponentName(component->name()),
-                         indexFromComponentName(component->name()));
-        QList<Component *> children = component->childItems();
-        foreach (const Component *child, children)
-            emit dataChanged(indexFromComponentName(child->name()),
-                             indexFromComponentName(child->name()));
+/*
+    Emits dataChanged() for the \a changed indexes and their ancestors. The rows are coalesced into
+    one range per parent, so a parent with many changed children is notified only once.
+*/
+void ComponentModel::emitDataChanged(const QSet<QModelIndex> &changed)
+{
+    QSet<QModelIndex> visited;
+    QHash<QModelIndex, QPair<int, int> > rowRanges;
+    foreach (QModelIndex current, changed) {
+        // an ancestor that was already visited has all of its ancestors visited as well
+        while (current.isValid() && !visited.contains(current)) {
+            visited.insert(current);
+            const QModelIndex parent = current.parent();
+            QHash<QModelIndex, QPair<int, int> >::iterator it = rowRanges.find(parent);
+            if (it == rowRanges.end()) {
+                rowRanges.insert(parent, qMakePair(current.row(), current.row()));
+            } else {
+                it->first = qMin(it->first, current.row());
+                it->second = qMax(it->second, current.row());
+            }
+            current = parent;
+        }
     }
+
+    for (auto it = rowRanges.constBegin(); it != rowRanges.constEnd(); ++it)
+        emit dataChanged(index(it->first, 0, it.key()), index(it->second, 0, it.key()));
 }
 
 void ComponentModel::collectComponents(Component *const component, const QModelIndex &parent) const
@@ -531,54 +555,44 @@ void ComponentModel::collectComponents(Component *const component, const QModelI
 
 namespace ComponentModelPrivate {
 
-static Qt::CheckState verifyPartiallyChecked(Component *component)
-{
-    bool anyChecked = false;
-    bool anyUnchecked = false;
-
-    const int count = component->childCount();
-    for (int i = 0; i < count; ++i) {
-        switch (component->childAt(i)->checkState()) {
-            case Qt::Checked: {
-                anyChecked = true;
-            }   break;
-            case Qt::Unchecked: {
-                anyUnchecked = true;
-            }   break;
-            default:
-                return Qt::PartiallyChecked;
-        }
-        if (anyChecked && anyUnchecked)
-            return Qt::PartiallyChecked;
-    }
-
-    if (anyChecked)
-        return Qt::Checked;
-
-    if (anyUnchecked)
-        return Qt::Unchecked;
-
-    return Qt::PartiallyChecked; // never hit here
+static int depth(Component *component)
+{
+    int result = 0;
+    while ((component = component->parentComponent()))
+        ++result;
+    return result;
 }
 
 }   // namespace ComponentModelPrivate
 
 QSet<QModelIndex> ComponentModel::updateCheckedState(const ComponentSet &components, Qt::CheckState state)
 {
-    // get all parent nodes for the components we're going to update
-    QMap<QString, Component *> sortedNodesMap;
+    // check states were set outside of the model since the last update, the child counts
+    // cannot be trusted anymore
+    if (m_checkStateRevision != ComponentModelHelper::checkStateRevision())
+        m_childCheckStates.clear();
+
+    // get all parent nodes for the components we're going to update, an ancestor that was
+    // already collected has all of its ancestors collected as well
+    ComponentSet nodes;
+    QVector<QPair<int, Component *> > sortedNodes;
     foreach (Component *component, components) {
-        while (component && !sortedNodesMap.values(component->name()).contains(component)) {
-            sortedNodesMap.insertMulti(component->name(), component);
+        while (component && !nodes.contains(component)) {
+            nodes.insert(component);
+            sortedNodes.append(qMakePair(ComponentModelPrivate::depth(component), component));
             component = component->parentComponent();
         }
     }
 
+    // update the deepest nodes first to check node and tri-state nodes properly
+    std::stable_sort(sortedNodes.begin(), sortedNodes.end(),
+        [](const QPair<int, Component *> &lhs, const QPair<int, Component *> &rhs) {
+            return lhs.first > rhs.first;
+        });
+
     QSet<QModelIndex> changed;
-    const ComponentList sortedNodes = sortedNodesMap.values();
-    // we can start in descending order to check node and tri-state nodes properly
-    for (int i = sortedNodes.count(); i > 0; i--) {
-        Component * const node = sortedNodes.at(i - 1);
+    for (int i = 0; i < sortedNodes.count(); ++i) {
+        Component * const node = sortedNodes.at(i).second;
 
         bool checkable = true;
         if (node->value(scCheckable, scTrue).toLower() == scFalse) {
@@ -591,13 +605,16 @@ QSet<QModelIndex> ComponentModel::updateCheckedState(const ComponentSet &compone
         Qt::CheckState newState = state;
         const Qt::CheckState recentState = node->checkState();
         if (node->isTristate())
-            newState = ComponentModelPrivate::verifyPartiallyChecked(node);
+            newState = childrenCheckState(node);
         if (recentState == newState)
             continue;
 
         node->setCheckState(newState);
         changed.insert(indexFromComponentName(node->name()));
+        if (Component *const parent = node->parentComponent())
+            updateChildCheckStates(parent, recentState, newState);
 
+        const int differenceBefore = checkedStateDifference(node);
         m_currentCheckedState[Qt::Checked].remove(node);
         m_currentCheckedState[Qt::Unchecked].remove(node);
         m_currentCheckedState[Qt::PartiallyChecked].remove(node);
@@ -613,8 +630,87 @@ QSet<QModelIndex> ComponentModel::updateCheckedState(const ComponentSet &compone
                 m_currentCheckedState[Qt::PartiallyChecked].insert(node);
             break;
         }
+        m_checkedStateDifference += checkedStateDifference(node) - differenceBefore;
     }
+
+    // the check states set above are accounted for in the child counts
+    m_checkStateRevision = ComponentModelHelper::checkStateRevision();
     return changed;
 }
 
+/*
+    Returns in how many of the checked state sets the membership of \a component differs from the
+    initial checked state. The sum over all components is kept in m_checkedStateDifference, so
+    comparing the whole current and initial states is not needed after every change.
+*/
+int ComponentModel::checkedStateDifference(Component *component) const
+{
+    int difference = 0;
+    foreach (const Qt::CheckState state, QList<Qt::CheckState>() << Qt::Checked << Qt::Unchecked
+            << Qt::PartiallyChecked) {
+        if (m_currentCheckedState.value(state).contains(component)
+                != m_initialCheckedState.value(state).contains(component)) {
+            ++difference;
+        }
+    }
+    return difference;
+}
+
+int &ComponentModel::ChildCheckStates::count(Qt::CheckState state)
+{
+    switch (state) {
+        case Qt::Checked:
+            return checked;
+        case Qt::Unchecked:
+            return unchecked;
+        default:
+            return partially;
+    }
+}
+
+/*
+    Returns the checked state of the tri-state \a component as derived from its direct children.
+    The children are counted on first use, afterwards updateChildCheckStates() keeps the counts up
+    to date, so the result does not depend on the number of children. The counts are dropped
+    whenever a check state was set outside of the model.
+*/
+Qt::CheckState ComponentModel::childrenCheckState(Component *component)
+{
+    QHash<Component *, ChildCheckStates>::iterator it = m_childCheckStates.find(component);
+    if (it == m_childCheckStates.end()) {
+        ChildCheckStates counts;
+        const int count = component->childCount();
+        for (int i = 0; i < count; ++i)
+            ++counts.count(component->childAt(i)->checkState());
+        it = m_childCheckStates.insert(component, counts);
+    }
+
+    const ChildCheckStates &counts = it.value();
+    if (counts.partially > 0 || (counts.checked > 0 && counts.unchecked > 0))
+        return Qt::PartiallyChecked;
+
+    if (counts.checked > 0)
+        return Qt::Checked;
+
+    if (counts.unchecked > 0)
+        return Qt::Unchecked;
+
+    return Qt::PartiallyChecked; // never hit here
+}
+
+/*
+    Moves one child of \a component from the \a oldState to the \a newState count. Counts that
+    were not computed yet are left alone, childrenCheckState() counts them when first needed.
+*/
+void ComponentModel::updateChildCheckStates(Component *component, Qt::CheckState oldState,
+    Qt::CheckState newState)
+{
+    QHash<Component *, ChildCheckStates>::iterator it = m_childCheckStates.find(component);
+    if (it == m_childCheckStates.end())
+        return;
+
+    --it->count(oldState);
+    ++it->count(newState);
+}
+
 } // namespace QInstaller
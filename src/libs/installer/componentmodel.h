@@ -98,9 +98,22 @@ private Q_SLOTS:
     void onVirtualStateChanged();
 
 private:
+    struct ChildCheckStates {
+        int checked = 0;
+        int unchecked = 0;
+        int partially = 0;
+
+        int &count(Qt::CheckState state);
+    };
+
     void updateAndEmitModelState();
+    void emitDataChanged(const QSet<QModelIndex> &changed);
     void collectComponents(Component *const component, const QModelIndex &parent) const;
     QSet<QModelIndex> updateCheckedState(const ComponentSet &components, Qt::CheckState state);
+    int checkedStateDifference(Component *component) const;
+    Qt::CheckState childrenCheckState(Component *component);
+    void updateChildCheckStates(Component *component, Qt::CheckState oldState,
+        Qt::CheckState newState);
 
 private:
     PackageManagerCore *m_core;
@@ -112,7 +125,10 @@ private:
 
     QHash<Qt::CheckState, ComponentSet> m_initialCheckedState;
     QHash<Qt::CheckState, ComponentSet> m_currentCheckedState;
+    int m_checkedStateDifference;
     mutable QHash<QString, QPersistentModelIndex> m_indexByNameCache;
+    QHash<Component *, ChildCheckStates> m_childCheckStates;
+    int m_checkStateRevision;
 };
 Q_DECLARE_OPERATORS_FOR_FLAGS(ComponentModel::ModelState);
 
@@ -46,6 +46,7 @@ static const QLatin1String scRemoteDisplayVersion("RemoteDisplayVersion");
 static const QLatin1String scInheritVersion("inheritVersionFrom");
 static const QLatin1String scReplaces("Replaces");
 static const QLatin1String scDownloadableArchives("DownloadableArchives");
+static const QLatin1String scDeltaArchives("DeltaArchives");
 static const QLatin1String scEssential("Essential");
 static const QLatin1String scTargetDir("TargetDir");
 static const QLatin1String scReleaseDate("ReleaseDate");
@@ -92,6 +93,14 @@ static const QLatin1String scSupportsModify("SupportsModify");
 static const QLatin1String scAllowUnstableComponents("AllowUnstableComponents");
 static const QLatin1String scSaveDefaultRepositories("SaveDefaultRepositories");
 static const QLatin1String scRepositoryCategoryDisplayName("RepositoryCategoryDisplayName");
+static const QLatin1String scPipelinedInstallation("PipelinedInstallation");
+static const QLatin1String scMaxConcurrentDownloads("MaxConcurrentDownloads");
+static const QLatin1String scInMemoryDownloadLimit("InMemoryDownloadLimit");
+static const QLatin1String scDownloadSegments("DownloadSegments");
+static const QLatin1String scDownloadSegmentSize("DownloadSegmentSize");
+static const QLatin1String scMaxConcurrentExtractions("MaxConcurrentExtractions");
+static const QLatin1String scLocalCachePath("LocalCachePath");
+static const QLatin1String scLocalCacheSizeLimit("LocalCacheSizeLimit");
 
 const char scRelocatable[] = "@RELOCATABLE_PATH@";
 
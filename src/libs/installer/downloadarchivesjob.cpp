@@ -29,34 +29,71 @@
 
 #include "binaryformatenginehandler.h"
 #include "component.h"
+#include "errors.h"
 #include "messageboxhandler.h"
+#include "mirrorhealth.h"
+#include "operationexecutor.h"
 #include "packagemanagercore.h"
+#include "settings.h"
 #include "utils.h"
 
 #include "filedownloader.h"
 #include "filedownloaderfactory.h"
 
 #include <QtCore/QFile>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QTimerEvent>
 
 using namespace QInstaller;
 using namespace KDUpdater;
 
+static const int scDefaultMaxConcurrentDownloads = 4;
+static const int scDefaultDownloadSegments = 4;
+static const qint64 scDefaultDownloadSegmentSize = 16 * 1024 * 1024;
 
 /*!
     Creates a new DownloadArchivesJob with \a parent.
+
+    The number of archives downloaded at the same time is read from the
+    \c MaxConcurrentDownloads value of \a core.
 */
 DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
     : Job(core)
     , m_core(core)
-    , m_downloader(nullptr)
     , m_archivesDownloaded(0)
-    , m_archivesToDownloadCount(0)
+    , m_maxConcurrentDownloads(scDefaultMaxConcurrentDownloads)
+    , m_inMemoryDownloadLimit(0)
+    , m_segmentCount(scDefaultDownloadSegments)
+    , m_segmentSize(scDefaultDownloadSegmentSize)
+    , m_downloadedWeight(0)
+    , m_totalWeight(0)
+    , m_fetchingHashes(false)
     , m_canceled(false)
-    , m_lastFileProgress(0)
+    , m_finished(false)
     , m_progressChangedTimerId(0)
 {
     setCapabilities(Cancelable);
+
+    // archives can only be looked up in the cache by the checksum fetched from the repository
+    if (m_core->testChecksum())
+        m_archiveCache = ArchiveCache::fromCore(m_core);
+
+    bool ok = false;
+    const int count = m_core->value(scMaxConcurrentDownloads).toInt(&ok);
+    if (ok)
+        setMaxConcurrentDownloads(count);
+
+    const qint64 limit = m_core->value(scInMemoryDownloadLimit).toLongLong(&ok);
+    if (ok)
+        setInMemoryDownloadLimit(limit);
+
+    const int segments = m_core->value(scDownloadSegments).toInt(&ok);
+    if (ok)
+        setSegmentCount(segments);
+
+    const qint64 segmentSize = m_core->value(scDownloadSegmentSize).toLongLong(&ok);
+    if (ok)
+        setSegmentSize(segmentSize);
 }
 
 /*!
@@ -64,8 +101,7 @@ DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
 */
 DownloadArchivesJob::~DownloadArchivesJob()
 {
-    if (m_downloader)
-        m_downloader->deleteLater();
+    cancelDownloads();
 }
 
 /*!
@@ -75,7 +111,68 @@ DownloadArchivesJob::~DownloadArchivesJob()
 void DownloadArchivesJob::setArchivesToDownload(const QList<QPair<QString, QString> > &archives)
 {
     m_archivesToDownload = archives;
-    m_archivesToDownloadCount = archives.count();
+}
+
+/*!
+    Sets the expected download \a sizes of the archives, keyed by the file name of the archive in
+    the installer's internal file system. The download progress is weighted by these sizes, so
+    that a large archive counts more than a small one. If the size of an archive is not known, all
+    archives count the same.
+*/
+void DownloadArchivesJob::setArchiveSizes(const QHash<QString, quint64> &sizes)
+{
+    m_archiveSizes = sizes;
+}
+
+/*!
+    Sets the \a deltas to download instead of the full archives, keyed by the file name of the
+    archive in the installer's internal file system. The full archive is reconstructed from a
+    delta and the installed files of the previous version of the component. If a delta cannot
+    be downloaded or applied, the full archive is downloaded instead.
+*/
+void DownloadArchivesJob::setArchiveDeltas(const QHash<QString, ArchiveDelta> &deltas)
+{
+    m_archiveDeltas = deltas;
+}
+
+/*!
+    Sets the maximum number of archives that are downloaded at the same time to \a count. All
+    downloads share one network access manager.
+*/
+void DownloadArchivesJob::setMaxConcurrentDownloads(int count)
+{
+    m_maxConcurrentDownloads = qMax(1, count);
+}
+
+/*!
+    Sets the total number of \a bytes of downloaded archives that may be kept in memory instead of
+    being written to the component's temporary directory. Archives kept in memory are hashed while
+    they are received and registered in the installer's file system without touching the disk. An
+    archive that does not fit into the remaining budget is spilled to disk. The default value \c 0
+    writes all archives to disk.
+*/
+void DownloadArchivesJob::setInMemoryDownloadLimit(qint64 bytes)
+{
+    m_inMemoryDownloadLimit = qMax<qint64>(0, bytes);
+}
+
+/*!
+    Sets the number of connections used to download a single large archive to \a count. The
+    archive is split into byte ranges that are fetched in parallel from the repository and its
+    mirrors. The value \c 1 downloads each archive over one connection.
+*/
+void DownloadArchivesJob::setSegmentCount(int count)
+{
+    m_segmentCount = qMax(1, count);
+}
+
+/*!
+    Sets the minimum size in \a bytes of a range of a segmented download. Only archives of at
+    least twice this size are downloaded in segments.
+*/
+void DownloadArchivesJob::setSegmentSize(qint64 bytes)
+{
+    m_segmentSize = qMax<qint64>(0, bytes);
 }
 
 /*!
@@ -84,7 +181,24 @@ void DownloadArchivesJob::setArchivesToDownload(const QList<QPair<QString, QStri
 void DownloadArchivesJob::doStart()
 {
     m_archivesDownloaded = 0;
-    fetchNextArchiveHash();
+    m_finished = false;
+    m_archiveSources.clear();
+
+    m_downloadedWeight = 0;
+    m_totalWeight = 0;
+    foreach (const Archive &archive, m_archivesToDownload) {
+        if (m_archiveSizes.value(archive.first) == 0) {
+            m_archiveSizes.clear();
+            m_totalWeight = m_archivesToDownload.count();
+            break;
+        }
+        m_totalWeight += archiveWeight(archive);
+    }
+
+    // Fetch all the hash files up front, so that the archives do not have to wait for them.
+    m_fetchingHashes = m_core->testChecksum();
+    m_pendingDownloads = m_archivesToDownload;
+    startNextDownloads();
 }
 
 /*!
@@ -93,94 +207,153 @@ void DownloadArchivesJob::doStart()
 void DownloadArchivesJob::doCancel()
 {
     m_canceled = true;
-    if (m_downloader != nullptr)
-        m_downloader->cancelDownload();
+    cancelDownloads();
 }
 
-void DownloadArchivesJob::fetchNextArchiveHash()
+/*!
+    Starts downloads from the queue of pending ones until the maximum number of concurrent
+    downloads is reached. Finishes the job once all downloads are done.
+*/
+void DownloadArchivesJob::startNextDownloads()
 {
-    if (m_core->testChecksum()) {
-        if (m_canceled) {
-            finishWithError(tr("Canceled"));
-            return;
-        }
+    if (m_canceled || m_finished)
+        return;
 
-        if (m_archivesToDownload.isEmpty()) {
-            emitFinished();
-            return;
-        }
+    while (m_activeDownloads.count() < m_maxConcurrentDownloads && !m_pendingDownloads.isEmpty()) {
+        const Archive archive = m_pendingDownloads.takeFirst();
+        if (m_fetchingHashes)
+            startHashDownload(archive);
+        else
+            startArchiveDownload(archive);
+    }
 
-        if (m_downloader)
-            m_downloader->deleteLater();
+    if (!m_activeDownloads.isEmpty() || !m_pendingDownloads.isEmpty())
+        return;
 
-        m_downloader = setupDownloader(QLatin1String(".sha1"));
-        if (!m_downloader) {
-            m_archivesToDownload.removeFirst();
-            QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-            return;
-        }
+    if (m_fetchingHashes) {
+        // all hashes are known, continue with the archives themselves
+        m_fetchingHashes = false;
+        m_pendingDownloads = m_archivesToDownload;
+        startNextDownloads();
+        return;
+    }
 
-        connect(m_downloader, &FileDownloader::downloadCompleted,
-                this, &DownloadArchivesJob::finishedHashDownload, Qt::QueuedConnection);
-        m_downloader->download();
-    } else {
-        QMetaObject::invokeMethod(this, "fetchNextArchive", Qt::QueuedConnection);
+    m_finished = true;
+    m_archiveCache.evict();
+    emitFinished();
+}
+
+void DownloadArchivesJob::startHashDownload(const Archive &archive)
+{
+    FileDownloader *downloader = setupDownloader(archive, QLatin1String(".sha1"));
+    if (!downloader) {
+        m_archivesToDownload.removeOne(archive);
+        return;
     }
+
+    m_activeDownloads.insert(downloader, archive);
+    connect(downloader, &FileDownloader::downloadCompleted, this, [this, downloader]() {
+        finishedHashDownload(downloader);
+    }, Qt::QueuedConnection);
+    downloader->download();
 }
 
-void DownloadArchivesJob::finishedHashDownload()
+void DownloadArchivesJob::finishedHashDownload(FileDownloader *downloader)
 {
-    Q_ASSERT(m_downloader != nullptr);
+    if (m_canceled || m_finished)
+        return;
 
-    QFile sha1HashFile(m_downloader->downloadedFileName());
+    QFile sha1HashFile(downloader->downloadedFileName());
     if (sha1HashFile.open(QFile::ReadOnly)) {
-        m_currentHash = sha1HashFile.readAll();
-        fetchNextArchive();
+        m_archiveHashes.insert(m_activeDownloads.value(downloader).first, sha1HashFile.readAll());
+        removeDownloader(downloader);
+        startNextDownloads();
     } else {
-        finishWithError(tr("Downloading hash signature failed."));
+        finishWithError(downloader, tr("Downloading hash signature failed."));
     }
 }
 
 /*!
-    Fetches the next archive and registers it in the installer.
+    Fetches \a archive. It gets registered in the installer once the download is finished.
 */
-void DownloadArchivesJob::fetchNextArchive()
+void DownloadArchivesJob::startArchiveDownload(const Archive &archive)
 {
-    if (m_canceled) {
-        finishWithError(tr("Canceled"));
+    if (registerCachedFile(archive))
+        return;
+
+    if (m_archiveDeltas.contains(archive.first)) {
+        startDeltaDownload(archive);
         return;
     }
 
-    if (m_archivesToDownload.isEmpty()) {
-        emitFinished();
+    FileDownloader *downloader = setupDownloader(archive, QString(), m_core->value(scUrlQueryString));
+    if (!downloader) {
+        m_archivesToDownload.removeOne(archive);
         return;
     }
 
-    if (m_downloader != nullptr)
-        m_downloader->deleteLater();
+    m_activeDownloads.insert(downloader, archive);
+    m_fileProgress.insert(downloader, 0);
+
+    // share the remaining in-memory budget between the concurrent downloads
+    if (m_inMemoryDownloadLimit > 0)
+        downloader->setMaximumInMemorySize(m_inMemoryDownloadLimit / m_maxConcurrentDownloads);
+
+    // split large archives into ranges, the size is only known for archives of fetched components
+    if (m_segmentCount > 1 && m_segmentSize > 0
+        && m_archiveSizes.value(archive.first) >= quint64(2 * m_segmentSize)) {
+            downloader->setSegmentCount(m_segmentCount);
+            downloader->setMinimumSegmentSize(m_segmentSize);
+    }
+
+    void (FileDownloader::*progressSignal)(double) = &FileDownloader::downloadProgress;
+    connect(downloader, progressSignal, this, [this, downloader](double progress) {
+        emitDownloadProgress(downloader, progress);
+    });
+    connect(downloader, &FileDownloader::downloadCompleted, this, [this, downloader]() {
+        registerFile(downloader);
+    }, Qt::QueuedConnection);
 
-    m_downloader = setupDownloader(QString(), m_core->value(scUrlQueryString));
-    if (!m_downloader) {
-        m_archivesToDownload.removeFirst();
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
+    downloader->download();
+}
+
+/*!
+    Fetches the delta of \a archive against the installed version of its component instead of
+    the full archive. The full archive is reconstructed by applyDelta() once the download is
+    finished.
+*/
+void DownloadArchivesJob::startDeltaDownload(const Archive &archive)
+{
+    const ArchiveDelta delta = m_archiveDeltas.value(archive.first);
+    FileDownloader *downloader = setupDownloader(archive, delta.suffix(), m_core->value(scUrlQueryString));
+    if (!downloader) {
+        m_archiveDeltas.remove(archive.first);
+        startArchiveDownload(archive);
         return;
     }
 
-    emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
-    connect(m_downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
-    connect(m_downloader, &FileDownloader::downloadCompleted,
-            this, &DownloadArchivesJob::registerFile, Qt::QueuedConnection);
+    m_activeDownloads.insert(downloader, archive);
+    m_fileProgress.insert(downloader, 0);
+    m_deltaDownloads.insert(downloader);
 
-    m_downloader->download();
+    void (FileDownloader::*progressSignal)(double) = &FileDownloader::downloadProgress;
+    connect(downloader, progressSignal, this, [this, downloader](double progress) {
+        emitDownloadProgress(downloader, progress);
+    });
+    connect(downloader, &FileDownloader::downloadCompleted, this, [this, downloader]() {
+        applyDelta(downloader);
+    }, Qt::QueuedConnection);
+
+    downloader->download();
 }
 
 /*!
-    Emits the global download progress during a single download in a lazy way (uses a timer to reduce to
+    Emits the global download progress during the downloads in a lazy way (uses a timer to reduce to
     much processChanged).
 */
-void DownloadArchivesJob::emitDownloadProgress(double progress)
+void DownloadArchivesJob::emitDownloadProgress(FileDownloader *downloader, double progress)
 {
-    m_lastFileProgress = progress;
+    m_fileProgress.insert(downloader, progress);
     if (!m_progressChangedTimerId)
         m_progressChangedTimerId = startTimer(5);
 }
@@ -193,103 +366,329 @@ void DownloadArchivesJob::timerEvent(QTimerEvent *event)
     if (event->timerId() == m_progressChangedTimerId) {
         killTimer(m_progressChangedTimerId);
         m_progressChangedTimerId = 0;
-        emit progressChanged((double(m_archivesDownloaded) + m_lastFileProgress) / m_archivesToDownloadCount);
+
+        emit progressChanged(downloadProgress());
     }
 }
 
 /*!
-    Registers the just downloaded file in the installer's file system.
+    Returns the weight of \a archive in the download progress.
+*/
+double DownloadArchivesJob::archiveWeight(const Archive &archive) const
+{
+    return m_archiveSizes.isEmpty() ? 1 : double(m_archiveSizes.value(archive.first));
+}
+
+/*!
+    Returns the download progress of all archives, including the partial progress of the running
+    downloads.
 */
-void DownloadArchivesJob::registerFile()
+double DownloadArchivesJob::downloadProgress() const
 {
-    Q_ASSERT(m_downloader != nullptr);
+    double pendingWeight = 0;
+    for (auto it = m_fileProgress.constBegin(); it != m_fileProgress.constEnd(); ++it)
+        pendingWeight += it.value() * archiveWeight(m_activeDownloads.value(it.key()));
+    return qMin(1.0, (m_downloadedWeight + pendingWeight) / qMax(1.0, m_totalWeight));
+}
 
-    if (m_canceled)
+/*!
+    Registers the file just downloaded by \a downloader in the installer's file system.
+*/
+void DownloadArchivesJob::registerFile(FileDownloader *downloader)
+{
+    if (m_canceled || m_finished)
         return;
 
-    if (m_core->testChecksum() && m_currentHash != m_downloader->sha1Sum().toHex()) {
-        //TODO: Maybe we should try to download the file again automatically
+    const Archive archive = m_activeDownloads.value(downloader);
+    if (m_core->testChecksum() && m_archiveHashes.value(archive.first) != downloader->sha1Sum().toHex()) {
+        if (tryNextSource(downloader, tr("Hash verification failed.")))
+            return;
+
         const QMessageBox::Button res =
             MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
             QLatin1String("DownloadError"), tr("Download Error"), tr("Hash verification while "
             "downloading failed. This is a temporary error, please retry."),
             QMessageBox::Retry | QMessageBox::Cancel, QMessageBox::Cancel);
 
+        if (m_canceled || m_finished)
+            return;
+
         if (res == QMessageBox::Cancel) {
-            finishWithError(tr("Cannot verify Hash"));
+            finishWithError(downloader, tr("Cannot verify Hash"));
             return;
         }
+        removeDownloader(downloader);
+        m_pendingDownloads.prepend(archive);
     } else {
-        ++m_archivesDownloaded;
-        if (m_progressChangedTimerId) {
-            killTimer(m_progressChangedTimerId);
-            m_progressChangedTimerId = 0;
-            emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
+        const QList<QUrl> sources = m_archiveSources.take(archive.first);
+        if (!sources.isEmpty()) {
+            MirrorHealth::instance().addSuccess(sources.first());
+            qDebug().noquote() << "Downloaded" << QFileInfo(archive.first).fileName() << "from"
+                << sources.first().toString();
+        }
+
+        const QByteArray hash = m_archiveHashes.value(archive.first);
+        if (downloader->isDownloadedInMemory()) {
+            const QByteArray data = downloader->downloadedData();
+            m_inMemoryDownloadLimit = qMax<qint64>(0, m_inMemoryDownloadLimit - data.size());
+            m_archiveCache.insert(hash, data);
+            BinaryFormatEngineHandler::instance()->registerResource(archive.first, data);
+        } else {
+            const QString cachedFileName = m_archiveCache.insert(hash,
+                downloader->downloadedFileName());
+            BinaryFormatEngineHandler::instance()->registerResource(archive.first,
+                cachedFileName.isEmpty() ? downloader->downloadedFileName() : cachedFileName);
+        }
+        removeDownloader(downloader);
+        archiveAvailable(archive);
+    }
+    startNextDownloads();
+}
+
+/*!
+    Verifies the delta just downloaded by \a downloader and reconstructs the full archive from it
+    next to the downloaded file. The reconstruction runs in a separate thread, as it reads all
+    unchanged files of the installed version.
+*/
+void DownloadArchivesJob::applyDelta(FileDownloader *downloader)
+{
+    if (m_canceled || m_finished)
+        return;
+
+    const Archive archive = m_activeDownloads.value(downloader);
+    const ArchiveDelta delta = m_archiveDeltas.value(archive.first);
+    if (downloader->sha1Sum().toHex() != delta.sha1()) {
+        downloadFullArchive(downloader, tr("Hash verification failed."));
+        return;
+    }
+
+    const QString deltaFileName = downloader->downloadedFileName();
+    const QString fileName = QFileInfo(deltaFileName).absolutePath() + QLatin1Char('/')
+        + QFileInfo(archive.first).fileName();
+    emit outputTextChanged(tr("Applying update to archive \"%1\".")
+        .arg(QFileInfo(archive.first).fileName()));
+
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, downloader, watcher, fileName]() {
+        watcher->deleteLater();
+        finishedApplyingDelta(downloader, fileName, watcher->result());
+    });
+    watcher->setFuture(OperationExecutor::run([deltaFileName, delta, fileName]() {
+        try {
+            ArchiveDelta::reconstruct(deltaFileName, delta.baseDirectory(), fileName);
+        } catch (const QInstaller::Error &error) {
+            QFile::remove(fileName);
+            return error.message();
         }
+        QFile::remove(deltaFileName);
+        return QString();
+    }));
+}
+
+/*!
+    Registers the archive \a fileName reconstructed from the delta fetched by \a downloader, or
+    falls back to the full archive if applying the delta failed with \a error. The reconstructed
+    archive is not put into the local archive cache, as its checksum differs from the one of the
+    archive in the repository.
+*/
+void DownloadArchivesJob::finishedApplyingDelta(FileDownloader *downloader, const QString &fileName,
+    const QString &error)
+{
+    if (m_canceled || m_finished)
+        return;
+
+    if (!error.isEmpty()) {
+        downloadFullArchive(downloader, error);
+        return;
+    }
+
+    const Archive archive = m_activeDownloads.value(downloader);
+    const QList<QUrl> sources = m_archiveSources.take(archive.first);
+    if (!sources.isEmpty())
+        MirrorHealth::instance().addSuccess(sources.first());
+    qDebug().noquote() << "Updated" << QFileInfo(archive.first).fileName() << "from delta"
+        << downloader->url().toString();
+
+    BinaryFormatEngineHandler::instance()->registerResource(archive.first, fileName);
+    removeDownloader(downloader);
+    archiveAvailable(archive);
+    startNextDownloads();
+}
+
+/*!
+    Gives up on the delta fetched by \a downloader because of \a error and queues the full
+    archive instead.
+*/
+void DownloadArchivesJob::downloadFullArchive(FileDownloader *downloader, const QString &error)
+{
+    const Archive archive = m_activeDownloads.value(downloader);
+    qDebug().noquote() << "Cannot update" << QFileInfo(archive.first).fileName() << "from delta"
+        << downloader->url().toString() << ":" << error << "Downloading the full archive instead.";
+
+    if (!downloader->downloadedFileName().isEmpty())
+        QFile::remove(downloader->downloadedFileName());
+    m_archiveDeltas.remove(archive.first);
+    removeDownloader(downloader);
+    m_pendingDownloads.prepend(archive);
+    QMetaObject::invokeMethod(this, "startNextDownloads", Qt::QueuedConnection);
+}
+
+/*!
+    Registers \a archive from the local archive cache if an archive with the same checksum was
+    downloaded before. Returns \c false if the archive needs to be downloaded.
+*/
+bool DownloadArchivesJob::registerCachedFile(const Archive &archive)
+{
+    const QString fileName = m_archiveCache.lookup(m_archiveHashes.value(archive.first));
+    if (fileName.isEmpty())
+        return false;
+
+    emit outputTextChanged(tr("Using cached archive \"%1\".")
+        .arg(QFileInfo(archive.first).fileName()));
+    BinaryFormatEngineHandler::instance()->registerResource(archive.first, fileName);
+    archiveAvailable(archive);
+    return true;
+}
+
+/*!
+    Updates the progress after \a archive has been registered and announces it.
+*/
+void DownloadArchivesJob::archiveAvailable(const Archive &archive)
+{
+    ++m_archivesDownloaded;
+    m_downloadedWeight += archiveWeight(archive);
 
-        const QPair<QString, QString> pair = m_archivesToDownload.takeFirst();
-        BinaryFormatEngineHandler::instance()->registerResource(pair.first,
-            m_downloader->downloadedFileName());
+    if (m_progressChangedTimerId) {
+        killTimer(m_progressChangedTimerId);
+        m_progressChangedTimerId = 0;
     }
-    fetchNextArchiveHash();
+    emit progressChanged(downloadProgress());
+    emit archiveRegistered(archive.first);
 }
 
-void DownloadArchivesJob::downloadCanceled()
+void DownloadArchivesJob::downloadCanceled(FileDownloader *downloader)
 {
-    emitFinishedWithError(Job::Canceled, m_downloader->errorString());
+    if (m_canceled || m_finished)
+        return;
+
+    m_finished = true;
+    const QString error = downloader->errorString();
+    cancelDownloads();
+    emitFinishedWithError(Job::Canceled, error);
 }
 
-void DownloadArchivesJob::downloadFailed(const QString &error)
+void DownloadArchivesJob::downloadFailed(FileDownloader *downloader, const QString &error)
 {
-    if (m_canceled)
+    if (m_canceled || m_finished)
+        return;
+
+    if (m_deltaDownloads.contains(downloader)) {
+        downloadFullArchive(downloader, error);
         return;
+    }
 
+    if (tryNextSource(downloader, error))
+        return;
+
+    const Archive archive = m_activeDownloads.value(downloader);
     const QMessageBox::StandardButton b =
         MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
         QLatin1String("archiveDownloadError"), tr("Download Error"), tr("Cannot download archive %1: %2")
-        .arg(m_archivesToDownload.first().second, error), QMessageBox::Retry | QMessageBox::Cancel);
+        .arg(archive.second, error), QMessageBox::Retry | QMessageBox::Cancel);
+
+    // the other downloads went on while the message box was shown
+    if (m_canceled || m_finished)
+        return;
+
+    if (b == QMessageBox::Retry) {
+        removeDownloader(downloader);
+        m_pendingDownloads.prepend(archive);
+        QMetaObject::invokeMethod(this, "startNextDownloads", Qt::QueuedConnection);
+    } else {
+        downloadCanceled(downloader);
+    }
+}
 
-    if (b == QMessageBox::Retry)
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-    else
-        downloadCanceled();
+void DownloadArchivesJob::finishWithError(FileDownloader *downloader, const QString &error)
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    const QString msg = tr("Cannot fetch archives: %1\nError while loading %2")
+        .arg(error, downloader->url().toString());
+    cancelDownloads();
+    emitFinishedWithError(QInstaller::DownloadError, msg);
+}
+
+void DownloadArchivesJob::removeDownloader(FileDownloader *downloader)
+{
+    m_activeDownloads.remove(downloader);
+    m_fileProgress.remove(downloader);
+    m_deltaDownloads.remove(downloader);
+    downloader->disconnect(this);
+    downloader->deleteLater();
 }
 
-void DownloadArchivesJob::finishWithError(const QString &error)
+void DownloadArchivesJob::cancelDownloads()
 {
-    const FileDownloader *const dl = qobject_cast<const FileDownloader*> (sender());
-    const QString msg = tr("Cannot fetch archives: %1\nError while loading %2");
-    if (dl != nullptr)
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, dl->url().toString()));
-    else
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, m_downloader->url().toString()));
+    foreach (FileDownloader *downloader, m_activeDownloads.keys()) {
+        downloader->disconnect(this);
+        downloader->cancelDownload();
+        downloader->deleteLater();
+    }
+    m_activeDownloads.clear();
+    m_fileProgress.clear();
+    m_deltaDownloads.clear();
+    m_pendingDownloads.clear();
 }
 
-KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &suffix, const QString &queryString)
+KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const Archive &archive, const QString &suffix,
+    const QString &queryString)
 {
     KDUpdater::FileDownloader *downloader = nullptr;
-    const QFileInfo fi = QFileInfo(m_archivesToDownload.first().first);
+    const QFileInfo fi = QFileInfo(archive.first);
     const Component *const component = m_core->componentByName(PackageManagerCore::checkableName(QFileInfo(fi.path()).fileName()));
     if (component) {
         QString fullQueryString;
         if (!queryString.isEmpty())
             fullQueryString = QLatin1String("?") + queryString;
-        const QUrl url(m_archivesToDownload.first().second + suffix + fullQueryString);
+
+        // fetch from the best server of the repository, the others serve segments of the archive
+        QString location = archive.second;
+        QList<QUrl> mirrors;
+        const QString repositoryUrl = component->repositoryUrl().toString();
+        if (location.startsWith(repositoryUrl)) {
+            QList<QUrl> &sources = m_archiveSources[archive.first];
+            if (sources.isEmpty())
+                sources = rankedSources(component);
+            const QString path = location.mid(repositoryUrl.length());
+            location = sources.first().toString() + path;
+            for (int i = 1; i < sources.count(); ++i)
+                mirrors.append(QUrl(sources.at(i).toString() + path + fullQueryString));
+        }
+        const QUrl url(location + suffix + fullQueryString);
         const QString &scheme = url.scheme();
         downloader = FileDownloaderFactory::instance().create(scheme, this);
 
         if (downloader) {
             downloader->setUrl(url);
+            if (suffix.isEmpty())
+                downloader->setMirrorUrls(mirrors);
             downloader->setAutoRemoveDownloadedFile(false);
+            downloader->setNetworkAccessManager(&m_networkManager);
 
             QAuthenticator auth;
             auth.setUser(component->value(QLatin1String("username")));
             auth.setPassword(component->value(QLatin1String("password")));
             downloader->setAuthenticator(auth);
 
-            connect(downloader, &FileDownloader::downloadCanceled, this, &DownloadArchivesJob::downloadCanceled);
-            connect(downloader, &FileDownloader::downloadAborted, this, &DownloadArchivesJob::downloadFailed,
-                Qt::QueuedConnection);
+            connect(downloader, &FileDownloader::downloadCanceled, this, [this, downloader]() {
+                downloadCanceled(downloader);
+            });
+            connect(downloader, &FileDownloader::downloadAborted, this, [this, downloader](const QString &error) {
+                downloadFailed(downloader, error);
+            }, Qt::QueuedConnection);
             connect(downloader, &FileDownloader::downloadStatus, this, &DownloadArchivesJob::downloadStatusChanged);
 
             if (FileDownloaderFactory::isSupportedScheme(scheme)) {
@@ -307,3 +706,44 @@ KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &s
     }
     return downloader;
 }
+
+/*!
+    Returns the URL of the repository of \a component and the URLs of its mirrors, best first.
+*/
+QList<QUrl> DownloadArchivesJob::rankedSources(const Component *component) const
+{
+    const QUrl repositoryUrl = component->repositoryUrl();
+    QSet<Repository> repositories = m_core->settings().repositories();
+    foreach (const RepositoryCategory &category, m_core->settings().repositoryCategories())
+        repositories.unite(category.repositories());
+
+    foreach (const Repository &repository, repositories) {
+        if (repository.url() == repositoryUrl)
+            return MirrorHealth::instance().ranked(repository);
+    }
+    return QList<QUrl>() << repositoryUrl;
+}
+
+/*!
+    Marks the server \a downloader fetched its file from as failed and starts the download again
+    from the next server of the repository, if there is one left. Returns \c false if the user
+    needs to decide how to go on after \a error.
+*/
+bool DownloadArchivesJob::tryNextSource(FileDownloader *downloader, const QString &error)
+{
+    const Archive archive = m_activeDownloads.value(downloader);
+    QList<QUrl> &sources = m_archiveSources[archive.first];
+    if (sources.isEmpty())
+        return false;
+
+    MirrorHealth::instance().addFailure(sources.takeFirst());
+    if (sources.isEmpty())
+        return false;   // the next attempt ranks all servers again
+
+    qDebug().noquote() << "Cannot download" << downloader->url().toString() << ":" << error
+        << "Trying" << sources.first().toString() << "instead.";
+    removeDownloader(downloader);
+    m_pendingDownloads.prepend(archive);
+    QMetaObject::invokeMethod(this, "startNextDownloads", Qt::QueuedConnection);
+    return true;
+}
@@ -29,9 +29,16 @@
 #ifndef DOWNLOADARCHIVESJOB_H
 #define DOWNLOADARCHIVESJOB_H
 
+#include "archivecache.h"
+#include "archivedelta.h"
 #include "job.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QUrl>
+
+#include <QtNetwork/QNetworkAccessManager>
 
 QT_BEGIN_NAMESPACE
 class QTimerEvent;
@@ -43,6 +50,7 @@ namespace KDUpdater {
 
 namespace QInstaller {
 
+class Component;
 class MessageBoxHandler;
 class PackageManagerCore;
 
@@ -56,11 +64,26 @@ public:
 
     int numberOfDownloads() const { return m_archivesDownloaded; }
     void setArchivesToDownload(const QList<QPair<QString, QString> > &archives);
+    void setArchiveSizes(const QHash<QString, quint64> &sizes);
+    void setArchiveDeltas(const QHash<QString, ArchiveDelta> &deltas);
+
+    int maxConcurrentDownloads() const { return m_maxConcurrentDownloads; }
+    void setMaxConcurrentDownloads(int count);
+
+    qint64 inMemoryDownloadLimit() const { return m_inMemoryDownloadLimit; }
+    void setInMemoryDownloadLimit(qint64 bytes);
+
+    int segmentCount() const { return m_segmentCount; }
+    void setSegmentCount(int count);
+
+    qint64 segmentSize() const { return m_segmentSize; }
+    void setSegmentSize(qint64 bytes);
 
 Q_SIGNALS:
     void progressChanged(double progress);
     void outputTextChanged(const QString &progress);
     void downloadStatusChanged(const QString &status);
+    void archiveRegistered(const QString &fileName);
 
 protected:
     void doStart();
@@ -68,29 +91,61 @@ protected:
     void timerEvent(QTimerEvent *event);
 
 protected Q_SLOTS:
-    void registerFile();
-    void downloadCanceled();
-    void downloadFailed(const QString &error);
-    void finishWithError(const QString &error);
-    void fetchNextArchive();
-    void fetchNextArchiveHash();
-    void finishedHashDownload();
-    void emitDownloadProgress(double progress);
+    void startNextDownloads();
 
 private:
-    KDUpdater::FileDownloader *setupDownloader(const QString &suffix = QString(), const QString &queryString = QString());
+    typedef QPair<QString, QString> Archive;
+
+    void startHashDownload(const Archive &archive);
+    void startArchiveDownload(const Archive &archive);
+    void startDeltaDownload(const Archive &archive);
+    void finishedHashDownload(KDUpdater::FileDownloader *downloader);
+    void registerFile(KDUpdater::FileDownloader *downloader);
+    void applyDelta(KDUpdater::FileDownloader *downloader);
+    void finishedApplyingDelta(KDUpdater::FileDownloader *downloader, const QString &fileName,
+        const QString &error);
+    void downloadFullArchive(KDUpdater::FileDownloader *downloader, const QString &error);
+    bool registerCachedFile(const Archive &archive);
+    void archiveAvailable(const Archive &archive);
+    void downloadFailed(KDUpdater::FileDownloader *downloader, const QString &error);
+    void downloadCanceled(KDUpdater::FileDownloader *downloader);
+    void finishWithError(KDUpdater::FileDownloader *downloader, const QString &error);
+    void emitDownloadProgress(KDUpdater::FileDownloader *downloader, double progress);
+    double archiveWeight(const Archive &archive) const;
+    double downloadProgress() const;
+    void removeDownloader(KDUpdater::FileDownloader *downloader);
+    void cancelDownloads();
+
+    KDUpdater::FileDownloader *setupDownloader(const Archive &archive, const QString &suffix = QString(),
+        const QString &queryString = QString());
+    QList<QUrl> rankedSources(const Component *component) const;
+    bool tryNextSource(KDUpdater::FileDownloader *downloader, const QString &error);
 
 private:
     PackageManagerCore *m_core;
-    KDUpdater::FileDownloader *m_downloader;
+    QNetworkAccessManager m_networkManager;
 
     int m_archivesDownloaded;
-    int m_archivesToDownloadCount;
-    QList<QPair<QString, QString> > m_archivesToDownload;
-
+    int m_maxConcurrentDownloads;
+    qint64 m_inMemoryDownloadLimit;
+    int m_segmentCount;
+    qint64 m_segmentSize;
+    QList<Archive> m_archivesToDownload;
+    QList<Archive> m_pendingDownloads;
+    QHash<KDUpdater::FileDownloader *, Archive> m_activeDownloads;
+    QHash<KDUpdater::FileDownloader *, double> m_fileProgress;
+    QHash<QString, quint64> m_archiveSizes;
+    QHash<QString, QList<QUrl> > m_archiveSources;
+    QHash<QString, ArchiveDelta> m_archiveDeltas;
+    QSet<KDUpdater::FileDownloader *> m_deltaDownloads;
+    double m_downloadedWeight;
+    double m_totalWeight;
+    QHash<QString, QByteArray> m_archiveHashes;
+    ArchiveCache m_archiveCache;
+
+    bool m_fetchingHashes;
     bool m_canceled;
-    QByteArray m_currentHash;
-    double m_lastFileProgress;
+    bool m_finished;
     int m_progressChangedTimerId;
 };
 
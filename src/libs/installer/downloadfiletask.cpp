@@ -200,6 +200,8 @@ void Downloader::onFinished(QNetworkReply *reply)
                 FileTaskItem taskItem = data.taskItem;
                 taskItem.insert(TaskRole::SourceFile, url.toString());
                 QNetworkReply *const redirectReply = startDownload(taskItem);
+                if (redirectReply)
+                    m_downloads[redirectReply]->timer = data.timer;
 
                 foreach (const QUrl &redirect, redirects)
                     m_redirects.insertMulti(redirectReply, redirect);
@@ -230,8 +232,20 @@ void Downloader::onFinished(QNetworkReply *reply)
         if (expectedCheckSum != data.observer->checkSum().toHex())
             checksumMismatch = true;
     }
-    m_futureInterface->reportResult(FileTaskResult(filename, data.observer->checkSum(), data.taskItem,
-                                                  checksumMismatch));
+    FileTaskResult result(filename, data.observer->checkSum(), data.taskItem, checksumMismatch);
+    if (data.taskItem.value(TaskRole::Revalidate).toBool()) {
+        // report the validators, so that the next request for the file can be a conditional one
+        result.insert(TaskRole::EntityTag, reply->rawHeader("ETag"));
+        result.insert(TaskRole::LastModified, reply->rawHeader("Last-Modified"));
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+            result.insert(TaskRole::NotModified, true);
+    }
+    // the time until the server answered, redirects included, but not the transfer of the file
+    if (reply->error() == QNetworkReply::NoError) {
+        result.insert(TaskRole::ElapsedTime, data.headersElapsed < 0 ? data.timer.elapsed()
+            : data.headersElapsed);
+    }
+    m_futureInterface->reportResult(result);
 
     m_downloads.erase(reply);
     m_redirects.remove(reply);
@@ -293,6 +307,16 @@ void Downloader::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
     }
 }
 
+void Downloader::onMetaDataChanged()
+{
+    QNetworkReply *const reply = qobject_cast<QNetworkReply *>(sender());
+    if (reply && m_downloads.find(reply) != m_downloads.cend()) {
+        Data &data = *m_downloads[reply];
+        if (data.headersElapsed < 0)
+            data.headersElapsed = data.timer.elapsed();
+    }
+}
+
 void Downloader::onAuthenticationRequired(QNetworkReply *reply, QAuthenticator *authenticator)
 {
     if (!authenticator || !reply || m_downloads.find(reply) == m_downloads.cend())
@@ -371,8 +395,23 @@ QNetworkReply *Downloader::startDownload(const FileTaskItem &item)
         return 0;
     }
 
-    QNetworkReply *reply = m_nam.get(QNetworkRequest(source));
+    QNetworkRequest request(source);
+    const bool headersOnly = item.value(TaskRole::HeadersOnly).toBool();
+    if (item.value(TaskRole::Revalidate).toBool() || headersOnly) {
+        // Make caches on the way check with the server instead of serving a stale copy. If we
+        // still have the file, the server answers 304 Not Modified when it did not change.
+        request.setRawHeader("Cache-Control", "no-cache");
+        request.setRawHeader("Pragma", "no-cache");
+        const QByteArray entityTag = item.value(TaskRole::EntityTag).toByteArray();
+        if (!entityTag.isEmpty())
+            request.setRawHeader("If-None-Match", entityTag);
+        const QByteArray lastModified = item.value(TaskRole::LastModified).toByteArray();
+        if (!lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", lastModified);
+    }
+    QNetworkReply *reply = headersOnly ? m_nam.head(request) : m_nam.get(request);
     std::unique_ptr<Data> data(new Data(item));
+    data->timer.start();
     m_downloads[reply] = std::move(data);
 
     connect(reply, &QIODevice::readyRead, this, &Downloader::onReadyRead);
@@ -382,6 +421,7 @@ QNetworkReply *Downloader::startDownload(const FileTaskItem &item)
     connect(reply, &QNetworkReply::sslErrors, this, &Downloader::onSslErrors);
 #endif
     connect(reply, &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgress);
+    connect(reply, &QNetworkReply::metaDataChanged, this, &Downloader::onMetaDataChanged);
     return reply;
 }
 
@@ -40,7 +40,13 @@ namespace QInstaller {
 namespace TaskRole {
 enum
 {
-    Authenticator = TaskRole::TargetFile + 10
+    Authenticator = TaskRole::TargetFile + 10,
+    EntityTag,
+    LastModified,
+    NotModified,
+    Revalidate,
+    ElapsedTime,
+    HeadersOnly
 };
 }
 
@@ -32,6 +32,7 @@
 #include "downloadfiletask.h"
 #include <observer.h>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -54,17 +55,21 @@ struct Data
     Data()
         : file(Q_NULLPTR)
         , observer(Q_NULLPTR)
+        , headersElapsed(-1)
     {}
 
     Data(const FileTaskItem &fti)
         : taskItem(fti)
         , file(Q_NULLPTR)
         , observer(new FileTaskObserver(QCryptographicHash::Sha1))
+        , headersElapsed(-1)
     {}
 
     FileTaskItem taskItem;
     std::unique_ptr<QFile> file;
     std::unique_ptr<FileTaskObserver> observer;
+    QElapsedTimer timer;
+    qint64 headersElapsed;
 };
 
 class Downloader : public QObject
@@ -89,6 +94,7 @@ private slots:
     void onError(QNetworkReply::NetworkError error);
     void onSslErrors(const QList<QSslError> &sslErrors);
     void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void onMetaDataChanged();
     void onAuthenticationRequired(QNetworkReply *reply, QAuthenticator *authenticator);
     void onProxyAuthenticationRequired(const QNetworkProxy &proxy, QAuthenticator *authenticator);
     void onTimeout();
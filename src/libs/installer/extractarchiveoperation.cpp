@@ -28,12 +28,16 @@
 
 #include "extractarchiveoperation_p.h"
 
+#include "archivefilelist.h"
 #include "constants.h"
+#include "operationexecutor.h"
 
+#include <QtConcurrentRun>
 #include <QEventLoop>
-#include <QThreadPool>
 #include <QFileInfo>
-#include <QDataStream>
+#include <QScopedPointer>
+
+#include <algorithm>
 
 namespace QInstaller {
 
@@ -57,32 +61,6 @@ bool ExtractArchiveOperation::performOperation()
     const QString archivePath = args.at(0);
     const QString targetDir = args.at(1);
 
-    Receiver receiver;
-    Callback callback;
-
-    connect(&callback, &Callback::progressChanged, this, &ExtractArchiveOperation::progressChanged);
-
-    if (PackageManagerCore *core = packageManager()) {
-        connect(core, &PackageManagerCore::statusChanged, &callback, &Callback::statusChanged);
-    }
-
-    Runnable *runnable = new Runnable(archivePath, targetDir, &callback);
-    connect(runnable, &Runnable::finished, &receiver, &Receiver::runnableFinished,
-        Qt::QueuedConnection);
-
-    QFileInfo fileInfo(archivePath);
-    emit outputTextChanged(tr("Extracting \"%1\"").arg(fileInfo.fileName()));
-
-    QEventLoop loop;
-    connect(&receiver, &Receiver::finished, &loop, &QEventLoop::quit);
-    if (QThreadPool::globalInstance()->tryStart(runnable)) {
-        loop.exec();
-    } else {
-        // HACK: In case there is no availabe thread we should call it directly.
-        runnable->run();
-        receiver.runnableFinished(true, QString());
-    }
-
     // Write all file names which belongs to a package to a separate file and only the separate
     // filename to a .dat file. There can be enormous amount of files in a package, which makes
     // the dat file very slow to read and write. The .dat file is read into memory in startup,
@@ -93,8 +71,7 @@ bool ExtractArchiveOperation::performOperation()
     // -installerResources (dir)
     //   -<component_name> (dir)
     //    -<filename>.txt (file)
-
-    QStringList files = callback.extractedFiles();
+    // The file names are written while the archive is extracted, see ArchiveFileListWriter.
 
     QString fileDirectory = targetDir + QLatin1String("/installerResources/") +
             archivePath.section(QLatin1Char('/'), 1, 1, QString::SectionSkipEmpty) + QLatin1Char('/');
@@ -110,18 +87,47 @@ bool ExtractArchiveOperation::performOperation()
     if (!dir.exists()) {
         dir.mkpath(targetDirectoryInfo.absolutePath());
     }
-    QFile file(targetDirectoryInfo.absolutePath() + QLatin1Char('/') + fileName);
-    if (file.open(QIODevice::WriteOnly)) {
-        setDefaultFilePermissions(file.fileName(), DefaultFilePermissions::NonExecutable);
-        QDataStream out (&file);
-        for (int i = 0; i < files.count(); ++i) {
-            files[i] = replacePath(files.at(i), targetDir, QLatin1String(scRelocatable));
-        }
-        out << files;
-        setValue(QLatin1String("files"), file.fileName());
-        file.close();
+    ArchiveFileListWriter fileList(targetDir);
+    if (fileList.open(targetDirectoryInfo.absolutePath() + QLatin1Char('/') + fileName)) {
+        setDefaultFilePermissions(fileList.fileName(), DefaultFilePermissions::NonExecutable);
     } else {
-        qWarning() << "Cannot open file for writing " << file.fileName() << ":" << file.errorString();
+        qWarning() << "Cannot open file for writing " << fileList.fileName() << ":"
+            << fileList.errorString();
+    }
+
+    Receiver receiver;
+    Callback callback(&fileList);
+
+    connect(&callback, &Callback::progressChanged, this, &ExtractArchiveOperation::progressChanged);
+
+    if (PackageManagerCore *core = packageManager()) {
+        // the extraction might run in a thread without event loop
+        connect(core, &PackageManagerCore::statusChanged, &callback, &Callback::statusChanged,
+            Qt::DirectConnection);
+    }
+
+    Runnable runnable(archivePath, targetDir, &callback);
+    connect(&runnable, &Runnable::finished, &receiver, &Receiver::runnableFinished,
+        Qt::DirectConnection);
+
+    QFileInfo fileInfo(archivePath);
+    emit outputTextChanged(tr("Extracting \"%1\"").arg(fileInfo.fileName()));
+
+    if (OperationExecutor::isGuiThread()) {
+        OperationExecutor::waitForFinished(OperationExecutor::run([&runnable]() {
+            runnable.run();
+        }));
+    } else {
+        // already running in the background, no need to hand the archive over to another thread
+        runnable.run();
+    }
+
+    if (fileList.isOpen()) {
+        if (!fileList.close()) {
+            qWarning() << "Cannot write file " << fileList.fileName() << ":"
+                << fileList.errorString();
+        }
+        setValue(QLatin1String("files"), fileList.fileName());
     }
 
     // TODO: Use backups for rollback, too? Doesn't work for uninstallation though.
@@ -140,41 +146,50 @@ bool ExtractArchiveOperation::performOperation()
 
 bool ExtractArchiveOperation::undoOperation()
 {
-    Q_ASSERT(arguments().count() == 2);
-
-    // For backward compatibility, check if "files" can be converted to QStringList.
-    // If yes, files are listed in .dat instead of in a separate file.
-    bool useStringListType(value(QLatin1String("files")).type() == QVariant::StringList);
-    QString targetDir = arguments().at(1);
-    QStringList files;
-    if (useStringListType) {
-        files = value(QLatin1String("files")).toStringList();
+    return undoOperations(QList<ExtractArchiveOperation *>() << this);
+}
+
+/*!
+    Removes the files extracted by \a operations at once. The files of all archives are removed in
+    parallel, and their directories only afterwards, deepest first, so that a directory shared by
+    several archives is removed together with the last of its files. Files that cannot be removed
+    right now are registered for delayed deletion with the operation that extracted them.
+*/
+bool ExtractArchiveOperation::undoOperations(const QList<ExtractArchiveOperation *> &operations)
+{
+    if (operations.isEmpty())
+        return true;
+
+    WorkerThread *const thread = new WorkerThread(operations);
+    connect(thread, &WorkerThread::currentFileChanged, operations.first(),
+        [operations](int operation, const QString &filename) {
+            emit operations.at(operation)->outputTextChanged(filename);
+        });
+    connect(thread, &WorkerThread::progressChanged, operations.first(),
+        [operations](int operation, double progress) {
+            emit operations.at(operation)->progressChanged(progress);
+        });
+
+    if (OperationExecutor::isGuiThread()) {
+        QEventLoop loop;
+        connect(thread, &QThread::finished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+        thread->start();
+        loop.exec();
+        thread->deleteLater();
     } else {
-        if (!readDataFileContents(targetDir, &files))
-            return false;
+        thread->start();
+        thread->wait();
+        delete thread;
     }
-    startUndoProcess(files);
-    if (!useStringListType)
-        deleteDataFile(m_relocatedDataFileName);
 
+    foreach (ExtractArchiveOperation *operation, operations) {
+        // For backward compatibility, files might be listed in .dat instead of in a separate file.
+        if (operation->value(QLatin1String("files")).type() != QVariant::StringList)
+            operation->deleteDataFile(operation->m_relocatedDataFileName);
+    }
     return true;
 }
 
-void ExtractArchiveOperation::startUndoProcess(const QStringList &files)
-{
-    WorkerThread *const thread = new WorkerThread(this, files);
-    connect(thread, &WorkerThread::currentFileChanged, this,
-        &ExtractArchiveOperation::outputTextChanged);
-    connect(thread, &WorkerThread::progressChanged, this,
-        &ExtractArchiveOperation::progressChanged);
-
-    QEventLoop loop;
-    connect(thread, &QThread::finished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
-    thread->start();
-    loop.exec();
-    thread->deleteLater();
-}
-
 void ExtractArchiveOperation::deleteDataFile(const QString &fileName)
 {
     if (fileName.isEmpty()) {
@@ -198,28 +213,141 @@ bool ExtractArchiveOperation::testOperation()
 }
 
 bool ExtractArchiveOperation::readDataFileContents(QString &targetDir, QStringList *resultList)
+{
+    QScopedPointer<ArchiveFileListReader> reader(openDataFile(targetDir));
+    if (reader) {
+        QString path;
+        while (reader->next(&path))
+            resultList->append(path);
+    }
+    return true;
+}
+
+/*!
+    Returns a reader for the list of extracted files, relocated to \a targetDir, or \c nullptr if
+    the list cannot be opened. The caller takes ownership of the reader.
+*/
+ArchiveFileListReader *ExtractArchiveOperation::openDataFile(QString &targetDir)
 {
     const QString filePath = value(QLatin1String("files")).toString();
     // Does not change target on non macOS platforms.
     if (QInstaller::isInBundle(targetDir, &targetDir))
         targetDir = QDir::cleanPath(targetDir + QLatin1String("/.."));
     m_relocatedDataFileName = replacePath(filePath, QLatin1String(scRelocatable), targetDir);
-    QFile file(m_relocatedDataFileName);
 
-    if (file.open(QIODevice::ReadOnly)) {
-        QDataStream in(&file);
-        in >> *resultList;
-        for (int i = 0; i < resultList->count(); ++i)
-            resultList->replace(i, replacePath(resultList->at(i),  QLatin1String(scRelocatable), targetDir));
-
-    } else {
+    QScopedPointer<ArchiveFileListReader> reader(new ArchiveFileListReader(targetDir));
+    if (!reader->open(m_relocatedDataFileName)) {
         // We should not be here. Either user has manually deleted the installer related
         // files or same component is installed several times.
-        qWarning() << "Cannot open file " << file.fileName() << " for reading:"
-                << file.errorString() << ". Component is already uninstalled "
+        qWarning() << "Cannot open file " << m_relocatedDataFileName << " for reading:"
+                << reader->errorString() << ". Component is already uninstalled "
                 << "or file is manually deleted.";
+        return nullptr;
+    }
+    return reader.take();
+}
+
+void WorkerThread::run()
+{
+    static const int ChunkSize = 256;
+
+    m_totalCount.fill(0, m_operations.count());
+    m_removedCount.fill(0, m_operations.count());
+    m_reportedPercentage.fill(0, m_operations.count());
+
+    // The file lists are read one chunk at a time and only a few chunks are in flight, so the
+    // memory used does not depend on the number of files.
+    Chunk chunk;
+    for (int i = 0; i < m_operations.count(); ++i) {
+        ExtractArchiveOperation *const operation = m_operations.at(i);
+        Q_ASSERT(operation->arguments().count() == 2);
+
+        // For backward compatibility, check if "files" can be converted to QStringList.
+        // If yes, files are listed in .dat instead of in a separate file.
+        if (operation->value(QLatin1String("files")).type() == QVariant::StringList) {
+            const QStringList files = operation->value(QLatin1String("files")).toStringList();
+            m_totalCount[i] = files.count();
+            foreach (const QString &file, files) {
+                chunk.append({ file, i });
+                if (chunk.count() == ChunkSize)
+                    scheduleChunk(&chunk);
+            }
+        } else {
+            QString targetDir = operation->arguments().at(1);
+            QScopedPointer<ArchiveFileListReader> reader(operation->openDataFile(targetDir));
+            if (!reader)
+                continue;
+            m_totalCount[i] = reader->count();
+            QString file;
+            while (reader->next(&file)) {
+                chunk.append({ file, i });
+                if (chunk.count() == ChunkSize)
+                    scheduleChunk(&chunk);
+            }
+        }
+    }
+    scheduleChunk(&chunk);
+    foreach (const QFuture<void> &future, m_chunks)
+        future.waitForFinished();
+    m_chunks.clear();
+
+    // remove the directories bottom-up, once all files in them are gone
+    m_directories.removeDuplicates();
+    std::sort(m_directories.begin(), m_directories.end(), [](const QString &lhs, const QString &rhs) {
+        const int lhsDepth = lhs.count(QLatin1Char('/')) + lhs.count(QLatin1Char('\\'));
+        const int rhsDepth = rhs.count(QLatin1Char('/')) + rhs.count(QLatin1Char('\\'));
+        return lhsDepth != rhsDepth ? lhsDepth > rhsDepth : lhs < rhs;
+    });
+    foreach (const QString &directory, m_directories) {
+        removeSystemGeneratedFiles(directory);
+        QDir().rmdir(directory); // directory may not exist
+    }
+
+    for (int i = 0; i < m_operations.count(); ++i)
+        emit progressChanged(i, 1.0);
+}
+
+void WorkerThread::scheduleChunk(Chunk *chunk)
+{
+    if (chunk->isEmpty())
+        return;
+
+    if (m_chunks.count() >= 2 * m_pool.maxThreadCount())
+        m_chunks.takeFirst().waitForFinished();
+
+    const Chunk entries = *chunk;
+    m_chunks.append(QtConcurrent::run(&m_pool, [this, entries]() { removeChunk(entries); }));
+    chunk->clear();
+}
+
+void WorkerThread::removeChunk(const Chunk &chunk)
+{
+    QStringList directories;
+    foreach (const Entry &entry, chunk) {
+        const QFileInfo fi(entry.path);
+        if (fi.isFile() || fi.isSymLink()) {
+            if (!QFile::remove(entry.path) && QFile::exists(entry.path)) {
+                // the file is locked, move it away and delete it later
+                QMutexLocker locker(&m_mutex);
+                m_operations.at(entry.operation)->deleteFileNowOrLater(fi.absoluteFilePath());
+            }
+        } else if (fi.isDir()) {
+            directories.append(entry.path);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_directories.append(directories);
+    foreach (const Entry &entry, chunk) {
+        const int percentage = (++m_removedCount[entry.operation] * 100)
+            / qMax(1, m_totalCount.at(entry.operation));
+        // report at most one hundred steps per operation
+        if (percentage > m_reportedPercentage.at(entry.operation)) {
+            m_reportedPercentage[entry.operation] = percentage;
+            emit currentFileChanged(entry.operation, QDir::toNativeSeparators(entry.path));
+            emit progressChanged(entry.operation, percentage / 100.0);
+        }
     }
-    return true;
 }
 
 } // namespace QInstaller
@@ -35,6 +35,8 @@
 
 namespace QInstaller {
 
+class ArchiveFileListReader;
+
 class INSTALLER_EXPORT ExtractArchiveOperation : public QObject, public Operation
 {
     Q_OBJECT
@@ -49,13 +51,14 @@ public:
     bool testOperation();
 
     bool readDataFileContents(QString &targetDir, QStringList *resultList);
+    static bool undoOperations(const QList<ExtractArchiveOperation *> &operations);
 
 Q_SIGNALS:
     void outputTextChanged(const QString &progress);
     void progressChanged(double);
 
 private:
-    void startUndoProcess(const QStringList &files);
+    ArchiveFileListReader *openDataFile(QString &targetDir);
     void deleteDataFile(const QString &fileName);
 
 private:
@@ -30,13 +30,18 @@
 
 #include "extractarchiveoperation.h"
 
+#include "archivefilelist.h"
 #include "fileutils.h"
 #include "lib7z_extract.h"
 #include "lib7z_facade.h"
 #include "packagemanagercore.h"
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QFuture>
 #include <QRunnable>
 #include <QThread>
+#include <QThreadPool>
 
 namespace QInstaller {
 
@@ -46,40 +51,38 @@ class WorkerThread : public QThread
     Q_DISABLE_COPY(WorkerThread)
 
 public:
-    WorkerThread(ExtractArchiveOperation *op, const QStringList &files)
-        : m_files(files)
-        , m_op(op)
+    explicit WorkerThread(const QList<ExtractArchiveOperation *> &operations)
+        : m_operations(operations)
     {
         setObjectName(QLatin1String("ExtractArchive"));
     }
 
-    void run()
-    {
-        Q_ASSERT(m_op != 0);
-
-        int removedCounter = 0;
-        foreach (const QString &file, m_files) {
-            removedCounter++;
-
-            const QFileInfo fi(file);
-            emit currentFileChanged(QDir::toNativeSeparators(file));
-            emit progressChanged(double(removedCounter) / m_files.count());
-            if (fi.isFile() || fi.isSymLink()) {
-                m_op->deleteFileNowOrLater(fi.absoluteFilePath());
-            } else if (fi.isDir()) {
-                removeSystemGeneratedFiles(file);
-                fi.dir().rmdir(file); // directory may not exist
-            }
-        }
-    }
+    void run();
 
 signals:
-    void currentFileChanged(const QString &filename);
-    void progressChanged(double);
+    void currentFileChanged(int operation, const QString &filename);
+    void progressChanged(int operation, double);
 
 private:
-    QStringList m_files;
-    ExtractArchiveOperation *m_op;
+    struct Entry
+    {
+        QString path;
+        int operation;
+    };
+    typedef QVector<Entry> Chunk;
+
+    void scheduleChunk(Chunk *chunk);
+    void removeChunk(const Chunk &chunk);
+
+private:
+    QList<ExtractArchiveOperation *> m_operations;
+    QThreadPool m_pool;
+    QList<QFuture<void> > m_chunks;
+    QVector<int> m_totalCount;
+    QVector<int> m_removedCount;
+    QVector<int> m_reportedPercentage;
+    QStringList m_directories;
+    QMutex m_mutex;
 };
 
 typedef QPair<QString, QString> Backup;
@@ -91,25 +94,23 @@ class ExtractArchiveOperation::Callback : public QObject, public Lib7z::ExtractC
     Q_DISABLE_COPY(Callback)
 
 public:
-    Callback() = default;
+    explicit Callback(ArchiveFileListWriter *fileList)
+        : m_fileList(fileList)
+    {}
 
     BackupFiles backupFiles() const {
         return m_backupFiles;
     }
 
-    QStringList extractedFiles() const {
-        return m_extractedFiles;
-    }
-
 public slots:
     void statusChanged(QInstaller::PackageManagerCore::Status status)
     {
         switch(status) {
             case PackageManagerCore::Canceled:
-                m_state = E_ABORT;
+                m_state.storeRelease(int(E_ABORT));
                 break;
             case PackageManagerCore::Failure:
-                m_state = E_FAIL;
+                m_state.storeRelease(int(E_FAIL));
                 break;
             default:    // ignore all other status values
                 break;
@@ -122,7 +123,7 @@ signals:
 private:
     void setCurrentFile(const QString &filename) Q_DECL_OVERRIDE
     {
-        m_extractedFiles.prepend(QDir::toNativeSeparators(filename));
+        m_fileList->append(filename);
     }
 
     static QString generateBackupName(const QString &fn)
@@ -154,13 +155,13 @@ private:
     HRESULT setCompleted(quint64 completed, quint64 total) Q_DECL_OVERRIDE
     {
         emit progressChanged(double(completed) / total);
-        return m_state;
+        return HRESULT(m_state.loadAcquire());
     }
 
 private:
-    HRESULT m_state = S_OK;
+    QAtomicInt m_state { int(S_OK) };
     BackupFiles m_backupFiles;
-    QStringList m_extractedFiles;
+    ArchiveFileListWriter *m_fileList;
 };
 
 class ExtractArchiveOperation::Runnable : public QObject, public QRunnable
@@ -28,11 +28,11 @@
 #include "fileutils.h"
 
 #include <errors.h>
+#include "operationexecutor.h"
 
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
-#include <QtCore/QEventLoop>
 #include <QtCore/QTemporaryFile>
 #include <QtCore/QThread>
 #include <QtCore/QUrl>
@@ -236,50 +236,19 @@ void QInstaller::removeDirectory(const QString &path, bool ignoreErrors)
     }
 }
 
-class RemoveDirectoryThread : public QThread
+void QInstaller::removeDirectoryThreaded(const QString &path, bool ignoreErrors)
 {
-public:
-    explicit RemoveDirectoryThread(const QString &path, bool ignoreErrors = false, QObject *parent = nullptr)
-        : QThread(parent)
-        , p(path)
-        , ignore(ignoreErrors)
-    {
-        setObjectName(QLatin1String("RemoveDirectory"));
-    }
-
-    const QString &error() const
-    {
-        return err;
-    }
-
-protected:
-    /*!
-     \reimp
-     */
-    void run()
-    {
+    const QFuture<QString> future = OperationExecutor::run([path, ignoreErrors]() -> QString {
         try {
-            removeDirectory(p, ignore);
+            removeDirectory(path, ignoreErrors);
         } catch (const Error &e) {
-            err = e.message();
+            return e.message();
         }
-    }
-
-private:
-    QString err;
-    const QString p;
-    const bool ignore;
-};
-
-void QInstaller::removeDirectoryThreaded(const QString &path, bool ignoreErrors)
-{
-    RemoveDirectoryThread thread(path, ignoreErrors);
-    QEventLoop loop;
-    QObject::connect(&thread, &RemoveDirectoryThread::finished, &loop, &QEventLoop::quit);
-    thread.start();
-    loop.exec();
-    if (!thread.error().isEmpty())
-        throw Error(thread.error());
+        return QString();
+    });
+    OperationExecutor::waitForFinished(future);
+    if (!future.result().isEmpty())
+        throw Error(future.result());
 }
 
 void QInstaller::removeSystemGeneratedFiles(const QString &path)
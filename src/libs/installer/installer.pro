@@ -60,8 +60,15 @@ HEADERS += packagemanagercore.h \
     linereplaceoperation.h \
     copydirectoryoperation.h \
     simplemovefileoperation.h \
+    archivecache.h \
+    archivedelta.h \
+    metadatacache.h \
+    mirrorhealth.h \
+    archivefilelist.h \
     extractarchiveoperation.h \
     extractarchiveoperation_p.h \
+    operationscheduler.h \
+    operationexecutor.h \
     globalsettingsoperation.h \
     createshortcutoperation.h \
     createdesktopentryoperation.h \
@@ -156,7 +163,14 @@ SOURCES += packagemanagercore.cpp \
     linereplaceoperation.cpp \
     copydirectoryoperation.cpp \
     simplemovefileoperation.cpp \
+    archivecache.cpp \
+    archivedelta.cpp \
+    metadatacache.cpp \
+    mirrorhealth.cpp \
+    archivefilelist.cpp \
     extractarchiveoperation.cpp \
+    operationscheduler.cpp \
+    operationexecutor.cpp \
     globalsettingsoperation.cpp \
     createshortcutoperation.cpp \
     createdesktopentryoperation.cpp \
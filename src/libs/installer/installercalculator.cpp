@@ -38,6 +38,7 @@ namespace QInstaller {
 
 InstallerCalculator::InstallerCalculator(const QList<Component *> &allComponents)
     : m_allComponents(allComponents)
+    , m_allComponentsByName(PackageManagerCore::componentIndex(allComponents))
 {
 }
 
@@ -88,6 +89,20 @@ QList<Component*> InstallerCalculator::orderedComponentsToInstall() const
     return m_orderedComponentsToInstall;
 }
 
+QList<Component*> InstallerCalculator::dependenciesToInstall(Component *component) const
+{
+    QList<Component*> dependencies;
+    foreach (const QString &name, component->dependencies() + component->autoDependencies()) {
+        Component *const dependency = PackageManagerCore::componentByName(name,
+            m_allComponentsByName);
+        if (dependency && m_toInstallComponentIds.contains(dependency->name())
+                && !dependencies.contains(dependency)) {
+            dependencies.append(dependency);
+        }
+    }
+    return dependencies;
+}
+
 QString InstallerCalculator::componentsToInstallError() const
 {
     return m_componentsToInstallError;
@@ -163,7 +178,7 @@ bool InstallerCalculator::appendComponentToInstall(Component *component, const Q
         // PackageManagerCore::componentByName returns 0 if dependencyComponentName contains a
         // version which is not available
         Component *dependencyComponent =
-            PackageManagerCore::componentByName(dependencyComponentName, m_allComponents);
+            PackageManagerCore::componentByName(dependencyComponentName, m_allComponentsByName);
         if (!dependencyComponent) {
             const QString errorMessage = QCoreApplication::translate("InstallerCalculator",
                 "Cannot find missing dependency \"%1\" for \"%2\".").arg(dependencyComponentName,
@@ -56,6 +56,7 @@ public:
     QString installReasonReferencedComponent(Component *component) const;
     QString installReason(Component *component) const;
     QList<Component*> orderedComponentsToInstall() const;
+    QList<Component*> dependenciesToInstall(Component *component) const;
     QString componentsToInstallError() const;
 
     bool appendComponentsToInstall(const QList<Component*> &components);
@@ -69,6 +70,7 @@ private:
     QString recursionError(Component *component);
 
     QList<Component*> m_allComponents;
+    QHash<QString, QList<Component *> > m_allComponentsByName;
     QHash<Component*, QSet<Component*> > m_visitedComponents;
     QHash<QString, Component *> m_toInstallComponentIds; //for faster lookups
     QString m_componentsToInstallError;
@@ -31,11 +31,17 @@
 #include <QScrollBar>
 
 const int INTERVAL = 20;
+// Upper limit for the lines shown and for the lines cached while the widget is hidden, so that
+// the cost of the widget does not depend on how much output an installation produces.
+const int MAXIMUM_LINE_COUNT = 10000;
 
 LazyPlainTextEdit::LazyPlainTextEdit(QWidget *parent)
     : QPlainTextEdit(parent)
     , m_timerId(0)
+    , m_droppedLineCount(0)
+    , m_cachedOutput(MAXIMUM_LINE_COUNT)
 {
+    setMaximumBlockCount(MAXIMUM_LINE_COUNT);
 }
 
 void LazyPlainTextEdit::timerEvent(QTimerEvent *event)
@@ -43,19 +49,30 @@ void LazyPlainTextEdit::timerEvent(QTimerEvent *event)
     if (event->timerId() == m_timerId) {
         killTimer(m_timerId);
         m_timerId = 0;
-        m_cachedOutput.chop(1); //removes the last \n
-        if (!m_cachedOutput.isEmpty()) {
-            appendPlainText(m_cachedOutput);
-            updateCursor(TextCursorPosition::Keep);
-            horizontalScrollBar()->setValue(0);
-            m_cachedOutput.clear();
+        if (m_cachedOutput.isEmpty())
+            return;
+
+        QStringList lines;
+        lines.reserve(m_cachedOutput.count() + 1);
+        if (m_droppedLineCount > 0) {
+            lines.append(tr("[%n line(s) of output omitted]", nullptr, m_droppedLineCount));
+            m_droppedLineCount = 0;
         }
+        while (!m_cachedOutput.isEmpty())
+            lines.append(m_cachedOutput.takeFirst());
+
+        appendPlainText(lines.join(QLatin1Char('\n')));
+        updateCursor(TextCursorPosition::Keep);
+        horizontalScrollBar()->setValue(0);
     }
 }
 
 void LazyPlainTextEdit::append(const QString &text)
 {
-    m_cachedOutput.append(text + QLatin1String("\n"));
+    // keep only the most recent lines, the older ones would be scrolled out of the document anyway
+    if (m_cachedOutput.isFull())
+        ++m_droppedLineCount;
+    m_cachedOutput.append(text);
     if (isVisible() && m_timerId == 0)
         m_timerId = startTimer(INTERVAL);
 }
@@ -65,8 +82,9 @@ void LazyPlainTextEdit::clear()
     if (m_timerId) {
         killTimer(m_timerId);
         m_timerId = 0;
-        m_cachedOutput.clear();
     }
+    m_cachedOutput.clear();
+    m_droppedLineCount = 0;
     QPlainTextEdit::clear();
 }
 
@@ -29,6 +29,7 @@
 #ifndef LAZYPLAINTEXTEDIT_H
 #define LAZYPLAINTEXTEDIT_H
 
+#include <QContiguousCache>
 #include <QPlainTextEdit>
 
 class LazyPlainTextEdit : public QPlainTextEdit
@@ -50,7 +51,8 @@ protected:
     void timerEvent(QTimerEvent *event);
 private:
     int m_timerId;
-    QString m_cachedOutput;
+    int m_droppedLineCount;
+    QContiguousCache<QString> m_cachedOutput;
 };
 
 #endif // LAZYPLAINTEXTEDIT_H
@@ -0,0 +1,274 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "metadatacache.h"
+
+#include "archivecache.h"
+#include "constants.h"
+#include "fileutils.h"
+#include "lib7z_extract.h"
+#include "packagemanagercore.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QTemporaryDir>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::MetadataCache
+    \inmodule QtInstallerFramework
+    \brief The MetadataCache class stores repository meta data between runs of the installer and
+        maintenance tool.
+
+    The \c Updates.xml file of a repository is stored together with the \c ETag and
+    \c Last-Modified validators the server sent for it, keyed by the URL it was fetched from. The
+    next fetch sends them as a conditional request, and an unchanged file is answered with
+    \c {304 Not Modified} instead of being transferred again.
+
+    The contents of meta data archives are stored extracted, keyed by the SHA-1 checksum of the
+    archive, so that the meta data of unchanged packages does not need to be extracted again. An
+    extracted entry is only kept as long as the archive itself is in the ArchiveCache, see prune().
+*/
+
+static const char scEntityTagField[] = "ETag";
+static const char scLastModifiedField[] = "Last-Modified";
+
+/*!
+    Creates a disabled cache.
+*/
+MetadataCache::MetadataCache()
+{
+}
+
+/*!
+    Creates a cache storing its entries in \a path.
+*/
+MetadataCache::MetadataCache(const QString &path)
+    : m_path(path)
+{
+}
+
+/*!
+    Returns the meta data cache configured for \a core by the \c LocalCachePath value. The cache is
+    disabled if no local cache path is set.
+*/
+MetadataCache MetadataCache::fromCore(PackageManagerCore *core)
+{
+    const QString cachePath = core->value(scLocalCachePath);
+    if (cachePath.isEmpty())
+        return MetadataCache();
+    return MetadataCache(QDir(cachePath).filePath(QLatin1String("metadata")));
+}
+
+/*!
+    Returns \c true if the cache has a directory to store its entries in.
+*/
+bool MetadataCache::isEnabled() const
+{
+    return !m_path.isEmpty();
+}
+
+/*!
+    Returns the directory of the cache entries.
+*/
+QString MetadataCache::path() const
+{
+    return m_path;
+}
+
+/*!
+    Returns the file name of the \c Updates.xml file stored for \a url, or an empty string if there
+    is none. The validators stored with the file are written to \a entityTag and \a lastModified,
+    if given.
+*/
+QString MetadataCache::updatesXml(const QString &url, QByteArray *entityTag,
+    QByteArray *lastModified) const
+{
+    if (!isEnabled())
+        return QString();
+
+    const QString directory = repositoryPath(url);
+    QFile validators(directory + QLatin1String("/validators"));
+    if (!validators.open(QIODevice::ReadOnly))
+        return QString();
+
+    QByteArray tag;
+    QByteArray modified;
+    foreach (const QByteArray &line, validators.readAll().split('\n')) {
+        const int colon = line.indexOf(':');
+        if (colon < 0)
+            continue;
+        const QByteArray field = line.left(colon).trimmed();
+        if (field == scEntityTagField)
+            tag = line.mid(colon + 1).trimmed();
+        else if (field == scLastModifiedField)
+            modified = line.mid(colon + 1).trimmed();
+    }
+
+    const QString fileName = directory + QLatin1String("/Updates.xml");
+    if ((tag.isEmpty() && modified.isEmpty()) || !QFileInfo(fileName).isFile())
+        return QString();
+
+    if (entityTag)
+        *entityTag = tag;
+    if (lastModified)
+        *lastModified = modified;
+    return fileName;
+}
+
+/*!
+    Stores a copy of the \c Updates.xml file \a fileName fetched from \a url, together with the
+    validators \a entityTag and \a lastModified the server sent for it. If the server sent neither,
+    a file stored earlier for \a url is removed, as it cannot be revalidated. Returns \c true if the
+    file was stored.
+*/
+bool MetadataCache::insertUpdatesXml(const QString &url, const QString &fileName,
+    const QByteArray &entityTag, const QByteArray &lastModified)
+{
+    if (!isEnabled())
+        return false;
+
+    const QString directory = repositoryPath(url);
+    // Drop the validators first, so that a failure below or another process reading the entry
+    // meanwhile never pairs them with a file they were not sent for.
+    const QString validatorsName = directory + QLatin1String("/validators");
+    if (QFileInfo(validatorsName).exists() && !QFile::remove(validatorsName)) {
+        qWarning() << "Cannot remove" << validatorsName << "from the meta data cache.";
+        return false;
+    }
+    if (entityTag.isEmpty() && lastModified.isEmpty())
+        return false;
+
+    QFile source(fileName);
+    if (!QDir().mkpath(directory) || !source.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot insert" << fileName << "into the meta data cache" << m_path;
+        return false;
+    }
+
+    QSaveFile file(directory + QLatin1String("/Updates.xml"));
+    const QByteArray data = source.readAll();
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Cannot insert" << fileName << "into the meta data cache:"
+            << file.errorString();
+        return false;
+    }
+
+    QByteArray fields;
+    if (!entityTag.isEmpty())
+        fields += scEntityTagField + QByteArray(": ") + entityTag + '\n';
+    if (!lastModified.isEmpty())
+        fields += scLastModifiedField + QByteArray(": ") + lastModified + '\n';
+
+    QSaveFile validators(validatorsName);
+    if (!validators.open(QIODevice::WriteOnly) || validators.write(fields) != fields.size()
+            || !validators.commit()) {
+        qWarning() << "Cannot insert" << validatorsName << "into the meta data cache:"
+            << validators.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    Returns the directory holding the extracted contents of the meta data archive with the checksum
+    \a sha1, or an empty string if it is not in the cache.
+*/
+QString MetadataCache::extractedMetadata(const QByteArray &sha1) const
+{
+    const QByteArray key = ArchiveCache::normalizedKey(sha1);
+    if (!isEnabled() || key.isEmpty())
+        return QString();
+
+    const QString directory = packagesPath() + QLatin1Char('/') + QString::fromLatin1(key);
+    return QFileInfo(directory).isDir() ? directory : QString();
+}
+
+/*!
+    Extracts the meta data archive \a archive with the checksum \a sha1 into the cache and returns
+    the directory holding its contents, or an empty string if the cache could not store it. Throws
+    Lib7z::SevenZipException if the archive cannot be extracted.
+*/
+QString MetadataCache::extractMetadata(const QByteArray &sha1, QFileDevice *archive)
+{
+    const QByteArray key = ArchiveCache::normalizedKey(sha1);
+    if (!isEnabled() || key.isEmpty() || !QDir().mkpath(packagesPath()))
+        return QString();
+
+    const QString target = packagesPath() + QLatin1Char('/') + QString::fromLatin1(key);
+    if (QFileInfo(target).isDir())
+        return target;
+
+    // Extract next to the entry and rename the directory once it is complete, so that other
+    // processes never see a partially extracted entry.
+    QTemporaryDir staging(target + QLatin1String(".XXXXXX"));
+    if (!staging.isValid())
+        return QString();
+
+    Lib7z::extractArchive(archive, staging.path());
+    if (QDir().rename(staging.path(), target)) {
+        staging.setAutoRemove(false);
+        return target;
+    }
+    return QFileInfo(target).isDir() ? target : QString();
+}
+
+/*!
+    Removes the extracted meta data of archives that are no longer in \a archives.
+*/
+void MetadataCache::prune(const ArchiveCache &archives)
+{
+    if (!isEnabled())
+        return;
+
+    foreach (const QFileInfo &entry, QDir(packagesPath()).entryInfoList(QDir::Dirs
+            | QDir::NoDotAndDotDot)) {
+        // skip the partial entries of other processes
+        const QByteArray key = ArchiveCache::normalizedKey(entry.fileName().toLatin1());
+        if (key.isEmpty() || archives.contains(key))
+            continue;
+        removeDirectory(entry.filePath(), true);
+    }
+}
+
+QString MetadataCache::repositoryPath(const QString &url) const
+{
+    return m_path + QLatin1String("/repositories/") + QString::fromLatin1(QCryptographicHash::hash(
+        url.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+QString MetadataCache::packagesPath() const
+{
+    return m_path + QLatin1String("/packages");
+}
+
+} // namespace QInstaller
@@ -0,0 +1,73 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include "installer_global.h"
+
+#include <QtCore/QString>
+
+QT_FORWARD_DECLARE_CLASS(QFileDevice)
+
+namespace QInstaller {
+
+class ArchiveCache;
+class PackageManagerCore;
+
+class INSTALLER_EXPORT MetadataCache
+{
+public:
+    MetadataCache();
+    explicit MetadataCache(const QString &path);
+
+    static MetadataCache fromCore(PackageManagerCore *core);
+
+    bool isEnabled() const;
+    QString path() const;
+
+    QString updatesXml(const QString &url, QByteArray *entityTag = nullptr,
+        QByteArray *lastModified = nullptr) const;
+    bool insertUpdatesXml(const QString &url, const QString &fileName,
+        const QByteArray &entityTag, const QByteArray &lastModified);
+
+    QString extractedMetadata(const QByteArray &sha1) const;
+    QString extractMetadata(const QByteArray &sha1, QFileDevice *archive);
+    void prune(const ArchiveCache &archives);
+
+private:
+    QString repositoryPath(const QString &url) const;
+    QString packagesPath() const;
+
+private:
+    QString m_path;
+};
+
+} // namespace QInstaller
+
+#endif // METADATACACHE_H
@@ -28,6 +28,7 @@
 #include "metadatajob.h"
 
 #include "metadatajob_p.h"
+#include "mirrorhealth.h"
 #include "packagemanagercore.h"
 #include "packagemanagerproxyfactory.h"
 #include "productkeycheck.h"
@@ -36,6 +37,8 @@
 #include "settings.h"
 #include "testrepository.h"
 
+#include "updatesinfo_p.h"
+
 #include <QTemporaryDir>
 #include <QtMath>
 
@@ -51,6 +54,23 @@ static QUrl resolveUrl(const FileTaskResult &result, const QString &url)
     return u;
 }
 
+// Marks the requests for the Updates.xml file of a mirror, which are only sent to measure how
+// fast the mirror answers. Holds the URL of the mirror.
+static const int scMirrorRole = TaskRole::UserRole + 1;
+
+static QString updatesXmlUrl(PackageManagerCore *core, const QUrl &repositoryUrl)
+{
+    QString url = repositoryUrl.toString() + QLatin1String("/Updates.xml");
+    if (!core->value(scUrlQueryString).isEmpty())
+        url += QLatin1Char('?') + core->value(scUrlQueryString);
+    return url;
+}
+
+static QString updatesXmlUrl(PackageManagerCore *core, const Repository &repo)
+{
+    return updatesXmlUrl(core, repo.url());
+}
+
 MetadataJob::MetadataJob(QObject *parent)
     : Job(parent)
     , m_core(nullptr)
@@ -115,6 +135,12 @@ void MetadataJob::doStart()
         emitFinishedWithError(Job::Canceled, tr("Missing package manager core engine."));
         return; // We can't do anything here without core, so avoid tons of !m_core checks.
     }
+    const QString cachePath = m_core->value(scLocalCachePath);
+    KDUpdater::UpdatesInfo::setCacheDirectory(cachePath.isEmpty() ? QString()
+        : QDir(cachePath).filePath(QLatin1String("updates")));
+    m_archiveCache = ArchiveCache::fromCore(m_core);
+    m_metadataCache = MetadataCache::fromCore(m_core);
+
     const ProductKeyCheck *const productKeyCheck = ProductKeyCheck::instance();
     if (!m_addCompressedPackages) {
         emit infoMessage(this, tr("Preparing meta information download..."));
@@ -130,15 +156,32 @@ void MetadataJob::doStart()
                     authenticator.setPassword(repo.password());
 
                     if (!repo.isCompressed()) {
-                        QString url = repo.url().toString() + QLatin1String("/Updates.xml?");
-                        if (!m_core->value(scUrlQueryString).isEmpty())
-                            url += m_core->value(scUrlQueryString) + QLatin1Char('&');
-
-                        // also append a random string to avoid proxy caches
-                        FileTaskItem item(url.append(QString::number(qrand() * qrand())));
+                        const QString url = updatesXmlUrl(m_core, repo);
+                        // revalidate with the server to avoid stale proxy caches, conditionally
+                        // if we still have the file from an earlier run
+                        FileTaskItem item(url);
+                        item.insert(TaskRole::Revalidate, true);
+                        QByteArray entityTag;
+                        QByteArray lastModified;
+                        if (!m_metadataCache.updatesXml(url, &entityTag, &lastModified).isEmpty()) {
+                            item.insert(TaskRole::EntityTag, entityTag);
+                            item.insert(TaskRole::LastModified, lastModified);
+                        }
                         item.insert(TaskRole::UserRole, QVariant::fromValue(repo));
                         item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
                         items.append(item);
+
+                        // ask the mirrors for the headers of the same file to rank them by their
+                        // response time, the file itself is only needed from one server
+                        foreach (const QUrl &mirror, repo.mirrors()) {
+                            FileTaskItem probe(updatesXmlUrl(m_core, mirror));
+                            probe.insert(TaskRole::HeadersOnly, true);
+                            probe.insert(scMirrorRole, mirror);
+                            probe.insert(TaskRole::UserRole, QVariant::fromValue(repo));
+                            probe.insert(TaskRole::Authenticator,
+                                QVariant::fromValue(authenticator));
+                            items.append(probe);
+                        }
                     }
                     else {
                         qDebug() << "Trying to parse compressed repo as normal repository."\
@@ -371,7 +414,7 @@ void MetadataJob::xmlTaskFinished()
         return;
 
     if (status == XmlDownloadSuccess) {
-        if (!fetchMetaDataPackages()) {
+        if (!fetchMetaDataPackages() && !startCachedUnzipTasks()) {
             emitFinished();
         }
     } else if (status == XmlDownloadRetry) {
@@ -404,6 +447,8 @@ void MetadataJob::unzipTaskFinished()
 
     if (m_unzipTasks.isEmpty()) {
         setProcessedAmount(100);
+        m_archiveCache.evict();
+        m_metadataCache.prune(m_archiveCache);
         emitFinished();
     }
 }
@@ -424,10 +469,12 @@ void MetadataJob::metadataTaskFinished()
         m_metadataTask.waitForFinished();
         m_metadataResult.append(m_metadataTask.future().results());
         if (!fetchMetaDataPackages()) {
-            if (m_metadataResult.count() > 0) {
+            if (m_metadataResult.count() > 0 || !m_cachedMetadata.isEmpty()) {
                 emit infoMessage(this, tr("Extracting meta information..."));
                 foreach (const FileTaskResult &result, m_metadataResult) {
                     const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
+                    QString archive = result.target();
+                    QByteArray checksum;
                     if (result.value(TaskRole::ChecksumMismatch).toBool()) {
                         QString mismatchMessage = tr("Checksum mismatch detected for \"%1\".")
                                 .arg(item.value(TaskRole::SourceFile).toString());
@@ -437,15 +484,16 @@ void MetadataJob::metadataTaskFinished()
                         } else {
                             throw QInstaller::TaskException(mismatchMessage);
                         }
+                    } else {
+                        // keep the verified archive for later runs
+                        checksum = item.value(TaskRole::Checksum).toByteArray();
+                        const QString cachedArchive = m_archiveCache.insert(checksum, archive);
+                        if (!cachedArchive.isEmpty())
+                            archive = cachedArchive;
                     }
-                    UnzipArchiveTask *task = new UnzipArchiveTask(result.target(),
-                        item.value(TaskRole::UserRole).toString());
-
-                    QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
-                    m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
-                    connect(watcher, &QFutureWatcherBase::finished, this, &MetadataJob::unzipTaskFinished);
-                    watcher->setFuture(QtConcurrent::run(&UnzipArchiveTask::doTask, task));
+                    startUnzipTask(archive, item.value(TaskRole::UserRole).toString(), checksum);
                 }
+                startCachedUnzipTasks();
             } else {
                 emitFinished();
             }
@@ -489,9 +537,37 @@ bool MetadataJob::fetchMetaDataPackages()
     return false;
 }
 
+void MetadataJob::startUnzipTask(const QString &archive, const QString &targetDir,
+    const QByteArray &checksum)
+{
+    UnzipArchiveTask *task = new UnzipArchiveTask(archive, targetDir);
+    task->setMetadataCache(m_metadataCache, checksum);
+
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
+    m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
+    connect(watcher, &QFutureWatcherBase::finished, this, &MetadataJob::unzipTaskFinished);
+    watcher->setFuture(QtConcurrent::run(&UnzipArchiveTask::doTask, task));
+}
+
+/*
+    Starts extracting the meta data archives found in the local archive cache, or copying their
+    contents if they were extracted before. Returns \c false if there are none.
+*/
+bool MetadataJob::startCachedUnzipTasks()
+{
+    if (m_cachedMetadata.isEmpty())
+        return false;
+
+    foreach (const FileTaskItem &item, m_cachedMetadata)
+        startUnzipTask(item.source(), item.target(), item.value(TaskRole::Checksum).toByteArray());
+    m_cachedMetadata.clear();
+    return true;
+}
+
 void MetadataJob::reset()
 {
     m_packages.clear();
+    m_cachedMetadata.clear();
     m_metaFromDefaultRepositories.clear();
     m_metaFromArchive.clear();
     m_fetchedArchive.clear();
@@ -536,13 +612,29 @@ void MetadataJob::resetCompressedFetch()
 
 MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &results)
 {
+    rankMirrors(results);
     foreach (const FileTaskResult &result, results) {
         if (error() != Job::NoError)
             return XmlDownloadFailure;
 
+        // The server answers 304 Not Modified if the Updates.xml file we kept did not change.
+        // The cache is keyed on the URL we asked for, not the one we might have been redirected to.
+        const FileTaskItem taskItem = result.taskItem();
+        if (taskItem.value(scMirrorRole).isValid())
+            continue;
+        const Repository repository = taskItem.value(TaskRole::UserRole).value<Repository>();
+        const bool notModified = result.value(TaskRole::NotModified).toBool();
+        // nothing was downloaded into the target of a 304 answer, do not leave it behind
+        if (notModified && !result.target().isEmpty())
+            QFile::remove(result.target());
+        const QString source = notModified
+            ? m_metadataCache.updatesXml(updatesXmlUrl(m_core, repository)) : result.target();
+
         //If repository is not found, target might be empty. Do not continue parsing the
         //repository and do not prevent further repositories usage.
-        if (result.target().isEmpty()) {
+        if (source.isEmpty()) {
+            if (notModified)
+                qDebug() << "Cannot find the cached Updates.xml file for" << taskItem.source();
             continue;
         }
         Metadata metadata;
@@ -556,84 +648,80 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
         metadata.directory = tmp.path();
         m_tempDirDeleter.add(metadata.directory);
 
-        QFile file(result.target());
-        if (!file.rename(metadata.directory + QLatin1String("/Updates.xml"))) {
-            qDebug() << "Cannot rename target to Updates.xml:" << file.errorString();
+        QFile file(source);
+        const QString updatesXml = metadata.directory + QLatin1String("/Updates.xml");
+        if (notModified && !file.copy(updatesXml)) {
+            qDebug() << "Cannot copy cached Updates.xml:" << file.errorString();
             return XmlDownloadFailure;
-        }
-
-        if (!file.open(QIODevice::ReadOnly)) {
-            qDebug() << "Cannot open Updates.xml for reading:" << file.errorString();
+        } else if (!notModified && !file.rename(updatesXml)) {
+            qDebug() << "Cannot rename target to Updates.xml:" << file.errorString();
             return XmlDownloadFailure;
         }
 
-        QString error;
-        QDomDocument doc;
-        if (!doc.setContent(&file, &error)) {
+        // The parsed packages are shared with the UpdateFinder, which reads the same file later.
+        KDUpdater::UpdatesInfo updatesInfo;
+        updatesInfo.setFileName(updatesXml);
+        if (updatesInfo.error() == KDUpdater::UpdatesInfo::CouldNotReadUpdateInfoFileError
+                || updatesInfo.error() == KDUpdater::UpdatesInfo::InvalidXmlError) {
             qDebug().nospace() << "Cannot fetch a valid version of Updates.xml from repository "
-                               << metadata.repository.displayname() << ": " << error;
+                               << metadata.repository.displayname() << ": "
+                               << updatesInfo.errorString();
             //If there are other repositories, try to use those
             continue;
         }
-        file.close();
 
-        const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
-        metadata.repository = item.value(TaskRole::UserRole).value<Repository>();
+        if (!notModified && taskItem.value(TaskRole::Revalidate).toBool()) {
+            m_metadataCache.insertUpdatesXml(updatesXmlUrl(m_core, repository), updatesXml,
+                result.value(TaskRole::EntityTag).toByteArray(),
+                result.value(TaskRole::LastModified).toByteArray());
+        }
+
+        metadata.repository = repository;
         const bool online = !(metadata.repository.url().scheme()).isEmpty();
 
-        bool testCheckSum = true;
-        const QDomElement root = doc.documentElement();
-        const QDomNode checksum = root.firstChildElement(QLatin1String("Checksum"));
-        if (!checksum.isNull())
-            testCheckSum = (checksum.toElement().text().toLower() == scTrue);
-
-        QDomNodeList children = root.childNodes();
-        for (int i = 0; i < children.count(); ++i) {
-            const QDomElement el = children.at(i).toElement();
-            if (!el.isNull() && el.tagName() == QLatin1String("PackageUpdate")) {
-                const QDomNodeList c2 = el.childNodes();
-                QString packageName, packageVersion, packageHash;
-                bool metaFound = false;
-                for (int j = 0; j < c2.count(); ++j) {
-                    if (c2.at(j).toElement().tagName() == scName)
-                        packageName = c2.at(j).toElement().text();
-                    else if (c2.at(j).toElement().tagName() == scVersion)
-                        packageVersion = (online ? c2.at(j).toElement().text() : QString());
-                    else if ((c2.at(j).toElement().tagName() == QLatin1String("SHA1")) && testCheckSum)
-                        packageHash = c2.at(j).toElement().text();
-                    else {
-                        foreach (QString meta, metaElements) {
-                            if (c2.at(j).toElement().tagName() == meta) {
-                                metaFound = true;
-                                break;
-                            }
-                        }
-                    }
+        const bool testCheckSum = updatesInfo.checksum();
+        foreach (const KDUpdater::UpdateInfo &info, updatesInfo.updatesInfo()) {
+            const QString packageName = info.data.value(scName).toString();
+            const QString packageVersion = online ? info.data.value(scVersion).toString()
+                : QString();
+            const QString packageHash = testCheckSum
+                ? info.data.value(QLatin1String("SHA1")).toString() : QString();
+            bool metaFound = false;
+            foreach (const QString &meta, metaElements) {
+                if (info.data.contains(meta)) {
+                    metaFound = true;
+                    break;
                 }
+            }
 
-                const QString repoUrl = metadata.repository.url().toString();
-                //If script element is not found, no need to fetch metadata
-                if (metaFound) {
-                    FileTaskItem item(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, packageName,
-                        packageVersion), metadata.directory + QString::fromLatin1("/%1-%2-meta.7z")
-                        .arg(packageName, packageVersion));
-
-                    QAuthenticator authenticator;
-                    authenticator.setUser(metadata.repository.username());
-                    authenticator.setPassword(metadata.repository.password());
-
-                    item.insert(TaskRole::UserRole, metadata.directory);
-                    item.insert(TaskRole::Checksum, packageHash.toLatin1());
-                    item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
-                    item.insert(TaskRole::Name, packageName);
-
-                    m_packages.append(item);
-                } else {
-                    QString fileName = metadata.directory + QLatin1Char('/') + packageName;
-                    QDir directory(fileName);
-                    if (!directory.exists()) {
-                        directory.mkdir(fileName);
-                    }
+            const QString repoUrl = metadata.repository.url().toString();
+            //If script element is not found, no need to fetch metadata
+            const QString cachedArchive = metaFound
+                ? m_archiveCache.lookup(packageHash.toLatin1()) : QString();
+            if (!cachedArchive.isEmpty()) {
+                FileTaskItem item(cachedArchive, metadata.directory);
+                item.insert(TaskRole::Checksum, packageHash.toLatin1());
+                m_cachedMetadata.append(item);
+            } else if (metaFound) {
+                FileTaskItem item(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, packageName,
+                    packageVersion), metadata.directory + QString::fromLatin1("/%1-%2-meta.7z")
+                    .arg(packageName, packageVersion));
+
+                QAuthenticator authenticator;
+                authenticator.setUser(metadata.repository.username());
+                authenticator.setPassword(metadata.repository.password());
+
+                item.insert(TaskRole::UserRole, metadata.directory);
+                item.insert(TaskRole::Checksum, packageHash.toLatin1());
+                item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
+                item.insert(TaskRole::Name, packageName);
+
+                m_packages.append(item);
+            } else {
+                QString fileName = metadata.directory + QLatin1Char('/') + packageName;
+                QDir directory(fileName);
+                if (!directory.exists()) {
+                    directory.mkdir(fileName);
                 }
             }
         }
@@ -662,57 +750,53 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
 
 
         // search for additional repositories that we might need to check
-        const QDomNode repositoryUpdate = root.firstChildElement(QLatin1String("RepositoryUpdate"));
-        if (repositoryUpdate.isNull())
+        const QList<KDUpdater::RepositoryUpdateInfo> repositoryElements = updatesInfo.repositoryUpdates();
+        if (repositoryElements.isEmpty())
             continue;
 
         QHash<QString, QPair<Repository, Repository> > repositoryUpdates;
-        children = repositoryUpdate.toElement().childNodes();
-        for (int i = 0; i < children.count(); ++i) {
-            const QDomElement el = children.at(i).toElement();
-            if (!el.isNull() && el.tagName() == QLatin1String("Repository")) {
-                const QString action = el.attribute(QLatin1String("action"));
-                if (action == QLatin1String("add")) {
-                    // add a new repository to the defaults list
-                    Repository repository(resolveUrl(result, el.attribute(QLatin1String("url"))), true);
-                    repository.setUsername(el.attribute(QLatin1String("username")));
-                    repository.setPassword(el.attribute(QLatin1String("password")));
-                    repository.setDisplayName(el.attribute(QLatin1String("displayname")));
-                    repository.setEnabled(el.attribute(QLatin1String("enabled"), QLatin1String("1"))
-                            != QLatin1String("0"));
-                    if (ProductKeyCheck::instance()->isValidRepository(repository)) {
-                        repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
-                        qDebug() << "Repository to add:" << repository.displayname();
-                    }
-                } else if (action == QLatin1String("remove")) {
-                    // remove possible default repositories using the given server url
-                    Repository repository(resolveUrl(result, el.attribute(QLatin1String("url"))), true);
-                    repository.setDisplayName(el.attribute(QLatin1String("displayname")));
+        foreach (const KDUpdater::RepositoryUpdateInfo &el, repositoryElements) {
+            const QString action = el.attributes.value(QLatin1String("action"));
+            if (action == QLatin1String("add")) {
+                // add a new repository to the defaults list
+                Repository repository(resolveUrl(result, el.attributes.value(QLatin1String("url"))), true);
+                repository.setUsername(el.attributes.value(QLatin1String("username")));
+                repository.setPassword(el.attributes.value(QLatin1String("password")));
+                repository.setDisplayName(el.attributes.value(QLatin1String("displayname")));
+                repository.setEnabled(el.attributes.value(QLatin1String("enabled"), QLatin1String("1"))
+                        != QLatin1String("0"));
+                if (ProductKeyCheck::instance()->isValidRepository(repository)) {
                     repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
-
-                    qDebug() << "Repository to remove:" << repository.displayname();
-                } else if (action == QLatin1String("replace")) {
-                    // replace possible default repositories using the given server url
-                    Repository oldRepository(resolveUrl(result, el.attribute(QLatin1String("oldUrl"))), true);
-                    Repository newRepository(resolveUrl(result, el.attribute(QLatin1String("newUrl"))), true);
-                    newRepository.setUsername(el.attribute(QLatin1String("username")));
-                    newRepository.setPassword(el.attribute(QLatin1String("password")));
-                    newRepository.setDisplayName(el.attribute(QLatin1String("displayname")));
-                    newRepository.setEnabled(el.attribute(QLatin1String("enabled"), QLatin1String("1"))
-                            != QLatin1String("0"));
-
-                    if (oldRepository.url() == newRepository.url()) {
-                        qDebug() << "Not replacing repository with itself" << oldRepository.displayname();
-                    } else if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
-                        // store the new repository and the one old it replaces
-                        repositoryUpdates.insertMulti(action, qMakePair(oldRepository, newRepository));
-                        qDebug() << "Replace repository" << oldRepository.displayname() << "with"
-                            << newRepository.displayname();
-                    }
-                } else {
-                    qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
-                        "from" << metadata.repository.displayname() << "line:" << el.lineNumber();
+                    qDebug() << "Repository to add:" << repository.displayname();
                 }
+            } else if (action == QLatin1String("remove")) {
+                // remove possible default repositories using the given server url
+                Repository repository(resolveUrl(result, el.attributes.value(QLatin1String("url"))), true);
+                repository.setDisplayName(el.attributes.value(QLatin1String("displayname")));
+                repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
+
+                qDebug() << "Repository to remove:" << repository.displayname();
+            } else if (action == QLatin1String("replace")) {
+                // replace possible default repositories using the given server url
+                Repository oldRepository(resolveUrl(result, el.attributes.value(QLatin1String("oldUrl"))), true);
+                Repository newRepository(resolveUrl(result, el.attributes.value(QLatin1String("newUrl"))), true);
+                newRepository.setUsername(el.attributes.value(QLatin1String("username")));
+                newRepository.setPassword(el.attributes.value(QLatin1String("password")));
+                newRepository.setDisplayName(el.attributes.value(QLatin1String("displayname")));
+                newRepository.setEnabled(el.attributes.value(QLatin1String("enabled"), QLatin1String("1"))
+                        != QLatin1String("0"));
+
+                if (oldRepository.url() == newRepository.url()) {
+                    qDebug() << "Not replacing repository with itself" << oldRepository.displayname();
+                } else if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
+                    // store the new repository and the one old it replaces
+                    repositoryUpdates.insertMulti(action, qMakePair(oldRepository, newRepository));
+                    qDebug() << "Replace repository" << oldRepository.displayname() << "with"
+                        << newRepository.displayname();
+                }
+            } else {
+                qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
+                    "from" << metadata.repository.displayname() << "line:" << el.lineNumber;
             }
         }
 
@@ -763,6 +847,48 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
     return XmlDownloadSuccess;
 }
 
+/*!
+    Records how fast the repositories with mirrors and each of their mirrors answered the request
+    for the Updates.xml file in \a results, and logs the resulting order in which archives are
+    fetched from them. Only the repository itself delivers the file, the mirrors are asked for its
+    headers.
+*/
+void MetadataJob::rankMirrors(const QList<FileTaskResult> &results)
+{
+    MirrorHealth &health = MirrorHealth::instance();
+    QList<Repository> ranked;
+    foreach (const FileTaskResult &result, results) {
+        const FileTaskItem taskItem = result.taskItem();
+        const Repository repository = taskItem.value(TaskRole::UserRole).value<Repository>();
+        if (repository.mirrors().isEmpty())
+            continue;
+
+        const QUrl mirror = taskItem.value(scMirrorRole).toUrl();
+        const QUrl url = mirror.isValid() ? mirror : repository.url();
+        const QVariant elapsed = result.value(TaskRole::ElapsedTime);
+        if (elapsed.isValid())
+            health.addLatency(url, elapsed.toLongLong());
+        else
+            health.addFailure(url);
+
+        if (mirror.isValid() && !result.target().isEmpty())
+            QFile::remove(result.target());
+        if (!ranked.contains(repository))
+            ranked.append(repository);
+    }
+
+    foreach (const Repository &repository, ranked) {
+        QStringList servers;
+        foreach (const QUrl &url, health.ranked(repository)) {
+            const qint64 latency = health.latency(url);
+            servers.append(latency < 0 ? QString::fromLatin1("%1 (unreachable)").arg(url.toString())
+                : QString::fromLatin1("%1 (%2 ms)").arg(url.toString()).arg(latency));
+        }
+        qDebug().noquote() << "Servers of repository" << repository.displayname()
+            << "in order of preference:" << servers.join(QLatin1String(", "));
+    }
+}
+
 QSet<Repository> MetadataJob::getRepositories()
 {
     QSet<Repository> repositories;
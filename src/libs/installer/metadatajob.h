@@ -29,9 +29,11 @@
 #ifndef METADATAJOB_H
 #define METADATAJOB_H
 
+#include "archivecache.h"
 #include "downloadfiletask.h"
 #include "fileutils.h"
 #include "job.h"
+#include "metadatacache.h"
 #include "repository.h"
 
 #include <QFutureWatcher>
@@ -87,10 +89,14 @@ private slots:
 
 private:
     bool fetchMetaDataPackages();
+    void startUnzipTask(const QString &archive, const QString &targetDir,
+        const QByteArray &checksum);
+    bool startCachedUnzipTasks();
     void startUnzipRepositoryTask(const Repository &repo);
     void reset();
     void resetCompressedFetch();
     Status parseUpdatesXml(const QList<FileTaskResult> &results);
+    void rankMirrors(const QList<FileTaskResult> &results);
     QSet<Repository> getRepositories();
 
 private:
@@ -105,6 +111,9 @@ private:
     bool m_addCompressedPackages;
     QList<FileTaskItem> m_unzipRepositoryitems;
     QList<FileTaskResult> m_metadataResult;
+    ArchiveCache m_archiveCache;
+    MetadataCache m_metadataCache;
+    QList<FileTaskItem> m_cachedMetadata;
     int m_downloadableChunkSize;
     int m_taskNumber;
     int m_totalTaskCount;
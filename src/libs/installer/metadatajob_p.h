@@ -29,10 +29,14 @@
 #ifndef METADATAJOB_P_H
 #define METADATAJOB_P_H
 
+#include "errors.h"
+#include "fileutils.h"
 #include "lib7z_extract.h"
 #include "lib7z_facade.h"
+#include "metadatacache.h"
 #include "metadatajob.h"
 
+#include <QDebug>
 #include <QDir>
 #include <QFile>
 
@@ -66,6 +70,11 @@ public:
     {}
     QString target() { return m_targetDir; }
     QString archive() { return m_archive; }
+    void setMetadataCache(const MetadataCache &cache, const QByteArray &checksum)
+    {
+        m_cache = cache;
+        m_checksum = checksum;
+    }
     void doTask(QFutureInterface<void> &fi)
     {
         fi.reportStarted();
@@ -76,10 +85,21 @@ public:
             return; // ignore already canceled
         }
 
+        // the meta data of an unchanged package was extracted before, no need to do it again
+        const QString extracted = m_cache.extractedMetadata(m_checksum);
+        if (!extracted.isEmpty() && copyExtractedMetadata(extracted)) {
+            fi.reportFinished();
+            return;
+        }
+
         QFile archive(m_archive);
         if (archive.open(QIODevice::ReadOnly)) {
             try {
-                Lib7z::extractArchive(&archive, m_targetDir);
+                const QString directory = m_cache.extractMetadata(m_checksum, &archive);
+                if (directory.isEmpty() || !copyExtractedMetadata(directory)) {
+                    archive.seek(0);
+                    Lib7z::extractArchive(&archive, m_targetDir);
+                }
             } catch (const Lib7z::SevenZipException& e) {
                 fi.reportException(UnzipArchiveException(MetadataJob::tr("Error while extracting "
                     "archive \"%1\": %2").arg(QDir::toNativeSeparators(m_archive), e.message())));
@@ -95,9 +115,23 @@ public:
         fi.reportFinished();
     }
 
+private:
+    bool copyExtractedMetadata(const QString &directory)
+    {
+        try {
+            copyDirectoryContents(directory, m_targetDir);
+            return true;
+        } catch (const Error &e) {
+            qDebug() << "Cannot copy cached meta data:" << e.message();
+        }
+        return false;
+    }
+
 private:
     QString m_archive;
     QString m_targetDir;
+    MetadataCache m_cache;
+    QByteArray m_checksum;
 };
 
 }   // namespace QInstaller
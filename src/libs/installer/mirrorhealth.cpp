@@ -0,0 +1,157 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "mirrorhealth.h"
+
+#include <QtCore/QPair>
+
+#include <algorithm>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::MirrorHealth
+    \inmodule QtInstallerFramework
+    \brief The MirrorHealth class ranks the servers of a repository by how fast and how reliably
+        they answered so far.
+
+    The response time of each server is measured until the headers of the Updates.xml file arrive,
+    and every archive download that succeeds or fails on it is counted. ranked() orders the URL of
+    a repository and its mirrors by score(), so that downloads start with the best server and fall
+    back to the next one.
+*/
+
+// Latency assumed for servers that were never measured, so that a measured one is preferred only
+// if it answers reasonably fast.
+static const qint64 scUnknownLatency = 1000;
+
+/*!
+    Creates an empty ranking. Usually the instance() shared by all downloads is used instead.
+*/
+MirrorHealth::MirrorHealth()
+{
+}
+
+/*!
+    Returns the ranking shared by all downloads of the process.
+*/
+MirrorHealth &MirrorHealth::instance()
+{
+    static MirrorHealth health;
+    return health;
+}
+
+/*!
+    Records that the server at \a url answered a request within \a msecs milliseconds. Earlier
+    measurements are taken into account, so that a single slow answer does not outweigh them.
+*/
+void MirrorHealth::addLatency(const QUrl &url, qint64 msecs)
+{
+    QMutexLocker _(&m_mutex);
+    Entry &entry = m_entries[key(url)];
+    entry.latency = entry.latency < 0 ? msecs : (3 * entry.latency + msecs) / 4;
+}
+
+/*!
+    Records that a file was downloaded from the server at \a url.
+*/
+void MirrorHealth::addSuccess(const QUrl &url)
+{
+    QMutexLocker _(&m_mutex);
+    ++m_entries[key(url)].successes;
+}
+
+/*!
+    Records that a download from the server at \a url failed.
+*/
+void MirrorHealth::addFailure(const QUrl &url)
+{
+    QMutexLocker _(&m_mutex);
+    ++m_entries[key(url)].failures;
+}
+
+/*!
+    Returns the measured response time of the server at \a url in milliseconds, or \c -1 if it
+    was not measured yet.
+*/
+qint64 MirrorHealth::latency(const QUrl &url) const
+{
+    QMutexLocker _(&m_mutex);
+    return m_entries.value(key(url)).latency;
+}
+
+/*!
+    Returns the score of the server at \a url. Lower scores are better: the response time is
+    weighted with the share of failed downloads.
+*/
+qreal MirrorHealth::score(const QUrl &url) const
+{
+    QMutexLocker _(&m_mutex);
+    return score(m_entries.value(key(url)));
+}
+
+/*!
+    Returns the URL of \a repository and its mirrors, best first. Servers with equal scores keep
+    their configured order, with the repository URL itself in front.
+*/
+QList<QUrl> MirrorHealth::ranked(const Repository &repository) const
+{
+    QList<QUrl> urls = QList<QUrl>() << repository.url();
+    foreach (const QUrl &mirror, repository.mirrors()) {
+        if (mirror.isValid() && !urls.contains(mirror))
+            urls.append(mirror);
+    }
+
+    QMutexLocker _(&m_mutex);
+    QList<QPair<qreal, QUrl> > scored;
+    foreach (const QUrl &url, urls)
+        scored.append(qMakePair(score(m_entries.value(key(url))), url));
+    std::stable_sort(scored.begin(), scored.end(),
+        [](const QPair<qreal, QUrl> &lhs, const QPair<qreal, QUrl> &rhs) {
+            return lhs.first < rhs.first;
+        });
+
+    urls.clear();
+    foreach (const auto &entry, scored)
+        urls.append(entry.second);
+    return urls;
+}
+
+QString MirrorHealth::key(const QUrl &url)
+{
+    return url.toString(QUrl::StripTrailingSlash);
+}
+
+qreal MirrorHealth::score(const Entry &entry)
+{
+    const qreal latency = entry.latency < 0 ? scUnknownLatency : qMax<qint64>(1, entry.latency);
+    const qreal failureRate = entry.failures / (entry.successes + entry.failures + 1.0);
+    return latency * (1.0 + 4.0 * failureRate);
+}
+
+} // namespace QInstaller
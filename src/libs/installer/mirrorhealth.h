@@ -0,0 +1,79 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef MIRRORHEALTH_H
+#define MIRRORHEALTH_H
+
+#include "installer_global.h"
+#include "repository.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QUrl>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT MirrorHealth
+{
+    Q_DISABLE_COPY(MirrorHealth)
+
+public:
+    MirrorHealth();
+
+    static MirrorHealth &instance();
+
+    void addLatency(const QUrl &url, qint64 msecs);
+    void addSuccess(const QUrl &url);
+    void addFailure(const QUrl &url);
+
+    qint64 latency(const QUrl &url) const;
+    qreal score(const QUrl &url) const;
+    QList<QUrl> ranked(const Repository &repository) const;
+
+private:
+    struct Entry
+    {
+        Entry() : latency(-1), successes(0), failures(0) {}
+
+        qint64 latency;
+        int successes;
+        int failures;
+    };
+
+    static QString key(const QUrl &url);
+    static qreal score(const Entry &entry);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+} // namespace QInstaller
+
+#endif // MIRRORHEALTH_H
@@ -0,0 +1,95 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "operationexecutor.h"
+
+#include <QtCore/QSet>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::OperationExecutor
+    \inmodule QtInstallerFramework
+    \brief The OperationExecutor class runs operations and other blocking file system work off the
+        user interface thread.
+
+    The work handed to run() is performed in a thread pool dedicated to installer I/O, so that it
+    neither competes with nor waits for other users of the global thread pool. The returned future
+    can be waited for with waitForFinished(), which keeps the user interface responsive only when
+    called from the user interface thread, and blocks otherwise.
+
+    Operations that only do a small, bounded amount of work are cheaper to perform directly than to
+    hand over to another thread, see canRunInline().
+*/
+
+Q_GLOBAL_STATIC(QThreadPool, operationThreadPool)
+
+/*!
+    Returns the thread pool used by run().
+*/
+QThreadPool *OperationExecutor::threadPool()
+{
+    return operationThreadPool();
+}
+
+/*!
+    Returns \c true if \a operation is cheap enough to be performed in the calling thread instead of
+    being handed over to threadPool().
+*/
+bool OperationExecutor::canRunInline(Operation *operation)
+{
+    static const QSet<QString> cheapOperations = QSet<QString>() << QLatin1String("Mkdir")
+        << QLatin1String("Rmdir") << QLatin1String("Settings") << QLatin1String("GlobalConfig")
+        << QLatin1String("CreateLink") << QLatin1String("License")
+        << QLatin1String("MinimumProgress");
+
+    return cheapOperations.contains(operation->name());
+}
+
+/*!
+    Returns \c true if called from the thread running the application event loop.
+*/
+bool OperationExecutor::isGuiThread()
+{
+    const QCoreApplication *const app = QCoreApplication::instance();
+    return app && QThread::currentThread() == app->thread();
+}
+
+/*!
+    \fn template <typename Function> QFuture<T> QInstaller::OperationExecutor::run(Function function)
+
+    Runs \a function in threadPool() and returns a future for its result.
+*/
+
+/*!
+    \fn template <typename T> void QInstaller::OperationExecutor::waitForFinished(const QFuture<T> &future)
+
+    Waits for \a future to finish. In the user interface thread, events are processed meanwhile.
+*/
+
+} // namespace QInstaller
@@ -0,0 +1,79 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef OPERATIONEXECUTOR_H
+#define OPERATIONEXECUTOR_H
+
+#include "qinstallerglobal.h"
+
+#include <QtConcurrentRun>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT OperationExecutor
+{
+public:
+    static QThreadPool *threadPool();
+    static bool canRunInline(Operation *operation);
+    static bool isGuiThread();
+
+    template <typename Function>
+    static auto run(Function function) -> QFuture<decltype(function())>
+    {
+        return QtConcurrent::run(threadPool(), function);
+    }
+
+    template <typename T>
+    static void waitForFinished(const QFuture<T> &future)
+    {
+        if (future.isFinished())
+            return;
+
+        if (!isGuiThread()) {
+            future.waitForFinished();
+            return;
+        }
+
+        QFutureWatcher<T> futureWatcher;
+        QEventLoop loop;
+        QObject::connect(&futureWatcher, &QFutureWatcher<T>::finished, &loop, &QEventLoop::quit,
+            Qt::QueuedConnection);
+        futureWatcher.setFuture(future);
+        if (!future.isFinished())
+            loop.exec();
+    }
+};
+
+} // namespace QInstaller
+
+#endif // OPERATIONEXECUTOR_H
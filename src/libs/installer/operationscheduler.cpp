@@ -0,0 +1,315 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "operationscheduler.h"
+
+#include "operationexecutor.h"
+
+#include <QtConcurrentRun>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSet>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::OperationScheduler
+    \inmodule QtInstallerFramework
+    \brief The OperationScheduler class performs operations of several components in the
+        background while the installation goes on.
+
+    Operations handed to schedule() are performed on worker threads, at most maxThreadCount() at
+    the same time. Only file system operations that neither interact with the user nor need
+    elevated rights can be scheduled, see canSchedule(). The operations of one component are
+    performed in their order, except that consecutive extract operations run side by side. The
+    installation still walks the operations of each component in order, but for a scheduled
+    operation it calls takeResult() instead of performing it again. This keeps the order of the
+    performed operations, and thus of the undo records, unchanged.
+
+    Operations that were performed but never taken are returned by discard(), so that they can be
+    undone during a rollback.
+
+    A scheduled operation should not be connected to the installer before its result is taken. The
+    output text it emits in the background is recorded and handed out by takeResult().
+*/
+
+/*!
+    \enum OperationScheduler::Result
+
+    This enum holds the result of a scheduled operation:
+
+    \value Performed
+           The operation was performed successfully.
+    \value Failed
+           Performing the operation failed.
+    \value Skipped
+           The operation was not performed, because an operation it depends on failed or the
+           scheduled operations were discarded.
+*/
+
+// Collects the output text of an operation performed on a worker thread.
+class OutputTextRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    QStringList text() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_text;
+    }
+
+public slots:
+    void record(const QString &text)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_text.append(text);
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QStringList m_text;
+};
+
+/*!
+    Creates a scheduler running at most \a maxThreadCount operations at the same time, with
+    \a parent as parent object.
+*/
+OperationScheduler::OperationScheduler(int maxThreadCount, QObject *parent)
+    : QObject(parent)
+    , m_discarded(0)
+{
+    m_pool.setMaxThreadCount(qMax(1, maxThreadCount));
+}
+
+/*!
+    Destroys the scheduler. Waits for running operations to finish.
+*/
+OperationScheduler::~OperationScheduler()
+{
+    m_discarded.storeRelease(1);
+    m_pool.waitForDone();
+    qDeleteAll(m_outputRecorders);
+}
+
+/*!
+    Returns the maximum number of operations performed at the same time.
+*/
+int OperationScheduler::maxThreadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+/*!
+    Returns the number of scheduled operations whose result was not taken yet.
+*/
+int OperationScheduler::pendingCount() const
+{
+    return m_operations.count();
+}
+
+/*!
+    Returns \c true if \a operation needs elevated rights or interacts with the user through the
+    installer. Such operations are never scheduled, and the scheduled operations must be finished
+    before performing one, see waitForScheduled().
+*/
+bool OperationScheduler::isSerializationPoint(Operation *operation)
+{
+    if (operation->value(QLatin1String("admin")).toBool())
+        return true;
+
+    const QObject *const object = dynamic_cast<QObject *>(operation);
+    return object && object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature(
+        "requestBlockingExecution(QString)")) > -1;
+}
+
+/*!
+    Returns \c true if \a operation is a file system operation that can be performed in the
+    background while other components are installed. Extract operations can only be scheduled
+    once their archive is available.
+*/
+bool OperationScheduler::canSchedule(Operation *operation) const
+{
+    static const QSet<QString> fileOperations = QSet<QString>() << QLatin1String("Extract")
+        << QLatin1String("Copy") << QLatin1String("Move") << QLatin1String("Delete")
+        << QLatin1String("Mkdir") << QLatin1String("Rmdir") << QLatin1String("AppendFile")
+        << QLatin1String("PrependFile") << QLatin1String("CopyDirectory")
+        << QLatin1String("SimpleMoveFile") << QLatin1String("Replace")
+        << QLatin1String("LineReplace") << QLatin1String("CreateLink")
+        << QLatin1String("License") << QLatin1String("MinimumProgress");
+
+    if (!fileOperations.contains(operation->name()) || isSerializationPoint(operation))
+        return false;
+    if (m_operations.contains(operation))
+        return false;
+
+    if (operation->name() == QLatin1String("Extract")) {
+        if (operation->arguments().count() != 2)
+            return false;
+        // the archive might still be downloading
+        return QFileInfo(operation->arguments().at(0)).isFile();
+    }
+    return true;
+}
+
+/*!
+    Starts performing \a operations, which must be consecutive operations of one component, on
+    worker threads. Each operation starts once the operations before it are finished, except that
+    consecutive extract operations do not wait for each other. If an operation fails, the
+    operations after it are skipped. The output text of the operations is recorded until their
+    result is taken.
+*/
+void OperationScheduler::schedule(const OperationList &operations)
+{
+    QList<QFuture<Result> > predecessors;
+    QList<QFuture<Result> > extractions;
+    foreach (Operation *operation, operations) {
+        Q_ASSERT(canSchedule(operation));
+
+        const bool isExtract = operation->name() == QLatin1String("Extract");
+        if (!isExtract && !extractions.isEmpty()) {
+            predecessors = extractions;
+            extractions.clear();
+        }
+
+        QObject *const object = dynamic_cast<QObject *>(operation);
+        if (object && object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature(
+                "outputTextChanged(QString)")) > -1) {
+            OutputTextRecorder *const recorder = new OutputTextRecorder;
+            connect(object, SIGNAL(outputTextChanged(QString)), recorder, SLOT(record(QString)),
+                Qt::DirectConnection);
+            m_outputRecorders.insert(operation, recorder);
+        }
+
+        // The pool starts tasks in the order they were scheduled, so the predecessors a task
+        // waits for are running or finished already and cannot be starved by waiting tasks.
+        const QFuture<Result> future = QtConcurrent::run(&m_pool, [this, operation, predecessors]() {
+            foreach (QFuture<Result> predecessor, predecessors) {
+                if (predecessor.result() != Result::Performed)
+                    return Result::Skipped;
+            }
+            if (m_discarded.loadAcquire())
+                return Result::Skipped;
+
+            operation->backup();
+            return operation->performOperation() ? Result::Performed : Result::Failed;
+        });
+
+        m_operations.insert(operation, future);
+        m_scheduleOrder.append(operation);
+        if (isExtract) {
+            extractions.append(future);
+        } else {
+            predecessors.clear();
+            predecessors.append(future);
+        }
+    }
+}
+
+/*!
+    Returns \c true if \a operation was scheduled and its result was not taken yet.
+*/
+bool OperationScheduler::isScheduled(Operation *operation) const
+{
+    return m_operations.contains(operation);
+}
+
+/*!
+    Waits for the scheduled \a operation to finish and returns its result. The output text the
+    operation emitted in the background is stored in \a outputText, if given. Its progress was not
+    reported, so the final progress of a performed operation needs to be reported by the caller.
+    A skipped operation needs to be performed by the caller.
+*/
+OperationScheduler::Result OperationScheduler::takeResult(Operation *operation,
+    QStringList *outputText)
+{
+    Q_ASSERT(isScheduled(operation));
+    const QFuture<Result> future = m_operations.take(operation);
+    m_scheduleOrder.removeOne(operation);
+
+    OperationExecutor::waitForFinished(future);
+    const QStringList text = stopRecording(operation);
+    if (outputText)
+        *outputText = text;
+    return future.result();
+}
+
+/*!
+    Waits for all scheduled operations to finish, without taking their results. Call this before
+    performing an operation for which isSerializationPoint() returns \c true.
+*/
+void OperationScheduler::waitForScheduled()
+{
+    foreach (const QFuture<Result> &future, m_operations)
+        OperationExecutor::waitForFinished(future);
+}
+
+/*!
+    Skips the scheduled operations that did not start yet, waits for the running ones, and returns
+    the operations that were performed but whose result was not taken, in reverse order. Their
+    changes need to be removed by undoing them.
+*/
+OperationList OperationScheduler::discard()
+{
+    m_discarded.storeRelease(1);
+
+    OperationList operations;
+    for (int i = m_scheduleOrder.count() - 1; i >= 0; --i) {
+        Operation *const operation = m_scheduleOrder.at(i);
+        QFuture<Result> future = m_operations.value(operation);
+        future.waitForFinished();
+        stopRecording(operation);
+        if (future.result() != Result::Skipped)
+            operations.append(operation);
+    }
+    m_operations.clear();
+    m_scheduleOrder.clear();
+    m_discarded.storeRelease(0);
+    return operations;
+}
+
+/*
+    Stops recording the output text of the finished \a operation and returns the recorded text.
+    Drops the progress the operation queued for itself while it was performed in the background.
+*/
+QStringList OperationScheduler::stopRecording(Operation *operation)
+{
+    QObject *const object = dynamic_cast<QObject *>(operation);
+    if (!object)
+        return QStringList();
+
+    QCoreApplication::removePostedEvents(object, QEvent::MetaCall);
+    QScopedPointer<OutputTextRecorder> recorder(m_outputRecorders.take(operation));
+    return recorder ? recorder->text() : QStringList();
+}
+
+} // namespace QInstaller
+
+#include "operationscheduler.moc"
@@ -0,0 +1,85 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef OPERATIONSCHEDULER_H
+#define OPERATIONSCHEDULER_H
+
+#include "qinstallerglobal.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFuture>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadPool>
+
+namespace QInstaller {
+
+class OutputTextRecorder;
+
+class INSTALLER_EXPORT OperationScheduler : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(OperationScheduler)
+
+public:
+    enum struct Result {
+        Performed,
+        Failed,
+        Skipped
+    };
+
+    explicit OperationScheduler(int maxThreadCount, QObject *parent = nullptr);
+    ~OperationScheduler();
+
+    int maxThreadCount() const;
+    int pendingCount() const;
+
+    static bool isSerializationPoint(Operation *operation);
+    bool canSchedule(Operation *operation) const;
+    void schedule(const OperationList &operations);
+    bool isScheduled(Operation *operation) const;
+    Result takeResult(Operation *operation, QStringList *outputText = nullptr);
+
+    void waitForScheduled();
+    OperationList discard();
+
+private:
+    QStringList stopRecording(Operation *operation);
+
+private:
+    QThreadPool m_pool;
+    QAtomicInt m_discarded;
+    QHash<Operation *, QFuture<Result> > m_operations;
+    QHash<Operation *, OutputTextRecorder *> m_outputRecorders;
+    OperationList m_scheduleOrder;
+};
+
+} // namespace QInstaller
+
+#endif // OPERATIONSCHEDULER_H
@@ -36,6 +36,7 @@
 #include "errors.h"
 #include "globals.h"
 #include "messageboxhandler.h"
+#include "operationexecutor.h"
 #include "packagemanagerproxyfactory.h"
 #include "progresscoordinator.h"
 #include "qprocesswrapper.h"
@@ -50,8 +51,6 @@
 #include <productkeycheck.h>
 
 #include <QFuture>
-#include <QFutureWatcher>
-#include <QtConcurrentRun>
 
 #include <QtCore/QMutex>
 #include <QtCore/QRegExp>
@@ -414,6 +413,38 @@ static bool sNoForceInstallation = false;
 static bool sVirtualComponentsVisible = false;
 static bool sCreateLocalRepositoryFromBinary = false;
 
+static bool versionKeyMatches(const KDUpdater::VersionKey &version, const QString &requirement)
+{
+    // a requirement without comparator asks for an equal version
+    bool allowEqual = false;
+    bool allowLess = false;
+    bool allowMore = false;
+    int length = 0;
+    for (; length < requirement.size(); ++length) {
+        const QChar c = requirement.at(length);
+        if (c == QLatin1Char('='))
+            allowEqual = true;
+        else if (c == QLatin1Char('<'))
+            allowLess = true;
+        else if (c == QLatin1Char('>'))
+            allowMore = true;
+        else
+            break;
+    }
+    if (length == 0)
+        allowEqual = true;
+    const QString ver = requirement.mid(length);
+
+    if (allowEqual && version.toString() == ver)
+        return true;
+
+    if (!allowLess && !allowMore)
+        return false;
+
+    const int result = KDUpdater::compareVersion(KDUpdater::VersionKey(ver), version);
+    return (allowLess && result > 0) || (allowMore && result < 0);
+}
+
 static bool componentMatches(const Component *component, const QString &name,
     const QString &version = QString())
 {
@@ -424,7 +455,7 @@ static bool componentMatches(const Component *component, const QString &name,
         return true;
 
     // can be remote or local version
-    return PackageManagerCore::versionMatches(component->value(scVersion), version);
+    return versionKeyMatches(component->versionKey(), version);
 }
 
 /*!
@@ -434,7 +465,7 @@ void PackageManagerCore::writeMaintenanceTool()
 {
     if (d->m_needToWriteMaintenanceTool) {
         try {
-            d->writeMaintenanceTool(d->m_performedOperationsOld + d->m_performedOperationsCurrentSession);
+            d->writeMaintenanceTool(d->performedOperationsOld() + d->m_performedOperationsCurrentSession);
 
             bool gainedAdminRights = false;
             if (!directoryWritable(d->targetDir())) {
@@ -641,17 +672,8 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
 {
     Q_ASSERT(partProgressSize >= 0 && partProgressSize <= 1);
 
-    QList<QPair<QString, QString> > archivesToDownload;
-    QList<Component*> neededComponents = orderedComponentsToInstall();
-    foreach (Component *component, neededComponents) {
-        // collect all archives to be downloaded
-        const QStringList toDownload = component->downloadableArchives();
-        foreach (const QString &versionFreeString, toDownload) {
-            archivesToDownload.push_back(qMakePair(QString::fromLatin1("installer://%1/%2")
-                .arg(component->name(), versionFreeString), QString::fromLatin1("%1/%2/%3")
-                .arg(component->repositoryUrl().toString(), component->name(), versionFreeString)));
-        }
-    }
+    const QList<QPair<QString, QString> > archivesToDownload =
+        d->archivesToDownload(orderedComponentsToInstall());
 
     if (archivesToDownload.isEmpty())
         return 0;
@@ -661,28 +683,9 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
     DownloadArchivesJob archivesJob(this);
     archivesJob.setAutoDelete(false);
     archivesJob.setArchivesToDownload(archivesToDownload);
-    connect(this, &PackageManagerCore::installationInterrupted, &archivesJob, &Job::cancel);
-    connect(&archivesJob, &DownloadArchivesJob::outputTextChanged,
-            ProgressCoordinator::instance(), &ProgressCoordinator::emitLabelAndDetailTextChanged);
-    connect(&archivesJob, &DownloadArchivesJob::downloadStatusChanged,
-            ProgressCoordinator::instance(), &ProgressCoordinator::downloadStatusChanged);
-
-    ProgressCoordinator::instance()->registerPartProgress(&archivesJob,
-        SIGNAL(progressChanged(double)), partProgressSize);
-
-    // Print some progress information on console as well
-    connect(&archivesJob, &DownloadArchivesJob::outputTextChanged, [](const QString &progress) {
-        qDebug().noquote() << progress;
-    });
-    connect(&archivesJob, &DownloadArchivesJob::progressChanged,
-            [lastReported = -10, time = QTime::currentTime()](double progress) mutable {
-        int roughProgress = static_cast<int>(progress * 10) * 10;
-        if ((roughProgress > lastReported && time.elapsed() > 3000) || time.elapsed() > 15000) {
-            qDebug().nospace() << qMax(roughProgress, 1) << "% ...";
-            lastReported = roughProgress;
-            time.restart();
-        }
-    });
+    archivesJob.setArchiveSizes(d->archiveSizes(orderedComponentsToInstall()));
+    archivesJob.setArchiveDeltas(d->archiveDeltas(orderedComponentsToInstall()));
+    d->connectArchivesJob(&archivesJob, partProgressSize);
 
     archivesJob.start();
     archivesJob.waitForFinished();
@@ -909,11 +912,7 @@ PackageManagerCore::PackageManagerCore(qint64 magicmaker, const QList<OperationB
     // Every installed package should have at least one MinimalProgress operation.
     //
     QSet<QString> installedPackages = d->m_core->localInstalledPackages().keys().toSet();
-    QSet<QString> operationPackages;
-    foreach (QInstaller::Operation *operation, d->m_performedOperationsOld) {
-        if (operation->hasValue(QLatin1String("component")))
-            operationPackages.insert(operation->value(QLatin1String("component")).toString());
-    }
+    QSet<QString> operationPackages = d->performedOperationsComponents();
 
     QSet<QString> packagesWithoutOperation = installedPackages - operationPackages;
     QSet<QString> orphanedOperations = operationPackages - installedPackages;
@@ -1537,6 +1536,7 @@ ScriptEngine *PackageManagerCore::controlScriptEngine() const
 void PackageManagerCore::appendRootComponent(Component *component)
 {
     d->m_rootComponents.append(component);
+    d->invalidateComponentIndex();
     emit componentAdded(component);
 }
 
@@ -1607,6 +1607,7 @@ void PackageManagerCore::appendUpdaterComponent(Component *component)
 {
     component->setUpdateAvailable(true);
     d->m_updaterComponents.append(component);
+    d->invalidateComponentIndex();
     emit componentAdded(component);
 }
 
@@ -1618,7 +1619,7 @@ void PackageManagerCore::appendUpdaterComponent(Component *component)
 */
 Component *PackageManagerCore::componentByName(const QString &name) const
 {
-    return componentByName(name, components(ComponentType::AllNoReplacements));
+    return componentByName(name, d->componentIndex());
 }
 
 /*!
@@ -1646,6 +1647,50 @@ Component *PackageManagerCore::componentByName(const QString &name, const QList<
     return nullptr;
 }
 
+/*!
+    Looks up the component matching \a name in \a components, an index created by
+    componentIndex(). \a name can also contain a version requirement. If no component
+    matches the requirement, \c 0 is returned.
+*/
+Component *PackageManagerCore::componentByName(const QString &name,
+    const QHash<QString, QList<Component *> > &components)
+{
+    if (name.isEmpty())
+        return nullptr;
+
+    QString fixedVersion;
+    QString fixedName;
+
+    parseNameAndVersion(name, &fixedName, &fixedVersion);
+
+    foreach (Component *component, components.value(fixedName)) {
+        if (componentMatches(component, fixedName, fixedVersion))
+            return component;
+    }
+
+    return nullptr;
+}
+
+/*!
+    Returns \a components indexed by their names for lookups with componentByName(). Components
+    with the same name are kept in the order of \a components, so a lookup returns the same
+    component as a lookup in the list would.
+*/
+QHash<QString, QList<Component *> > PackageManagerCore::componentIndex(
+    const QList<Component *> &components)
+{
+    QHash<QString, QList<Component *> > index;
+    index.reserve(components.count());
+    foreach (Component *component, components)
+        index[component->name()].append(component);
+    return index;
+}
+
+void PackageManagerCore::invalidateComponentIndex()
+{
+    d->invalidateComponentIndex();
+}
+
 /*!
     Returns \c true if directory specified by \a path is writable by
     the current user.
@@ -1841,20 +1886,11 @@ QList<Component*> PackageManagerCore::dependees(const Component *_component) con
     if (!_component)
         return QList<Component *>();
 
-    const QList<QInstaller::Component *> availableComponents = components(ComponentType::All);
-    if (availableComponents.isEmpty())
-        return QList<Component *>();
-
     QList<Component *> dependees;
-    QString name;
-    QString version;
-    foreach (Component *component, availableComponents) {
-        const QStringList &dependencies = component->dependencies();
-        foreach (const QString &dependency, dependencies) {
-            parseNameAndVersion(dependency, &name, &version);
-            if (componentMatches(_component, name, version))
-                dependees.append(component);
-        }
+    typedef QPair<Component *, QString> Dependee;
+    foreach (const Dependee &dependee, d->dependeeIndex().value(_component->name())) {
+        if (componentMatches(_component, _component->name(), dependee.second))
+            dependees.append(dependee.first);
     }
     return dependees;
 }
@@ -2121,17 +2157,11 @@ bool PackageManagerCore::killProcess(const QString &absoluteFilePath) const
         if (processPath == normalizedPath) {
             qDebug().nospace() << "try to kill process " << process.name << " (" << process.id << ")";
 
-            //to keep the ui responsible use QtConcurrent::run
-            QFutureWatcher<bool> futureWatcher;
-            const QFuture<bool> future = QtConcurrent::run(KDUpdater::killProcess, process, 30000);
-
-            QEventLoop loop;
-            connect(&futureWatcher, &QFutureWatcher<bool>::finished,
-                    &loop, &QEventLoop::quit, Qt::QueuedConnection);
-            futureWatcher.setFuture(future);
-
-            if (!future.isFinished())
-                loop.exec();
+            //to keep the ui responsible kill the process in the background
+            const QFuture<bool> future = OperationExecutor::run([process]() {
+                return KDUpdater::killProcess(process, 30000);
+            });
+            OperationExecutor::waitForFinished(future);
 
             qDebug() << process.name << "killed!";
             return future.result();
@@ -2337,24 +2367,7 @@ bool PackageManagerCore::performOperation(const QString &name, const QStringList
 */
 bool PackageManagerCore::versionMatches(const QString &version, const QString &requirement)
 {
-    QRegExp compEx(QLatin1String("([<=>]+)(.*)"));
-    const QString comparator = compEx.exactMatch(requirement) ? compEx.cap(1) : QLatin1String("=");
-    const QString ver = compEx.exactMatch(requirement) ? compEx.cap(2) : requirement;
-
-    const bool allowEqual = comparator.contains(QLatin1Char('='));
-    const bool allowLess = comparator.contains(QLatin1Char('<'));
-    const bool allowMore = comparator.contains(QLatin1Char('>'));
-
-    if (allowEqual && version == ver)
-        return true;
-
-    if (allowLess && KDUpdater::compareVersion(ver, version) > 0)
-        return true;
-
-    if (allowMore && KDUpdater::compareVersion(ver, version) < 0)
-        return true;
-
-    return false;
+    return versionKeyMatches(KDUpdater::VersionKey(version), requirement);
 }
 
 /*!
@@ -2874,6 +2887,7 @@ void PackageManagerCore::storeReplacedComponents(QHash<QString, Component *> &co
                 // This case can happen when in installer mode as well, a component
                 // is in the installer binary and its replacement component as well.
                 d->replacementDependencyComponents().append(componentToReplace);
+                d->invalidateComponentIndex();
             }
             d->componentsToReplace().insert(componentName, qMakePair(it.key(), componentToReplace));
         }
@@ -2953,6 +2967,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
         if (updateComponentData(data, component.data())) {
             // Keep a reference so we can resolve dependencies during update.
             d->m_updaterComponentsDeps.append(component.take());
+            d->invalidateComponentIndex();
 
 //            const QString isNew = update->data(scNewComponent).toString();
 //            if (isNew.toLower() != scTrue)
@@ -2996,6 +3011,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
 
             // this is not a dependency, it is a real update
             components.insert(name, d->m_updaterComponentsDeps.takeLast());
+            d->invalidateComponentIndex();
         }
     }
 
@@ -3004,6 +3020,7 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
         QInstaller::Component *component = new QInstaller::Component(this);
         component->loadDataFromPackage(installedPackages.value(key));
         d->m_updaterComponentsDeps.append(component);
+        d->invalidateComponentIndex();
         // Keep a list of local components that should be replaced
         if (replaceMes.contains(component->name()))
             localReplaceMes.insert(component->name(), component);
@@ -112,6 +112,9 @@ public:
     static void setCreateLocalRepositoryFromBinary(bool create);
 
     static Component *componentByName(const QString &name, const QList<Component *> &components);
+    static Component *componentByName(const QString &name,
+        const QHash<QString, QList<Component *> > &components);
+    static QHash<QString, QList<Component *> > componentIndex(const QList<Component *> &components);
 
     bool directoryWritable(const QString &path) const;
 
@@ -361,6 +364,11 @@ private:
     PackageManagerCorePrivate *const d;
     friend class PackageManagerCorePrivate;
 
+private:
+    // called by components whose name or children changed
+    friend class Component;
+    void invalidateComponentIndex();
+
 private:
     // remove once we deprecate isSelected, setSelected etc...
     friend class ComponentSelectionPage;
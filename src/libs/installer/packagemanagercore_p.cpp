@@ -28,17 +28,22 @@
 #include "packagemanagercore_p.h"
 
 #include "adminauthorization.h"
+#include "archivedelta.h"
 #include "binarycontent.h"
 #include "binaryformatenginehandler.h"
 #include "binarylayout.h"
 #include "component.h"
 #include "scriptengine.h"
 #include "componentmodel.h"
+#include "downloadarchivesjob.h"
 #include "errors.h"
+#include "extractarchiveoperation.h"
 #include "fileio.h"
 #include "remotefileengine.h"
 #include "graph.h"
 #include "messageboxhandler.h"
+#include "operationexecutor.h"
+#include "operationscheduler.h"
 #include "packagemanagercore.h"
 #include "progresscoordinator.h"
 #include "qprocesswrapper.h"
@@ -56,14 +61,15 @@
 #include <productkeycheck.h>
 
 #include <QSettings>
-#include <QtConcurrentRun>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
+#include <QtCore/QEventLoop>
 #include <QtCore/QUuid>
 #include <QtCore/QFuture>
-#include <QtCore/QFutureWatcher>
 #include <QtCore/QTemporaryFile>
+#include <QtCore/QThread>
+#include <QtCore/QTime>
 
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -106,6 +112,43 @@ private:
     Operation *m_operation;
 };
 
+// The progress weight of an operation besides the data it extracts, about the size of a small file.
+static const quint64 scOperationProgressWeight = 64 * 1024;
+
+// Keeps the installation, update and uninstallation from being started again by the events
+// processed while one of them waits for work done in the background.
+class DriverStateTransition
+{
+    Q_DISABLE_COPY(DriverStateTransition)
+
+public:
+    DriverStateTransition(PackageManagerCorePrivate::DriverState &state,
+            PackageManagerCorePrivate::DriverState target)
+        : m_state(state)
+        , m_entered(state == PackageManagerCorePrivate::DriverState::Idle)
+    {
+        if (m_entered)
+            m_state = target;
+        else
+            qWarning() << "Cannot start while another installation step is running.";
+    }
+
+    ~DriverStateTransition()
+    {
+        if (m_entered)
+            m_state = PackageManagerCorePrivate::DriverState::Idle;
+    }
+
+    bool entered() const
+    {
+        return m_entered;
+    }
+
+private:
+    PackageManagerCorePrivate::DriverState &m_state;
+    const bool m_entered;
+};
+
 static bool runOperation(Operation *operation, PackageManagerCorePrivate::OperationType type)
 {
     OperationTracer tracer(operation);
@@ -215,6 +258,11 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core)
     , m_updaterModel(nullptr)
     , m_guiObject(nullptr)
     , m_remoteFileEngineHandler(nullptr)
+    , m_componentIndexValid(false)
+    , m_componentIndexUpdater(false)
+    , m_dependeeIndexValid(false)
+    , m_dependeeIndexUpdater(false)
+    , m_driverState(DriverState::Idle)
     , m_foundEssentialUpdate(false)
     , m_checkAvailableSpace(true)
 {
@@ -247,23 +295,15 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
     , m_updaterModel(nullptr)
     , m_guiObject(nullptr)
     , m_remoteFileEngineHandler(new RemoteFileEngineHandler)
+    , m_componentIndexValid(false)
+    , m_componentIndexUpdater(false)
+    , m_dependeeIndexValid(false)
+    , m_dependeeIndexUpdater(false)
+    , m_driverState(DriverState::Idle)
     , m_foundEssentialUpdate(false)
     , m_checkAvailableSpace(true)
 {
-    foreach (const OperationBlob &operation, performedOperations) {
-        QScopedPointer<QInstaller::Operation> op(KDUpdater::UpdateOperationFactory::instance()
-            .create(operation.name, core));
-        if (op.isNull()) {
-            qWarning() << "Failed to load unknown operation" << operation.name;
-            continue;
-        }
-
-        if (!op->fromXml(operation.xml)) {
-            qWarning() << "Failed to load XML for operation" << operation.name;
-            continue;
-        }
-        m_performedOperationsOld.append(op.take());
-    }
+    m_performedOperationBlobs = performedOperations;
 
     connect(this, &PackageManagerCorePrivate::installationStarted,
             m_core, &PackageManagerCore::installationStarted);
@@ -277,6 +317,7 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
 
 PackageManagerCorePrivate::~PackageManagerCorePrivate()
 {
+    m_operationScheduler.reset();
     clearAllComponentLists();
     clearUpdaterComponentLists();
     clearInstallerCalculator();
@@ -330,17 +371,14 @@ bool PackageManagerCorePrivate::isProcessRunning(const QString &name,
 /* static */
 bool PackageManagerCorePrivate::performOperationThreaded(Operation *operation, OperationType type)
 {
-    QFutureWatcher<bool> futureWatcher;
-    const QFuture<bool> future = QtConcurrent::run(runOperation, operation, type);
-
-    QEventLoop loop;
-    QObject::connect(&futureWatcher, &decltype(futureWatcher)::finished, &loop, &QEventLoop::quit,
-                     Qt::QueuedConnection);
-    futureWatcher.setFuture(future);
-
-    if (!future.isFinished())
-        loop.exec();
+    // handing a cheap operation over to another thread costs more than performing it
+    if (OperationExecutor::canRunInline(operation))
+        return runOperation(operation, type);
 
+    const QFuture<bool> future = OperationExecutor::run([operation, type]() {
+        return runOperation(operation, type);
+    });
+    OperationExecutor::waitForFinished(future);
     return future.result();
 }
 
@@ -479,6 +517,7 @@ void PackageManagerCorePrivate::clearAllComponentLists()
 
     toDelete << m_rootComponents;
     m_rootComponents.clear();
+    invalidateComponentIndex();
 
     m_rootDependencyReplacements.clear();
 
@@ -507,6 +546,7 @@ void PackageManagerCorePrivate::clearUpdaterComponentLists()
 
     m_updaterComponents.clear();
     m_updaterComponentsDeps.clear();
+    invalidateComponentIndex();
 
     m_updaterDependencyReplacements.clear();
 
@@ -517,6 +557,48 @@ void PackageManagerCorePrivate::clearUpdaterComponentLists()
     cleanUpComponentEnvironment();
 }
 
+/*!
+    Returns the components returned by PackageManagerCore::components() for
+    PackageManagerCore::ComponentType::AllNoReplacements, indexed by name. The index is rebuilt
+    on the first lookup after the component lists changed.
+*/
+const QHash<QString, QList<Component *> > &PackageManagerCorePrivate::componentIndex() const
+{
+    const bool updater = isUpdater();
+    if (!m_componentIndexValid || m_componentIndexUpdater != updater) {
+        m_componentIndex = PackageManagerCore::componentIndex(
+            m_core->components(PackageManagerCore::ComponentType::AllNoReplacements));
+        m_componentIndexValid = true;
+        m_componentIndexUpdater = updater;
+    }
+    return m_componentIndex;
+}
+
+/*!
+    Returns the dependencies of the components returned by PackageManagerCore::components() for
+    PackageManagerCore::ComponentType::All, indexed by the name of the component depended on. Each
+    entry holds the depending component and the required version. The index is rebuilt on the
+    first lookup after the component lists or dependencies changed.
+*/
+const QHash<QString, QList<QPair<Component *, QString> > > &PackageManagerCorePrivate::dependeeIndex() const
+{
+    const bool updater = isUpdater();
+    if (!m_dependeeIndexValid || m_dependeeIndexUpdater != updater) {
+        m_dependeeIndex.clear();
+        QString name;
+        QString version;
+        foreach (Component *component, m_core->components(PackageManagerCore::ComponentType::All)) {
+            foreach (const QString &dependency, component->dependencies()) {
+                PackageManagerCore::parseNameAndVersion(dependency, &name, &version);
+                m_dependeeIndex[name].append(qMakePair(component, version));
+            }
+        }
+        m_dependeeIndexValid = true;
+        m_dependeeIndexUpdater = updater;
+    }
+    return m_dependeeIndex;
+}
+
 QList<Component *> &PackageManagerCorePrivate::replacementDependencyComponents()
 {
     return (!isUpdater()) ? m_rootDependencyReplacements : m_updaterDependencyReplacements;
@@ -743,6 +825,8 @@ static QSet<Repository> readRepositories(QXmlStreamReader &reader, bool isDefaul
             while (reader.readNextStartElement()) {
                 if (reader.name() == QLatin1String("Host"))
                     repo.setUrl(reader.readElementText());
+                else if (reader.name() == QLatin1String("Mirror"))
+                    repo.setMirrors(repo.mirrors() << QUrl(reader.readElementText()));
                 else if (reader.name() == QLatin1String("Username"))
                     repo.setUsername(reader.readElementText());
                 else if (reader.name() == QLatin1String("Password"))
@@ -824,6 +908,8 @@ void PackageManagerCorePrivate::writeMaintenanceConfigFiles()
             foreach (const Repository &repo, m_data.settings().userRepositories()) {
                 writer.writeStartElement(QLatin1String("Repository"));
                     writer.writeTextElement(QLatin1String("Host"), repo.url().toString());
+                    foreach (const QUrl &mirror, repo.mirrors())
+                        writer.writeTextElement(QLatin1String("Mirror"), mirror.toString());
                     writer.writeTextElement(QLatin1String("Username"), repo.username());
                     writer.writeTextElement(QLatin1String("Password"), repo.password());
                     writer.writeTextElement(QLatin1String("Enabled"), QString::number(repo.isEnabled()));
@@ -835,6 +921,8 @@ void PackageManagerCorePrivate::writeMaintenanceConfigFiles()
             foreach (const Repository &repo, m_data.settings().virtualRepositories()) {
                 writer.writeStartElement(QLatin1String("Repository"));
                     writer.writeTextElement(QLatin1String("Host"), repo.url().toString());
+                    foreach (const QUrl &mirror, repo.mirrors())
+                        writer.writeTextElement(QLatin1String("Mirror"), mirror.toString());
                     writer.writeTextElement(QLatin1String("Username"), repo.username());
                     writer.writeTextElement(QLatin1String("Password"), repo.password());
                     writer.writeTextElement(QLatin1String("Enabled"), QString::number(repo.isEnabled()));
@@ -941,15 +1029,21 @@ void PackageManagerCorePrivate::stopProcessesForUpdates(const QList<Component*>
     }
 }
 
+static bool hasProgressSignal(Operation *operation)
+{
+    if (QObject *operationObject = dynamic_cast<QObject*> (operation)) {
+        const QMetaObject *const mo = operationObject->metaObject();
+        return mo->indexOfSignal(QMetaObject::normalizedSignature("progressChanged(double)")) > -1;
+    }
+    return false;
+}
+
 int PackageManagerCorePrivate::countProgressOperations(const OperationList &operations)
 {
     int operationCount = 0;
     foreach (Operation *operation, operations) {
-        if (QObject *operationObject = dynamic_cast<QObject*> (operation)) {
-            const QMetaObject *const mo = operationObject->metaObject();
-            if (mo->indexOfSignal(QMetaObject::normalizedSignature("progressChanged(double)")) > -1)
-                operationCount++;
-        }
+        if (hasProgressSignal(operation))
+            operationCount++;
     }
     return operationCount;
 }
@@ -963,6 +1057,45 @@ int PackageManagerCorePrivate::countProgressOperations(const QList<Component*> &
     return operationCount;
 }
 
+/*!
+    Returns the progress weight of installing \a components, see progressWeight(Component *).
+*/
+quint64 PackageManagerCorePrivate::progressWeight(const QList<Component*> &components) const
+{
+    quint64 weight = 0;
+    foreach (Component *component, components)
+        weight += progressWeight(component);
+    return weight;
+}
+
+/*!
+    Returns the progress weight of installing \a component, which is the uncompressed size of its
+    data plus a small fixed amount for its scripts and operations. The weight is taken from the
+    metadata, so the operations of the component do not need to exist yet.
+*/
+quint64 PackageManagerCorePrivate::progressWeight(Component *component) const
+{
+    return component->value(scUncompressedSize).toULongLong() + scOperationProgressWeight;
+}
+
+/*!
+    Returns the share of the download in the progress of downloading and installing
+    \a components, based on the compressed size of the archives to download and the
+    \a installWeight. Returns \a defaultShare if the sizes are not known.
+*/
+double PackageManagerCorePrivate::downloadProgressShare(const QList<Component*> &components,
+    quint64 installWeight, double defaultShare) const
+{
+    quint64 downloadWeight = 0;
+    foreach (Component *component, components) {
+        if (!component->downloadableArchives().isEmpty())
+            downloadWeight += component->value(scCompressedSize).toULongLong();
+    }
+    if (downloadWeight == 0 || installWeight == 0)
+        return defaultShare;
+    return double(downloadWeight) / double(downloadWeight + installWeight);
+}
+
 void PackageManagerCorePrivate::connectOperationToInstaller(Operation *const operation, double operationPartSize)
 {
     Q_ASSERT(operationPartSize);
@@ -1134,16 +1267,20 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinaryData(QFileDevice *outp
         QInstaller::appendData(output, input, segment.length());
     }
 
-    const qint64 operationsStart = output->pos();
-    QInstaller::appendInt64(output, performedOperations.count());
+    QList<OperationBlob> operations;
+    operations.reserve(performedOperations.count());
     foreach (Operation *operation, performedOperations) {
-        QInstaller::appendString(output, operation->name());
-        QInstaller::appendString(output, operation->toXml().toString());
+        QStringList arguments;
+        QVariantMap values;
+        operation->toBinary(&arguments, &values);
+        operations.append(OperationBlob(operation->name(), arguments, values));
 
         // for the ui not to get blocked
         qApp->processEvents();
     }
-    QInstaller::appendInt64(output, performedOperations.count());
+
+    const qint64 operationsStart = output->pos();
+    BinaryContent::writeOperations(output, operations);
     const qint64 operationsEnd = output->pos();
 
     // we don't save any component-indexes.
@@ -1450,6 +1587,10 @@ QString PackageManagerCorePrivate::registerPath()
 
 bool PackageManagerCorePrivate::runInstaller()
 {
+    DriverStateTransition transition(m_driverState, DriverState::Installing);
+    if (!transition.entered())
+        return false;
+
     bool adminRightsGained = false;
     try {
         setStatus(PackageManagerCore::Running);
@@ -1523,9 +1664,24 @@ bool PackageManagerCorePrivate::runInstaller()
             }
         }
 
-        const double downloadPartProgressSize = double(1) / double(3);
-        double componentsInstallPartProgressSize = double(2) / double(3);
-        const int downloadedArchivesCount = m_core->downloadNeededArchives(downloadPartProgressSize);
+        const quint64 installWeight = progressWeight(componentsToInstall)
+            // add one more operation as we support progress
+            + (PackageManagerCore::createLocalRepositoryFromBinary() ? scOperationProgressWeight : 0);
+        // weight the download and the installation by the number of bytes they handle
+        const double downloadPartProgressSize = downloadProgressShare(componentsToInstall,
+            installWeight, double(1) / double(3));
+        double componentsInstallPartProgressSize = 1 - downloadPartProgressSize;
+
+        // In pipelined mode the archives are downloaded while the components get installed.
+        const bool pipelined = isPipelinedInstallation();
+        QList<QPair<QString, QString> > archives;
+        int downloadedArchivesCount = 0;
+        if (pipelined) {
+            archives = archivesToDownload(componentsToInstall);
+            downloadedArchivesCount = archives.count();
+        } else {
+            downloadedArchivesCount = m_core->downloadNeededArchives(downloadPartProgressSize);
+        }
 
         // if there was no download we have the whole progress for installing components
         if (!downloadedArchivesCount)
@@ -1540,13 +1696,22 @@ bool PackageManagerCorePrivate::runInstaller()
             m_data.settings().applicationName()).toString());
         m_localPackageHub->setApplicationVersion(QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)));
 
-        const int progressOperationCount = countProgressOperations(componentsToInstall)
-            // add one more operation as we support progress
-            + (PackageManagerCore::createLocalRepositoryFromBinary() ? 1 : 0);
-        double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
+        const double progressWeightSize = componentsInstallPartProgressSize
+            / qMax<quint64>(1, installWeight);
 
-        foreach (Component *component, componentsToInstall)
-            installComponent(component, progressOperationSize, adminRightsGained);
+        setupOperationScheduler();
+        if (pipelined && !archives.isEmpty()) {
+            installComponentsPipelined(componentsToInstall, archives, downloadPartProgressSize,
+                progressWeightSize, adminRightsGained);
+        } else {
+            for (int i = 0; i < componentsToInstall.count(); ++i) {
+                prefetchOperations(componentsToInstall, i);
+                installComponent(componentsToInstall.at(i), progressWeightSize, adminRightsGained);
+            }
+        }
+        m_operationScheduler.reset();
+        // compact the journal written after each component into the components xml
+        m_localPackageHub->writeToDisk();
 
         if (m_core->isOfflineOnly() && PackageManagerCore::createLocalRepositoryFromBinary()) {
             emit m_core->titleMessageChanged(tr("Creating local repository"));
@@ -1569,7 +1734,7 @@ bool PackageManagerCorePrivate::runInstaller()
                 createRepo->setArguments(QStringList() << binaryFile << target
                     + QLatin1String("/repository"));
 
-                connectOperationToInstaller(createRepo, progressOperationSize);
+                connectOperationToInstaller(createRepo, progressWeightSize * scOperationProgressWeight);
 
                 bool success = performOperationThreaded(createRepo);
                 if (!success) {
@@ -1597,7 +1762,7 @@ bool PackageManagerCorePrivate::runInstaller()
 
         emit m_core->titleMessageChanged(tr("Creating Maintenance Tool"));
 
-        writeMaintenanceTool(m_performedOperationsOld + m_performedOperationsCurrentSession);
+        writeMaintenanceTool(performedOperationsOld() + m_performedOperationsCurrentSession);
 
         // fake a possible wrong value to show a full progress bar
         const int progress = ProgressCoordinator::instance()->progressInPercentage();
@@ -1618,6 +1783,7 @@ bool PackageManagerCorePrivate::runInstaller()
             qDebug() << "ROLLING BACK operations=" << m_performedOperationsCurrentSession.count();
         }
 
+        discardScheduledOperations();
         m_core->rollBackInstallation();
 
         ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nInstallation aborted!"));
@@ -1631,10 +1797,15 @@ bool PackageManagerCorePrivate::runInstaller()
 
 bool PackageManagerCorePrivate::runPackageUpdater()
 {
-    bool adminRightsGained = false;
     if (m_completeUninstall) {
         return runUninstaller();
     }
+
+    DriverStateTransition transition(m_driverState, DriverState::Updating);
+    if (!transition.entered())
+        return false;
+
+    bool adminRightsGained = false;
     try {
         setStatus(PackageManagerCore::Running);
         emit installationStarted(); //resets also the ProgressCoordninator
@@ -1672,7 +1843,7 @@ bool PackageManagerCorePrivate::runPackageUpdater()
         QHash<QString, Component *> componentsByName;
 
         // order the operations in the right component dependency order
-        OperationList performedOperationsOld = sortOperationsBasedOnComponentDependencies(m_performedOperationsOld);
+        OperationList performedOperationsOld = sortOperationsBasedOnComponentDependencies(performedOperationsOld());
 
         // build a list of undo operations based on the checked state of the component
         foreach (Operation *operation, performedOperationsOld) {
@@ -1740,14 +1911,22 @@ bool PackageManagerCorePrivate::runPackageUpdater()
         }
 
         double undoOperationProgressSize = 0;
-        const double downloadPartProgressSize = double(2) / double(5);
-        double componentsInstallPartProgressSize = double(3) / double(5);
+        double downloadAndInstallPartProgressSize = 1;
+        double defaultDownloadShare = double(2) / double(5);
         if (undoOperations.count() > 0) {
             undoOperationProgressSize = double(1) / double(5);
-            componentsInstallPartProgressSize = downloadPartProgressSize;
+            downloadAndInstallPartProgressSize = double(4) / double(5);
+            defaultDownloadShare = double(1) / double(2);
             undoOperationProgressSize /= countProgressOperations(undoOperations);
         }
 
+        // weight the download and the installation by the number of bytes they handle
+        const quint64 installWeight = progressWeight(componentsToInstall);
+        const double downloadPartProgressSize = downloadAndInstallPartProgressSize
+            * downloadProgressShare(componentsToInstall, installWeight, defaultDownloadShare);
+        const double componentsInstallPartProgressSize = downloadAndInstallPartProgressSize
+            - downloadPartProgressSize;
+
         ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("Preparing the installation..."));
 
         // following, we download the needed archives
@@ -1759,11 +1938,17 @@ bool PackageManagerCorePrivate::runPackageUpdater()
         }
         m_performedOperationsOld = nonRevertedOperations; // these are all operations left: those not reverted
 
-        const double progressOperationCount = countProgressOperations(componentsToInstall);
-        const double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
+        const double progressWeightSize = componentsInstallPartProgressSize
+            / qMax<quint64>(1, installWeight);
 
-        foreach (Component *component, componentsToInstall)
-            installComponent(component, progressOperationSize, adminRightsGained);
+        setupOperationScheduler();
+        for (int i = 0; i < componentsToInstall.count(); ++i) {
+            prefetchOperations(componentsToInstall, i);
+            installComponent(componentsToInstall.at(i), progressWeightSize, adminRightsGained);
+        }
+        m_operationScheduler.reset();
+        // compact the journal written after each component into the components xml
+        m_localPackageHub->writeToDisk();
 
         emit m_core->titleMessageChanged(tr("Creating Maintenance Tool"));
 
@@ -1789,6 +1974,7 @@ bool PackageManagerCorePrivate::runPackageUpdater()
             qDebug() << "ROLLING BACK operations=" << m_performedOperationsCurrentSession.count();
         }
 
+        discardScheduledOperations();
         m_core->rollBackInstallation();
 
         ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nUpdate aborted!"));
@@ -1802,6 +1988,10 @@ bool PackageManagerCorePrivate::runPackageUpdater()
 
 bool PackageManagerCorePrivate::runUninstaller()
 {
+    DriverStateTransition transition(m_driverState, DriverState::Uninstalling);
+    if (!transition.entered())
+        return false;
+
     emit uninstallationStarted();
     bool adminRightsGained = false;
 
@@ -1812,12 +2002,12 @@ bool PackageManagerCorePrivate::runUninstaller()
         if (!directoryWritable(targetDir()))
             adminRightsGained = m_core->gainAdminRights();
 
-        OperationList undoOperations = m_performedOperationsOld;
+        OperationList undoOperations = performedOperationsOld();
         std::reverse(undoOperations.begin(), undoOperations.end());
 
         bool updateAdminRights = false;
         if (!adminRightsGained) {
-            foreach (Operation *op, m_performedOperationsOld) {
+            foreach (Operation *op, performedOperationsOld()) {
                 updateAdminRights |= op->value(QLatin1String("admin")).toBool();
                 if (updateAdminRights)
                     break;  // an operation needs elevation to be able to perform their undo
@@ -1868,7 +2058,7 @@ bool PackageManagerCorePrivate::runUninstaller()
     return success;
 }
 
-void PackageManagerCorePrivate::installComponent(Component *component, double progressOperationSize,
+void PackageManagerCorePrivate::installComponent(Component *component, double progressWeightSize,
     bool adminRightsGained)
 {
     const OperationList operations = component->operations();
@@ -1884,10 +2074,34 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
         showDetailsLog = true;
     }
 
+    // Share the progress of the component between its operations. Each operation counts like a
+    // small file, extract operations additionally count with the data they extract.
+    int progressCount = 0;
+    int extractCount = 0;
+    foreach (Operation *operation, operations) {
+        if (hasProgressSignal(operation)) {
+            ++progressCount;
+            if (operation->name() == QLatin1String("Extract"))
+                ++extractCount;
+        }
+    }
+    const quint64 extractWeight = extractCount > 0
+        ? component->value(scUncompressedSize).toULongLong() / extractCount : 0;
+    const double operationsWeight = double(progressCount) * scOperationProgressWeight
+        + double(extractCount) * extractWeight;
+    const double progressSizePerWeight = progressWeightSize * progressWeight(component)
+        / qMax(1.0, operationsWeight);
+
     foreach (Operation *operation, operations) {
         if (statusCanceledOrFailed())
             throw Error(tr("Installation canceled by user"));
 
+        // operations of other components must not run while elevating or asking the user
+        if (m_operationScheduler && !m_operationScheduler->isScheduled(operation)
+                && OperationScheduler::isSerializationPoint(operation)) {
+            m_operationScheduler->waitForScheduled();
+        }
+
         // maybe this operations wants us to be admin...
         bool becameAdmin = false;
         if (!adminRightsGained && operation->value(QLatin1String("admin")).toBool()) {
@@ -1895,14 +2109,40 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
             qDebug() << operation->name() << "as admin:" << becameAdmin;
         }
 
-        connectOperationToInstaller(operation, progressOperationSize);
+        // A scheduled operation is connected only once it finished in the background, so that
+        // its output shows up for this component and not while others are installed.
+        OperationScheduler::Result result = OperationScheduler::Result::Skipped;
+        QStringList outputText;
+        if (m_operationScheduler && m_operationScheduler->isScheduled(operation))
+            result = m_operationScheduler->takeResult(operation, &outputText);
+
+        const quint64 weight = scOperationProgressWeight
+            + (operation->name() == QLatin1String("Extract") ? extractWeight : 0);
+        connectOperationToInstaller(operation, qMin(1.0, progressSizePerWeight * weight));
         connectOperationCallMethodRequest(operation);
 
-        // allow the operation to backup stuff before performing the operation
-        performOperationThreaded(operation, PackageManagerCorePrivate::Backup);
+        foreach (const QString &text, outputText)
+            ProgressCoordinator::instance()->emitDetailTextChanged(text);
+        if (result == OperationScheduler::Result::Performed && hasProgressSignal(operation)) {
+            // the intermediate progress was not reported
+            QMetaObject::invokeMethod(dynamic_cast<QObject *>(operation), "progressChanged",
+                Q_ARG(double, 1.0));
+        }
 
         bool ignoreError = false;
-        bool ok = performOperationThreaded(operation);
+        bool ok = false;
+        if (result == OperationScheduler::Result::Performed) {
+            ok = true;
+        } else if (result == OperationScheduler::Result::Failed) {
+            if (m_core->status() != PackageManagerCore::Canceled) {
+                qDebug() << "Background operation failed, retrying:" << operation->errorString();
+                ok = performOperationThreaded(operation);
+            }
+        } else {
+            // allow the operation to backup stuff before performing the operation
+            performOperationThreaded(operation, PackageManagerCorePrivate::Backup);
+            ok = performOperationThreaded(operation);
+        }
         while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
             qDebug() << QString::fromLatin1("Operation \"%1\" with arguments \"%2\" failed: %3")
                 .arg(operation->name(), operation->arguments().join(QLatin1String("; ")),
@@ -1962,7 +2202,7 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
                                   component->value(scInheritVersion),
                                   component->isCheckable(),
                                   component->isExpandedByDefault());
-    m_localPackageHub->writeToDisk();
+    m_localPackageHub->writeJournal();
 
     component->setInstalled();
     component->markAsPerformedInstallation();
@@ -1971,8 +2211,299 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
         ProgressCoordinator::instance()->emitDetailTextChanged(tr("Done"));
 }
 
+/*!
+    Returns the archives of \a components that need to be downloaded. The first value of each pair
+    contains the file name used to register the archive in the installer's internal file system, the
+    second one the source url. The archives are returned in the order of \a components.
+*/
+QList<QPair<QString, QString> > PackageManagerCorePrivate::archivesToDownload(
+    const QList<Component *> &components) const
+{
+    QList<QPair<QString, QString> > archives;
+    foreach (Component *component, components) {
+        // collect all archives to be downloaded
+        const QStringList toDownload = component->downloadableArchives();
+        foreach (const QString &versionFreeString, toDownload) {
+            archives.push_back(qMakePair(QString::fromLatin1("installer://%1/%2")
+                .arg(component->name(), versionFreeString), QString::fromLatin1("%1/%2/%3")
+                .arg(component->repositoryUrl().toString(), component->name(), versionFreeString)));
+        }
+    }
+    return archives;
+}
+
+/*!
+    Returns the expected download sizes of the archives of \a components, keyed like the archives
+    returned by archivesToDownload(). The compressed size of a component is split evenly between
+    its archives.
+*/
+QHash<QString, quint64> PackageManagerCorePrivate::archiveSizes(const QList<Component *> &components) const
+{
+    QHash<QString, quint64> sizes;
+    foreach (Component *component, components) {
+        const QStringList toDownload = component->downloadableArchives();
+        if (toDownload.isEmpty())
+            continue;
+        const quint64 size = component->value(scCompressedSize).toULongLong() / toDownload.count();
+        foreach (const QString &versionFreeString, toDownload) {
+            sizes.insert(QString::fromLatin1("installer://%1/%2").arg(component->name(),
+                versionFreeString), size);
+        }
+    }
+    return sizes;
+}
+
+/*!
+    Returns the delta archives that update the installed versions of \a components, keyed like
+    the archives returned by archivesToDownload(). A delta is only used if it applies to the
+    installed version of the component and the directory its archive was extracted to is known
+    from the performed operations, as the unchanged files are taken from there.
+*/
+QHash<QString, ArchiveDelta> PackageManagerCorePrivate::archiveDeltas(const QList<Component *> &components)
+{
+    QHash<QString, ArchiveDelta> deltas;
+    foreach (Component *component, components) {
+        const QString installedVersion = component->value(scInstalledVersion);
+        if (installedVersion.isEmpty())
+            continue;
+
+        foreach (ArchiveDelta delta, ArchiveDelta::fromString(component->value(scDeltaArchives))) {
+            if (delta.baseVersion() != installedVersion)
+                continue;
+
+            const QString baseArchive = QString::fromLatin1("installer://%1/%2%3")
+                .arg(component->name(), installedVersion, delta.archive());
+            foreach (const Operation *operation, performedOperationsOld()) {
+                if (operation->name() == QLatin1String("Extract")
+                    && operation->arguments().value(0) == baseArchive) {
+                        delta.setBaseDirectory(operation->arguments().value(1));
+                        break;
+                }
+            }
+            if (delta.baseDirectory().isEmpty() || !QFileInfo(delta.baseDirectory()).isDir())
+                continue;
+
+            deltas.insert(QString::fromLatin1("installer://%1/%2%3").arg(component->name(),
+                component->value(scVersion), delta.archive()), delta);
+        }
+    }
+    return deltas;
+}
+
+/*!
+    Connects the signals of \a archivesJob to the progress coordinator and the log output.
+    \a partProgressSize is reserved for the download progress.
+*/
+void PackageManagerCorePrivate::connectArchivesJob(DownloadArchivesJob *archivesJob,
+    double partProgressSize)
+{
+    connect(m_core, &PackageManagerCore::installationInterrupted, archivesJob, &Job::cancel);
+    connect(archivesJob, &DownloadArchivesJob::outputTextChanged,
+            ProgressCoordinator::instance(), &ProgressCoordinator::emitLabelAndDetailTextChanged);
+    connect(archivesJob, &DownloadArchivesJob::downloadStatusChanged,
+            ProgressCoordinator::instance(), &ProgressCoordinator::downloadStatusChanged);
+
+    ProgressCoordinator::instance()->registerPartProgress(archivesJob,
+        SIGNAL(progressChanged(double)), partProgressSize);
+
+    // Print some progress information on console as well
+    connect(archivesJob, &DownloadArchivesJob::outputTextChanged, [](const QString &progress) {
+        qDebug().noquote() << progress;
+    });
+    connect(archivesJob, &DownloadArchivesJob::progressChanged,
+            [lastReported = -10, time = QTime::currentTime()](double progress) mutable {
+        int roughProgress = static_cast<int>(progress * 10) * 10;
+        if ((roughProgress > lastReported && time.elapsed() > 3000) || time.elapsed() > 15000) {
+            qDebug().nospace() << qMax(roughProgress, 1) << "% ...";
+            lastReported = roughProgress;
+            time.restart();
+        }
+    });
+}
+
 // -- private
 
+bool PackageManagerCorePrivate::isPipelinedInstallation() const
+{
+    return QVariant(m_core->value(scPipelinedInstallation, scFalse)).toBool();
+}
+
+void PackageManagerCorePrivate::setupOperationScheduler()
+{
+    m_operationScheduler.reset();
+
+    bool ok = false;
+    const int count = m_core->value(scMaxConcurrentExtractions).toInt(&ok);
+    if (!ok || count <= 0)
+        return;
+
+    m_operationScheduler.reset(new OperationScheduler(qMin(count,
+        qMax(1, QThread::idealThreadCount()))));
+    qDebug() << "Performing operations of up to" << m_operationScheduler->maxThreadCount()
+        << "components in the background.";
+}
+
+/*!
+    Schedules the operations of the \a components following the one at \a index, until the
+    operation scheduler is busy. A component is only scheduled once all components it depends on
+    are installed, so its operations can run next to the ones of the components installed before
+    it. Only the operations at the beginning of a component's operation list that can run in the
+    background are scheduled; the remaining ones are performed by installComponent(). At most as
+    many components as the scheduler has threads are busy at the same time.
+
+    Components with archives in \a pendingArchives are skipped, as their operations can only be
+    created once all of their archives are registered.
+*/
+void PackageManagerCorePrivate::prefetchOperations(const QList<Component *> &components, int index,
+    const QSet<QString> &pendingArchives)
+{
+    if (!m_operationScheduler)
+        return;
+
+    // the components from index on are not installed yet
+    QSet<Component *> pending;
+    for (int i = index; i < components.count(); ++i)
+        pending.insert(components.at(i));
+
+    int scheduledCount = 0;
+    const int maxCount = m_operationScheduler->maxThreadCount();
+    for (int i = index + 1; i < components.count(); ++i) {
+        if (scheduledCount >= maxCount)
+            return;
+
+        Component *const component = components.at(i);
+        bool dependencyPending = false;
+        foreach (Component *dependency, installerCalculator()->dependenciesToInstall(component)) {
+            if (pending.contains(dependency)) {
+                dependencyPending = true;
+                break;
+            }
+        }
+        if (dependencyPending)
+            continue;
+
+        // the operations are created only once, from the archives registered at that time
+        bool archivePending = false;
+        foreach (const QString &versionFreeString, component->downloadableArchives()) {
+            if (pendingArchives.contains(QString::fromLatin1("installer://%1/%2")
+                    .arg(component->name(), versionFreeString))) {
+                archivePending = true;
+                break;
+            }
+        }
+        if (archivePending)
+            continue;
+
+        const OperationList operations = component->operations();
+        if (!component->operationsCreatedSuccessfully())
+            return;
+        if (operations.isEmpty())
+            continue;
+        // operations are taken in order, so the component is still busy if its first one is
+        if (m_operationScheduler->isScheduled(operations.first())) {
+            ++scheduledCount;
+            continue;
+        }
+
+        OperationList prefix;
+        foreach (Operation *operation, operations) {
+            if (!m_operationScheduler->canSchedule(operation))
+                break;
+            prefix.append(operation);
+        }
+        if (!prefix.isEmpty()) {
+            m_operationScheduler->schedule(prefix);
+            ++scheduledCount;
+        }
+    }
+}
+
+/*!
+    Waits for the running background operations and undoes the ones that were not yet taken over
+    by the installation, as they are not part of the performed operations.
+*/
+void PackageManagerCorePrivate::discardScheduledOperations()
+{
+    if (!m_operationScheduler)
+        return;
+
+    foreach (Operation *operation, m_operationScheduler->discard())
+        performOperationThreaded(operation, Undo);
+    m_operationScheduler.reset();
+}
+
+/*!
+    Installs \a components while their \a archives are still being downloaded. A component is
+    installed as soon as all of its archives have been downloaded and verified. The components are
+    installed in the given order, which already places every dependency before its dependees, so the
+    archives of all dependencies are available as well at that point.
+*/
+void PackageManagerCorePrivate::installComponentsPipelined(const QList<Component *> &components,
+    const QList<QPair<QString, QString> > &archives, double downloadPartProgressSize,
+    double progressWeightSize, bool adminRightsGained)
+{
+    QSet<QString> pendingArchives;
+    for (const QPair<QString, QString> &archive : archives)
+        pendingArchives.insert(archive.first);
+
+    ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nDownloading packages..."));
+
+    DownloadArchivesJob archivesJob(m_core);
+    archivesJob.setAutoDelete(false);
+    archivesJob.setArchivesToDownload(archives);
+    archivesJob.setArchiveSizes(archiveSizes(components));
+    connectArchivesJob(&archivesJob, downloadPartProgressSize);
+
+    bool downloadFinished = false;
+    connect(&archivesJob, &DownloadArchivesJob::archiveRegistered, [&pendingArchives](const QString &name) {
+        pendingArchives.remove(name);
+    });
+    connect(&archivesJob, &Job::finished, [&downloadFinished]() {
+        downloadFinished = true;
+    });
+
+    const auto checkDownloadError = [this, &archivesJob]() {
+        if (archivesJob.error() == Job::Canceled)
+            m_core->interrupt();
+        else if (archivesJob.error() != Job::NoError)
+            throw Error(archivesJob.errorString());
+
+        if (statusCanceledOrFailed())
+            throw Error(tr("Installation canceled by user."));
+    };
+
+    archivesJob.start();
+    foreach (Component *component, components) {
+        const QStringList componentArchives = component->downloadableArchives();
+        const auto hasPendingArchive = [&]() {
+            foreach (const QString &versionFreeString, componentArchives) {
+                if (pendingArchives.contains(QString::fromLatin1("installer://%1/%2")
+                        .arg(component->name(), versionFreeString))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        while (!downloadFinished && hasPendingArchive()) {
+            QEventLoop loop;
+            connect(&archivesJob, &DownloadArchivesJob::archiveRegistered, &loop, &QEventLoop::quit);
+            connect(&archivesJob, &Job::finished, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        checkDownloadError();
+
+        prefetchOperations(components, components.indexOf(component), pendingArchives);
+        installComponent(component, progressWeightSize, adminRightsGained);
+    }
+
+    if (!downloadFinished)
+        archivesJob.waitForFinished();
+    checkDownloadError();
+
+    ProgressCoordinator::instance()->emitDownloadStatus(tr("All downloads finished."));
+}
+
 void PackageManagerCorePrivate::deleteMaintenanceTool()
 {
 #ifdef Q_OS_WIN
@@ -2009,8 +2540,8 @@ void PackageManagerCorePrivate::deleteMaintenanceTool()
     QStringList arguments;
     arguments << QLatin1String("//Nologo") << batchfile; // execute the batchfile
     arguments << QDir::toNativeSeparators(QFileInfo(installerBinaryPath()).absoluteFilePath());
-    if (!m_performedOperationsOld.isEmpty()) {
-        const Operation *const op = m_performedOperationsOld.first();
+    if (!performedOperationsOld().isEmpty()) {
+        const Operation *const op = performedOperationsOld().first();
         if (op->name() == QLatin1String("Mkdir")) // the target directory name
             arguments << QDir::toNativeSeparators(QFileInfo(op->arguments().first()).absoluteFilePath());
     }
@@ -2089,23 +2620,62 @@ void PackageManagerCorePrivate::unregisterMaintenanceTool()
 #endif
 }
 
+// Returns the consecutive extract operations starting at index that share their need for
+// elevated rights.
+static QList<ExtractArchiveOperation *> consecutiveExtractOperations(const OperationList &operations,
+    int index)
+{
+    QList<ExtractArchiveOperation *> extractOperations;
+    const bool admin = operations.at(index)->value(QLatin1String("admin")).toBool();
+    for (int i = index; i < operations.count(); ++i) {
+        Operation *const operation = operations.at(i);
+        ExtractArchiveOperation *const extractOperation =
+            dynamic_cast<ExtractArchiveOperation *>(operation);
+        if (!extractOperation || operation->arguments().count() != 2
+                || operation->value(QLatin1String("admin")).toBool() != admin) {
+            break;
+        }
+        extractOperations.append(extractOperation);
+    }
+    return extractOperations;
+}
+
 void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOperations, double progressSize,
     bool adminRightsGained, bool deleteOperation)
 {
     try {
-        foreach (Operation *undoOperation, undoOperations) {
+        QSet<Operation *> undoneOperations;
+        for (int i = 0; i < undoOperations.count(); ++i) {
+            Operation *const undoOperation = undoOperations.at(i);
             if (statusCanceledOrFailed())
                 throw Error(tr("Installation canceled by user"));
 
+            // already undone together with a preceding extract operation
+            const bool undone = undoneOperations.remove(undoOperation);
+
             bool becameAdmin = false;
-            if (!adminRightsGained && undoOperation->value(QLatin1String("admin")).toBool())
+            if (!undone && !adminRightsGained && undoOperation->value(QLatin1String("admin")).toBool())
                 becameAdmin = m_core->gainAdminRights();
 
-            connectOperationToInstaller(undoOperation, progressSize);
-            qDebug() << "undo operation=" << undoOperation->name();
-
             bool ignoreError = false;
-            bool ok = performOperationThreaded(undoOperation, PackageManagerCorePrivate::Undo);
+            bool ok = true;
+            const QList<ExtractArchiveOperation *> extractOperations = undone
+                ? QList<ExtractArchiveOperation *>() : consecutiveExtractOperations(undoOperations, i);
+            if (extractOperations.count() > 1) {
+                // remove the files of consecutive archives at once instead of one after the other
+                foreach (ExtractArchiveOperation *extractOperation, extractOperations) {
+                    connectOperationToInstaller(extractOperation, progressSize);
+                    undoneOperations.insert(extractOperation);
+                }
+                undoneOperations.remove(undoOperation);
+                qDebug() << "undo operation=" << undoOperation->name() << "for"
+                    << extractOperations.count() << "archives";
+                ok = ExtractArchiveOperation::undoOperations(extractOperations);
+            } else if (!undone) {
+                connectOperationToInstaller(undoOperation, progressSize);
+                qDebug() << "undo operation=" << undoOperation->name();
+                ok = performOperationThreaded(undoOperation, PackageManagerCorePrivate::Undo);
+            }
 
             const QString componentName = undoOperation->value(QLatin1String("component")).toString();
 
@@ -2127,7 +2697,8 @@ void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOpera
                     component = componentsToReplace().value(componentName).second;
                 if (component) {
                     component->setUninstalled();
-                    m_localPackageHub->removePackage(component->name());
+                    if (m_localPackageHub->removePackage(component->name()))
+                        m_localPackageHub->writeJournal();
                 }
             }
 
@@ -2411,6 +2982,64 @@ void PackageManagerCorePrivate::connectOperationCallMethodRequest(Operation *con
     }
 }
 
+/*!
+    Returns the operations performed by previous runs of the maintenance tool. The operations are
+    created from the blobs read from the maintenance tool binary on first use.
+*/
+OperationList &PackageManagerCorePrivate::performedOperationsOld()
+{
+    if (m_performedOperationBlobs.isEmpty())
+        return m_performedOperationsOld;
+
+    m_performedOperationsOld.reserve(m_performedOperationBlobs.count());
+    foreach (const OperationBlob &operation, m_performedOperationBlobs) {
+        QScopedPointer<QInstaller::Operation> op(KDUpdater::UpdateOperationFactory::instance()
+            .create(operation.name, m_core));
+        if (op.isNull()) {
+            qWarning() << "Failed to load unknown operation" << operation.name;
+            continue;
+        }
+
+        if (!operation.isXml()) {
+            op->fromBinary(operation.arguments, operation.values);
+        } else if (!op->fromXml(operation.xml)) {
+            qWarning() << "Failed to load XML for operation" << operation.name;
+            continue;
+        }
+        m_performedOperationsOld.append(op.take());
+    }
+    m_performedOperationBlobs.clear();
+    return m_performedOperationsOld;
+}
+
+/*!
+    Returns the names of the components the operations performed by previous runs of the
+    maintenance tool belong to. Operations read from the binary operation log do not need to be
+    created for this.
+*/
+QSet<QString> PackageManagerCorePrivate::performedOperationsComponents()
+{
+    const QString component = QLatin1String("component");
+    const bool binaryOnly = std::none_of(m_performedOperationBlobs.constBegin(),
+        m_performedOperationBlobs.constEnd(), [](const OperationBlob &operation) {
+            return operation.isXml();
+        });
+
+    QSet<QString> components;
+    if (binaryOnly && !m_performedOperationBlobs.isEmpty()) {
+        foreach (const OperationBlob &operation, m_performedOperationBlobs) {
+            if (operation.values.contains(component))
+                components.insert(operation.values.value(component).toString());
+        }
+    } else {
+        foreach (Operation *operation, performedOperationsOld()) {
+            if (operation->hasValue(component))
+                components.insert(operation->value(component).toString());
+        }
+    }
+    return components;
+}
+
 OperationList PackageManagerCorePrivate::sortOperationsBasedOnComponentDependencies(const OperationList &operationList)
 {
     OperationList sortedOperations;
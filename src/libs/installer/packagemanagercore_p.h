@@ -52,7 +52,10 @@ using namespace KDUpdater;
 namespace QInstaller {
 
 struct BinaryLayout;
+class ArchiveDelta;
 class Component;
+class DownloadArchivesJob;
+class OperationScheduler;
 class ScriptEngine;
 class ComponentModel;
 class TempDirDeleter;
@@ -73,6 +76,13 @@ public:
         Undo
     };
 
+    enum struct DriverState {
+        Idle,
+        Installing,
+        Updating,
+        Uninstalling
+    };
+
     explicit PackageManagerCorePrivate(PackageManagerCore *core);
     explicit PackageManagerCorePrivate(PackageManagerCore *core, qint64 magicInstallerMaker,
         const QList<OperationBlob> &performedOperations);
@@ -114,6 +124,13 @@ public:
     void clearAllComponentLists();
     void clearUpdaterComponentLists();
     QList<Component*> &replacementDependencyComponents();
+
+    const QHash<QString, QList<Component *> > &componentIndex() const;
+    const QHash<QString, QList<QPair<Component *, QString> > > &dependeeIndex() const;
+    void invalidateComponentIndex() {
+        m_componentIndexValid = false;
+        m_dependeeIndexValid = false;
+    }
     QHash<QString, QPair<Component*, Component*> > &componentsToReplace();
 
     void clearInstallerCalculator();
@@ -141,6 +158,10 @@ public:
     void stopProcessesForUpdates(const QList<Component*> &components);
     int countProgressOperations(const QList<Component*> &components);
     int countProgressOperations(const OperationList &operations);
+    quint64 progressWeight(const QList<Component*> &components) const;
+    quint64 progressWeight(Component *component) const;
+    double downloadProgressShare(const QList<Component*> &components, quint64 installWeight,
+        double defaultShare) const;
     void connectOperationToInstaller(Operation *const operation, double progressOperationPartSize);
     void connectOperationCallMethodRequest(Operation *const operation);
     OperationList sortOperationsBasedOnComponentDependencies(const OperationList &operationList);
@@ -157,13 +178,18 @@ public:
     }
 
     void commitSessionOperations() {
-        m_performedOperationsOld += m_performedOperationsCurrentSession;
+        performedOperationsOld() += m_performedOperationsCurrentSession;
         m_performedOperationsCurrentSession.clear();
     }
 
-    void installComponent(Component *component, double progressOperationSize,
+    void installComponent(Component *component, double progressWeightSize,
         bool adminRightsGained = false);
 
+    QList<QPair<QString, QString> > archivesToDownload(const QList<Component *> &components) const;
+    QHash<QString, quint64> archiveSizes(const QList<Component *> &components) const;
+    QHash<QString, ArchiveDelta> archiveDeltas(const QList<Component *> &components);
+    void connectArchivesJob(DownloadArchivesJob *archivesJob, double partProgressSize);
+
 signals:
     void installationStarted();
     void installationFinished();
@@ -198,9 +224,14 @@ public:
     QList<QInstaller::Component*> m_updaterComponentsDeps;
     QList<QInstaller::Component*> m_updaterDependencyReplacements;
 
+    OperationList &performedOperationsOld();
+    QSet<QString> performedOperationsComponents();
+
     OperationList m_ownedOperations;
     OperationList m_performedOperationsOld;
     OperationList m_performedOperationsCurrentSession;
+    // operations read from the maintenance tool, created on first use by performedOperationsOld()
+    QList<OperationBlob> m_performedOperationBlobs;
 
     bool m_dependsOnLocalInstallerBinary;
 
@@ -230,6 +261,16 @@ private:
     void runUndoOperations(const OperationList &undoOperations, double undoOperationProgressSize,
         bool adminRightsGained, bool deleteOperation);
 
+    bool isPipelinedInstallation() const;
+    void installComponentsPipelined(const QList<Component *> &components,
+        const QList<QPair<QString, QString> > &archives, double downloadPartProgressSize,
+        double progressWeightSize, bool adminRightsGained);
+
+    void setupOperationScheduler();
+    void prefetchOperations(const QList<Component *> &components, int index,
+        const QSet<QString> &pendingArchives = QSet<QString>());
+    void discardScheduledOperations();
+
     PackagesList remotePackages();
     PackagesList compressedPackages();
     LocalPackagesHash localInstalledPackages();
@@ -268,6 +309,16 @@ private:
 
     QObject *m_guiObject;
     QScopedPointer<RemoteFileEngineHandler> m_remoteFileEngineHandler;
+    QScopedPointer<OperationScheduler> m_operationScheduler;
+
+    mutable QHash<QString, QList<Component *> > m_componentIndex;
+    mutable bool m_componentIndexValid;
+    mutable bool m_componentIndexUpdater;
+    mutable QHash<QString, QList<QPair<Component *, QString> > > m_dependeeIndex;
+    mutable bool m_dependeeIndexValid;
+    mutable bool m_dependeeIndexUpdater;
+
+    DriverState m_driverState;
 
 private:
     // remove once we deprecate isSelected, setSelected etc...
@@ -175,6 +175,15 @@ void PerformInstallationForm::updateProgress()
     const int progressPercentage = progressCoordninator->progressInPercentage();
 
     m_progressBar->setValue(progressPercentage);
+    const int remainingSeconds = progressCoordninator->estimatedRemainingSeconds();
+    if (remainingSeconds < 0) {
+        m_progressBar->setFormat(QLatin1String("%p%"));
+    } else if (remainingSeconds < 60) {
+        m_progressBar->setFormat(tr("%p% (less than a minute remaining)"));
+    } else {
+        m_progressBar->setFormat(tr("%p% (about %n minute(s) remaining)", nullptr,
+            (remainingSeconds + 30) / 60));
+    }
 #ifdef Q_OS_WIN
     if (m_taskButton) {
         if (!m_taskButton->window() && QApplication::activeWindow())
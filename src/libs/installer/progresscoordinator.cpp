@@ -42,12 +42,14 @@ QT_END_NAMESPACE
 
 ProgressCoordinator::ProgressCoordinator(QObject *parent)
     : QObject(parent)
+    , m_pendingCalculatedPercentageSum(0)
     , m_currentCompletePercentage(0)
     , m_currentBasePercentage(0)
     , m_manualAddedPercentage(0)
     , m_reservedPercentage(0)
     , m_undoMode(false)
     , m_reachedPercentageBeforeUndo(0)
+    , m_percentageAtTimerStart(0)
 {
     // it has to be in the main thread to be able refresh the ui with processEvents
     Q_ASSERT(thread() == qApp->thread());
@@ -75,6 +77,8 @@ void ProgressCoordinator::reset()
     m_reservedPercentage = 0;
     m_undoMode = false;
     m_reachedPercentageBeforeUndo = 0;
+    m_progressTimer.invalidate();
+    m_percentageAtTimerStart = 0;
     emit detailTextResetNeeded();
 }
 
@@ -149,9 +153,9 @@ void ProgressCoordinator::partProgressChanged(double fraction)
         m_currentCompletePercentage = newCurrentCompletePercentage;
         if (fraction == 1) {
             m_currentBasePercentage = m_currentBasePercentage - pendingCalculatedPartPercentage;
-            m_senderPendingCalculatedPercentageHash.insert(sender(), 0);
+            setPendingCalculatedPartPercentage(sender(), 0);
         } else {
-            m_senderPendingCalculatedPercentageHash.insert(sender(), pendingCalculatedPartPercentage);
+            setPendingCalculatedPartPercentage(sender(), pendingCalculatedPartPercentage);
         }
 
     } else { //if (m_undoMode)
@@ -180,12 +184,16 @@ void ProgressCoordinator::partProgressChanged(double fraction)
             qDebug("Something is wrong with the calculation of the progress.");
 
         m_currentCompletePercentage = newCurrentCompletePercentage;
+        if (!m_progressTimer.isValid()) {
+            m_progressTimer.start();
+            m_percentageAtTimerStart = m_currentCompletePercentage;
+        }
 
         if (fraction == 1) {
             m_currentBasePercentage = m_currentBasePercentage + pendingCalculatedPartPercentage;
-            m_senderPendingCalculatedPercentageHash.insert(sender(), 0);
+            setPendingCalculatedPartPercentage(sender(), 0);
         } else {
-            m_senderPendingCalculatedPercentageHash.insert(sender(), pendingCalculatedPartPercentage);
+            setPendingCalculatedPartPercentage(sender(), pendingCalculatedPartPercentage);
         }
     } //if (m_undoMode)
 }
@@ -202,6 +210,26 @@ int ProgressCoordinator::progressInPercentage() const
     return currentValue;
 }
 
+/*!
+    Returns the estimated number of seconds until the installation is finished, or \c -1 if there
+    is no estimate yet. The estimate assumes that the remaining progress is made as fast as the
+    progress since the first reported part progress. As the parts are weighted by their size,
+    this also holds when large and small components are mixed.
+*/
+int ProgressCoordinator::estimatedRemainingSeconds() const
+{
+    if (m_undoMode || !m_progressTimer.isValid())
+        return -1;
+
+    const double progress = m_currentCompletePercentage - m_percentageAtTimerStart;
+    const qint64 elapsed = m_progressTimer.elapsed();
+    // wait for a meaningful sample before guessing
+    if (progress < 1 || elapsed < 3000)
+        return -1;
+
+    return qRound((100 - m_currentCompletePercentage) * elapsed / progress / 1000);
+}
+
 void ProgressCoordinator::disconnectAllSenders()
 {
     foreach (QPointer<QObject> sender, m_senderPartProgressSizeHash.keys()) {
@@ -213,6 +241,7 @@ void ProgressCoordinator::disconnectAllSenders()
     }
     m_senderPartProgressSizeHash.clear();
     m_senderPendingCalculatedPercentageHash.clear();
+    m_pendingCalculatedPercentageSum = 0;
 }
 
 void ProgressCoordinator::setUndoMode()
@@ -223,6 +252,7 @@ void ProgressCoordinator::setUndoMode()
     disconnectAllSenders();
     m_reachedPercentageBeforeUndo = progressInPercentage();
     m_currentBasePercentage = m_reachedPercentageBeforeUndo;
+    m_progressTimer.invalidate();
 }
 
 void ProgressCoordinator::addManualPercentagePoints(int value)
@@ -274,14 +304,17 @@ void ProgressCoordinator::emitLabelAndDetailTextChanged(const QString &text)
 
 double ProgressCoordinator::allPendingCalculatedPartPercentages(QObject *excludeKeyObject)
 {
-    double result = 0;
-    QHash<QPointer<QObject>, double>::iterator it = m_senderPendingCalculatedPercentageHash.begin();
-    while (it != m_senderPendingCalculatedPercentageHash.end()) {
-        if (it.key() != excludeKeyObject)
-            result += it.value();
-        it++;
-    }
-    return result;
+    // the sum is kept up to date, so the progress of one sender costs the same no matter how many
+    // senders are registered
+    return m_pendingCalculatedPercentageSum
+        - m_senderPendingCalculatedPercentageHash.value(excludeKeyObject, 0);
+}
+
+void ProgressCoordinator::setPendingCalculatedPartPercentage(QObject *sender, double percentage)
+{
+    double &pending = m_senderPendingCalculatedPercentageHash[sender];
+    m_pendingCalculatedPercentageSum += percentage - pending;
+    pending = percentage;
 }
 
 void ProgressCoordinator::emitDownloadStatus(const QString &status)
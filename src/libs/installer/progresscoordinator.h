@@ -31,6 +31,7 @@
 
 #include "installer_global.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
@@ -55,6 +56,7 @@ public slots:
     void setLabelText(const QString &text);
 
     int progressInPercentage() const;
+    int estimatedRemainingSeconds() const;
     void partProgressChanged(double fraction);
 
     void addManualPercentagePoints(int value);
@@ -75,11 +77,13 @@ protected:
 
 private:
     double allPendingCalculatedPartPercentages(QObject *excludeKeyObject = 0);
+    void setPendingCalculatedPartPercentage(QObject *sender, double percentage);
     void disconnectAllSenders();
 
 private:
     QHash<QPointer<QObject>, double> m_senderPendingCalculatedPercentageHash;
     QHash<QPointer<QObject>, double> m_senderPartProgressSizeHash;
+    double m_pendingCalculatedPercentageSum;
     QString m_installationLabelText;
     double m_currentCompletePercentage;
     double m_currentBasePercentage;
@@ -87,6 +91,8 @@ private:
     int m_reservedPercentage;
     bool m_undoMode;
     double m_reachedPercentageBeforeUndo;
+    QElapsedTimer m_progressTimer;
+    double m_percentageAtTimerStart;
 };
 
 } //namespace QInstaller
@@ -27,11 +27,214 @@
 **************************************************************************/
 
 #include "protocol.h"
+
+#include <QHash>
 #include <QIODevice>
+#include <QVector>
+
+#include <cstring>
 
 namespace QInstaller {
 
 typedef qint32 PackageSize;
+typedef quint16 PackageCommand;
+typedef quint32 PackageRequestId;
+
+// Marks a packet carrying a numeric command, command names never start with it.
+static const char BinaryPacketMarker = '\x01';
+static const int BinaryPacketHeaderSize = sizeof(char) + sizeof(PackageCommand)
+    + sizeof(PackageRequestId);
+
+namespace Protocol {
+
+struct CommandInfo {
+    Command command;
+    const char *name;
+    bool deferrable;
+};
+
+// Deferrable commands neither reply nor need to reach the server before the next command that
+// waits for a reply, so they are not flushed to the socket on their own.
+static const CommandInfo commandTable[] = {
+    { Protocol::Command::Create, Protocol::Create, false },
+    { Protocol::Command::Destroy, Protocol::Destroy, false },
+    { Protocol::Command::Shutdown, Protocol::Shutdown, false },
+    { Protocol::Command::Authorize, Protocol::Authorize, false },
+    { Protocol::Command::Reply, Protocol::Reply, false },
+    { Protocol::Command::GetQProcessSignals, Protocol::GetQProcessSignals, false },
+    { Protocol::Command::QProcessCloseWriteChannel, Protocol::QProcessCloseWriteChannel, false },
+    { Protocol::Command::QProcessExitCode, Protocol::QProcessExitCode, false },
+    { Protocol::Command::QProcessExitStatus, Protocol::QProcessExitStatus, false },
+    { Protocol::Command::QProcessKill, Protocol::QProcessKill, false },
+    { Protocol::Command::QProcessReadAll, Protocol::QProcessReadAll, false },
+    { Protocol::Command::QProcessReadAllStandardOutput, Protocol::QProcessReadAllStandardOutput, false },
+    { Protocol::Command::QProcessReadAllStandardError, Protocol::QProcessReadAllStandardError, false },
+    { Protocol::Command::QProcessStartDetached, Protocol::QProcessStartDetached, false },
+    { Protocol::Command::QProcessSetWorkingDirectory, Protocol::QProcessSetWorkingDirectory, true },
+    { Protocol::Command::QProcessSetEnvironment, Protocol::QProcessSetEnvironment, true },
+    { Protocol::Command::QProcessEnvironment, Protocol::QProcessEnvironment, false },
+    { Protocol::Command::QProcessStart3Arg, Protocol::QProcessStart3Arg, false },
+    { Protocol::Command::QProcessStart2Arg, Protocol::QProcessStart2Arg, false },
+    { Protocol::Command::QProcessState, Protocol::QProcessState, false },
+    { Protocol::Command::QProcessTerminate, Protocol::QProcessTerminate, false },
+    { Protocol::Command::QProcessWaitForFinished, Protocol::QProcessWaitForFinished, false },
+    { Protocol::Command::QProcessWaitForStarted, Protocol::QProcessWaitForStarted, false },
+    { Protocol::Command::QProcessWorkingDirectory, Protocol::QProcessWorkingDirectory, false },
+    { Protocol::Command::QProcessErrorString, Protocol::QProcessErrorString, false },
+    { Protocol::Command::QProcessReadChannel, Protocol::QProcessReadChannel, false },
+    { Protocol::Command::QProcessSetReadChannel, Protocol::QProcessSetReadChannel, true },
+    { Protocol::Command::QProcessWrite, Protocol::QProcessWrite, false },
+    { Protocol::Command::QProcessProcessChannelMode, Protocol::QProcessProcessChannelMode, false },
+    { Protocol::Command::QProcessSetProcessChannelMode, Protocol::QProcessSetProcessChannelMode, true },
+    { Protocol::Command::QProcessSetNativeArguments, Protocol::QProcessSetNativeArguments, true },
+    { Protocol::Command::QSettingsAllKeys, Protocol::QSettingsAllKeys, false },
+    { Protocol::Command::QSettingsBeginGroup, Protocol::QSettingsBeginGroup, true },
+    { Protocol::Command::QSettingsBeginWriteArray, Protocol::QSettingsBeginWriteArray, true },
+    { Protocol::Command::QSettingsBeginReadArray, Protocol::QSettingsBeginReadArray, false },
+    { Protocol::Command::QSettingsChildGroups, Protocol::QSettingsChildGroups, false },
+    { Protocol::Command::QSettingsChildKeys, Protocol::QSettingsChildKeys, false },
+    { Protocol::Command::QSettingsClear, Protocol::QSettingsClear, false },
+    { Protocol::Command::QSettingsContains, Protocol::QSettingsContains, false },
+    { Protocol::Command::QSettingsEndArray, Protocol::QSettingsEndArray, true },
+    { Protocol::Command::QSettingsEndGroup, Protocol::QSettingsEndGroup, true },
+    { Protocol::Command::QSettingsFallbacksEnabled, Protocol::QSettingsFallbacksEnabled, false },
+    { Protocol::Command::QSettingsFileName, Protocol::QSettingsFileName, false },
+    { Protocol::Command::QSettingsGroup, Protocol::QSettingsGroup, false },
+    { Protocol::Command::QSettingsIsWritable, Protocol::QSettingsIsWritable, false },
+    { Protocol::Command::QSettingsRemove, Protocol::QSettingsRemove, true },
+    { Protocol::Command::QSettingsSetArrayIndex, Protocol::QSettingsSetArrayIndex, true },
+    { Protocol::Command::QSettingsSetFallbacksEnabled, Protocol::QSettingsSetFallbacksEnabled, true },
+    { Protocol::Command::QSettingsStatus, Protocol::QSettingsStatus, false },
+    { Protocol::Command::QSettingsSync, Protocol::QSettingsSync, false },
+    { Protocol::Command::QSettingsSetValue, Protocol::QSettingsSetValue, true },
+    { Protocol::Command::QSettingsValue, Protocol::QSettingsValue, false },
+    { Protocol::Command::QSettingsOrganizationName, Protocol::QSettingsOrganizationName, false },
+    { Protocol::Command::QSettingsApplicationName, Protocol::QSettingsApplicationName, false },
+    { Protocol::Command::QAbstractFileEngineAtEnd, Protocol::QAbstractFileEngineAtEnd, false },
+    { Protocol::Command::QAbstractFileEngineCaseSensitive, Protocol::QAbstractFileEngineCaseSensitive, false },
+    { Protocol::Command::QAbstractFileEngineClose, Protocol::QAbstractFileEngineClose, false },
+    { Protocol::Command::QAbstractFileEngineCopy, Protocol::QAbstractFileEngineCopy, false },
+    { Protocol::Command::QAbstractFileEngineEntryList, Protocol::QAbstractFileEngineEntryList, false },
+    { Protocol::Command::QAbstractFileEngineError, Protocol::QAbstractFileEngineError, false },
+    { Protocol::Command::QAbstractFileEngineErrorString, Protocol::QAbstractFileEngineErrorString, false },
+    { Protocol::Command::QAbstractFileEngineFileFlags, Protocol::QAbstractFileEngineFileFlags, false },
+    { Protocol::Command::QAbstractFileEngineFileName, Protocol::QAbstractFileEngineFileName, false },
+    { Protocol::Command::QAbstractFileEngineFlush, Protocol::QAbstractFileEngineFlush, false },
+    { Protocol::Command::QAbstractFileEngineHandle, Protocol::QAbstractFileEngineHandle, false },
+    { Protocol::Command::QAbstractFileEngineIsRelativePath, Protocol::QAbstractFileEngineIsRelativePath, false },
+    { Protocol::Command::QAbstractFileEngineIsSequential, Protocol::QAbstractFileEngineIsSequential, false },
+    { Protocol::Command::QAbstractFileEngineLink, Protocol::QAbstractFileEngineLink, false },
+    { Protocol::Command::QAbstractFileEngineMkdir, Protocol::QAbstractFileEngineMkdir, false },
+    { Protocol::Command::QAbstractFileEngineOpen, Protocol::QAbstractFileEngineOpen, false },
+    { Protocol::Command::QAbstractFileEngineOwner, Protocol::QAbstractFileEngineOwner, false },
+    { Protocol::Command::QAbstractFileEngineOwnerId, Protocol::QAbstractFileEngineOwnerId, false },
+    { Protocol::Command::QAbstractFileEnginePos, Protocol::QAbstractFileEnginePos, false },
+    { Protocol::Command::QAbstractFileEngineRead, Protocol::QAbstractFileEngineRead, false },
+    { Protocol::Command::QAbstractFileEngineReadLine, Protocol::QAbstractFileEngineReadLine, false },
+    { Protocol::Command::QAbstractFileEngineRemove, Protocol::QAbstractFileEngineRemove, false },
+    { Protocol::Command::QAbstractFileEngineRename, Protocol::QAbstractFileEngineRename, false },
+    { Protocol::Command::QAbstractFileEngineRmdir, Protocol::QAbstractFileEngineRmdir, false },
+    { Protocol::Command::QAbstractFileEngineSeek, Protocol::QAbstractFileEngineSeek, false },
+    { Protocol::Command::QAbstractFileEngineSetFileName, Protocol::QAbstractFileEngineSetFileName, true },
+    { Protocol::Command::QAbstractFileEngineSetPermissions, Protocol::QAbstractFileEngineSetPermissions, false },
+    { Protocol::Command::QAbstractFileEngineSetSize, Protocol::QAbstractFileEngineSetSize, false },
+    { Protocol::Command::QAbstractFileEngineSize, Protocol::QAbstractFileEngineSize, false },
+    { Protocol::Command::QAbstractFileEngineSupportsExtension, Protocol::QAbstractFileEngineSupportsExtension, false },
+    { Protocol::Command::QAbstractFileEngineExtension, Protocol::QAbstractFileEngineExtension, false },
+    { Protocol::Command::QAbstractFileEngineWrite, Protocol::QAbstractFileEngineWrite, false },
+    { Protocol::Command::QAbstractFileEngineSyncToDisk, Protocol::QAbstractFileEngineSyncToDisk, false },
+    { Protocol::Command::QAbstractFileEngineRenameOverwrite, Protocol::QAbstractFileEngineRenameOverwrite, false },
+    { Protocol::Command::QAbstractFileEngineFileTime, Protocol::QAbstractFileEngineFileTime, false },
+};
+
+struct CommandIndex
+{
+    CommandIndex()
+    {
+        for (const CommandInfo &info : commandTable) {
+            const int index = static_cast<int>(info.command);
+            byName.insert(QString::fromLatin1(info.name), info.command);
+            if (index >= byCommand.size())
+                byCommand.resize(index + 1);
+            byCommand[index] = &info;
+        }
+    }
+
+    const CommandInfo *info(Command command) const
+    {
+        const int index = static_cast<int>(command);
+        return index < byCommand.size() ? byCommand.at(index) : nullptr;
+    }
+
+    QHash<QString, Command> byName;
+    QVector<const CommandInfo *> byCommand;
+};
+
+static const CommandIndex &commandIndex()
+{
+    static const CommandIndex index;
+    return index;
+}
+
+/*!
+    Returns the numeric command for the command \a name, or Command::Unknown.
+*/
+Command command(const QString &name)
+{
+    return commandIndex().byName.value(name, Command::Unknown);
+}
+
+/*!
+    Returns the name of \a command, or an empty byte array for an unknown command.
+*/
+QByteArray commandName(Command command)
+{
+    const CommandInfo *info = commandIndex().info(command);
+    return info ? QByteArray(info->name) : QByteArray();
+}
+
+/*!
+    Returns \c true if \a command may be kept in the socket buffer until a later command is sent.
+*/
+bool isDeferrable(Command command)
+{
+    const CommandInfo *info = commandIndex().info(command);
+    return info && info->deferrable;
+}
+
+} // namespace Protocol
+
+static void writePacket(QIODevice *device, QByteArray packet)
+{
+    forever {
+        const int bytesWritten = device->write(packet);
+        Q_ASSERT(bytesWritten >= 0);
+        if (bytesWritten == packet.size())
+            break;
+        packet.remove(0, bytesWritten);
+    }
+}
+
+static bool readPayload(QIODevice *device, QByteArray *payload)
+{
+    if (device->bytesAvailable() < static_cast<qint64>(sizeof(PackageSize)))
+        return false;
+
+    // read payload size
+    char payloadBytes[sizeof(PackageSize)];
+    PackageSize *payloadSize = reinterpret_cast<PackageSize*>(&payloadBytes);
+    device->read(payloadBytes, sizeof(PackageSize));
+
+    // not enough data yet? back off ...
+    if (device->bytesAvailable() < *payloadSize) {
+        for (int i = sizeof(PackageSize) - 1; i >= 0; --i)
+            device->ungetChar(payloadBytes[i]);
+        return false;
+    }
+
+    *payload = device->read(*payloadSize);
+    return true;
+}
 
 /*!
     Write a packet containing \a command and \a data to \a device.
@@ -52,13 +255,7 @@ void sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &
     packet.append('\0');
     packet.append(data);
 
-    forever {
-        const int bytesWritten = device->write(packet);
-        Q_ASSERT(bytesWritten >= 0);
-        if (bytesWritten == packet.size())
-            break;
-        packet.remove(0, bytesWritten);
-    }
+    writePacket(device, packet);
 }
 
 /*!
@@ -70,25 +267,79 @@ void sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &
  */
 bool receivePacket(QIODevice *device, QByteArray *command, QByteArray *data)
 {
-    if (device->bytesAvailable() < static_cast<qint64>(sizeof(PackageSize)))
+    QByteArray payload;
+    if (!readPayload(device, &payload))
         return false;
 
-    // read payload size
-    char payloadBytes[sizeof(PackageSize)];
-    PackageSize *payloadSize = reinterpret_cast<PackageSize*>(&payloadBytes);
-    device->read(payloadBytes, sizeof(PackageSize));
+    int separator = payload.indexOf('\0');
 
-    // not enough data yet? back off ...
-    if (device->bytesAvailable() < *payloadSize) {
-        for (int i = sizeof(PackageSize) - 1; i >= 0; --i)
-            device->ungetChar(payloadBytes[i]);
+    *command = payload.left(separator);
+    *data = payload.right(payload.size() - separator - 1);
+    return true;
+}
+
+/*!
+    Write a packet containing the numeric \a command, \a requestId and \a data to \a device.
+    A reply to the packet is sent with the same \a requestId.
+
+    \note Both client and server need to have the same endianness.
+ */
+void sendPacket(QIODevice *device, Protocol::Command command, quint32 requestId,
+    const QByteArray &data)
+{
+    char headerBytes[sizeof(PackageSize) + BinaryPacketHeaderSize];
+    char *header = headerBytes;
+    const PackageSize payloadSize = BinaryPacketHeaderSize + data.size();
+    const PackageCommand packageCommand = static_cast<PackageCommand>(command);
+    const PackageRequestId packageRequestId = requestId;
+
+    memcpy(header, &payloadSize, sizeof(PackageSize));
+    header += sizeof(PackageSize);
+    *header++ = BinaryPacketMarker;
+    memcpy(header, &packageCommand, sizeof(PackageCommand));
+    header += sizeof(PackageCommand);
+    memcpy(header, &packageRequestId, sizeof(PackageRequestId));
+
+    QByteArray packet;
+    packet.reserve(sizeof(headerBytes) + data.size());
+    packet.append(headerBytes, sizeof(headerBytes));
+    packet.append(data);
+
+    writePacket(device, packet);
+}
+
+/*!
+    Reads a packet from \a device, and stores its content into \a command, \a requestId and
+    \a data. Packets sent with a command name are accepted as well, their command is looked up
+    by name and \a requestId is set to \c 0.
+
+    Returns \c false if the packet in the device buffer is yet incomplete, \c true otherwise.
+
+    \note Both client and server need to have the same endianness.
+ */
+bool receivePacket(QIODevice *device, Protocol::Command *command, quint32 *requestId,
+    QByteArray *data)
+{
+    QByteArray payload;
+    if (!readPayload(device, &payload))
         return false;
-    }
 
-    const QByteArray payload = device->read(*payloadSize);
-    int separator = payload.indexOf('\0');
+    if (payload.size() >= BinaryPacketHeaderSize && payload.at(0) == BinaryPacketMarker) {
+        PackageCommand packageCommand;
+        PackageRequestId packageRequestId;
+        const char *header = payload.constData() + sizeof(char);
+        memcpy(&packageCommand, header, sizeof(PackageCommand));
+        memcpy(&packageRequestId, header + sizeof(PackageCommand), sizeof(PackageRequestId));
 
-    *command = payload.left(separator);
+        *command = static_cast<Protocol::Command>(packageCommand);
+        *requestId = packageRequestId;
+        *data = payload.mid(BinaryPacketHeaderSize);
+        return true;
+    }
+
+    const int separator = payload.indexOf('\0');
+    *command = Protocol::command(QString::fromLatin1(payload.left(separator)));
+    *requestId = 0;
     *data = payload.right(payload.size() - separator - 1);
     return true;
 }
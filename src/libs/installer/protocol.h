@@ -31,6 +31,9 @@
 
 #include "installer_global.h"
 
+#include <QByteArray>
+#include <QString>
+
 QT_FORWARD_DECLARE_CLASS(QIODevice)
 
 namespace QInstaller {
@@ -163,11 +166,120 @@ const char QAbstractFileEngineSyncToDisk[] = "QAbstractFileEngine::syncToDisk";
 const char QAbstractFileEngineRenameOverwrite[] = "QAbstractFileEngine::renameOverwrite";
 const char QAbstractFileEngineFileTime[] = "QAbstractFileEngine::fileTime";
 
+// Numeric opcodes of the commands above, sent instead of the command names.
+enum struct Command : quint16 {
+    Unknown = 0,
+    Create,
+    Destroy,
+    Shutdown,
+    Authorize,
+    Reply,
+    GetQProcessSignals,
+
+    // QProcessWrapper, keep the range contiguous
+    QProcessCloseWriteChannel,
+    QProcessExitCode,
+    QProcessExitStatus,
+    QProcessKill,
+    QProcessReadAll,
+    QProcessReadAllStandardOutput,
+    QProcessReadAllStandardError,
+    QProcessStartDetached,
+    QProcessSetWorkingDirectory,
+    QProcessSetEnvironment,
+    QProcessEnvironment,
+    QProcessStart3Arg,
+    QProcessStart2Arg,
+    QProcessState,
+    QProcessTerminate,
+    QProcessWaitForFinished,
+    QProcessWaitForStarted,
+    QProcessWorkingDirectory,
+    QProcessErrorString,
+    QProcessReadChannel,
+    QProcessSetReadChannel,
+    QProcessWrite,
+    QProcessProcessChannelMode,
+    QProcessSetProcessChannelMode,
+    QProcessSetNativeArguments,
+
+    // QSettingsWrapper, keep the range contiguous
+    QSettingsAllKeys,
+    QSettingsBeginGroup,
+    QSettingsBeginWriteArray,
+    QSettingsBeginReadArray,
+    QSettingsChildGroups,
+    QSettingsChildKeys,
+    QSettingsClear,
+    QSettingsContains,
+    QSettingsEndArray,
+    QSettingsEndGroup,
+    QSettingsFallbacksEnabled,
+    QSettingsFileName,
+    QSettingsGroup,
+    QSettingsIsWritable,
+    QSettingsRemove,
+    QSettingsSetArrayIndex,
+    QSettingsSetFallbacksEnabled,
+    QSettingsStatus,
+    QSettingsSync,
+    QSettingsSetValue,
+    QSettingsValue,
+    QSettingsOrganizationName,
+    QSettingsApplicationName,
+
+    // RemoteFileEngine, keep the range contiguous
+    QAbstractFileEngineAtEnd,
+    QAbstractFileEngineCaseSensitive,
+    QAbstractFileEngineClose,
+    QAbstractFileEngineCopy,
+    QAbstractFileEngineEntryList,
+    QAbstractFileEngineError,
+    QAbstractFileEngineErrorString,
+    QAbstractFileEngineFileFlags,
+    QAbstractFileEngineFileName,
+    QAbstractFileEngineFlush,
+    QAbstractFileEngineHandle,
+    QAbstractFileEngineIsRelativePath,
+    QAbstractFileEngineIsSequential,
+    QAbstractFileEngineLink,
+    QAbstractFileEngineMkdir,
+    QAbstractFileEngineOpen,
+    QAbstractFileEngineOwner,
+    QAbstractFileEngineOwnerId,
+    QAbstractFileEnginePos,
+    QAbstractFileEngineRead,
+    QAbstractFileEngineReadLine,
+    QAbstractFileEngineRemove,
+    QAbstractFileEngineRename,
+    QAbstractFileEngineRmdir,
+    QAbstractFileEngineSeek,
+    QAbstractFileEngineSetFileName,
+    QAbstractFileEngineSetPermissions,
+    QAbstractFileEngineSetSize,
+    QAbstractFileEngineSize,
+    QAbstractFileEngineSupportsExtension,
+    QAbstractFileEngineExtension,
+    QAbstractFileEngineWrite,
+    QAbstractFileEngineSyncToDisk,
+    QAbstractFileEngineRenameOverwrite,
+    QAbstractFileEngineFileTime
+};
+
+Command INSTALLER_EXPORT command(const QString &name);
+QByteArray INSTALLER_EXPORT commandName(Command command);
+bool INSTALLER_EXPORT isDeferrable(Command command);
+
 } // namespace Protocol
 
 void INSTALLER_EXPORT sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &data);
 bool INSTALLER_EXPORT receivePacket(QIODevice *device, QByteArray *command, QByteArray *data);
 
+void INSTALLER_EXPORT sendPacket(QIODevice *device, Protocol::Command command, quint32 requestId,
+    const QByteArray &data);
+bool INSTALLER_EXPORT receivePacket(QIODevice *device, Protocol::Command *command,
+    quint32 *requestId, QByteArray *data);
+
 } // namespace QInstaller
 
 #endif // PROTOCOL_H
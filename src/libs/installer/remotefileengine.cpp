@@ -35,6 +35,11 @@
 
 namespace QInstaller {
 
+// Reads are fetched and writes are sent in batches of this size at least.
+static const qint64 scBatchSize = 64 * 1024;
+// Number of write batches that may be sent before their replies are checked.
+static const int scMaxPendingWrites = 8;
+
 
 // -- RemoteFileEngineHandler
 
@@ -114,11 +119,75 @@ QString RemoteFileEngineIterator::currentFileName() const
 
 RemoteFileEngine::RemoteFileEngine()
     : RemoteObject(QLatin1String(Protocol::QAbstractFileEngine))
+    , m_readAhead(ReadAhead::Unknown)
+    , m_readBufferPos(0)
+    , m_writeFailed(false)
 {
 }
 
 RemoteFileEngine::~RemoteFileEngine()
 {
+    if (isConnectedToServer())
+        sendWriteBatch();
+}
+
+/*
+    Connects to the server and makes sure all batched writes have been performed, so that the
+    remote file engine is in the state the caller expects.
+*/
+bool RemoteFileEngine::connectAndFinishWrites()
+{
+    if (!connectToServer())
+        return false;
+    finishWrites(0);
+    return true;
+}
+
+/*
+    Sends the batched write data, without waiting for the reply.
+*/
+void RemoteFileEngine::sendWriteBatch()
+{
+    if (m_writeBuffer.isEmpty())
+        return;
+
+    const quint32 requestId = sendRemoteMethod(QString::fromLatin1(Protocol::QAbstractFileEngineWrite),
+        m_writeBuffer, dummy, dummy);
+    m_pendingWrites.append(qMakePair(requestId, qint64(m_writeBuffer.size())));
+    m_writeBuffer.clear();
+}
+
+/*
+    Sends the batched write data and checks the replies to the sent batches until at most
+    \a maxPending batches are left unchecked. Returns \c false if any batch failed.
+*/
+bool RemoteFileEngine::finishWrites(int maxPending)
+{
+    if (maxPending == 0)
+        sendWriteBatch();
+    while (m_pendingWrites.count() > maxPending) {
+        const QPair<quint32, qint64> write = m_pendingWrites.takeFirst();
+        const qint64 written = takeReply<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite),
+            write.first);
+        if (written != write.second)
+            m_writeFailed = true;
+    }
+    return !m_writeFailed;
+}
+
+/*
+    Drops data that was read ahead and not consumed yet. If \a restorePosition is \c true, the
+    remote file position is moved back to the position the caller has read up to.
+*/
+void RemoteFileEngine::discardReadAhead(bool restorePosition)
+{
+    const qint64 unread = m_readBuffer.size() - m_readBufferPos;
+    m_readBuffer.clear();
+    m_readBufferPos = 0;
+    if (restorePosition && unread > 0) {
+        const qint64 position = callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+        callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), position - unread);
+    }
 }
 
 /*!
@@ -126,8 +195,11 @@ RemoteFileEngine::~RemoteFileEngine()
 */
 bool RemoteFileEngine::atEnd() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
+        if (m_readBufferPos < m_readBuffer.size())
+            return false;
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineAtEnd));
+    }
     return m_fileEngine.atEnd();
 }
 
@@ -158,7 +230,7 @@ QAbstractFileEngine::Iterator* RemoteFileEngine::endEntryList()
 */
 bool RemoteFileEngine::caseSensitive() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineCaseSensitive));
     return m_fileEngine.caseSensitive();
 }
@@ -168,8 +240,14 @@ bool RemoteFileEngine::caseSensitive() const
 */
 bool RemoteFileEngine::close()
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineClose));
+    if (connectAndFinishWrites()) {
+        discardReadAhead(false);
+        m_readAhead = ReadAhead::Unknown;
+        const bool written = !m_writeFailed;
+        m_writeFailed = false;
+        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineClose))
+            && written;
+    }
     return m_fileEngine.close();
 }
 
@@ -178,7 +256,7 @@ bool RemoteFileEngine::close()
 */
 bool RemoteFileEngine::copy(const QString &newName)
 {
-    if (connectToServer())
+    if (connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineCopy), newName);
     return m_fileEngine.copy(newName);
 }
@@ -188,7 +266,7 @@ bool RemoteFileEngine::copy(const QString &newName)
 */
 QStringList RemoteFileEngine::entryList(QDir::Filters filters, const QStringList &filterNames) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<QStringList>
             (QString::fromLatin1(Protocol::QAbstractFileEngineEntryList),
             static_cast<qint32>(filters), filterNames);
@@ -201,7 +279,7 @@ QStringList RemoteFileEngine::entryList(QDir::Filters filters, const QStringList
 */
 QFile::FileError RemoteFileEngine::error() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return static_cast<QFile::FileError>
             (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineError)));
     }
@@ -213,7 +291,7 @@ QFile::FileError RemoteFileEngine::error() const
 */
 QString RemoteFileEngine::errorString() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineErrorString));
     return m_fileEngine.errorString();
 }
@@ -233,7 +311,7 @@ bool RemoteFileEngine::extension(Extension extension, const ExtensionOption *eo,
 */
 QAbstractFileEngine::FileFlags RemoteFileEngine::fileFlags(FileFlags type) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return static_cast<QAbstractFileEngine::FileFlags>
             (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineFileFlags),
             static_cast<qint32>(type)));
@@ -246,7 +324,7 @@ QAbstractFileEngine::FileFlags RemoteFileEngine::fileFlags(FileFlags type) const
 */
 QString RemoteFileEngine::fileName(FileName file) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineFileName),
             static_cast<qint32>(file));
     }
@@ -258,8 +336,10 @@ QString RemoteFileEngine::fileName(FileName file) const
 */
 bool RemoteFileEngine::flush()
 {
-    if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineFlush));
+    if (connectAndFinishWrites()) {
+        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineFlush))
+            && !m_writeFailed;
+    }
     return m_fileEngine.flush();
 }
 
@@ -268,7 +348,7 @@ bool RemoteFileEngine::flush()
 */
 int RemoteFileEngine::handle() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineHandle));
     return m_fileEngine.handle();
 }
@@ -278,7 +358,7 @@ int RemoteFileEngine::handle() const
 */
 bool RemoteFileEngine::isRelativePath() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsRelativePath));
     return m_fileEngine.isRelativePath();
 }
@@ -288,7 +368,7 @@ bool RemoteFileEngine::isRelativePath() const
 */
 bool RemoteFileEngine::isSequential() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsSequential));
     return m_fileEngine.isSequential();
 }
@@ -298,7 +378,7 @@ bool RemoteFileEngine::isSequential() const
 */
 bool RemoteFileEngine::link(const QString &newName)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineLink),
             newName);
     }
@@ -310,7 +390,7 @@ bool RemoteFileEngine::link(const QString &newName)
 */
 bool RemoteFileEngine::mkdir(const QString &dirName, bool createParentDirectories) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineMkdir),
             dirName, createParentDirectories);
     }
@@ -322,7 +402,10 @@ bool RemoteFileEngine::mkdir(const QString &dirName, bool createParentDirectorie
 */
 bool RemoteFileEngine::open(QIODevice::OpenMode mode)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
+        discardReadAhead(false);
+        m_readAhead = ReadAhead::Unknown;
+        m_writeFailed = false;
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineOpen),
             static_cast<qint32>(mode | QIODevice::Unbuffered));
     }
@@ -334,7 +417,7 @@ bool RemoteFileEngine::open(QIODevice::OpenMode mode)
 */
 QString RemoteFileEngine::owner(FileOwner owner) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineOwner),
             static_cast<qint32>(owner));
     }
@@ -346,7 +429,7 @@ QString RemoteFileEngine::owner(FileOwner owner) const
 */
 uint RemoteFileEngine::ownerId(FileOwner owner) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<quint32>(QString::fromLatin1(Protocol::QAbstractFileEngineOwnerId),
             static_cast<qint32>(owner));
     }
@@ -358,8 +441,10 @@ uint RemoteFileEngine::ownerId(FileOwner owner) const
 */
 qint64 RemoteFileEngine::pos() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
+        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos))
+            - (m_readBuffer.size() - m_readBufferPos);
+    }
     return m_fileEngine.pos();
 }
 
@@ -368,7 +453,7 @@ qint64 RemoteFileEngine::pos() const
 */
 bool RemoteFileEngine::remove()
 {
-    if (connectToServer())
+    if (connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRemove));
     return m_fileEngine.remove();
 }
@@ -378,7 +463,7 @@ bool RemoteFileEngine::remove()
 */
 bool RemoteFileEngine::rename(const QString &newName)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRename),
             newName);
     }
@@ -390,7 +475,7 @@ bool RemoteFileEngine::rename(const QString &newName)
 */
 bool RemoteFileEngine::rmdir(const QString &dirName, bool recurseParentDirectories) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRmdir),
             dirName, recurseParentDirectories);
     }
@@ -402,8 +487,10 @@ bool RemoteFileEngine::rmdir(const QString &dirName, bool recurseParentDirectori
 */
 bool RemoteFileEngine::seek(qint64 offset)
 {
-    if (connectToServer())
+    if (connectAndFinishWrites()) {
+        discardReadAhead(false);
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), offset);
+    }
     return m_fileEngine.seek(offset);
 }
 
@@ -412,7 +499,7 @@ bool RemoteFileEngine::seek(qint64 offset)
 */
 void RemoteFileEngine::setFileName(const QString &fileName)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
         callRemoteMethod(QString::fromLatin1(Protocol::QAbstractFileEngineSetFileName), fileName,
             dummy);
     }
@@ -424,7 +511,7 @@ void RemoteFileEngine::setFileName(const QString &fileName)
 */
 bool RemoteFileEngine::setPermissions(uint perms)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSetPermissions),
             perms);
     }
@@ -436,7 +523,8 @@ bool RemoteFileEngine::setPermissions(uint perms)
 */
 bool RemoteFileEngine::setSize(qint64 size)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
+        discardReadAhead(true);
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSetSize),
             size);
     }
@@ -448,7 +536,7 @@ bool RemoteFileEngine::setSize(qint64 size)
 */
 qint64 RemoteFileEngine::size() const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites())
         return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineSize));
     return m_fileEngine.size();
 }
@@ -468,16 +556,32 @@ bool RemoteFileEngine::supportsExtension(Extension extension) const
 */
 qint64 RemoteFileEngine::read(char *data, qint64 maxlen)
 {
-    if (connectToServer()) {
-        QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
-            (QString::fromLatin1(Protocol::QAbstractFileEngineRead), maxlen);
-
-        if (result.first <= 0)
-            return result.first;
-
-        QDataStream dataStream(result.second);
-        dataStream.readRawData(data, result.first);
-        return result.first;
+    if (connectAndFinishWrites()) {
+        if (m_readAhead == ReadAhead::Unknown) {
+            m_readAhead = callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsSequential))
+                ? ReadAhead::Disabled : ReadAhead::Enabled;
+        }
+
+        if (m_readBufferPos >= m_readBuffer.size()) {
+            // fetch a whole batch, the following reads are served from it
+            const qint64 length = (m_readAhead == ReadAhead::Enabled) ? qMax(maxlen, scBatchSize)
+                : maxlen;
+            QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
+                (QString::fromLatin1(Protocol::QAbstractFileEngineRead), length);
+
+            if (result.first <= 0)
+                return result.first;
+
+            m_readBuffer = result.second.left(result.first);
+            m_readBufferPos = 0;
+        }
+
+        const qint64 count = qMin(maxlen, qint64(m_readBuffer.size() - m_readBufferPos));
+        memcpy(data, m_readBuffer.constData() + m_readBufferPos, count);
+        m_readBufferPos += count;
+        if (m_readBufferPos >= m_readBuffer.size())
+            discardReadAhead(false);
+        return count;
     }
     return m_fileEngine.read(data, maxlen);
 }
@@ -487,7 +591,8 @@ qint64 RemoteFileEngine::read(char *data, qint64 maxlen)
 */
 qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
+        discardReadAhead(true);
         QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
             (QString::fromLatin1(Protocol::QAbstractFileEngineReadLine), maxlen);
 
@@ -507,22 +612,30 @@ qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 qint64 RemoteFileEngine::write(const char *data, qint64 len)
 {
     if (connectToServer()) {
-        QByteArray ba(data, len);
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite), ba);
+        discardReadAhead(true);
+
+        // Writes are collected and sent in batches without waiting for each reply. A failing
+        // batch is reported by the following write, flush() or close().
+        if (!finishWrites(scMaxPendingWrites))
+            return -1;
+        m_writeBuffer.append(data, int(len));
+        if (m_writeBuffer.size() >= scBatchSize)
+            sendWriteBatch();
+        return len;
     }
     return m_fileEngine.write(data, len);
 }
 
 bool RemoteFileEngine::syncToDisk()
 {
-    if (connectToServer())
+    if (connectAndFinishWrites())
         return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSyncToDisk));
     return m_fileEngine.syncToDisk();
 }
 
 bool RemoteFileEngine::renameOverwrite(const QString &newName)
 {
-    if (connectToServer()) {
+    if (connectAndFinishWrites()) {
         return callRemoteMethod<bool>
             (QString::fromLatin1(Protocol::QAbstractFileEngineRenameOverwrite), newName);
     }
@@ -531,7 +644,7 @@ bool RemoteFileEngine::renameOverwrite(const QString &newName)
 
 QDateTime RemoteFileEngine::fileTime(FileTime time) const
 {
-    if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
+    if ((const_cast<RemoteFileEngine *>(this))->connectAndFinishWrites()) {
         return callRemoteMethod<QDateTime>
             (QString::fromLatin1(Protocol::QAbstractFileEngineFileTime),
             static_cast<qint32> (time));
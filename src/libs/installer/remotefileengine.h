@@ -99,7 +99,26 @@ public:
     bool supportsExtension(Extension extension) const Q_DECL_OVERRIDE;
 
 private:
+    bool connectAndFinishWrites();
+    void sendWriteBatch();
+    bool finishWrites(int maxPending);
+    void discardReadAhead(bool restorePosition);
+
+private:
+    enum struct ReadAhead {
+        Unknown,
+        Enabled,
+        Disabled
+    };
+
     QFSFileEngine m_fileEngine;
+
+    ReadAhead m_readAhead;
+    QByteArray m_readBuffer;
+    int m_readBufferPos;
+    QByteArray m_writeBuffer;
+    QList<QPair<quint32, qint64> > m_pendingWrites;
+    bool m_writeFailed;
 };
 
 } // namespace QInstaller
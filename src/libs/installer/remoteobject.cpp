@@ -42,6 +42,7 @@ RemoteObject::RemoteObject(const QString &wrappedType, QObject *parent)
     , dummy(nullptr)
     , m_type(wrappedType)
     , m_socket(nullptr)
+    , m_requestId(0)
 {
     Q_ASSERT_X(!m_type.isEmpty(), Q_FUNC_INFO, "The wrapped Qt type needs to be passed as "
         "argument and cannot be empty.");
@@ -99,8 +100,7 @@ bool RemoteObject::connectToServer(const QVariantList &arguments)
     foreach (const QVariant &arg, arguments)
         out << arg;
 
-    sendPacket(m_socket, Protocol::Create, data);
-    m_socket->flush();
+    sendCommand(QLatin1String(Protocol::Create), data);
 
     return true;
 }
@@ -119,4 +119,53 @@ void RemoteObject::callRemoteMethod(const QString &name)
     writeData(name, dummy, dummy, dummy);
 }
 
+/*!
+    Sends the command \a name with the serialized arguments \a data and returns the id of the
+    request. Deferrable commands stay in the socket buffer and go out together with the next
+    command that is flushed.
+*/
+quint32 RemoteObject::sendCommand(const QString &name, const QByteArray &data) const
+{
+    const Protocol::Command command = Protocol::command(name);
+    Q_ASSERT_X(command != Protocol::Command::Unknown, Q_FUNC_INFO, qPrintable(name));
+
+    if (++m_requestId == 0)
+        ++m_requestId;
+    sendPacket(m_socket, command, m_requestId, data);
+    if (!Protocol::isDeferrable(command))
+        m_socket->flush();
+    return m_requestId;
+}
+
+/*!
+    Waits for the reply to the request \a requestId of the command \a name and returns its
+    content. Replies to other pipelined requests that arrive first are kept until taken.
+*/
+QByteArray RemoteObject::waitForReply(const QString &name, quint32 requestId) const
+{
+    if (m_replies.contains(requestId))
+        return m_replies.take(requestId);
+
+    while (m_socket->bytesToWrite())
+        m_socket->waitForBytesWritten();
+
+    forever {
+        Protocol::Command command;
+        quint32 replyId;
+        QByteArray data;
+        while (!receivePacket(m_socket, &command, &replyId, &data)) {
+            if (!m_socket->waitForReadyRead(-1)) {
+                throw Error(tr("Cannot read all data after sending command: %1. "
+                    "Bytes expected: %2, Bytes received: %3. Error: %4").arg(name).arg(0)
+                    .arg(m_socket->bytesAvailable()).arg(m_socket->errorString()));
+            }
+        }
+
+        Q_ASSERT(command == Protocol::Command::Reply);
+        if (replyId == requestId)
+            return data;
+        m_replies.insert(replyId, data);
+    }
+}
+
 } // namespace QInstaller
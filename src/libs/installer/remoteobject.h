@@ -35,6 +35,7 @@
 
 #include <QCoreApplication>
 #include <QDataStream>
+#include <QHash>
 #include <QObject>
 #include <QLocalSocket>
 
@@ -85,22 +86,26 @@ public:
     template<typename T, typename T1, typename T2, typename T3>
     T callRemoteMethod(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
     {
-        writeData(name, arg, arg2, arg3);
-        while (m_socket->bytesToWrite())
-            m_socket->waitForBytesWritten();
+        return takeReply<T>(name, writeData(name, arg, arg2, arg3));
+    }
 
-        QByteArray command;
-        QByteArray data;
-        while (!receivePacket(m_socket, &command, &data)) {
-            if (!m_socket->waitForReadyRead(-1)) {
-                throw Error(tr("Cannot read all data after sending command: %1. "
-                    "Bytes expected: %2, Bytes received: %3. Error: %4").arg(name).arg(0)
-                    .arg(m_socket->bytesAvailable()).arg(m_socket->errorString()));
-            }
-        }
+protected:
+    bool authorize();
+    bool connectToServer(const QVariantList &arguments = QVariantList());
 
-        Q_ASSERT(command == Protocol::Reply);
+    // Sends a call that replies without waiting for the reply. Calls can be pipelined this way,
+    // the reply is fetched later with takeReply() and the returned request id.
+    template<typename T1, typename T2, typename T3>
+    quint32 sendRemoteMethod(const QString &name, const T1 &arg, const T2 &arg2,
+        const T3 &arg3) const
+    {
+        return writeData(name, arg, arg2, arg3);
+    }
 
+    template<typename T>
+    T takeReply(const QString &name, quint32 requestId) const
+    {
+        QByteArray data = waitForReply(name, requestId);
         QDataStream stream(&data, QIODevice::ReadOnly);
 
         T result;
@@ -110,10 +115,6 @@ public:
         return result;
     }
 
-protected:
-    bool authorize();
-    bool connectToServer(const QVariantList &arguments = QVariantList());
-
     // Use this structure to allow derived classes to manipulate the template
     // function signature of the callRemoteMethod templates, since most of the
     // generated functions will differ in return type rather given arguments.
@@ -134,7 +135,7 @@ private:
     }
 
     template<typename T1, typename T2, typename T3>
-    void writeData(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
+    quint32 writeData(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
     {
         QByteArray data;
         QDataStream out(&data, QIODevice::WriteOnly);
@@ -146,13 +147,17 @@ private:
         if (isValueType(arg3))
             out << arg3;
 
-        sendPacket(m_socket, name.toLatin1(), data);
-        m_socket->flush();
+        return sendCommand(name, data);
     }
 
+    quint32 sendCommand(const QString &name, const QByteArray &data) const;
+    QByteArray waitForReply(const QString &name, quint32 requestId) const;
+
 private:
     QString m_type;
     QLocalSocket *m_socket;
+    mutable quint32 m_requestId;
+    mutable QHash<quint32, QByteArray> m_replies;
 };
 
 } // namespace QInstaller
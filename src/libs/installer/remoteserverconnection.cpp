@@ -48,6 +48,7 @@ RemoteServerConnection::RemoteServerConnection(qintptr socketDescriptor, const Q
     , m_engine(nullptr)
     , m_authorizationKey(key)
     , m_signalReceiver(nullptr)
+    , m_requestId(0)
 {
     setObjectName(QString::fromLatin1("RemoteServerConnection(%1)").arg(socketDescriptor));
 }
@@ -71,15 +72,15 @@ void RemoteServerConnection::run()
 
     bool authorized = false;
     while (socket.state() == QLocalSocket::ConnectedState) {
-        QByteArray cmd;
+        Protocol::Command command;
         QByteArray data;
 
-        if (!receivePacket(&socket, &cmd, &data)) {
+        if (!receivePacket(&socket, &command, &m_requestId, &data)) {
+            socket.flush();
             socket.waitForReadyRead(250);
             continue;
         }
 
-        const QString command = QString::fromLatin1(cmd);
         QBuffer buf;
         buf.setBuffer(&data);
         buf.open(QIODevice::ReadOnly);
@@ -87,14 +88,14 @@ void RemoteServerConnection::run()
         stream.setDevice(&buf);
         StreamChecker streamChecker(&stream);
 
-        if (authorized && command == QLatin1String(Protocol::Shutdown)) {
+        if (authorized && command == Protocol::Command::Shutdown) {
             authorized = false;
             sendData(&socket, true);
             socket.flush();
             socket.close();
             emit shutdownRequested();
             return;
-        } else if (command == QLatin1String(Protocol::Authorize)) {
+        } else if (command == Protocol::Command::Authorize) {
             QString key;
             stream >> key;
             sendData(&socket, (authorized = (key == m_authorizationKey)));
@@ -104,10 +105,10 @@ void RemoteServerConnection::run()
                 return;
             }
         } else if (authorized) {
-            if (command.isEmpty())
+            if (command == Protocol::Command::Unknown)
                 continue;
 
-            if (command == QLatin1String(Protocol::Create)) {
+            if (command == Protocol::Command::Create) {
                 QString type;
                 stream >> type;
                 if (type == QLatin1String(Protocol::QSettings)) {
@@ -138,7 +139,7 @@ void RemoteServerConnection::run()
                 continue;
             }
 
-            if (command == QLatin1String(Protocol::Destroy)) {
+            if (command == Protocol::Command::Destroy) {
                 QString type;
                 stream >> type;
                 if (type == QLatin1String(Protocol::QSettings)) {
@@ -154,7 +155,7 @@ void RemoteServerConnection::run()
                 return;
             }
 
-            if (command == QLatin1String(Protocol::GetQProcessSignals)) {
+            if (command == Protocol::Command::GetQProcessSignals) {
                 if (m_signalReceiver) {
                     QMutexLocker _(&m_signalReceiver->m_lock);
                     sendData(&socket, m_signalReceiver->m_receivedSignals);
@@ -164,20 +165,25 @@ void RemoteServerConnection::run()
                 continue;
             }
 
-            if (command.startsWith(QLatin1String(Protocol::QProcess))) {
+            if (command >= Protocol::Command::QProcessCloseWriteChannel
+                && command <= Protocol::Command::QProcessSetNativeArguments) {
                 handleQProcess(&socket, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::QSettings))) {
+            } else if (command >= Protocol::Command::QSettingsAllKeys
+                && command <= Protocol::Command::QSettingsApplicationName) {
                 handleQSettings(&socket, command, stream, settings.data());
-            } else if (command.startsWith(QLatin1String(Protocol::QAbstractFileEngine))) {
+            } else if (command >= Protocol::Command::QAbstractFileEngineAtEnd
+                && command <= Protocol::Command::QAbstractFileEngineFileTime) {
                 handleQFSFileEngine(&socket, command, stream);
             } else {
-                qDebug() << "Unknown command:" << command;
+                qDebug() << "Unknown command:" << Protocol::commandName(command);
             }
-            socket.flush();
+            // pipelined commands are answered together
+            if (!socket.bytesAvailable())
+                socket.flush();
         } else {
             // authorization failed, connection not wanted
             socket.close();
-            qDebug() << "Unknown command:" << command;
+            qDebug() << "Unknown command:" << Protocol::commandName(command);
             return;
         }
     }
@@ -190,26 +196,39 @@ void RemoteServerConnection::sendData(QIODevice *device, const T &data)
     QDataStream returnStream(&result, QIODevice::WriteOnly);
     returnStream << data;
 
-    sendPacket(device, Protocol::Reply, result);
+    // requests sent by command name expect a reply of the same kind
+    if (m_requestId == 0)
+        sendPacket(device, Protocol::Reply, result);
+    else
+        sendPacket(device, Protocol::Command::Reply, m_requestId, result);
 }
 
-void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &command, QDataStream &data)
+void RemoteServerConnection::handleQProcess(QIODevice *socket, Protocol::Command command,
+                                            QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QProcessCloseWriteChannel)) {
+    switch (command) {
+    case Protocol::Command::QProcessCloseWriteChannel:
         m_process->closeWriteChannel();
-    } else if (command == QLatin1String(Protocol::QProcessExitCode)) {
+        break;
+    case Protocol::Command::QProcessExitCode:
         sendData(socket, m_process->exitCode());
-    } else if (command == QLatin1String(Protocol::QProcessExitStatus)) {
+        break;
+    case Protocol::Command::QProcessExitStatus:
         sendData(socket, static_cast<qint32> (m_process->exitStatus()));
-    } else if (command == QLatin1String(Protocol::QProcessKill)) {
+        break;
+    case Protocol::Command::QProcessKill:
         m_process->kill();
-    } else if (command == QLatin1String(Protocol::QProcessReadAll)) {
+        break;
+    case Protocol::Command::QProcessReadAll:
         sendData(socket, m_process->readAll());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardOutput)) {
+        break;
+    case Protocol::Command::QProcessReadAllStandardOutput:
         sendData(socket, m_process->readAllStandardOutput());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardError)) {
+        break;
+    case Protocol::Command::QProcessReadAllStandardError:
         sendData(socket, m_process->readAllStandardError());
-    } else if (command == QLatin1String(Protocol::QProcessStartDetached)) {
+        break;
+    case Protocol::Command::QProcessStartDetached: {
         QString program;
         QStringList arguments;
         QString workingDirectory;
@@ -220,17 +239,24 @@ void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &co
         qint64 pid = -1;
         bool success = QInstaller::startDetached(program, arguments, workingDirectory, &pid);
         sendData(socket, qMakePair< bool, qint64>(success, pid));
-    } else if (command == QLatin1String(Protocol::QProcessSetWorkingDirectory)) {
+        break;
+    }
+    case Protocol::Command::QProcessSetWorkingDirectory: {
         QString dir;
         data >> dir;
         m_process->setWorkingDirectory(dir);
-    } else if (command == QLatin1String(Protocol::QProcessSetEnvironment)) {
+        break;
+    }
+    case Protocol::Command::QProcessSetEnvironment: {
         QStringList env;
         data >> env;
         m_process->setEnvironment(env);
-    } else if (command == QLatin1String(Protocol::QProcessEnvironment)) {
+        break;
+    }
+    case Protocol::Command::QProcessEnvironment:
         sendData(socket, m_process->environment());
-    } else if (command == QLatin1String(Protocol::QProcessStart3Arg)) {
+        break;
+    case Protocol::Command::QProcessStart3Arg: {
         QString program;
         QStringList arguments;
         qint32 mode;
@@ -238,148 +264,207 @@ void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &co
         data >> arguments;
         data >> mode;
         m_process->start(program, arguments, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessStart2Arg)) {
+        break;
+    }
+    case Protocol::Command::QProcessStart2Arg: {
         QString program;
         qint32 mode;
         data >> program;
         data >> mode;
         m_process->start(program, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessState)) {
+        break;
+    }
+    case Protocol::Command::QProcessState:
         sendData(socket, static_cast<qint32> (m_process->state()));
-    } else if (command == QLatin1String(Protocol::QProcessTerminate)) {
+        break;
+    case Protocol::Command::QProcessTerminate:
         m_process->terminate();
-    } else if (command == QLatin1String(Protocol::QProcessWaitForFinished)) {
+        break;
+    case Protocol::Command::QProcessWaitForFinished: {
         qint32 msecs;
         data >> msecs;
         sendData(socket, m_process->waitForFinished(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWaitForStarted)) {
+        break;
+    }
+    case Protocol::Command::QProcessWaitForStarted: {
         qint32 msecs;
         data >> msecs;
         sendData(socket, m_process->waitForStarted(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWorkingDirectory)) {
+        break;
+    }
+    case Protocol::Command::QProcessWorkingDirectory:
         sendData(socket, m_process->workingDirectory());
-    } else if (command == QLatin1String(Protocol::QProcessErrorString)) {
+        break;
+    case Protocol::Command::QProcessErrorString:
         sendData(socket, m_process->errorString());
-    } else if (command == QLatin1String(Protocol::QProcessReadChannel)) {
+        break;
+    case Protocol::Command::QProcessReadChannel:
         sendData(socket, static_cast<qint32> (m_process->readChannel()));
-    } else if (command == QLatin1String(Protocol::QProcessSetReadChannel)) {
+        break;
+    case Protocol::Command::QProcessSetReadChannel: {
         qint32 processChannel;
         data >> processChannel;
         m_process->setReadChannel(static_cast<QProcess::ProcessChannel>(processChannel));
-    } else if (command == QLatin1String(Protocol::QProcessWrite)) {
+        break;
+    }
+    case Protocol::Command::QProcessWrite: {
         QByteArray byteArray;
         data >> byteArray;
         sendData(socket, m_process->write(byteArray));
-    } else if (command == QLatin1String(Protocol::QProcessProcessChannelMode)) {
+        break;
+    }
+    case Protocol::Command::QProcessProcessChannelMode:
         sendData(socket, static_cast<qint32> (m_process->processChannelMode()));
-    } else if (command == QLatin1String(Protocol::QProcessSetProcessChannelMode)) {
+        break;
+    case Protocol::Command::QProcessSetProcessChannelMode: {
         qint32 processChannel;
         data >> processChannel;
         m_process->setProcessChannelMode(static_cast<QProcess::ProcessChannelMode>(processChannel));
+        break;
     }
 #ifdef Q_OS_WIN
-    else if (command == QLatin1String(Protocol::QProcessSetNativeArguments)) {
+    case Protocol::Command::QProcessSetNativeArguments: {
         QString arguments;
         data >> arguments;
         m_process->setNativeArguments(arguments);
+        break;
     }
 #endif
-    else if (!command.isEmpty()) {
-        qDebug() << "Unknown QProcess command:" << command;
+    default:
+        qDebug() << "Unknown QProcess command:" << Protocol::commandName(command);
+        break;
     }
 }
 
-void RemoteServerConnection::handleQSettings(QIODevice *socket, const QString &command,
+void RemoteServerConnection::handleQSettings(QIODevice *socket, Protocol::Command command,
                                              QDataStream &data, PermissionSettings *settings)
 {
     if (!settings)
         return;
 
-    if (command == QLatin1String(Protocol::QSettingsAllKeys)) {
+    switch (command) {
+    case Protocol::Command::QSettingsAllKeys:
         sendData(socket, settings->allKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsBeginGroup)) {
+        break;
+    case Protocol::Command::QSettingsBeginGroup: {
         QString prefix;
         data >> prefix;
         settings->beginGroup(prefix);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginWriteArray)) {
+        break;
+    }
+    case Protocol::Command::QSettingsBeginWriteArray: {
         QString prefix;
         data >> prefix;
         qint32 size;
         data >> size;
         settings->beginWriteArray(prefix, size);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginReadArray)) {
+        break;
+    }
+    case Protocol::Command::QSettingsBeginReadArray: {
         QString prefix;
         data >> prefix;
         sendData(socket, settings->beginReadArray(prefix));
-    } else if (command == QLatin1String(Protocol::QSettingsChildGroups)) {
+        break;
+    }
+    case Protocol::Command::QSettingsChildGroups:
         sendData(socket, settings->childGroups());
-    } else if (command == QLatin1String(Protocol::QSettingsChildKeys)) {
+        break;
+    case Protocol::Command::QSettingsChildKeys:
         sendData(socket, settings->childKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsClear)) {
+        break;
+    case Protocol::Command::QSettingsClear:
         settings->clear();
-    } else if (command == QLatin1String(Protocol::QSettingsContains)) {
+        break;
+    case Protocol::Command::QSettingsContains: {
         QString key;
         data >> key;
         sendData(socket, settings->contains(key));
-    } else if (command == QLatin1String(Protocol::QSettingsEndArray)) {
+        break;
+    }
+    case Protocol::Command::QSettingsEndArray:
         settings->endArray();
-    } else if (command == QLatin1String(Protocol::QSettingsEndGroup)) {
+        break;
+    case Protocol::Command::QSettingsEndGroup:
         settings->endGroup();
-    } else if (command == QLatin1String(Protocol::QSettingsFallbacksEnabled)) {
+        break;
+    case Protocol::Command::QSettingsFallbacksEnabled:
         sendData(socket, settings->fallbacksEnabled());
-    } else if (command == QLatin1String(Protocol::QSettingsFileName)) {
+        break;
+    case Protocol::Command::QSettingsFileName:
         sendData(socket, settings->fileName());
-    } else if (command == QLatin1String(Protocol::QSettingsGroup)) {
+        break;
+    case Protocol::Command::QSettingsGroup:
         sendData(socket, settings->group());
-    } else if (command == QLatin1String(Protocol::QSettingsIsWritable)) {
+        break;
+    case Protocol::Command::QSettingsIsWritable:
         sendData(socket, settings->isWritable());
-    } else if (command == QLatin1String(Protocol::QSettingsRemove)) {
+        break;
+    case Protocol::Command::QSettingsRemove: {
         QString key;
         data >> key;
         settings->remove(key);
-    } else if (command == QLatin1String(Protocol::QSettingsSetArrayIndex)) {
+        break;
+    }
+    case Protocol::Command::QSettingsSetArrayIndex: {
         qint32 i;
         data >> i;
         settings->setArrayIndex(i);
-    } else if (command == QLatin1String(Protocol::QSettingsSetFallbacksEnabled)) {
+        break;
+    }
+    case Protocol::Command::QSettingsSetFallbacksEnabled: {
         bool b;
         data >> b;
         settings->setFallbacksEnabled(b);
-    } else if (command == QLatin1String(Protocol::QSettingsStatus)) {
+        break;
+    }
+    case Protocol::Command::QSettingsStatus:
         sendData(socket, settings->status());
-    } else if (command == QLatin1String(Protocol::QSettingsSync)) {
+        break;
+    case Protocol::Command::QSettingsSync:
         settings->sync();
-    } else if (command == QLatin1String(Protocol::QSettingsSetValue)) {
+        break;
+    case Protocol::Command::QSettingsSetValue: {
         QString key;
         QVariant value;
         data >> key;
         data >> value;
         settings->setValue(key, value);
-    } else if (command == QLatin1String(Protocol::QSettingsValue)) {
+        break;
+    }
+    case Protocol::Command::QSettingsValue: {
         QString key;
         QVariant defaultValue;
         data >> key;
         data >> defaultValue;
         sendData(socket, settings->value(key, defaultValue));
-    } else if (command == QLatin1String(Protocol::QSettingsOrganizationName)) {
+        break;
+    }
+    case Protocol::Command::QSettingsOrganizationName:
         sendData(socket, settings->organizationName());
-    } else if (command == QLatin1String(Protocol::QSettingsApplicationName)) {
+        break;
+    case Protocol::Command::QSettingsApplicationName:
         sendData(socket, settings->applicationName());
-    } else if (!command.isEmpty()) {
-        qDebug() << "Unknown QSettings command:" << command;
+        break;
+    default:
+        qDebug() << "Unknown QSettings command:" << Protocol::commandName(command);
+        break;
     }
 }
 
-void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, const QString &command,
+void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, Protocol::Command command,
                                                  QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QAbstractFileEngineAtEnd)) {
+    switch (command) {
+    case Protocol::Command::QAbstractFileEngineAtEnd:
         sendData(socket, m_engine->atEnd());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCaseSensitive)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineCaseSensitive:
         sendData(socket, m_engine->caseSensitive());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineClose)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineClose:
         sendData(socket, m_engine->close());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCopy)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineCopy: {
         QString newName;
         data >>newName;
 #ifdef Q_OS_LINUX
@@ -390,119 +475,173 @@ void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, const QStrin
 #else
         sendData(socket, m_engine->copy(newName));
 #endif
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineEntryList)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineEntryList: {
         qint32 filters;
         QStringList filterNames;
         data >>filters;
         data >>filterNames;
         sendData(socket, m_engine->entryList(static_cast<QDir::Filters> (filters), filterNames));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineError)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineError:
         sendData(socket, static_cast<qint32> (m_engine->error()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineErrorString)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineErrorString:
         sendData(socket, m_engine->errorString());
-    }
-    else if (command == QLatin1String(Protocol::QAbstractFileEngineFileFlags)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineFileFlags: {
         qint32 flags;
         data >>flags;
         flags = m_engine->fileFlags(static_cast<QAbstractFileEngine::FileFlags>(flags));
         sendData(socket, static_cast<qint32>(flags));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileName)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineFileName: {
         qint32 file;
         data >>file;
         sendData(socket, m_engine->fileName(static_cast<QAbstractFileEngine::FileName> (file)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFlush)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineFlush:
         sendData(socket, m_engine->flush());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineHandle)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineHandle:
         sendData(socket, m_engine->handle());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsRelativePath)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineIsRelativePath:
         sendData(socket, m_engine->isRelativePath());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsSequential)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineIsSequential:
         sendData(socket, m_engine->isSequential());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineLink)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineLink: {
         QString newName;
         data >>newName;
         sendData(socket, m_engine->link(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineMkdir)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineMkdir: {
         QString dirName;
         bool createParentDirectories;
         data >>dirName;
         data >>createParentDirectories;
         sendData(socket, m_engine->mkdir(dirName, createParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOpen)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineOpen: {
         qint32 openMode;
         data >>openMode;
         sendData(socket, m_engine->open(static_cast<QIODevice::OpenMode> (openMode)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwner)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineOwner: {
         qint32 owner;
         data >>owner;
         sendData(socket, m_engine->owner(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwnerId)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineOwnerId: {
         qint32 owner;
         data >>owner;
         sendData(socket, m_engine->ownerId(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEnginePos)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEnginePos:
         sendData(socket, m_engine->pos());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRead)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineRead: {
         qint64 maxlen;
         data >> maxlen;
         QByteArray byteArray(maxlen, '\0');
         const qint64 r = m_engine->read(byteArray.data(), maxlen);
+        // only send back what was read, the client copies at most r bytes anyway
+        byteArray.resize(qMax(r, qint64(0)));
         sendData(socket, qMakePair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineReadLine)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineReadLine: {
         qint64 maxlen;
         data >> maxlen;
         QByteArray byteArray(maxlen, '\0');
         const qint64 r = m_engine->readLine(byteArray.data(), maxlen);
+        byteArray.resize(qMax(r, qint64(0)));
         sendData(socket, qMakePair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRemove)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineRemove:
         sendData(socket, m_engine->remove());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRename)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineRename: {
         QString newName;
         data >>newName;
         sendData(socket, m_engine->rename(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRmdir)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineRmdir: {
         QString dirName;
         bool recurseParentDirectories;
         data >>dirName;
         data >>recurseParentDirectories;
         sendData(socket, m_engine->rmdir(dirName, recurseParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSeek)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSeek: {
         quint64 offset;
         data >>offset;
         sendData(socket, m_engine->seek(offset));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetFileName)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSetFileName: {
         QString fileName;
         data >>fileName;
         m_engine->setFileName(fileName);
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetPermissions)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSetPermissions: {
         uint perms;
         data >>perms;
         sendData(socket, m_engine->setPermissions(perms));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetSize)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSetSize: {
         qint64 size;
         data >>size;
         sendData(socket, m_engine->setSize(size));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSize)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSize:
         sendData(socket, m_engine->size());
-    } else if ((command == QLatin1String(Protocol::QAbstractFileEngineSupportsExtension))
-        || (command == QLatin1String(Protocol::QAbstractFileEngineExtension))) {
-            // Implemented client side.
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineWrite)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineSupportsExtension:
+    case Protocol::Command::QAbstractFileEngineExtension:
+        // Implemented client side.
+        break;
+    case Protocol::Command::QAbstractFileEngineWrite: {
         QByteArray content;
         data >> content;
         sendData(socket, m_engine->write(content.data(), content.size()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSyncToDisk)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineSyncToDisk:
         sendData(socket, m_engine->syncToDisk());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRenameOverwrite)) {
+        break;
+    case Protocol::Command::QAbstractFileEngineRenameOverwrite: {
         QString newFilename;
         data >> newFilename;
         sendData(socket, m_engine->renameOverwrite(newFilename));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileTime)) {
+        break;
+    }
+    case Protocol::Command::QAbstractFileEngineFileTime: {
         qint32 filetime;
         data >> filetime;
         sendData(socket, m_engine->fileTime(static_cast<QAbstractFileEngine::FileTime> (filetime)));
-    } else if (!command.isEmpty()) {
-        qDebug() << "Unknown QAbstractFileEngine command:" << command;
+        break;
+    }
+    default:
+        qDebug() << "Unknown QAbstractFileEngine command:" << Protocol::commandName(command);
+        break;
     }
 }
 
@@ -29,6 +29,8 @@
 #ifndef REMOTESERVERCONNECTION_H
 #define REMOTESERVERCONNECTION_H
 
+#include "protocol.h"
+
 #include <QPointer>
 #include <QThread>
 
@@ -62,10 +64,10 @@ signals:
 private:
     template <typename T>
     void sendData(QIODevice *device, const T &arg);
-    void handleQProcess(QIODevice *device, const QString &command, QDataStream &data);
-    void handleQSettings(QIODevice *device, const QString &command, QDataStream &data,
+    void handleQProcess(QIODevice *device, Protocol::Command command, QDataStream &data);
+    void handleQSettings(QIODevice *device, Protocol::Command command, QDataStream &data,
                          PermissionSettings *settings);
-    void handleQFSFileEngine(QIODevice *device, const QString &command, QDataStream &data);
+    void handleQFSFileEngine(QIODevice *device, Protocol::Command command, QDataStream &data);
 
 private:
     qintptr m_socketDescriptor;
@@ -74,6 +76,7 @@ private:
     QFSFileEngine *m_engine;
     QString m_authorizationKey;
     QProcessSignalReceiver *m_signalReceiver;
+    quint32 m_requestId;
 };
 
 } // namespace QInstaller
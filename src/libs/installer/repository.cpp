@@ -51,6 +51,7 @@ Repository::Repository()
 */
 Repository::Repository(const Repository &other)
     : m_url(other.m_url)
+    , m_mirrors(other.m_mirrors)
     , m_default(other.m_default)
     , m_enabled(other.m_enabled)
     , m_username(other.m_username)
@@ -135,6 +136,24 @@ void Repository::setUrl(const QUrl &url)
     m_url = url;
 }
 
+/*!
+    Returns the URLs of mirrors serving the same content as url(), in the order they were
+    configured.
+*/
+QList<QUrl> Repository::mirrors() const
+{
+    return m_mirrors;
+}
+
+/*!
+    Sets the URLs of mirrors serving the same content as url() to \a mirrors. Large archives are
+    downloaded in segments, some of which may be fetched from the mirrors.
+*/
+void Repository::setMirrors(const QList<QUrl> &mirrors)
+{
+    m_mirrors = mirrors;
+}
+
 /*!
     Returns whether the repository is enabled and used during information retrieval.
 */
@@ -233,12 +252,13 @@ void Repository::setCompressed(bool compressed)
 }
 /*!
     Compares the values of this repository to \a other and returns true if they are equal (same server,
-    default state, enabled state as well as username and password). \sa operator!=()
+    mirrors, default state, enabled state as well as username and password). \sa operator!=()
 */
 bool Repository::operator==(const Repository &other) const
 {
-    return m_url == other.m_url && m_default == other.m_default && m_enabled == other.m_enabled
-        && m_username == other.m_username && m_password == other.m_password && m_displayname == other.m_displayname;
+    return m_url == other.m_url && m_mirrors == other.m_mirrors && m_default == other.m_default
+        && m_enabled == other.m_enabled && m_username == other.m_username
+        && m_password == other.m_password && m_displayname == other.m_displayname;
 }
 
 /*!
@@ -259,6 +279,7 @@ const Repository &Repository::operator=(const Repository &other)
         return *this;
 
     m_url = other.m_url;
+    m_mirrors = other.m_mirrors;
     m_default = other.m_default;
     m_enabled = other.m_enabled;
     m_username = other.m_username;
@@ -278,21 +299,36 @@ void Repository::registerMetaType()
 
 QDataStream &operator>>(QDataStream &istream, Repository &repository)
 {
-    QByteArray url, username, password, displayname, compressed;
+    QByteArray url, username, password, displayname, categoryname;
     istream >> url >> repository.m_default >> repository.m_enabled >> username >> password
-            >> displayname >> repository.m_categoryname;
+            >> displayname >> categoryname;
     repository.setUrl(QUrl::fromEncoded(QByteArray::fromBase64(url)));
     repository.setUsername(QString::fromUtf8(QByteArray::fromBase64(username)));
     repository.setPassword(QString::fromUtf8(QByteArray::fromBase64(password)));
     repository.setDisplayName(QString::fromUtf8(QByteArray::fromBase64(displayname)));
+    repository.setCategoryName(QString::fromUtf8(QByteArray::fromBase64(categoryname)));
+
+    // repositories written by older versions end here
+    QList<QByteArray> mirrors;
+    if (!istream.atEnd())
+        istream >> mirrors;
+    QList<QUrl> mirrorUrls;
+    foreach (const QByteArray &mirror, mirrors)
+        mirrorUrls.append(QUrl::fromEncoded(QByteArray::fromBase64(mirror)));
+    repository.setMirrors(mirrorUrls);
     return istream;
 }
 
 QDataStream &operator<<(QDataStream &ostream, const Repository &repository)
 {
+    QList<QByteArray> mirrors;
+    foreach (const QUrl &mirror, repository.m_mirrors)
+        mirrors.append(mirror.toEncoded().toBase64());
+
     return ostream << repository.m_url.toEncoded().toBase64() << repository.m_default << repository.m_enabled
         << repository.m_username.toUtf8().toBase64() << repository.m_password.toUtf8().toBase64()
-        << repository.m_displayname.toUtf8().toBase64() << repository.m_categoryname.toUtf8().toBase64();
+        << repository.m_displayname.toUtf8().toBase64() << repository.m_categoryname.toUtf8().toBase64()
+        << mirrors;
 }
 
 }
@@ -31,6 +31,7 @@
 
 #include "installer_global.h"
 
+#include <QtCore/QList>
 #include <QtCore/QMetaType>
 #include <QtCore/QUrl>
 
@@ -52,6 +53,9 @@ public:
     QUrl url() const;
     void setUrl(const QUrl &url);
 
+    QList<QUrl> mirrors() const;
+    void setMirrors(const QList<QUrl> &mirrors);
+
     bool isEnabled() const;
     void setEnabled(bool enabled);
 
@@ -80,6 +84,7 @@ public:
 
 private:
     QUrl m_url;
+    QList<QUrl> m_mirrors;
     bool m_default;
     bool m_enabled;
     QString m_username;
@@ -150,6 +150,8 @@ static QSet<Repository> readRepositories(QXmlStreamReader &reader, bool isDefaul
             while (reader.readNextStartElement()) {
                 if (reader.name() == QLatin1String("Url")) {
                     repo.setUrl(reader.readElementText());
+                } else if (reader.name() == QLatin1String("Mirror")) {
+                    repo.setMirrors(repo.mirrors() << QUrl(reader.readElementText()));
                 } else if (reader.name() == QLatin1String("Username")) {
                     repo.setUsername(reader.readElementText());
                 } else if (reader.name() == QLatin1String("Password")) {
@@ -293,7 +295,10 @@ Settings Settings::fromFileAndPrefix(const QString &path, const QString &prefix,
                 << scRepositorySettingsPageVisible << scTargetConfigurationFile
                 << scRemoteRepositories << scTranslations << scUrlQueryString << QLatin1String(scControlScript)
                 << scCreateLocalRepository << scInstallActionColumnVisible << scSupportsModify << scAllowUnstableComponents
-                << scSaveDefaultRepositories << scRepositoryCategories;
+                << scSaveDefaultRepositories << scRepositoryCategories << scPipelinedInstallation
+                << scMaxConcurrentDownloads << scInMemoryDownloadLimit
+                << scDownloadSegments << scDownloadSegmentSize
+                << scMaxConcurrentExtractions << scLocalCachePath << scLocalCacheSizeLimit;
 
     Settings s;
     s.d->m_data.insert(scPrefix, prefix);
@@ -38,6 +38,8 @@ namespace QInstaller {
 
 UninstallerCalculator::UninstallerCalculator(const QList<Component *> &installedComponents)
     : m_installedComponents(installedComponents)
+    , m_installedComponentsByName(PackageManagerCore::componentIndex(installedComponents))
+    , m_initialized(false)
 {
 }
 
@@ -46,105 +48,202 @@ QSet<Component *> UninstallerCalculator::componentsToUninstall() const
     return m_componentsToUninstall;
 }
 
-void UninstallerCalculator::appendComponentToUninstall(Component *component)
+/*
+    Resolves the auto dependencies of all installed components once, so that the passes in
+    appendComponentsToUninstall() only need to look at components whose state might have
+    changed since they were last checked.
+*/
+void UninstallerCalculator::initialize()
 {
-    if (!component)
+    if (m_initialized)
         return;
+    m_initialized = true;
 
-    if (!component->isInstalled())
-        return;
+    // Every name an installed component provides, either by its own name or by replacing one.
+    QSet<QString> providedNames;
+    foreach (Component *component, m_installedComponents) {
+        providedNames.insert(component->name());
+        foreach (const QString &replaced, component->replaces())
+            providedNames.insert(replaced);
+    }
 
-    PackageManagerCore *core = component->packageManagerCore();
-    // remove all already resolved dependees
-    QSet<Component *> dependees = core->dependees(component).toSet()
-            .subtract(m_componentsToUninstall);
+    for (int i = 0; i < m_installedComponents.count(); ++i) {
+        Component *component = m_installedComponents.at(i);
+        if (m_installedIndex.contains(component))
+            continue;
+        m_installedIndex.insert(component, i);
+        if (!component->isInstalled())
+            continue;
+
+        const QStringList autoDependencies = PackageManagerCore::parseNames(component->autoDependencies());
+        if (autoDependencies.isEmpty()) {
+            if (component->isVirtual() && !component->forcedInstallation()) {
+                m_virtualComponents.insert(component->name(), component);
+                m_pendingVirtual.insert(i, component);
+            }
+            continue;
+        }
 
-    foreach (Component *dependee, dependees)
-        appendComponentToUninstall(dependee);
+        // This code needs to be enabled once the scripts use isInstalled, installationRequested and
+        // uninstallationRequested...
+        if (autoDependencies.first().compare(scScript, Qt::CaseInsensitive) == 0) {
+            //QScriptValue valueFromScript;
+            //try {
+            //    valueFromScript = callScriptMethod(QLatin1String("isAutoDependOn"));
+            //} catch (const Error &error) {
+            //    // keep the component, should do no harm
+            //    continue;
+            //}
+
+            //if (valueFromScript.isValid() && !valueFromScript.toBool())
+            //    autoDependOnList.append(component);
+            continue;
+        }
 
-    m_componentsToUninstall.insert(component);
+        // A null entry marks a name no installed component provides.
+        QList<Component *> resolved;
+        foreach (const QString &name, autoDependencies) {
+            Component *provider = providedNames.contains(name)
+                ? PackageManagerCore::componentByName(name, m_installedComponentsByName) : 0;
+            resolved.append(provider);
+            if (provider)
+                m_autoDependees[provider].append(component);
+        }
+        m_autoDependOn.insert(component, resolved);
+        m_pendingAutoDependOn.insert(i, component);
+    }
 }
 
-void UninstallerCalculator::appendComponentsToUninstall(const QList<Component*> &components)
+void UninstallerCalculator::appendComponentToUninstall(Component *component)
 {
-    foreach (Component *component, components)
-        appendComponentToUninstall(component);
-
-    QList<Component*> autoDependOnList;
-    // All regular dependees are resolved. Now we are looking for auto depend on components.
-    foreach (Component *component, m_installedComponents) {
-        // If a components is installed and not yet scheduled for un-installation, check for auto depend.
-        if (component->isInstalled() && !m_componentsToUninstall.contains(component)) {
-            QStringList autoDependencies = PackageManagerCore::parseNames(component->autoDependencies());
-            if (autoDependencies.isEmpty())
-                continue;
-
-            // This code needs to be enabled once the scripts use isInstalled, installationRequested and
-            // uninstallationRequested...
-            if (autoDependencies.first().compare(scScript, Qt::CaseInsensitive) == 0) {
-                //QScriptValue valueFromScript;
-                //try {
-                //    valueFromScript = callScriptMethod(QLatin1String("isAutoDependOn"));
-                //} catch (const Error &error) {
-                //    // keep the component, should do no harm
-                //    continue;
-                //}
-
-                //if (valueFromScript.isValid() && !valueFromScript.toBool())
-                //    autoDependOnList.append(component);
-                continue;
-            }
+    QList<Component *> stack;
+    stack.append(component);
+    while (!stack.isEmpty()) {
+        Component *current = stack.takeLast();
+        if (!current || !current->isInstalled() || m_componentsToUninstall.contains(current))
+            continue;
+
+        insertComponentToUninstall(current);
+
+        PackageManagerCore *core = current->packageManagerCore();
+        foreach (Component *dependee, core->dependees(current)) {
+            if (!m_componentsToUninstall.contains(dependee))
+                stack.append(dependee);
+        }
+    }
+}
 
-            foreach (Component *c, m_installedComponents) {
-                const QString replaces = c->value(scReplaces);
-                const QStringList possibleNames = replaces.split(QInstaller::commaRegExp(),
-                                                                 QString::SkipEmptyParts) << c->name();
-                foreach (const QString &possibleName, possibleNames) {
+void UninstallerCalculator::insertComponentToUninstall(Component *component)
+{
+    m_componentsToUninstall.insert(component);
 
-                    Component *cc = PackageManagerCore::componentByName(possibleName, m_installedComponents);
-                    if (cc && (cc->installAction() != ComponentModelHelper::AutodependUninstallation)) {
-                        autoDependencies.removeAll(possibleName);
+    const int index = m_installedIndex.value(component, -1);
+    if (index >= 0) {
+        m_pendingAutoDependOn.remove(index);
+        m_pendingVirtual.remove(index);
+    }
 
-                    }
-                }
-            }
+    // Virtual components this one depended on may have lost their last installed dependee.
+    foreach (const QString &name, PackageManagerCore::parseNames(component->dependencies())) {
+        foreach (Component *dependency, m_virtualComponents.values(name)) {
+            if (!m_componentsToUninstall.contains(dependency))
+                m_pendingVirtual.insert(m_installedIndex.value(dependency), dependency);
+        }
+    }
+}
 
-            // A component requested auto uninstallation, keep it to resolve their dependencies as well.
-            if (!autoDependencies.isEmpty()) {
-                autoDependOnList.append(component);
-                component->setInstallAction(ComponentModelHelper::AutodependUninstallation);
+/*
+    Returns the installed components not yet scheduled for un-installation that have at least one
+    auto dependency that is not provided anymore, and marks them for auto dependency
+    un-installation. Components are checked in installation order; a component marked during the
+    pass affects the components after it right away and the ones before it in the next pass.
+*/
+QList<Component *> UninstallerCalculator::takeAutoDependOnComponents()
+{
+    QList<Component *> autoDependOnList;
+    QMap<int, Component *> pending;
+    pending.swap(m_pendingAutoDependOn);
+
+    while (!pending.isEmpty()) {
+        const QMap<int, Component *>::iterator it = pending.begin();
+        const int index = it.key();
+        Component *component = it.value();
+        pending.erase(it);
+
+        if (m_componentsToUninstall.contains(component))
+            continue;
+
+        bool unresolved = false;
+        foreach (Component *provider, m_autoDependOn.value(component)) {
+            if (!provider || provider->installAction() == ComponentModelHelper::AutodependUninstallation) {
+                unresolved = true;
+                break;
             }
         }
-    }
+        if (!unresolved)
+            continue;
 
-    if (!autoDependOnList.isEmpty())
-        appendComponentsToUninstall(autoDependOnList);
+        // A component requested auto uninstallation, keep it to resolve their dependencies as well.
+        autoDependOnList.append(component);
+        component->setInstallAction(ComponentModelHelper::AutodependUninstallation);
 
-    QList<Component*> unneededVirtualList;
-    // Check for virtual components without dependees
-    foreach (Component *component, m_installedComponents) {
-        if (component->isInstalled() && component->isVirtual() && !m_componentsToUninstall.contains(component)) {
-            // Components with auto dependencies were handled in the previous step
-            if (!component->autoDependencies().isEmpty())
-                continue;
-            if (component->forcedInstallation())
+        foreach (Component *dependee, m_autoDependees.value(component)) {
+            if (m_componentsToUninstall.contains(dependee) || dependee == component)
                 continue;
+            const int dependeeIndex = m_installedIndex.value(dependee);
+            if (dependeeIndex > index)
+                pending.insert(dependeeIndex, dependee);
+            else
+                m_pendingAutoDependOn.insert(dependeeIndex, dependee);
+        }
+    }
+    return autoDependOnList;
+}
 
-            bool required = false;
-            PackageManagerCore *core = component->packageManagerCore();
-            foreach (Component *dependee, core->dependees(component)) {
-                if (dependee->isInstalled() && !m_componentsToUninstall.contains(dependee)) {
-                    required = true;
-                    break;
-                }
+/*
+    Returns the installed virtual components not yet scheduled for un-installation that have no
+    installed dependee left, in installation order.
+*/
+QList<Component *> UninstallerCalculator::takeUnneededVirtualComponents()
+{
+    QList<Component *> unneededVirtualList;
+    QMap<int, Component *> pending;
+    pending.swap(m_pendingVirtual);
+
+    foreach (Component *component, pending) {
+        if (m_componentsToUninstall.contains(component))
+            continue;
+
+        bool required = false;
+        PackageManagerCore *core = component->packageManagerCore();
+        foreach (Component *dependee, core->dependees(component)) {
+            if (dependee->isInstalled() && !m_componentsToUninstall.contains(dependee)) {
+                required = true;
+                break;
             }
-            if (!required)
-                unneededVirtualList.append(component);
         }
+        if (!required)
+            unneededVirtualList.append(component);
     }
+    return unneededVirtualList;
+}
 
-    if (!unneededVirtualList.isEmpty())
-        appendComponentsToUninstall(unneededVirtualList);
+void UninstallerCalculator::appendComponentsToUninstall(const QList<Component*> &components)
+{
+    initialize();
+
+    // Each round schedules the given components together with their dependees, then looks for
+    // auto depend on components and afterwards for virtual components that are not needed
+    // anymore. Only components affected by a previous round are checked again.
+    QList<Component *> next = components;
+    while (!next.isEmpty()) {
+        foreach (Component *component, next)
+            appendComponentToUninstall(component);
+
+        next = takeAutoDependOnComponents();
+        if (next.isEmpty())
+            next = takeUnneededVirtualComponents();
+    }
 }
 
 } // namespace QInstaller
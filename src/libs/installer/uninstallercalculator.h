@@ -32,6 +32,7 @@
 
 #include <QHash>
 #include <QList>
+#include <QMap>
 #include <QSet>
 #include <QString>
 
@@ -49,11 +50,23 @@ public:
     void appendComponentsToUninstall(const QList<Component*> &components);
 
 private:
-
+    void initialize();
     void appendComponentToUninstall(Component *component);
+    void insertComponentToUninstall(Component *component);
+    QList<Component *> takeAutoDependOnComponents();
+    QList<Component *> takeUnneededVirtualComponents();
 
     QList<Component *> m_installedComponents;
+    QHash<QString, QList<Component *> > m_installedComponentsByName;
     QSet<Component *> m_componentsToUninstall;
+
+    bool m_initialized;
+    QHash<Component *, int> m_installedIndex;
+    QHash<Component *, QList<Component *> > m_autoDependOn;
+    QHash<Component *, QList<Component *> > m_autoDependees;
+    QMultiHash<QString, Component *> m_virtualComponents;
+    QMap<int, Component *> m_pendingAutoDependOn;
+    QMap<int, Component *> m_pendingVirtual;
 };
 
 }
@@ -33,9 +33,12 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
+#include <QMutex>
 #include <QProcessEnvironment>
+#include <QTemporaryFile>
 #include <QThread>
 #include <QVector>
+#include <QWaitCondition>
 
 #if defined(Q_OS_WIN) || defined(Q_OS_WINCE)
 #   include "qt_windows.h"
@@ -207,54 +210,228 @@ QString QInstaller::replaceWindowsEnvironmentVariables(const QString &str)
     return res;
 }
 
+namespace QInstaller {
+
+/*
+    Collects the log lines in a bounded in-memory buffer and streams them to a temporary file from
+    a background thread, so that logging from worker threads does not wait for the disk, the memory
+    used does not grow with the size of the log, and the log survives a crash of the installer. The
+    temporary file is appended to the final log file once the target directory exists.
+*/
+class VerboseWriterPrivate : public QThread
+{
+public:
+    enum {
+        WriteThreshold = 64 * 1024,     // wake up the writer thread once that much is pending
+        MaxPendingSize = 1024 * 1024,   // let the logging threads wait beyond that
+        WriteInterval = 500,            // ms
+        CopyChunkSize = 1024 * 1024
+    };
+
+    VerboseWriterPrivate()
+        : m_device(nullptr)
+        , m_stopped(false)
+        , m_closed(false)
+        , m_headerWritten(false)
+        , m_copiedSize(0)
+        , m_currentDateTimeAsString(QDateTime::currentDateTime().toString())
+    {
+        start(QThread::LowPriority);
+    }
+
+    ~VerboseWriterPrivate()
+    {
+        stop();
+        if (m_device)
+            m_device->close();
+        if (m_device == &m_file)
+            m_file.remove();
+    }
+
+    void append(const QString &line)
+    {
+        const QByteArray data = line.toLocal8Bit() + '\n';
+
+        QMutexLocker locker(&m_mutex);
+        if (m_closed)
+            return;
+        if (QThread::currentThread() != this) {
+            while (!m_stopped && m_pending.size() >= MaxPendingSize)
+                m_pendingWritten.wait(&m_mutex);
+        }
+        m_pending.append(data);
+        if (m_pending.size() >= WriteThreshold)
+            m_pendingAvailable.wakeOne();
+    }
+
+    bool isClosed() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_closed;
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopped = true;
+            m_pendingAvailable.wakeOne();
+            m_pendingWritten.wakeAll();
+        }
+        wait();
+    }
+
+    void restart()
+    {
+        // Keeps streaming the pending lines to the temporary file after a failed copyTo(), so
+        // they do not pile up in memory until the copy is retried.
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopped = false;
+        }
+        start(QThread::LowPriority);
+    }
+
+    bool copyTo(const QString &fileName, VerboseWriterOutput *output)
+    {
+        // may only be called after stop(), so this is the only thread touching the device
+        const QIODevice::OpenMode openMode = QIODevice::ReadWrite | QIODevice::Append
+            | QIODevice::Text;
+        if (!m_headerWritten) {
+            QString logInfo;
+            logInfo += QLatin1String("************************************* Invoked: ");
+            logInfo += m_currentDateTimeAsString;
+            logInfo += QLatin1String("\n");
+            if (!output->write(fileName, openMode, logInfo.toLocal8Bit()))
+                return false;
+            m_headerWritten = true;
+        }
+
+        // writing the log might log itself, so keep going until nothing is pending anymore
+        forever {
+            writePending();
+            if (m_device && !m_device->seek(m_copiedSize))
+                return false;
+            while (m_device && !m_device->atEnd()) {
+                const QByteArray chunk = m_device->read(CopyChunkSize);
+                if (chunk.isEmpty() || !output->write(fileName, openMode, chunk))
+                    return false;
+                m_copiedSize += chunk.size();
+            }
+
+            QMutexLocker locker(&m_mutex);
+            if (m_pending.isEmpty()) {
+                m_closed = true;
+                return true;
+            }
+        }
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        bool stopped = false;
+        while (!stopped) {
+            {
+                QMutexLocker locker(&m_mutex);
+                if (!m_stopped && m_pending.size() < WriteThreshold)
+                    m_pendingAvailable.wait(&m_mutex, WriteInterval);
+                stopped = m_stopped;
+            }
+            writePending();
+        }
+    }
+
+private:
+    void writePending()
+    {
+        QByteArray data;
+        {
+            QMutexLocker locker(&m_mutex);
+            data.swap(m_pending);
+            m_pendingWritten.wakeAll();
+        }
+        if (data.isEmpty())
+            return;
+
+        if (!m_device)
+            openDevice();
+        m_device->seek(m_device->size());
+        m_device->write(data);
+        if (m_device == &m_file)
+            m_file.flush();
+    }
+
+    void openDevice()
+    {
+        m_file.setFileTemplate(QDir::tempPath() + QLatin1String("/IFW_LogXXXXXX.txt"));
+        m_file.setAutoRemove(false); // keep the log if the installer crashes
+        if (m_file.open()) {
+            m_device = &m_file;
+        } else {
+            // fall back to keeping the whole log in memory
+            m_buffer.open(QIODevice::ReadWrite);
+            m_device = &m_buffer;
+        }
+    }
+
+public:
+    QString m_logFileName;
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_pendingAvailable;
+    QWaitCondition m_pendingWritten;
+    QByteArray m_pending;
+
+    QIODevice *m_device;
+    QTemporaryFile m_file;
+    QBuffer m_buffer;
+
+    bool m_stopped;
+    bool m_closed;
+    bool m_headerWritten;
+    qint64 m_copiedSize;
+    QString m_currentDateTimeAsString;
+};
+
+} // namespace QInstaller
+
 QInstaller::VerboseWriter::VerboseWriter()
+    : d(new VerboseWriterPrivate)
 {
-    preFileBuffer.open(QIODevice::ReadWrite);
-    stream.setDevice(&preFileBuffer);
-    currentDateTimeAsString = QDateTime::currentDateTime().toString();
 }
 
 QInstaller::VerboseWriter::~VerboseWriter()
 {
-    if (preFileBuffer.isOpen()) {
+    if (!d->isClosed()) {
         PlainVerboseWriterOutput output;
         (void)flush(&output);
     }
+    delete d;
 }
 
 bool QInstaller::VerboseWriter::flush(VerboseWriterOutput *output)
 {
-    stream.flush();
-    if (logFileName.isEmpty()) // binarycreator
+    if (d->m_logFileName.isEmpty()) // binarycreator
         return true;
-    if (!preFileBuffer.isOpen())
+    if (d->isClosed())
         return true;
     //if the installer installed nothing - there is no target directory - where the logfile can be saved
-    if (!QFileInfo(logFileName).absoluteDir().exists())
+    if (!QFileInfo(d->m_logFileName).absoluteDir().exists())
         return true;
 
-    QString logInfo;
-    logInfo += QLatin1String("************************************* Invoked: ");
-    logInfo += currentDateTimeAsString;
-    logInfo += QLatin1String("\n");
-
-    QBuffer buffer;
-    buffer.open(QIODevice::WriteOnly);
-    buffer.write(logInfo.toLocal8Bit());
-    buffer.write(preFileBuffer.data());
-    buffer.close();
-
-    if (output->write(logFileName, QIODevice::ReadWrite | QIODevice::Append | QIODevice::Text, buffer.data())) {
-        preFileBuffer.close();
-        stream.setDevice(nullptr);
+    d->stop();
+    if (d->copyTo(d->m_logFileName, output))
         return true;
-    }
+
+    d->restart();
     return false;
 }
 
 void QInstaller::VerboseWriter::setFileName(const QString &fileName)
 {
-    logFileName = fileName;
+    d->m_logFileName = fileName;
 }
 
 
@@ -267,7 +444,7 @@ QInstaller::VerboseWriter *QInstaller::VerboseWriter::instance()
 
 void QInstaller::VerboseWriter::appendLine(const QString &msg)
 {
-    stream << msg << endl;
+    d->append(msg);
 }
 
 QInstaller::VerboseWriterOutput::~VerboseWriterOutput()
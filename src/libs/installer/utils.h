@@ -82,8 +82,11 @@ namespace QInstaller {
         virtual bool write(const QString &fileName, QIODevice::OpenMode openMode, const QByteArray &data);
     };
 
+    class VerboseWriterPrivate;
     class INSTALLER_EXPORT VerboseWriter
     {
+        Q_DISABLE_COPY(VerboseWriter)
+
     public:
         VerboseWriter();
         ~VerboseWriter();
@@ -96,10 +99,7 @@ namespace QInstaller {
         void setFileName(const QString &fileName);
 
     private:
-        QTextStream stream;
-        QBuffer preFileBuffer;
-        QString logFileName;
-        QString currentDateTimeAsString;
+        VerboseWriterPrivate *const d;
     };
 
 }
@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "downloadsegments.h"
+
+/*!
+    \inmodule kdupdater
+    \class KDUpdater::DownloadSegments
+    \brief The DownloadSegments class plans the byte ranges of a file that is downloaded in
+        segments and keeps track of what was received of them.
+
+    The first segment of the file is requested on its own. Once its answer tells the size of the
+    whole file, plan() divides the rest into segments that are handed out by takeNextSegment() in
+    file order. Segments are dropped by takeContiguousEnd() once they and all segments before them
+    are complete, so that the data can be hashed in file order even if the segments complete in
+    any order.
+*/
+
+/*!
+    Creates an empty plan.
+*/
+KDUpdater::DownloadSegments::DownloadSegments()
+    : m_totalSize(0)
+    , m_firstSegmentEnd(0)
+    , m_segmentSize(0)
+    , m_nextSegmentBegin(0)
+{
+}
+
+/*!
+    Parses the value \a header of a \c Content-Range header of the form
+    \c {bytes <first>-<last>/<total>} into \a first, \a last, and \a total. Returns \c false if
+    the header is malformed, the range is empty, or it does not fit into the file.
+*/
+bool KDUpdater::DownloadSegments::parseContentRange(const QByteArray &header, qint64 *first,
+    qint64 *last, qint64 *total)
+{
+    const QByteArray range = header.trimmed();
+    const int dash = range.indexOf('-');
+    const int slash = range.indexOf('/');
+    if (!range.startsWith("bytes ") || dash < 0 || slash < dash)
+        return false;
+
+    bool ok = false;
+    const qint64 begin = range.mid(6, dash - 6).trimmed().toLongLong(&ok);
+    if (!ok || begin < 0)
+        return false;
+    const qint64 end = range.mid(dash + 1, slash - dash - 1).toLongLong(&ok);
+    if (!ok || end < begin)
+        return false;
+    const qint64 size = range.mid(slash + 1).toLongLong(&ok);
+    if (!ok || size <= end)
+        return false;
+
+    *first = begin;
+    *last = end;
+    *total = size;
+    return true;
+}
+
+/*!
+    Plans the segments following the first one, which ends at \a firstSegmentEnd, of a file of
+    \a totalSize bytes that is downloaded over \a connections connections. Segments are not
+    smaller than \a minimumSegmentSize.
+*/
+void KDUpdater::DownloadSegments::plan(qint64 firstSegmentEnd, qint64 totalSize, int connections,
+    qint64 minimumSegmentSize)
+{
+    m_segments.clear();
+    m_totalSize = totalSize;
+    m_firstSegmentEnd = firstSegmentEnd;
+    m_nextSegmentBegin = firstSegmentEnd;
+    // a few segments per connection, so that a faster connection takes over more of the file
+    m_segmentSize = qMax(qMax(minimumSegmentSize, qint64(1)),
+        (totalSize - firstSegmentEnd) / (qMax(connections, 1) * 4));
+}
+
+/*!
+    Forgets the plan and all segments. The replies of the segments are not touched.
+*/
+void KDUpdater::DownloadSegments::clear()
+{
+    *this = DownloadSegments();
+}
+
+/*!
+    Returns the index of the segment fetched by \a reply, or \c -1 if there is none.
+*/
+int KDUpdater::DownloadSegments::indexOf(QNetworkReply *reply) const
+{
+    for (int i = 0; reply && i < m_segments.count(); ++i) {
+        if (m_segments.at(i).reply == reply)
+            return i;
+    }
+    return -1;
+}
+
+/*!
+    Returns the number of segments that are being fetched.
+*/
+int KDUpdater::DownloadSegments::activeCount() const
+{
+    int active = 0;
+    foreach (const Segment &segment, m_segments) {
+        if (segment.reply)
+            ++active;
+    }
+    return active;
+}
+
+/*!
+    Appends the next segment of the file, to be fetched from \a url, and returns its index. Must
+    only be called if hasNextSegment() returns \c true.
+*/
+int KDUpdater::DownloadSegments::takeNextSegment(const QUrl &url)
+{
+    Segment segment;
+    segment.reply = 0;
+    segment.url = url;
+    segment.begin = m_nextSegmentBegin;
+    segment.end = qMin(m_totalSize, segment.begin + m_segmentSize);
+    segment.received = 0;
+    segment.validated = false;
+    m_nextSegmentBegin = segment.end;
+    m_segments.append(segment);
+    return m_segments.count() - 1;
+}
+
+/*!
+    Returns whether the \c Content-Range header \a header names exactly the part of the segment
+    at \a index that was not received yet, of a file of the planned size.
+*/
+bool KDUpdater::DownloadSegments::matchesContentRange(int index, const QByteArray &header) const
+{
+    qint64 first = -1, last = -1, total = -1;
+    if (!parseContentRange(header, &first, &last, &total))
+        return false;
+    const Segment &segment = m_segments.at(index);
+    return first == segment.begin + segment.received && last == segment.end - 1
+        && total == m_totalSize;
+}
+
+/*!
+    Drops the complete segments at the beginning of the file and returns the end of the data
+    received without gaps after the first segment.
+*/
+qint64 KDUpdater::DownloadSegments::takeContiguousEnd()
+{
+    while (!m_segments.isEmpty() && m_segments.first().isComplete())
+        m_segments.removeFirst();
+    if (m_segments.isEmpty())
+        return m_nextSegmentBegin;
+    return m_segments.first().begin + m_segments.first().received;
+}
+
+/*!
+    Returns the number of bytes received for all segments but the first.
+*/
+qint64 KDUpdater::DownloadSegments::receivedSize() const
+{
+    // segments no longer in the list are complete
+    qint64 received = (m_segments.isEmpty() ? m_nextSegmentBegin : m_segments.first().begin)
+        - m_firstSegmentEnd;
+    foreach (const Segment &segment, m_segments)
+        received += segment.received;
+    return received;
+}
+
+/*!
+    Returns whether all segments of the file were received and dropped by takeContiguousEnd().
+*/
+bool KDUpdater::DownloadSegments::isComplete() const
+{
+    return m_segments.isEmpty() && m_nextSegmentBegin >= m_totalSize;
+}
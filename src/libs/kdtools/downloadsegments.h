@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef DOWNLOADSEGMENTS_H
+#define DOWNLOADSEGMENTS_H
+
+#include "kdtoolsglobal.h"
+
+#include <QtCore/QList>
+#include <QtCore/QUrl>
+
+QT_BEGIN_NAMESPACE
+class QNetworkReply;
+QT_END_NAMESPACE
+
+namespace KDUpdater {
+
+class KDTOOLS_EXPORT DownloadSegments
+{
+public:
+    // A byte range of a file downloaded in segments, fetched by its own reply.
+    struct Segment
+    {
+        QNetworkReply *reply;
+        QUrl url;
+        qint64 begin;
+        qint64 end;
+        qint64 received;
+        bool validated;
+
+        bool isComplete() const { return !reply && received >= end - begin; }
+    };
+
+    DownloadSegments();
+
+    static bool parseContentRange(const QByteArray &header, qint64 *first, qint64 *last,
+        qint64 *total);
+
+    void plan(qint64 firstSegmentEnd, qint64 totalSize, int connections,
+        qint64 minimumSegmentSize);
+    void clear();
+
+    qint64 totalSize() const { return m_totalSize; }
+    qint64 firstSegmentEnd() const { return m_firstSegmentEnd; }
+    qint64 segmentSize() const { return m_segmentSize; }
+    qint64 nextSegmentBegin() const { return m_nextSegmentBegin; }
+
+    int count() const { return m_segments.count(); }
+    Segment &at(int index) { return m_segments[index]; }
+    const Segment &at(int index) const { return m_segments.at(index); }
+    int indexOf(QNetworkReply *reply) const;
+    int activeCount() const;
+
+    bool hasNextSegment() const { return m_nextSegmentBegin < m_totalSize; }
+    int takeNextSegment(const QUrl &url);
+
+    bool matchesContentRange(int index, const QByteArray &header) const;
+    qint64 takeContiguousEnd();
+    qint64 receivedSize() const;
+    bool isComplete() const;
+
+private:
+    qint64 m_totalSize;
+    qint64 m_firstSegmentEnd;
+    qint64 m_segmentSize;
+    qint64 m_nextSegmentBegin;
+    QList<Segment> m_segments;
+};
+
+} // namespace KDUpdater
+
+#endif // DOWNLOADSEGMENTS_H
@@ -26,6 +26,7 @@
 **
 ****************************************************************************/
 
+#include "downloadsegments.h"
 #include "filedownloader_p.h"
 #include "filedownloaderfactory.h"
 #include "ui_authenticationdialog.h"
@@ -203,6 +204,9 @@ struct KDUpdater::FileDownloader::Private
         , m_downloadSpeed(0)
         , m_factory(0)
         , m_ignoreSslErrors(false)
+        , m_maximumInMemorySize(0)
+        , m_segmentCount(1)
+        , m_minimumSegmentSize(0)
     {
         memset(m_samples, 0, sizeof(m_samples));
     }
@@ -243,6 +247,11 @@ struct KDUpdater::FileDownloader::Private
     QAuthenticator m_authenticator;
     FileDownloaderProxyFactory *m_factory;
     bool m_ignoreSslErrors;
+    QPointer<QNetworkAccessManager> m_networkAccessManager;
+    qint64 m_maximumInMemorySize;
+    int m_segmentCount;
+    qint64 m_minimumSegmentSize;
+    QList<QUrl> m_mirrorUrls;
 };
 
 /*!
@@ -730,6 +739,122 @@ void KDUpdater::FileDownloader::setIgnoreSslErrors(bool ignore)
     d->m_ignoreSslErrors = ignore;
 }
 
+/*!
+    Returns the network access manager shared with other downloaders, or \c 0 if the downloader
+    uses its own one.
+*/
+QNetworkAccessManager *KDUpdater::FileDownloader::networkAccessManager() const
+{
+    return d->m_networkAccessManager;
+}
+
+/*!
+    Sets \a manager as the network access manager to be used for network requests. This allows
+    several downloaders running at the same time to share connections and the cache. The manager
+    is not owned by the downloader. Has no effect on downloaders that do not use the network.
+*/
+void KDUpdater::FileDownloader::setNetworkAccessManager(QNetworkAccessManager *manager)
+{
+    d->m_networkAccessManager = manager;
+}
+
+/*!
+    Returns the maximum size of a download that is kept in memory instead of being written to
+    disk. The default value \c 0 means all downloads are written to disk.
+*/
+qint64 KDUpdater::FileDownloader::maximumInMemorySize() const
+{
+    return d->m_maximumInMemorySize;
+}
+
+/*!
+    Sets the maximum size of a download that is kept in memory to \a size. Downloads exceeding
+    \a size are written to the downloaded file name instead. Only supported by downloaders
+    fetching files over the network.
+
+    \sa isDownloadedInMemory(), downloadedData()
+*/
+void KDUpdater::FileDownloader::setMaximumInMemorySize(qint64 size)
+{
+    d->m_maximumInMemorySize = size;
+}
+
+/*!
+    Returns the maximum number of connections a file is downloaded over at the same time. The
+    default value \c 1 downloads each file over a single connection.
+*/
+int KDUpdater::FileDownloader::segmentCount() const
+{
+    return d->m_segmentCount;
+}
+
+/*!
+    Sets the maximum number of connections a file is downloaded over at the same time to \a count.
+    If the server supports range requests and the file is larger than minimumSegmentSize(), the
+    file is split into segments that are fetched in parallel, from url() as well as from the
+    mirrorUrls(). Only supported by downloaders fetching files over the network.
+*/
+void KDUpdater::FileDownloader::setSegmentCount(int count)
+{
+    d->m_segmentCount = qMax(1, count);
+}
+
+/*!
+    Returns the minimum size of a segment of a file that is downloaded over several connections.
+*/
+qint64 KDUpdater::FileDownloader::minimumSegmentSize() const
+{
+    return d->m_minimumSegmentSize;
+}
+
+/*!
+    Sets the minimum size of a segment of a file that is downloaded over several connections to
+    \a size. Files not larger than \a size are downloaded over a single connection.
+
+    \sa setSegmentCount()
+*/
+void KDUpdater::FileDownloader::setMinimumSegmentSize(qint64 size)
+{
+    d->m_minimumSegmentSize = qMax<qint64>(0, size);
+}
+
+/*!
+    Returns the URLs of mirrors serving the same file as url().
+*/
+QList<QUrl> KDUpdater::FileDownloader::mirrorUrls() const
+{
+    return d->m_mirrorUrls;
+}
+
+/*!
+    Sets the URLs of mirrors serving the same file as url() to \a urls. When a file is downloaded
+    in segments, some of them are fetched from the mirrors. A segment a mirror fails to deliver is
+    fetched from url() instead.
+
+    \sa setSegmentCount()
+*/
+void KDUpdater::FileDownloader::setMirrorUrls(const QList<QUrl> &urls)
+{
+    d->m_mirrorUrls = urls;
+}
+
+/*!
+    Returns \c true if the downloaded file was kept in memory and not written to disk.
+*/
+bool KDUpdater::FileDownloader::isDownloadedInMemory() const
+{
+    return false;
+}
+
+/*!
+    Returns the downloaded data if isDownloadedInMemory() returns \c true; otherwise returns an
+    empty byte array.
+*/
+QByteArray KDUpdater::FileDownloader::downloadedData() const
+{
+    return QByteArray();
+}
+
 // -- KDUpdater::LocalFileDownloader
 
 /*!
@@ -1162,7 +1287,14 @@ struct KDUpdater::HttpDownloader::Private
         , destination(0)
         , downloaded(false)
         , aborted(false)
+        , inMemory(false)
         , m_authenticationCount(0)
+        , probing(false)
+        , rangesUnsupported(false)
+        , segmented(false)
+        , firstSegmentDone(false)
+        , hashedSize(0)
+        , nextSource(0)
     {}
 
     HttpDownloader *const q;
@@ -1171,12 +1303,62 @@ struct KDUpdater::HttpDownloader::Private
     QUrl sourceUrl;
     QFile *destination;
     QString destFileName;
+    QByteArray data;
     bool downloaded;
     bool aborted;
+    bool inMemory;
     int m_authenticationCount;
 
+    // The first segment of a segmented download is fetched by http and written to destination
+    // like any other download, the others are written to segmentFile at their offsets.
+    bool probing;
+    bool rangesUnsupported;
+    bool segmented;
+    bool firstSegmentDone;
+    qint64 hashedSize;
+    DownloadSegments segments;
+    QList<QUrl> segmentSources;
+    int nextSource;
+    QFile segmentFile;
+
+    bool ownsReply(QNetworkReply *reply) const
+    {
+        return reply && (reply == http || segments.indexOf(reply) >= 0);
+    }
+
+    void abortSegments()
+    {
+        for (int i = 0; i < segments.count(); ++i) {
+            if (QNetworkReply *const reply = segments.at(i).reply) {
+                reply->disconnect(q);
+                reply->abort();
+                reply->deleteLater();
+                segments.at(i).reply = 0;
+            }
+        }
+    }
+
+    void resetSegments()
+    {
+        abortSegments();
+        segments.clear();
+        segmentSources.clear();
+        segmentFile.close();
+        probing = false;
+        segmented = false;
+        firstSegmentDone = false;
+    }
+
+    QNetworkAccessManager *networkAccessManager()
+    {
+        if (QNetworkAccessManager *shared = q->networkAccessManager())
+            return shared;
+        return &manager;
+    }
+
     void shutDown(bool closeDestination = true)
     {
+        abortSegments();
         if (http) {
             disconnect(http, &QNetworkReply::finished, q, &HttpDownloader::httpReqFinished);
             disconnect(http, &QNetworkReply::downloadProgress,
@@ -1188,10 +1370,15 @@ struct KDUpdater::HttpDownloader::Private
         }
         http = 0;
         if (closeDestination) {
-            destination->close();
-            destination->deleteLater();
-            destination = 0;
+            if (destination) {
+                destination->close();
+                destination->deleteLater();
+                destination = 0;
+            }
+            data.clear();
+            inMemory = false;
             q->resetCheckSumData();
+            resetSegments();
         }
     }
 };
@@ -1265,6 +1452,22 @@ QString KDUpdater::HttpDownloader::downloadedFileName() const
     return d->destFileName;
 }
 
+/*!
+    Returns \c true if the downloaded file was kept in memory.
+*/
+bool KDUpdater::HttpDownloader::isDownloadedInMemory() const
+{
+    return d->downloaded && d->inMemory;
+}
+
+/*!
+    Returns the downloaded data if the file was kept in memory.
+*/
+QByteArray KDUpdater::HttpDownloader::downloadedData() const
+{
+    return isDownloadedInMemory() ? d->data : QByteArray();
+}
+
 /*!
     Sets the file name of the downloaded file to \a name.
 */
@@ -1284,11 +1487,44 @@ KDUpdater::HttpDownloader *KDUpdater::HttpDownloader::clone(QObject *parent) con
 
 void KDUpdater::HttpDownloader::httpReadyRead()
 {
-    if (d->http == 0 || d->destination == 0)
+    if (d->http == 0 || (d->destination == 0 && !d->inMemory))
       return;
+    if (d->probing) {
+        const QUrl redirectUrl = d->http->attribute(QNetworkRequest::RedirectionTargetAttribute)
+            .toUrl();
+        if (!followRedirects() || !redirectUrl.isValid()) {
+            d->probing = false;
+            if (!beginSegmentedDownload())
+                return;
+        }
+    }
     static QByteArray buffer(16384, '\0');
     while (d->http->bytesAvailable()) {
         const qint64 read = d->http->read(buffer.data(), buffer.size());
+        if (d->inMemory) {
+            const qint64 announced = d->http->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+            if (qMax(announced, d->data.size() + read) > maximumInMemorySize()) {
+                // too big to be kept in memory, spill what we have to the file and go on there
+                if (!openDestination(d->sourceUrl))
+                    return;
+                if (d->destination->write(d->data) != d->data.size()) {
+                    const QString error = d->destination->errorString();
+                    const QString fileName = d->destination->fileName();
+                    d->shutDown();
+                    setDownloadAborted(tr("Cannot download %1. Writing to file \"%2\" failed: %3")
+                        .arg(url().toString(), fileName, error));
+                    return;
+                }
+                d->data.clear();
+                d->inMemory = false;
+            } else {
+                d->data.append(buffer.constData(), read);
+                addSample(read);
+                addCheckSumData(buffer.data(), read);
+                updateBytesDownloadedBeforeResume(read);
+                continue;
+            }
+        }
         qint64 written = 0;
         while (written < read) {
             const qint64 numWritten = d->destination->write(buffer.data() + written, read - written);
@@ -1323,6 +1559,11 @@ void KDUpdater::HttpDownloader::cancelDownload()
     if (d->http) {
         d->http->abort();
         httpDone(true);
+    } else if (d->segmented) {
+        d->shutDown();
+        onError();
+        d->aborted = false;
+        setDownloadCanceled();
     }
 }
 
@@ -1360,8 +1601,11 @@ void KDUpdater::HttpDownloader::onError()
 {
     d->downloaded = false;
     d->destFileName.clear();
+    d->data.clear();
+    d->inMemory = false;
     delete d->destination;
     d->destination = 0;
+    d->resetSegments();
     stopDownloadSpeedTimer();
     stopDownloadDeadlineTimer();
 }
@@ -1380,6 +1624,7 @@ void KDUpdater::HttpDownloader::onSuccess()
     }
     delete d->destination;
     d->destination = 0;
+    d->resetSegments();
     stopDownloadSpeedTimer();
     stopDownloadDeadlineTimer();
     setDownloadResumed(false);
@@ -1413,6 +1658,24 @@ void KDUpdater::HttpDownloader::httpReqFinished()
         httpReadyRead();
         if (d->destination)
             d->destination->flush();
+        if (d->segmented) {
+            // the first segment is complete, the others might still be on their way
+            d->http->deleteLater();
+            d->http = 0;
+            if (bytesDownloadedBeforeResume() != d->segments.firstSegmentEnd()) {
+                d->shutDown();
+                setDownloadAborted(tr("Cannot download %1: %2").arg(url().toString(),
+                    tr("The connection was closed before all data was received.")));
+                return;
+            }
+            d->firstSegmentDone = true;
+            d->hashedSize = d->segments.firstSegmentEnd();
+            if (hashSegments()) {
+                startNextSegments();
+                finishSegmentedDownload();
+            }
+            return;
+        }
         setDownloadCompleted();
         if (d->http)
             d->http->deleteLater();
@@ -1422,6 +1685,10 @@ void KDUpdater::HttpDownloader::httpReqFinished()
 
 void KDUpdater::HttpDownloader::httpReadProgress(qint64 done, qint64 total)
 {
+    if (d->segmented) {
+        updateSegmentedProgress();
+        return;
+    }
     if (d->http) {
         const QUrl redirectUrl = d->http->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
         if (followRedirects() && redirectUrl.isValid())
@@ -1456,13 +1723,41 @@ void KDUpdater::HttpDownloader::timerEvent(QTimerEvent *event)
     }
 }
 
+void KDUpdater::HttpDownloader::connectSharedManager()
+{
+    QNetworkAccessManager *const shared = networkAccessManager();
+    if (!shared)
+        return;
+
+    // The signals of a shared manager are emitted for the replies of all downloaders using it,
+    // the slots check that the reply belongs to this downloader.
+#ifndef QT_NO_SSL
+    connect(shared, &QNetworkAccessManager::sslErrors,
+            this, &HttpDownloader::onSslErrors, Qt::UniqueConnection);
+#endif
+    connect(shared, &QNetworkAccessManager::authenticationRequired,
+            this, &HttpDownloader::onAuthenticationRequired, Qt::UniqueConnection);
+    connect(shared, &QNetworkAccessManager::networkAccessibleChanged,
+            this, &HttpDownloader::onNetworkAccessibleChanged, Qt::UniqueConnection);
+}
+
 void KDUpdater::HttpDownloader::startDownload(const QUrl &url)
 {
     d->sourceUrl = url;
     d->m_authenticationCount = 0;
-    d->manager.setProxyFactory(proxyFactory());
+    QNetworkAccessManager *const manager = d->networkAccessManager();
+    // a shared manager gets its proxy factory set once by its owner
+    if (manager == &d->manager || !manager->proxyFactory())
+        manager->setProxyFactory(proxyFactory());
+    connectSharedManager();
     clearBytesDownloadedBeforeResume();
-    d->http = d->manager.get(QNetworkRequest(url));
+    QNetworkRequest request(url);
+    // If the file may be downloaded in segments, ask for the first one only. A server supporting
+    // range requests tells the size of the whole file in its answer.
+    d->probing = segmentCount() > 1 && minimumSegmentSize() > 0 && !d->rangesUnsupported;
+    if (d->probing)
+        request.setRawHeader("Range", "bytes=0-" + QByteArray::number(minimumSegmentSize() - 1));
+    d->http = manager->get(request);
     connect(d->http, &QIODevice::readyRead, this, &HttpDownloader::httpReadyRead);
     connect(d->http, &QNetworkReply::downloadProgress,
             this, &HttpDownloader::httpReadProgress);
@@ -1470,6 +1765,15 @@ void KDUpdater::HttpDownloader::startDownload(const QUrl &url)
     void (QNetworkReply::*errorSignal)(QNetworkReply::NetworkError) = &QNetworkReply::error;
     connect(d->http, errorSignal, this, &HttpDownloader::httpError);
 
+    // keep the data in memory until it exceeds the limit, then write it to the file
+    d->data.clear();
+    d->inMemory = maximumInMemorySize() > 0;
+    if (!d->inMemory)
+        openDestination(url);
+}
+
+bool KDUpdater::HttpDownloader::openDestination(const QUrl &url)
+{
     if (d->destFileName.isEmpty()) {
         QTemporaryFile *file = new QTemporaryFile(this);
         file->open();
@@ -1485,21 +1789,40 @@ void KDUpdater::HttpDownloader::startDownload(const QUrl &url)
         d->shutDown();
         setDownloadAborted(tr("Cannot download %1. Cannot create file \"%2\": %3").arg(
             url.toString(), fileName, error));
+        return false;
     }
+    return true;
 }
 
 void KDUpdater::HttpDownloader::resumeDownload()
 {
+    if (d->segmented) {
+        for (int i = 0; i < d->segments.count(); ++i) {
+            const DownloadSegments::Segment &segment = d->segments.at(i);
+            if (!segment.reply && segment.received < segment.end - segment.begin)
+                startSegment(i);
+        }
+        if (d->firstSegmentDone) {
+            runDownloadSpeedTimer();
+            runDownloadDeadlineTimer();
+            return;
+        }
+    }
+
     updateTotalBytesDownloadedBeforeResume();
     d->m_authenticationCount = 0;
     QNetworkRequest request(d->sourceUrl);
 
+    // the first segment of a segmented download must not run into the ones after it
     request.setRawHeader(QByteArray("Range"),
-                         QString(QStringLiteral("bytes=%1-"))
+                         QString(QStringLiteral("bytes=%1-%2"))
                          .arg(bytesDownloadedBeforeResume())
+                         .arg(d->segmented ? QString::number(d->segments.firstSegmentEnd() - 1)
+                                           : QString())
                          .toLatin1());
     setDownloadResumed(true);
-    d->http = d->manager.get(request);
+    connectSharedManager();
+    d->http = d->networkAccessManager()->get(request);
     connect(d->http, &QIODevice::readyRead, this, &HttpDownloader::httpReadyRead);
     connect(d->http, &QNetworkReply::downloadProgress,
             this, &HttpDownloader::httpReadProgress);
@@ -1512,7 +1835,9 @@ void KDUpdater::HttpDownloader::resumeDownload()
 
 void KDUpdater::HttpDownloader::onAuthenticationRequired(QNetworkReply *reply, QAuthenticator *authenticator)
 {
-    Q_UNUSED(reply)
+    if (!d->ownsReply(reply))
+        return;
+
     // first try with the information we have already
     if (d->m_authenticationCount == 0) {
         d->m_authenticationCount++;
@@ -1549,6 +1874,9 @@ void KDUpdater::HttpDownloader::onAuthenticationRequired(QNetworkReply *reply, Q
 
 void KDUpdater::HttpDownloader::onNetworkAccessibleChanged(QNetworkAccessManager::NetworkAccessibility accessible)
 {
+  // a shared manager reports the change to downloaders that are idle as well
+  if (!d->http && !d->segmented && !isDownloadPaused())
+      return;
   if (accessible == QNetworkAccessManager::NotAccessible) {
       d->shutDown(false);
       setDownloadPaused(true);
@@ -1562,13 +1890,259 @@ void KDUpdater::HttpDownloader::onNetworkAccessibleChanged(QNetworkAccessManager
   }
 }
 
+/*!
+    Checks the answer to the request for the first segment. If the server sent a part of a larger
+    file, the destination is resized to the whole file and the remaining segments are requested.
+    Returns \c false if the download was restarted or aborted.
+*/
+bool KDUpdater::HttpDownloader::beginSegmentedDownload()
+{
+    if (d->http->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206)
+        return true;    // the server ignored the range and sends the whole file
+
+    qint64 first = -1, last = -1, total = -1;
+    if (!DownloadSegments::parseContentRange(d->http->rawHeader("Content-Range"), &first, &last,
+        &total) || first != 0) {
+        // we cannot tell which part of the file we got, ask for all of it instead
+        d->rangesUnsupported = true;
+        const QUrl url = d->sourceUrl;
+        d->shutDown();
+        startDownload(url);
+        return false;
+    }
+    if (total == last + 1)
+        return true;    // the file fits into the first segment
+
+    if (d->inMemory) {
+        // the segments are written at their offsets, so a file is needed right from the start
+        d->inMemory = false;
+        if (!openDestination(d->sourceUrl))
+            return false;
+    }
+
+    // allocate the whole file, the segments are written into it as they arrive
+    d->segmentFile.setFileName(d->destination->fileName());
+    if (!d->destination->resize(total)
+        || !d->segmentFile.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+            const QString error = d->destination->error() != QFileDevice::NoError
+                ? d->destination->errorString() : d->segmentFile.errorString();
+            const QString fileName = d->destination->fileName();
+            d->shutDown();
+            setDownloadAborted(tr("Cannot download %1. Writing to file \"%2\" failed: %3")
+                .arg(url().toString(), fileName, error));
+            return false;
+    }
+
+    d->segmented = true;
+    d->segments.plan(last + 1, total, segmentCount(), minimumSegmentSize());
+    d->hashedSize = 0;
+
+    d->segmentSources = QList<QUrl>() << d->sourceUrl;
+    foreach (const QUrl &mirror, mirrorUrls()) {
+        if (mirror.isValid() && !d->segmentSources.contains(mirror))
+            d->segmentSources.append(mirror);
+    }
+    d->nextSource = d->segmentSources.count() > 1 ? 1 : 0;
+
+    startNextSegments();
+    return true;
+}
+
+/*!
+    Requests further segments until segmentCount() connections are busy or the whole file is
+    requested.
+*/
+void KDUpdater::HttpDownloader::startNextSegments()
+{
+    int active = d->segments.activeCount() + (d->firstSegmentDone ? 0 : 1);
+    while (active < segmentCount() && d->segments.hasNextSegment()) {
+        const QUrl source = d->segmentSources.at(d->nextSource++ % d->segmentSources.count());
+        startSegment(d->segments.takeNextSegment(source));
+        ++active;
+    }
+}
+
+/*!
+    Requests the part of the segment at \a index that has not been received yet.
+*/
+void KDUpdater::HttpDownloader::startSegment(int index)
+{
+    DownloadSegments::Segment &segment = d->segments.at(index);
+    QNetworkRequest request(segment.url);
+    request.setRawHeader("Range", "bytes=" + QByteArray::number(segment.begin + segment.received)
+        + '-' + QByteArray::number(segment.end - 1));
+    segment.validated = false;
+
+    QNetworkReply *const reply = d->networkAccessManager()->get(request);
+    segment.reply = reply;
+    connect(reply, &QIODevice::readyRead, this, [this, reply]() { segmentReadyRead(reply); });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { segmentFinished(reply); });
+}
+
+/*!
+    Writes the data available from the segment \a reply to its place in the file.
+*/
+void KDUpdater::HttpDownloader::segmentReadyRead(QNetworkReply *reply)
+{
+    const int index = d->segments.indexOf(reply);
+    if (index < 0)
+        return;
+
+    DownloadSegments::Segment &segment = d->segments.at(index);
+    if (!segment.validated) {
+        // the server must send exactly the requested range of the very same file
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206
+            || !d->segments.matchesContentRange(index, reply->rawHeader("Content-Range"))) {
+                segmentFailed(index, reply->error() != QNetworkReply::NoError ? reply->errorString()
+                    : tr("The server did not send the requested part of the file."));
+                return;
+        }
+        segment.validated = true;
+    }
+
+    static QByteArray buffer(16384, '\0');
+    while (reply->bytesAvailable()) {
+        const qint64 read = reply->read(buffer.data(), buffer.size());
+        if (read <= 0)
+            break;
+        if (segment.received + read > segment.end - segment.begin) {
+            segmentFailed(index, tr("The server sent more data than requested."));
+            return;
+        }
+        if (!d->segmentFile.seek(segment.begin + segment.received)
+            || d->segmentFile.write(buffer.constData(), read) != read) {
+                const QString error = d->segmentFile.errorString();
+                const QString fileName = d->segmentFile.fileName();
+                d->shutDown();
+                setDownloadAborted(tr("Cannot download %1. Writing to file \"%2\" failed: %3")
+                    .arg(url().toString(), fileName, error));
+                return;
+        }
+        segment.received += read;
+        addSample(read);
+    }
+
+    if (hashSegments())
+        updateSegmentedProgress();
+}
+
+/*!
+    Handles the end of the segment \a reply and requests the next segment.
+*/
+void KDUpdater::HttpDownloader::segmentFinished(QNetworkReply *reply)
+{
+    segmentReadyRead(reply);
+    const int index = d->segments.indexOf(reply);
+    if (index < 0)
+        return;     // already failed over, or the download was aborted
+
+    DownloadSegments::Segment &segment = d->segments.at(index);
+    if (segment.received < segment.end - segment.begin) {
+        segmentFailed(index, reply->error() != QNetworkReply::NoError ? reply->errorString()
+            : tr("The connection was closed before all data was received."));
+        return;
+    }
+    segment.reply = 0;
+    reply->disconnect(this);
+    reply->deleteLater();
+
+    if (!hashSegments())
+        return;
+    startNextSegments();
+    finishSegmentedDownload();
+}
+
+/*!
+    Drops the reply of the segment at \a index. A segment fetched from a mirror is requested from
+    the source URL again and the mirror is not used anymore; otherwise the download is aborted
+    with \a error.
+*/
+void KDUpdater::HttpDownloader::segmentFailed(int index, const QString &error)
+{
+    DownloadSegments::Segment &segment = d->segments.at(index);
+    if (QNetworkReply *const reply = segment.reply) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+        segment.reply = 0;
+    }
+
+    if (segment.url != d->sourceUrl) {
+        qCDebug(QInstaller::lcNetwork) << "Cannot download part of" << url().toString() << "from"
+            << segment.url.toString() << "-" << error << "- falling back to the source.";
+        d->segmentSources.removeAll(segment.url);
+        segment.url = d->sourceUrl;
+        startSegment(index);
+        return;
+    }
+
+    d->shutDown();
+    setDownloadAborted(tr("Cannot download %1: %2").arg(url().toString(), error));
+}
+
+/*!
+    Adds the data received in file order since the last call to the checksum. Returns \c false if
+    the file could not be read back and the download was aborted.
+*/
+bool KDUpdater::HttpDownloader::hashSegments()
+{
+    // the first segment is hashed while it is received
+    if (!d->firstSegmentDone)
+        return true;
+
+    static QByteArray buffer(16384, '\0');
+    const qint64 available = d->segments.takeContiguousEnd();
+    while (d->hashedSize < available) {
+        const qint64 size = qMin(qint64(buffer.size()), available - d->hashedSize);
+        if (!d->segmentFile.seek(d->hashedSize)
+            || d->segmentFile.read(buffer.data(), size) != size) {
+                const QString error = d->segmentFile.errorString();
+                const QString fileName = d->segmentFile.fileName();
+                d->shutDown();
+                setDownloadAborted(tr("Cannot download %1. Reading from file \"%2\" failed: %3")
+                    .arg(url().toString(), fileName, error));
+                return false;
+        }
+        addCheckSumData(buffer.constData(), int(size));
+        d->hashedSize += size;
+    }
+    return true;
+}
+
+/*!
+    Reports the progress of all segments of the download together.
+*/
+void KDUpdater::HttpDownloader::updateSegmentedProgress()
+{
+    const qint64 received = qMin(bytesDownloadedBeforeResume(), d->segments.firstSegmentEnd())
+        + d->segments.receivedSize();
+    setProgress(received, d->segments.totalSize());
+    runDownloadDeadlineTimer();
+    emit downloadProgress(calcProgress(received, d->segments.totalSize()));
+}
+
+/*!
+    Completes the download once all segments were received and hashed.
+*/
+void KDUpdater::HttpDownloader::finishSegmentedDownload()
+{
+    if (!d->firstSegmentDone || !d->segments.isComplete())
+        return;
+
+    d->segmentFile.close();
+    setDownloadCompleted();
+}
+
 #ifndef QT_NO_SSL
 
 #include "messageboxhandler.h"
 
 void KDUpdater::HttpDownloader::onSslErrors(QNetworkReply* reply, const QList<QSslError> &errors)
 {
-    Q_UNUSED(reply)
+    const int segment = d->segments.indexOf(reply);
+    if (reply != d->http && segment < 0)
+        return;
+
     QString errorString;
     foreach (const QSslError &error, errors) {
         if (!errorString.isEmpty())
@@ -1583,6 +2157,15 @@ void KDUpdater::HttpDownloader::onSslErrors(QNetworkReply* reply, const QList<QS
             reply->ignoreSslErrors();
             return;
     }
+
+    // do not ask again for a segment, fetch it from the server the user already agreed to
+    if (segment >= 0) {
+        if (FileDownloaderFactory::ignoreSslErrors())
+            reply->ignoreSslErrors();
+        else
+            segmentFailed(segment, errorString);
+        return;
+    }
     // TODO: Remove above code once we have a proper implementation for message box handler supporting
     // methods used in the following code, right now we return here cause the message box is not scriptable.
 
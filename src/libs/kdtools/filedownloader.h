@@ -31,11 +31,14 @@
 
 #include "kdtoolsglobal.h"
 
+#include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
 
 #include <QtNetwork/QAuthenticator>
 
+QT_FORWARD_DECLARE_CLASS(QNetworkAccessManager)
+
 namespace KDUpdater {
 
 class FileDownloaderProxyFactory;
@@ -87,6 +90,21 @@ public:
     bool ignoreSslErrors();
     void setIgnoreSslErrors(bool ignore);
 
+    QNetworkAccessManager *networkAccessManager() const;
+    void setNetworkAccessManager(QNetworkAccessManager *manager);
+
+    qint64 maximumInMemorySize() const;
+    void setMaximumInMemorySize(qint64 size);
+    virtual bool isDownloadedInMemory() const;
+    virtual QByteArray downloadedData() const;
+
+    int segmentCount() const;
+    void setSegmentCount(int count);
+    qint64 minimumSegmentSize() const;
+    void setMinimumSegmentSize(qint64 size);
+    QList<QUrl> mirrorUrls() const;
+    void setMirrorUrls(const QList<QUrl> &urls);
+
 public Q_SLOTS:
     virtual void cancelDownload();
 
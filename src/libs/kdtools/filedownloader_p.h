@@ -112,6 +112,9 @@ public:
     void setDownloadedFileName(const QString &name);
     HttpDownloader *clone(QObject *parent = 0) const;
 
+    bool isDownloadedInMemory() const;
+    QByteArray downloadedData() const;
+
 public Q_SLOTS:
     void cancelDownload();
 
@@ -134,9 +137,21 @@ private Q_SLOTS:
     void onSslErrors(QNetworkReply* reply, const QList<QSslError> &errors);
 #endif
 private:
+    void connectSharedManager();
     void startDownload(const QUrl &url);
+    bool openDestination(const QUrl &url);
     void resumeDownload();
 
+    bool beginSegmentedDownload();
+    void startNextSegments();
+    void startSegment(int index);
+    void segmentReadyRead(QNetworkReply *reply);
+    void segmentFinished(QNetworkReply *reply);
+    void segmentFailed(int index, const QString &error);
+    bool hashSegments();
+    void updateSegmentedProgress();
+    void finishSegmentedDownload();
+
 private:
     struct Private;
     Private *d;
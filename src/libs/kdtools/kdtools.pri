@@ -22,6 +22,7 @@ SOURCES += $$PWD/job.cpp \
 HEADERS += $$PWD/updater.h \
     $$PWD/filedownloader.h \
     $$PWD/filedownloader_p.h \
+    $$PWD/downloadsegments.h \
     $$PWD/filedownloaderfactory.h \
     $$PWD/localpackagehub.h \
     $$PWD/update.h \
@@ -35,6 +36,7 @@ HEADERS += $$PWD/updater.h \
     $$PWD/updatesinfodata_p.h
 
 SOURCES += $$PWD/filedownloader.cpp \
+    $$PWD/downloadsegments.cpp \
     $$PWD/filedownloaderfactory.cpp \
     $$PWD/localpackagehub.cpp \
     $$PWD/update.cpp \
@@ -32,6 +32,7 @@
 #include "globals.h"
 #include "constants.h"
 
+#include <QDataStream>
 #include <QDomDocument>
 #include <QDomElement>
 #include <QFileInfo>
@@ -53,6 +54,11 @@ using namespace QInstaller;
         \li Get information about the number of packages installed and their meta-data via the
             packageInfoCount() and packageInfo() methods.
     \endlist
+
+    Changes can be saved in two ways. writeToDisk() rewrites the whole XML file, while
+    writeJournal() only appends the changes made since the last save to a journal file next to
+    it. The journal is replayed by refresh() and removed the next time the XML file is written,
+    so installing many packages does not require rewriting the XML file after each of them.
 */
 
 /*!
@@ -70,6 +76,48 @@ using namespace QInstaller;
                                             descriptions.
 */
 
+static const quint32 JournalMagic = 0x49465731; // "IFW1"
+
+enum struct JournalEntry : quint8
+{
+    ApplicationInfo = 1,
+    AddPackage,
+    RemovePackage,
+    ClearPackages
+};
+
+namespace KDUpdater {
+
+static QDataStream &operator<<(QDataStream &stream, const LocalPackage &info)
+{
+    stream << info.name << info.title << info.description << info.version
+        << info.inheritVersionFrom << info.dependencies << info.autoDependencies
+        << info.lastUpdateDate << info.installDate << info.forcedInstallation << info.virtualComp
+        << info.uncompressedSize << info.checkable << info.expandedByDefault;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, LocalPackage &info)
+{
+    stream >> info.name >> info.title >> info.description >> info.version
+        >> info.inheritVersionFrom >> info.dependencies >> info.autoDependencies
+        >> info.lastUpdateDate >> info.installDate >> info.forcedInstallation >> info.virtualComp
+        >> info.uncompressedSize >> info.checkable >> info.expandedByDefault;
+    return stream;
+}
+
+// Appends an entry of \a type carrying \a data to the serialized \a journal.
+static void appendJournalEntry(QByteArray *journal, JournalEntry type, const QByteArray &data)
+{
+    // Every entry is prefixed with its size, so that an entry which was only partially written
+    // can be recognized and ignored when the journal is replayed.
+    QDataStream stream(journal, QIODevice::WriteOnly | QIODevice::Append);
+    stream << qint32(sizeof(quint8) + data.size()) << static_cast<quint8>(type);
+    stream.writeRawData(data.constData(), data.size());
+}
+
+} // namespace KDUpdater
+
 struct LocalPackageHub::PackagesInfoData
 {
     PackagesInfoData() :
@@ -85,8 +133,16 @@ struct LocalPackageHub::PackagesInfoData
 
     QMap<QString, LocalPackage> m_packageInfoMap;
 
+    // journal entries not yet written by writeJournal()
+    QByteArray m_journal;
+
     void addPackageFrom(const QDomElement &packageE);
     void setInvalidContentError(const QString &detail);
+
+    QString journalFileName() const;
+    void appendJournalEntry(JournalEntry type, const QByteArray &data);
+    bool replayJournal();
+    void removeJournal();
 };
 
 void LocalPackageHub::PackagesInfoData::setInvalidContentError(const QString &detail)
@@ -95,6 +151,86 @@ void LocalPackageHub::PackagesInfoData::setInvalidContentError(const QString &de
     errorMessage = tr("%1 contains invalid content: %2").arg(fileName, detail);
 }
 
+QString LocalPackageHub::PackagesInfoData::journalFileName() const
+{
+    return fileName + QLatin1String(".journal");
+}
+
+void LocalPackageHub::PackagesInfoData::appendJournalEntry(JournalEntry type,
+    const QByteArray &data)
+{
+    KDUpdater::appendJournalEntry(&m_journal, type, data);
+}
+
+/*
+    Applies the entries of the journal file to the packages read from the XML file. Returns
+    \c true if a journal was found.
+*/
+bool LocalPackageHub::PackagesInfoData::replayJournal()
+{
+    QFile file(journalFileName());
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray journal = file.readAll();
+    file.close();
+
+    QDataStream stream(journal);
+    quint32 magic = 0;
+    stream >> magic;
+    if (magic != JournalMagic)
+        return false;
+
+    while (!stream.atEnd()) {
+        qint32 size = 0;
+        stream >> size;
+        if (stream.status() != QDataStream::Ok || size <= 0
+                || size > journal.size() - stream.device()->pos()) {
+            break; // the last entry was not written completely
+        }
+
+        QByteArray entry(size, Qt::Uninitialized);
+        stream.readRawData(entry.data(), size);
+
+        QDataStream entryStream(entry);
+        quint8 type;
+        entryStream >> type;
+        switch (static_cast<JournalEntry>(type)) {
+        case JournalEntry::ApplicationInfo:
+            entryStream >> applicationName >> applicationVersion;
+            break;
+        case JournalEntry::AddPackage: {
+            LocalPackage info;
+            entryStream >> info;
+            m_packageInfoMap.insert(info.name, info);
+        }   break;
+        case JournalEntry::RemovePackage: {
+            QString name;
+            entryStream >> name;
+            m_packageInfoMap.remove(name);
+        }   break;
+        case JournalEntry::ClearPackages:
+            m_packageInfoMap.clear();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // the replayed changes are only saved in the journal, make sure they end up in the XML file
+    modified = true;
+    return true;
+}
+
+void LocalPackageHub::PackagesInfoData::removeJournal()
+{
+    m_journal.clear();
+
+    QFile file(journalFileName());
+    if (file.exists())
+        file.remove();
+}
+
 /*!
     Constructs a local package hub. To fully setup the class you have to call setFileName().
 
@@ -229,7 +365,8 @@ QList<LocalPackage> LocalPackageHub::packageInfos() const
 }
 
 /*!
-    Re-reads the installation information XML file and updates itself. Changes to applicationName()
+    Re-reads the installation information XML file and updates itself. Changes written to the
+    journal by writeJournal() are applied on top of the XML file. Changes to applicationName()
     and applicationVersion() are lost after this function returns. The function emits a reset()
     signal after completion.
 */
@@ -239,12 +376,19 @@ void LocalPackageHub::refresh()
     d->applicationName.clear();
     d->applicationVersion.clear();
     d->m_packageInfoMap.clear();
+    d->m_journal.clear();
     d->modified = false;
 
     QFile file(d->fileName);
 
     // if the file does not exist then we just skip the reading
     if (!file.exists()) {
+        // ... unless the packages were only written to the journal so far
+        if (d->replayJournal()) {
+            d->error = NoError;
+            d->errorMessage.clear();
+            return;
+        }
         d->error = NotYetReadError;
         d->errorMessage = tr("The file %1 does not exist.").arg(d->fileName);
         return;
@@ -295,6 +439,7 @@ void LocalPackageHub::refresh()
         else if (childNodeE.tagName() == QLatin1String("Package"))
             d->addPackageFrom(childNodeE);
     }
+    d->replayJournal();
 
     d->error = NoError;
     d->errorMessage.clear();
@@ -350,6 +495,11 @@ void LocalPackageHub::addPackage(const QString &name,
         d->m_packageInfoMap.insert(name, info);
     }
     d->modified = true;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << d->m_packageInfoMap.value(name);
+    d->appendJournalEntry(JournalEntry::AddPackage, data);
 }
 
 /*!
@@ -361,6 +511,11 @@ bool LocalPackageHub::removePackage(const QString &name)
         return false;
 
     d->modified = true;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << name;
+    d->appendJournalEntry(JournalEntry::RemovePackage, data);
     return true;
 }
 
@@ -380,11 +535,64 @@ static void addTextChildHelper(QDomNode *node,
 }
 
 /*!
-    Writes the installation information file to disk.
+    Appends the changes made since the last call to writeJournal() or writeToDisk() to the
+    journal file next to the installation information file. This is much cheaper than
+    writeToDisk() for large installations, but the journal needs to be compacted into the
+    installation information file by calling writeToDisk() eventually.
+*/
+void LocalPackageHub::writeJournal()
+{
+    if (d->m_journal.isEmpty())
+        return;
+
+    // unbuffered, so that write() reports what actually reached the file
+    QFile file(d->journalFileName());
+    if (!file.open(QFile::WriteOnly | QFile::Append | QFile::Unbuffered))
+        return;
+
+    // the pending entries are kept untouched until they are written, so a failed write can be
+    // retried later
+    QByteArray journal;
+    const qint64 oldSize = file.size();
+    if (oldSize == 0) {
+        // a new journal, store the values that are otherwise only saved in the XML file
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << d->applicationName << d->applicationVersion;
+
+        QDataStream(&journal, QIODevice::WriteOnly) << JournalMagic;
+        appendJournalEntry(&journal, JournalEntry::ApplicationInfo, data);
+    }
+    journal.append(d->m_journal);
+
+    if (file.write(journal) != journal.size()) {
+        // Entries appended after a partially written one would be lost on replay. Cut the
+        // journal back to its previous size, or replace it by the XML file if that fails.
+        if (!file.resize(oldSize)) {
+            file.close();
+            writeToDisk();
+        }
+        return;
+    }
+    file.close();
+
+    // Write permissions for installation information journal
+    QInstaller::setDefaultFilePermissions(
+        &file, DefaultFilePermissions::NonExecutable);
+
+    d->m_journal.clear();
+}
+
+/*!
+    Writes the installation information file to disk and removes the journal written by
+    writeJournal().
 */
 void LocalPackageHub::writeToDisk()
 {
-    if (d->modified && (!d->m_packageInfoMap.isEmpty() || QFile::exists(d->fileName))) {
+    if (!d->modified)
+        return;
+
+    if (!d->m_packageInfoMap.isEmpty() || QFile::exists(d->fileName)) {
         QDomDocument doc;
         QDomElement root = doc.createElement(QLatin1String("Packages")) ;
         doc.appendChild(root);
@@ -437,9 +645,10 @@ void LocalPackageHub::writeToDisk()
         // Write permissions for installation information file
         QInstaller::setDefaultFilePermissions(
             &file, DefaultFilePermissions::NonExecutable);
-
-        d->modified = false;
     }
+
+    d->removeJournal();
+    d->modified = false;
 }
 
 void LocalPackageHub::PackagesInfoData::addPackageFrom(const QDomElement &packageE)
@@ -503,6 +712,7 @@ void LocalPackageHub::clearPackageInfos()
 {
     d->m_packageInfoMap.clear();
     d->modified = true;
+    d->appendJournalEntry(JournalEntry::ClearPackages, QByteArray());
 }
 
 /*!
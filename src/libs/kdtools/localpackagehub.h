@@ -110,6 +110,7 @@ public:
     bool removePackage(const QString &pkgName);
 
     void refresh();
+    void writeJournal();
     void writeToDisk();
 
 private:
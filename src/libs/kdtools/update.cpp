@@ -46,9 +46,11 @@ using namespace KDUpdater;
 /*!
    \internal
 */
-Update::Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo)
+Update::Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo,
+        const VersionKey &versionKey)
     : m_packageSource(packageSource)
     , m_updateInfo(updateInfo)
+    , m_versionKey(versionKey)
 {
 }
 
@@ -60,3 +62,9 @@ QVariant Update::data(const QString &name, const QVariant &defaultValue) const
 {
     return m_updateInfo.data.value(name, defaultValue);
 }
+
+/*!
+   \fn KDUpdater::VersionKey KDUpdater::Update::versionKey() const
+
+   Returns the parsed version of the update.
+*/
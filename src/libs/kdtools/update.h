@@ -41,14 +41,17 @@ public:
     QVariant data(const QString &name, const QVariant &defaultValue = QVariant()) const;
 
     QInstaller::PackageSource packageSource() const {return m_packageSource; }
+    VersionKey versionKey() const { return m_versionKey; }
 
 private:
     friend class UpdateFinder;
-    Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo);
+    Update(const QInstaller::PackageSource &packageSource, const UpdateInfo &updateInfo,
+        const VersionKey &versionKey);
 
 private:
     QInstaller::PackageSource m_packageSource;
     UpdateInfo m_updateInfo;
+    VersionKey m_versionKey;
 };
 
 } // namespace KDUpdater
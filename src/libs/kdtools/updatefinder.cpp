@@ -39,7 +39,6 @@
 
 #include <QCoreApplication>
 #include <QFileInfo>
-#include <QRegExp>
 
 using namespace KDUpdater;
 using namespace QInstaller;
@@ -104,7 +103,8 @@ public:
 
     QList<UpdateInfo> applicableUpdates(UpdatesInfo *updatesInfo);
     void createUpdateObjects(const PackageSource &source, const QList<UpdateInfo> &updateInfoList);
-    Resolution checkPriorityAndVersion(const PackageSource &source, const QVariantHash &data) const;
+    Resolution checkPriorityAndVersion(const PackageSource &source, const QVariantHash &data,
+        const VersionKey &versionKey) const;
     void slotDownloadDone();
 
     QSet<PackageSource> packageSources;
@@ -387,7 +387,8 @@ void UpdateFinder::Private::createUpdateObjects(const PackageSource &source,
     const QList<UpdateInfo> &updateInfoList)
 {
     foreach (const UpdateInfo &info, updateInfoList) {
-        const Resolution value = checkPriorityAndVersion(source, info.data);
+        const VersionKey versionKey(info.data.value(QLatin1String("Version")).toString());
+        const Resolution value = checkPriorityAndVersion(source, info.data, versionKey);
         if (value == Resolution::KeepExisting)
             continue;
 
@@ -397,7 +398,7 @@ void UpdateFinder::Private::createUpdateObjects(const PackageSource &source,
 
         // Create and register the update
         if (!q->isCompressedPackage() || value == Resolution::AddPackage)
-            updates.insert(name, new Update(source, info));
+            updates.insert(name, new Update(source, info, versionKey));
     }
 }
 
@@ -407,14 +408,13 @@ void UpdateFinder::Private::createUpdateObjects(const PackageSource &source,
     priority, use the new new package, otherwise keep the already existing package.
 */
 UpdateFinder::Private::Resolution UpdateFinder::Private::checkPriorityAndVersion(
-    const PackageSource &source, const QVariantHash &newPackage) const
+    const PackageSource &source, const QVariantHash &newPackage, const VersionKey &versionKey) const
 {
     const QString name = newPackage.value(QLatin1String("Name")).toString();
     if (Update *existingPackage = updates.value(name)) {
         // Bingo, package was previously found elsewhere.
 
-        const int match = compareVersion(newPackage.value(QLatin1String("Version")).toString(),
-            existingPackage->data(QLatin1String("Version")).toString());
+        const int match = compareVersion(versionKey, existingPackage->versionKey());
 
         if (match > 0) {
             // new package has higher version, use
@@ -590,77 +590,130 @@ int KDUpdater::compareVersion(const QString &v1, const QString &v2)
     if (v1 == v2)
         return 0;
 
-    // Split version components across ".", "-" or "_"
-    QStringList v1_comps = v1.split(QRegExp(QLatin1String( "\\.|-|_")));
-    QStringList v2_comps = v2.split(QRegExp(QLatin1String( "\\.|-|_")));
+    return VersionKey(v1).compare(VersionKey(v2));
+}
+
+/*!
+   \inmodule kdupdater
+   \overload
+
+   Compares the already parsed version keys \c v1 and \c v2 and returns -1, 0 or +1 following
+   the same rules as the function taking version strings.
+*/
+int KDUpdater::compareVersion(const VersionKey &v1, const VersionKey &v2)
+{
+    return v1.compare(v2);
+}
+
+/*!
+   \inmodule kdupdater
+   \class KDUpdater::VersionKey
+   \brief The VersionKey class holds a version string split into its components.
+
+   Splitting a version string and converting its numeric components is done once on
+   construction, so that a version that takes part in many comparisons does not have to be
+   parsed again for each of them. Comparing two keys does not allocate memory and gives the
+   same result as KDUpdater::compareVersion() for the version strings.
+*/
+
+/*!
+   Constructs a version key for \a version. Components are separated by ".", "-" or "_".
+*/
+VersionKey::VersionKey(const QString &version)
+    : m_version(version)
+{
+    int start = 0;
+    for (int i = 0; i <= m_version.size(); ++i) {
+        if (i < m_version.size()) {
+            const QChar c = m_version.at(i);
+            if (c != QLatin1Char('.') && c != QLatin1Char('-') && c != QLatin1Char('_'))
+                continue;
+        }
+        Segment segment;
+        segment.position = start;
+        segment.length = i - start;
+        segment.value = QStringRef(&m_version, start, i - start).toLongLong(&segment.numeric);
+        m_segments.append(segment);
+        start = i + 1;
+    }
+}
 
-    // Check each component of the version
+/*!
+   \fn QString KDUpdater::VersionKey::toString() const
+
+   Returns the version string the key was constructed from.
+*/
+
+/*!
+   Compares this key to \a other and returns -1, 0 or +1 if this version is lower, equal or
+   higher than the \a other version.
+*/
+int VersionKey::compare(const VersionKey &other) const
+{
+    if (m_version == other.m_version)
+        return 0;
+
+    const int count = m_segments.count();
+    const int otherCount = other.m_segments.count();
+
+    // Characters at the start of the current components that are equal in both versions.
+    int skipped = 0;
     int index = 0;
     while (true) {
-        bool v1_ok = false;
-        bool v2_ok = false;
+        if (index == count && index < otherCount)
+            return other.m_segments.at(index).numeric ? -1 : +1;
+        if (index < count && index == otherCount)
+            return m_segments.at(index).numeric ? +1 : -1;
+        if (index >= count || index >= otherCount)
+            break;
 
-        if (index == v1_comps.count() && index < v2_comps.count()) {
-            v2_comps.at(index).toLongLong(&v2_ok);
-            return v2_ok ? -1 : +1;
-        }
-        if (index < v1_comps.count() && index == v2_comps.count()) {
-            v1_comps.at(index).toLongLong(&v1_ok);
-            return v1_ok ? +1 : -1;
+        const Segment &segment = m_segments.at(index);
+        const Segment &otherSegment = other.m_segments.at(index);
+        const QStringRef comp(&m_version, segment.position + skipped, segment.length - skipped);
+        const QStringRef otherComp(&other.m_version, otherSegment.position + skipped,
+            otherSegment.length - skipped);
+
+        bool ok = segment.numeric;
+        bool otherOk = otherSegment.numeric;
+        qlonglong value = segment.value;
+        qlonglong otherValue = otherSegment.value;
+        if (skipped > 0) {
+            value = comp.toLongLong(&ok);
+            otherValue = otherComp.toLongLong(&otherOk);
         }
-        if (index >= v1_comps.count() || index >= v2_comps.count())
-            break;
 
-        qlonglong v1_comp = v1_comps.at(index).toLongLong(&v1_ok);
-        qlonglong v2_comp = v2_comps.at(index).toLongLong(&v2_ok);
+        if (!ok && comp == QLatin1String("x"))
+            return 0;
+        if (!otherOk && otherComp == QLatin1String("x"))
+            return 0;
 
-        if (!v1_ok) {
-            if (v1_comps.at(index) == QLatin1String("x"))
-                return 0;
-        }
-        if (!v2_ok) {
-            if (v2_comps.at(index) == QLatin1String("x"))
-                return 0;
-        }
-        if (!v1_ok && !v2_ok) {
+        if (!ok && !otherOk) {
             // try remove equal start
             int i = 0;
-            while (i < v1_comps.at(index).size()
-                && i < v2_comps.at(index).size()
-                && v1_comps.at(index).at(i) == v2_comps.at(index).at(i)) {
+            while (i < comp.size() && i < otherComp.size() && comp.at(i) == otherComp.at(i))
                 ++i;
-            }
             if (i > 0) {
-                v1_comps[index] = v1_comps.at(index).mid(i);
-                v2_comps[index] = v2_comps.at(index).mid(i);
+                skipped += i;
                 // compare again
                 continue;
             }
         }
-        if (!v1_ok || !v2_ok) {
-            int res = v1_comps.at(index).compare(v2_comps.at(index));
-            if (res == 0) {
-                // v1_comps.at(index) == v2_comps(index)
-                ++index;
-                continue;
-            }
-            return res > 0 ? +1 : -1;
+        if (!ok || !otherOk) {
+            const int res = comp.compare(otherComp);
+            if (res != 0)
+                return res > 0 ? +1 : -1;
+        } else if (value != otherValue) {
+            return value < otherValue ? -1 : +1;
         }
 
-        if (v1_comp < v2_comp)
-            return -1;
-
-        if (v1_comp > v2_comp)
-            return +1;
-
-        // v1_comp == v2_comp
         ++index;
+        skipped = 0;
     }
 
-    if (index < v2_comps.count())
+    if (index < otherCount)
         return +1;
 
-    if (index < v1_comps.count())
+    if (index < count)
         return -1;
 
     // Controversial return. I hope this never happens.
@@ -385,6 +385,40 @@ bool UpdateOperation::deleteFileNowOrLater(const QString &file, QString *errorSt
     Returns \c true if the operation is successful.
 */
 
+/*!
+    Returns the values set with setValue() that are saved by toXml() and toBinary(). The default
+    implementation returns all values except the package manager core set as \c installer.
+    Override this method to exclude values that are only needed while the operation is performed
+    or undone in the same session.
+*/
+QVariantMap UpdateOperation::persistentValues() const
+{
+    QVariantMap values = m_values;
+    // the installer can't be saved, ignore
+    values.remove(QLatin1String("installer"));
+    return values;
+}
+
+/*
+    Returns the target directory of the installation the maintenance tool is running from. Paths
+    saved relative to the relocatable placeholder are resolved against it.
+*/
+static QString relocatedTargetDir()
+{
+    QString target = QCoreApplication::applicationDirPath();
+    // Does not change target on non macOS platforms.
+    if (QInstaller::isInBundle(target, &target))
+        target = QDir::cleanPath(target + QLatin1String("/.."));
+    return target;
+}
+
+static QStringList replacePaths(QStringList list, const QString &before, const QString &after)
+{
+    for (int i = 0; i < list.count(); ++i)
+        list[i] = QInstaller::replacePath(list.at(i), before, after);
+    return list;
+}
+
 /*!
     Saves operation arguments and values as an XML document and returns the
     document. You can override this method to store your
@@ -407,16 +441,14 @@ QDomDocument UpdateOperation::toXml() const
         args.appendChild(arg);
     }
     root.appendChild(args);
-    if (m_values.isEmpty())
+
+    const QVariantMap persistent = persistentValues();
+    if (persistent.isEmpty())
         return doc;
 
     // append all values set with setValue
     QDomElement values = doc.createElement(QLatin1String("values"));
-    for (QVariantMap::const_iterator it = m_values.constBegin(); it != m_values.constEnd(); ++it) {
-        // the installer can't be put into XML, ignore
-        if (it.key() == QLatin1String("installer"))
-            continue;
-
+    for (QVariantMap::const_iterator it = persistent.constBegin(); it != persistent.constEnd(); ++it) {
         QDomElement value = doc.createElement(QLatin1String("value"));
         QVariant variant = it.value();
         value.setAttribute(QLatin1String("name"), it.key());
@@ -454,10 +486,7 @@ QDomDocument UpdateOperation::toXml() const
 */
 bool UpdateOperation::fromXml(const QDomDocument &doc)
 {
-    QString target = QCoreApplication::applicationDirPath();
-    // Does not change target on non macOS platforms.
-    if (QInstaller::isInBundle(target, &target))
-        target = QDir::cleanPath(target + QLatin1String("/.."));
+    const QString target = relocatedTargetDir();
 
     QStringList args;
     const QDomElement root = doc.documentElement();
@@ -508,6 +537,45 @@ bool UpdateOperation::fromXml(const QDomDocument &doc)
     return true;
 }
 
+/*!
+    Stores the operation arguments in \a arguments and the values returned by persistentValues()
+    in \a values, in the form used by the binary operation log of the maintenance tool. Like with
+    toXml(), paths inside the target directory are saved relative to a relocatable placeholder.
+*/
+void UpdateOperation::toBinary(QStringList *arguments, QVariantMap *values) const
+{
+    const QString target = m_core ? m_core->value(QInstaller::scTargetDir) : QString();
+    const QString relocatable = QLatin1String(QInstaller::scRelocatable);
+
+    *arguments = replacePaths(m_arguments, target, relocatable);
+    *values = persistentValues();
+    for (QVariantMap::iterator it = values->begin(); it != values->end(); ++it) {
+        if (it.value().type() == QVariant::String)
+            it.value() = QInstaller::replacePath(it.value().toString(), target, relocatable);
+        else if (it.value().type() == QVariant::StringList)
+            it.value() = replacePaths(it.value().toStringList(), target, relocatable);
+    }
+}
+
+/*!
+    Restores operation arguments and values from \a arguments and \a values as stored by
+    toBinary(). \note: Clears all previously set values and arguments.
+*/
+void UpdateOperation::fromBinary(const QStringList &arguments, const QVariantMap &values)
+{
+    const QString target = relocatedTargetDir();
+    const QString relocatable = QLatin1String(QInstaller::scRelocatable);
+
+    setArguments(replacePaths(arguments, relocatable, target));
+    m_values = values;
+    for (QVariantMap::iterator it = m_values.begin(); it != m_values.end(); ++it) {
+        if (it.value().type() == QVariant::String)
+            it.value() = QInstaller::replacePath(it.value().toString(), relocatable, target);
+        else if (it.value().type() == QVariant::StringList)
+            it.value() = replacePaths(it.value().toStringList(), relocatable, target);
+    }
+}
+
 /*!
     \overload
 
@@ -83,7 +83,12 @@ public:
     virtual bool fromXml(const QString &xml);
     virtual bool fromXml(const QDomDocument &doc);
 
+    void toBinary(QStringList *arguments, QVariantMap *values) const;
+    void fromBinary(const QStringList &arguments, const QVariantMap &values);
+
 protected:
+    virtual QVariantMap persistentValues() const;
+
     void setName(const QString &name);
     void setErrorString(const QString &errorString);
     void setError(int error, const QString &errorString = QString());
@@ -211,19 +211,12 @@ bool CopyOperation::undoOperation()
 /*!
  \reimp
  */
-QDomDocument CopyOperation::toXml() const
+QVariantMap CopyOperation::persistentValues() const
 {
     // we don't want to save the backupOfExistingDestination
-    if (!hasValue(QLatin1String("backupOfExistingDestination")))
-        return UpdateOperation::toXml();
-
-    CopyOperation *const me = const_cast<CopyOperation *>(this);
-
-    const QVariant v = value(QLatin1String("backupOfExistingDestination"));
-    me->clearValue(QLatin1String("backupOfExistingDestination"));
-    const QDomDocument xml = UpdateOperation::toXml();
-    me->setValue(QLatin1String("backupOfExistingDestination"), v);
-    return xml;
+    QVariantMap values = UpdateOperation::persistentValues();
+    values.remove(QLatin1String("backupOfExistingDestination"));
+    return values;
 }
 
 bool CopyOperation::testOperation()
@@ -394,19 +387,12 @@ bool DeleteOperation::testOperation()
 /*!
  \reimp
  */
-QDomDocument DeleteOperation::toXml() const
+QVariantMap DeleteOperation::persistentValues() const
 {
     // we don't want to save the backupOfExistingFile
-    if (!hasValue(QLatin1String("backupOfExistingFile")))
-        return UpdateOperation::toXml();
-
-    DeleteOperation *const me = const_cast<DeleteOperation *>(this);
-
-    const QVariant v = value(QLatin1String("backupOfExistingFile"));
-    me->clearValue(QLatin1String("backupOfExistingFile"));
-    const QDomDocument xml = UpdateOperation::toXml();
-    me->setValue(QLatin1String("backupOfExistingFile"), v);
-    return xml;
+    QVariantMap values = UpdateOperation::persistentValues();
+    values.remove(QLatin1String("backupOfExistingFile"));
+    return values;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -45,7 +45,9 @@ public:
     bool undoOperation();
     bool testOperation();
 
-    QDomDocument toXml() const;
+protected:
+    QVariantMap persistentValues() const;
+
 private:
     QString sourcePath();
     QString destinationPath();
@@ -76,7 +78,8 @@ public:
     bool undoOperation();
     bool testOperation();
 
-    QDomDocument toXml() const;
+protected:
+    QVariantMap persistentValues() const;
 };
 
 class KDTOOLS_EXPORT MkdirOperation : public UpdateOperation
@@ -31,6 +31,9 @@
 
 #include "kdtoolsglobal.h"
 
+#include <QString>
+#include <QVector>
+
 namespace KDUpdater
 {
     enum Error
@@ -42,7 +45,30 @@ namespace KDUpdater
         ECannotStopTask,
         EUnknown
     };
+
+    class KDTOOLS_EXPORT VersionKey
+    {
+    public:
+        explicit VersionKey(const QString &version = QString());
+
+        QString toString() const { return m_version; }
+        int compare(const VersionKey &other) const;
+
+    private:
+        struct Segment
+        {
+            int position;
+            int length;
+            bool numeric;
+            qlonglong value;
+        };
+
+        QString m_version;
+        QVector<Segment> m_segments;
+    };
+
     KDTOOLS_EXPORT int compareVersion(const QString &v1, const QString &v2);
+    KDTOOLS_EXPORT int compareVersion(const VersionKey &v1, const VersionKey &v2);
 }
 
 #endif // UPDATER_H
@@ -29,17 +29,45 @@
 #include "updatesinfo_p.h"
 #include "utils.h"
 
-#include <QDomDocument>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QGlobalStatic>
 #include <QLocale>
-#include <QPair>
-#include <QVector>
+#include <QMutex>
+#include <QSaveFile>
 #include <QUrl>
+#include <QXmlStreamReader>
 
 using namespace KDUpdater;
 
+namespace {
+
+static const quint32 scCacheMagic = 0x55504458; // "UPDX"
+static const quint32 scCacheVersion = 1;
+
+struct UpdatesInfoCache
+{
+    UpdatesInfoCache()
+        : infos(32)
+    {}
+
+    QMutex mutex;
+    QString directory;
+    // keeps the last parsed files so that the same Updates.xml is parsed only once per session
+    QCache<QString, UpdatesInfo> infos;
+};
+
+Q_GLOBAL_STATIC(UpdatesInfoCache, updatesInfoCache)
+
+} // namespace
+
 UpdatesInfoData::UpdatesInfoData()
      : error(UpdatesInfo::NotYetReadError)
+     , checksum(true)
 {
 }
 
@@ -49,50 +77,59 @@ UpdatesInfoData::~UpdatesInfoData()
 
 void UpdatesInfoData::setInvalidContentError(const QString &detail)
 {
+    // keep the first error, parsing continues to collect the valid packages
+    if (error == UpdatesInfo::InvalidContentError)
+        return;
     error = UpdatesInfo::InvalidContentError;
     errorMessage = tr("Updates.xml contains invalid content: %1").arg(detail);
 }
 
-void UpdatesInfoData::parseFile(const QString &updateXmlFile)
+void UpdatesInfoData::parseData(const QByteArray &data)
 {
-    QFile file(updateXmlFile);
-    if (!file.open(QFile::ReadOnly)) {
-        error = UpdatesInfo::CouldNotReadUpdateInfoFileError;
-        errorMessage = tr("Cannot read \"%1\"").arg(updateXmlFile);
-        return;
+    error = UpdatesInfo::NotYetReadError;
+    errorMessage.clear();
+
+    QXmlStreamReader reader(data);
+    if (reader.readNextStartElement()) {
+        if (reader.qualifiedName() != QLatin1String("Updates")) {
+            setInvalidContentError(tr("Root element %1 unexpected, should be \"Updates\".")
+                .arg(reader.qualifiedName().toString()));
+            return;
+        }
+
+        while (reader.readNextStartElement()) {
+            const QStringRef tagName = reader.qualifiedName();
+            if (tagName == QLatin1String("ApplicationName")) {
+                applicationName = reader.readElementText(QXmlStreamReader::IncludeChildElements);
+            } else if (tagName == QLatin1String("ApplicationVersion")) {
+                applicationVersion = reader.readElementText(QXmlStreamReader::IncludeChildElements);
+            } else if (tagName == QLatin1String("Checksum")) {
+                checksum = reader.readElementText(QXmlStreamReader::IncludeChildElements).toLower()
+                    == QLatin1String("true");
+            } else if (tagName == QLatin1String("PackageUpdate")) {
+                parsePackageUpdateElement(reader);
+            } else if (tagName == QLatin1String("RepositoryUpdate")) {
+                parseRepositoryUpdateElement(reader);
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
     }
+    // make sure the rest of the document is well-formed as well
+    while (!reader.atEnd())
+        reader.readNext();
+    m_strings.clear();
 
-    QDomDocument doc;
-    QString parseErrorMessage;
-    int parseErrorLine, parseErrorColumn;
-    if (!doc.setContent(&file, &parseErrorMessage, &parseErrorLine, &parseErrorColumn)) {
+    if (reader.hasError()) {
         error = UpdatesInfo::InvalidXmlError;
         errorMessage = tr("Parse error in %1 at %2, %3: %4").arg(updateXmlFile,
-            QString::number(parseErrorLine), QString::number(parseErrorColumn), parseErrorMessage);
+            QString::number(reader.lineNumber()), QString::number(reader.columnNumber()),
+            reader.errorString());
         return;
     }
 
-    QDomElement rootE = doc.documentElement();
-    if (rootE.tagName() != QLatin1String("Updates")) {
-        setInvalidContentError(tr("Root element %1 unexpected, should be \"Updates\".").arg(rootE.tagName()));
+    if (error == UpdatesInfo::InvalidContentError)
         return;
-    }
-
-    QDomNodeList childNodes = rootE.childNodes();
-    for(int i = 0; i < childNodes.count(); i++) {
-        const QDomElement childE = childNodes.at(i).toElement();
-        if (childE.isNull())
-            continue;
-
-        if (childE.tagName() == QLatin1String("ApplicationName"))
-            applicationName = childE.text();
-        else if (childE.tagName() == QLatin1String("ApplicationVersion"))
-            applicationVersion = childE.text();
-        else if (childE.tagName() == QLatin1String("PackageUpdate")) {
-            if (!parsePackageUpdateElement(childE))
-                return; //error handled in subroutine
-        }
-    }
 
     if (applicationName.isEmpty()) {
         setInvalidContentError(tr("ApplicationName element is missing."));
@@ -108,54 +145,59 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
     error = UpdatesInfo::NoError;
 }
 
-bool UpdatesInfoData::parsePackageUpdateElement(const QDomElement &updateE)
+void UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader)
 {
-    if (updateE.isNull())
-        return false;
-
     UpdateInfo info;
     QMap<QString, QString> localizedDescriptions;
-    for (int i = 0; i < updateE.childNodes().count(); i++) {
-        QDomElement childE = updateE.childNodes().at(i).toElement();
-        if (childE.isNull())
-            continue;
-
-        if (childE.tagName() == QLatin1String("ReleaseNotes")) {
-            info.data[childE.tagName()] = QUrl(childE.text());
-        } else if (childE.tagName() == QLatin1String("Licenses")) {
+    while (reader.readNextStartElement()) {
+        const QString tagName = intern(reader.qualifiedName().toString());
+        const QXmlStreamAttributes attributes = reader.attributes();
+
+        if (tagName == QLatin1String("ReleaseNotes")) {
+            info.data[tagName] = QUrl(reader.readElementText(QXmlStreamReader::IncludeChildElements));
+        } else if (tagName == QLatin1String("Licenses")) {
             QHash<QString, QVariant> licenseHash;
-            const QDomNodeList licenseNodes = childE.childNodes();
-            for (int i = 0; i < licenseNodes.count(); ++i) {
-                const QDomNode licenseNode = licenseNodes.at(i);
-                if (licenseNode.nodeName() == QLatin1String("License")) {
-                    QDomElement element = licenseNode.toElement();
-                    QVariantMap attributes;
-                    attributes.insert(QLatin1String("file"), element.attributeNode(QLatin1String("file")).value());
-                    if (!element.attributeNode(QLatin1String("priority")).isNull())
-                        attributes.insert(QLatin1String("priority"), element.attributeNode(QLatin1String("priority")).value());
-                    else
-                        attributes.insert(QLatin1String("priority"), QLatin1String("0"));
-                    licenseHash.insert(element.attributeNode(QLatin1String("name")).value(), attributes);
+            while (reader.readNextStartElement()) {
+                if (reader.qualifiedName() == QLatin1String("License")) {
+                    const QXmlStreamAttributes licenseAttributes = reader.attributes();
+                    QVariantMap license;
+                    license.insert(QLatin1String("file"),
+                        licenseAttributes.value(QLatin1String("file")).toString());
+                    if (licenseAttributes.hasAttribute(QLatin1String("priority"))) {
+                        license.insert(QLatin1String("priority"),
+                            licenseAttributes.value(QLatin1String("priority")).toString());
+                    } else {
+                        license.insert(QLatin1String("priority"), QLatin1String("0"));
+                    }
+                    licenseHash.insert(licenseAttributes.value(QLatin1String("name")).toString(),
+                        license);
                 }
+                reader.skipCurrentElement();
             }
-            if (!licenseHash.isEmpty())
-                info.data.insert(QLatin1String("Licenses"), licenseHash);
-        } else if (childE.tagName() == QLatin1String("Version")) {
+            // inserted even if empty, the element tells that the package has meta data
+            info.data.insert(tagName, licenseHash);
+        } else if (tagName == QLatin1String("Version")) {
             info.data.insert(QLatin1String("inheritVersionFrom"),
-                childE.attribute(QLatin1String("inheritVersionFrom")));
-            info.data[childE.tagName()] = childE.text();
-        } else if (childE.tagName() == QLatin1String("DisplayName")) {
-            processLocalizedTag(childE, info.data);
-        } else if (childE.tagName() == QLatin1String("Description")) {
-            if (!childE.hasAttribute(QLatin1String("xml:lang")))
-                info.data[QLatin1String("Description")] = childE.text();
-            QString languageAttribute = childE.attribute(QLatin1String("xml:lang"), QLatin1String("en"));
-            localizedDescriptions.insert(languageAttribute.toLower(), childE.text());
-        } else if (childE.tagName() == QLatin1String("UpdateFile")) {
-            info.data[QLatin1String("CompressedSize")] = childE.attribute(QLatin1String("CompressedSize"));
-            info.data[QLatin1String("UncompressedSize")] = childE.attribute(QLatin1String("UncompressedSize"));
+                attributes.value(QLatin1String("inheritVersionFrom")).toString());
+            info.data[tagName] = intern(reader.readElementText(QXmlStreamReader::IncludeChildElements));
+        } else if (tagName == QLatin1String("DisplayName")) {
+            processLocalizedTag(tagName, attributes.value(QLatin1String("xml:lang")).toString(),
+                reader.readElementText(QXmlStreamReader::IncludeChildElements), info.data);
+        } else if (tagName == QLatin1String("Description")) {
+            const QString text = reader.readElementText(QXmlStreamReader::IncludeChildElements);
+            if (!attributes.hasAttribute(QLatin1String("xml:lang")))
+                info.data[tagName] = text;
+            QString languageAttribute = attributes.hasAttribute(QLatin1String("xml:lang"))
+                ? attributes.value(QLatin1String("xml:lang")).toString() : QLatin1String("en");
+            localizedDescriptions.insert(languageAttribute.toLower(), text);
+        } else if (tagName == QLatin1String("UpdateFile")) {
+            info.data[QLatin1String("CompressedSize")]
+                = attributes.value(QLatin1String("CompressedSize")).toString();
+            info.data[QLatin1String("UncompressedSize")]
+                = attributes.value(QLatin1String("UncompressedSize")).toString();
+            reader.skipCurrentElement();
         } else {
-            info.data[childE.tagName()] = childE.text();
+            info.data[tagName] = intern(reader.readElementText(QXmlStreamReader::IncludeChildElements));
         }
     }
 
@@ -171,30 +213,60 @@ bool UpdatesInfoData::parsePackageUpdateElement(const QDomElement &updateE)
 
     if (!info.data.contains(QLatin1String("Name"))) {
         setInvalidContentError(tr("PackageUpdate element without Name"));
-        return false;
+        return;
     }
     if (!info.data.contains(QLatin1String("Version"))) {
         setInvalidContentError(tr("PackageUpdate element without Version"));
-        return false;
+        return;
     }
     if (!info.data.contains(QLatin1String("ReleaseDate"))) {
         setInvalidContentError(tr("PackageUpdate element without ReleaseDate"));
-        return false;
+        return;
     }
 
     updateInfoList.append(info);
-    return true;
 }
 
-void UpdatesInfoData::processLocalizedTag(const QDomElement &childE, QHash<QString, QVariant> &info) const
+void UpdatesInfoData::parseRepositoryUpdateElement(QXmlStreamReader &reader)
+{
+    while (reader.readNextStartElement()) {
+        if (reader.qualifiedName() == QLatin1String("Repository")) {
+            RepositoryUpdateInfo repository;
+            repository.lineNumber = reader.lineNumber();
+            foreach (const QXmlStreamAttribute &attribute, reader.attributes()) {
+                repository.attributes.insert(intern(attribute.qualifiedName().toString()),
+                    attribute.value().toString());
+            }
+            repositoryUpdateList.append(repository);
+        }
+        reader.skipCurrentElement();
+    }
+}
+
+/*
+    Returns a string equal to \a string that shares its data with all equal strings returned
+    before. Element names and values such as versions and dependencies repeat over and over in
+    large repositories.
+*/
+QString UpdatesInfoData::intern(const QString &string)
 {
-    QString languageAttribute = childE.attribute(QLatin1String("xml:lang")).toLower();
-    if (!info.contains(childE.tagName()) && (languageAttribute.isEmpty()))
-        info[childE.tagName()] = childE.text();
+    const QSet<QString>::const_iterator it = m_strings.constFind(string);
+    if (it != m_strings.constEnd())
+        return *it;
+    m_strings.insert(string);
+    return string;
+}
+
+void UpdatesInfoData::processLocalizedTag(const QString &tagName, const QString &language,
+    const QString &text, QHash<QString, QVariant> &info) const
+{
+    const QString languageAttribute = language.toLower();
+    if (!info.contains(tagName) && (languageAttribute.isEmpty()))
+        info[tagName] = text;
 
     // overwrite default if we have a language specific description
     if (QLocale().name().startsWith(languageAttribute, Qt::CaseInsensitive))
-        info[childE.tagName()] = childE.text();
+        info[tagName] = text;
 }
 
 
@@ -215,22 +287,59 @@ bool UpdatesInfo::isValid() const
     return d->error == NoError;
 }
 
+UpdatesInfo::Error UpdatesInfo::error() const
+{
+    return static_cast<Error>(d->error);
+}
+
 QString UpdatesInfo::errorString() const
 {
     return d->errorMessage;
 }
 
+/*
+    Reads the packages from \a updateXmlFile. Files with the same content are parsed only once,
+    the parsed result is shared between all UpdatesInfo objects. If a cache directory is set, the
+    parsed result is also stored there and read back instead of parsing the file again.
+*/
 void UpdatesInfo::setFileName(const QString &updateXmlFile)
 {
     if (d->updateXmlFile == updateXmlFile)
         return;
 
-    d->applicationName.clear();
-    d->applicationVersion.clear();
-    d->updateInfoList.clear();
-
+    d = new UpdatesInfoData;
     d->updateXmlFile = updateXmlFile;
-    d->parseFile(d->updateXmlFile);
+
+    QFile file(updateXmlFile);
+    if (!file.open(QFile::ReadOnly)) {
+        d->error = CouldNotReadUpdateInfoFileError;
+        d->errorMessage = UpdatesInfoData::tr("Cannot read \"%1\"").arg(updateXmlFile);
+        return;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    const QString key = cacheKey(data);
+    UpdatesInfoCache *const cache = updatesInfoCache();
+    {
+        QMutexLocker _(&cache->mutex);
+        if (const UpdatesInfo *const cached = cache->infos.object(key)) {
+            d = cached->d;
+            d->updateXmlFile = updateXmlFile;
+            return;
+        }
+    }
+
+    if (!readCache(key)) {
+        d->parseData(data);
+        if (isValid())
+            writeCache(key);
+    }
+
+    if (isValid()) {
+        QMutexLocker _(&cache->mutex);
+        cache->infos.insert(key, new UpdatesInfo(*this));
+    }
 }
 
 QString UpdatesInfo::fileName() const
@@ -248,6 +357,15 @@ QString UpdatesInfo::applicationVersion() const
     return d->applicationVersion;
 }
 
+/*
+    Returns whether the checksums of the package meta data should be verified. Defaults to \c true
+    if the file has no Checksum element.
+*/
+bool UpdatesInfo::checksum() const
+{
+    return d->checksum;
+}
+
 int UpdatesInfo::updateInfoCount() const
 {
     return d->updateInfoList.count();
@@ -264,3 +382,119 @@ QList<UpdateInfo> UpdatesInfo::updatesInfo() const
 {
     return d->updateInfoList;
 }
+
+/*
+    Returns the Repository elements of the RepositoryUpdate element.
+*/
+QList<RepositoryUpdateInfo> UpdatesInfo::repositoryUpdates() const
+{
+    return d->repositoryUpdateList;
+}
+
+/*
+    Returns the directory parsed files are cached in. Empty if the disk cache is disabled.
+*/
+QString UpdatesInfo::cacheDirectory()
+{
+    UpdatesInfoCache *const cache = updatesInfoCache();
+    QMutexLocker _(&cache->mutex);
+    return cache->directory;
+}
+
+/*
+    Sets the \a directory parsed files are cached in. An empty directory disables the disk cache.
+    Changing the directory drops the files parsed before from the in-memory cache.
+*/
+void UpdatesInfo::setCacheDirectory(const QString &directory)
+{
+    UpdatesInfoCache *const cache = updatesInfoCache();
+    QMutexLocker _(&cache->mutex);
+    if (cache->directory == directory)
+        return;
+    cache->directory = directory;
+    cache->infos.clear();
+}
+
+QString UpdatesInfo::cacheKey(const QByteArray &data) const
+{
+    // the localized descriptions are resolved while parsing
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex())
+        + QLatin1Char('_') + QLocale().name();
+}
+
+bool UpdatesInfo::readCache(const QString &key)
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty())
+        return false;
+
+    QFile file(QDir(directory).filePath(key + QLatin1String(".updatesinfo")));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != scCacheMagic || version != scCacheVersion)
+        return false;
+
+    QString applicationName, applicationVersion;
+    bool checksum = true;
+    qint32 count = 0;
+    stream >> applicationName >> applicationVersion >> checksum >> count;
+
+    QList<UpdateInfo> updateInfoList;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        UpdateInfo info;
+        stream >> info.data;
+        updateInfoList.append(info);
+    }
+
+    stream >> count;
+    QList<RepositoryUpdateInfo> repositoryUpdateList;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        RepositoryUpdateInfo repository;
+        stream >> repository.attributes >> repository.lineNumber;
+        repositoryUpdateList.append(repository);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring corrupt cache file" << file.fileName();
+        return false;
+    }
+
+    d->applicationName = applicationName;
+    d->applicationVersion = applicationVersion;
+    d->checksum = checksum;
+    d->updateInfoList = updateInfoList;
+    d->repositoryUpdateList = repositoryUpdateList;
+    d->errorMessage.clear();
+    d->error = NoError;
+    return true;
+}
+
+void UpdatesInfo::writeCache(const QString &key) const
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty() || !QDir().mkpath(directory))
+        return;
+
+    QSaveFile file(QDir(directory).filePath(key + QLatin1String(".updatesinfo")));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << scCacheMagic << scCacheVersion << d->applicationName << d->applicationVersion
+        << d->checksum << qint32(d->updateInfoList.count());
+    foreach (const UpdateInfo &info, d->updateInfoList)
+        stream << info.data;
+    stream << qint32(d->repositoryUpdateList.count());
+    foreach (const RepositoryUpdateInfo &repository, d->repositoryUpdateList)
+        stream << repository.attributes << repository.lineNumber;
+
+    if (stream.status() != QDataStream::Ok || !file.commit())
+        qDebug() << "Cannot write cache file" << file.fileName();
+}
@@ -46,6 +46,12 @@ struct KDTOOLS_EXPORT UpdateInfo
     QHash<QString, QVariant> data;
 };
 
+struct KDTOOLS_EXPORT RepositoryUpdateInfo
+{
+    QHash<QString, QString> attributes;
+    qint64 lineNumber;
+};
+
 class KDTOOLS_EXPORT UpdatesInfo
 {
 public:
@@ -71,10 +77,20 @@ public:
 
     QString applicationName() const;
     QString applicationVersion() const;
+    bool checksum() const;
 
     int updateInfoCount() const;
     UpdateInfo updateInfo(int index) const;
     QList<UpdateInfo> updatesInfo() const;
+    QList<RepositoryUpdateInfo> repositoryUpdates() const;
+
+    static QString cacheDirectory();
+    static void setCacheDirectory(const QString &directory);
+
+private:
+    QString cacheKey(const QByteArray &data) const;
+    bool readCache(const QString &key);
+    void writeCache(const QString &key) const;
 
 private:
     QSharedDataPointer<UpdatesInfoData> d;
@@ -30,13 +30,15 @@
 #define UPDATESINFODATA_P_H
 
 #include <QCoreApplication>
+#include <QSet>
 #include <QSharedData>
 
-QT_FORWARD_DECLARE_CLASS(QDomElement)
+QT_FORWARD_DECLARE_CLASS(QXmlStreamReader)
 
 namespace KDUpdater {
 
 struct UpdateInfo;
+struct RepositoryUpdateInfo;
 
 struct UpdatesInfoData : public QSharedData
 {
@@ -51,15 +53,23 @@ public:
     QString updateXmlFile;
     QString applicationName;
     QString applicationVersion;
+    bool checksum;
     QList<UpdateInfo> updateInfoList;
+    QList<RepositoryUpdateInfo> repositoryUpdateList;
 
-    void parseFile(const QString &updateXmlFile);
-    bool parsePackageUpdateElement(const QDomElement &updateE);
+    void parseData(const QByteArray &data);
+    void parsePackageUpdateElement(QXmlStreamReader &reader);
+    void parseRepositoryUpdateElement(QXmlStreamReader &reader);
 
     void setInvalidContentError(const QString &detail);
 
 private:
-    void processLocalizedTag(const QDomElement &childE, QHash<QString, QVariant> &info) const;
+    QString intern(const QString &string);
+    void processLocalizedTag(const QString &tagName, const QString &language, const QString &text,
+        QHash<QString, QVariant> &info) const;
+
+private:
+    QSet<QString> m_strings;
 };
 
 } // namespace KDUpdater
@@ -0,0 +1,155 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivecache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_archivecache : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString writeFile(const QString &name, const QByteArray &data)
+    {
+        QFile file(m_tempDir.path() + QLatin1Char('/') + name);
+        if (!file.open(QIODevice::WriteOnly))
+            return QString();
+        file.write(data);
+        return file.fileName();
+    }
+
+    static QByteArray sha1(const QByteArray &data)
+    {
+        return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    }
+
+private slots:
+    void init()
+    {
+        QVERIFY(m_tempDir.isValid());
+        m_cachePath = m_tempDir.path() + QLatin1String("/cache");
+    }
+
+    void testDisabled()
+    {
+        ArchiveCache cache;
+        QVERIFY(!cache.isEnabled());
+        QVERIFY(cache.lookup(sha1("data")).isEmpty());
+        QVERIFY(cache.insert(sha1("data"), QByteArray("data")).isEmpty());
+    }
+
+    void testNormalizedKey()
+    {
+        const QByteArray key = sha1("data");
+        QCOMPARE(ArchiveCache::normalizedKey(key.toUpper() + '\n'), key);
+        QVERIFY(ArchiveCache::normalizedKey("1234").isEmpty());
+        QVERIFY(ArchiveCache::normalizedKey(QByteArray(40, 'x')).isEmpty());
+    }
+
+    void testInsertFile()
+    {
+        const QByteArray data("archive content");
+        const QString fileName = writeFile(QLatin1String("archive.7z"), data);
+        QVERIFY(!fileName.isEmpty());
+
+        ArchiveCache cache(m_cachePath);
+        const QString cached = cache.insert(sha1(data), fileName);
+        QVERIFY(!cached.isEmpty());
+        QVERIFY(!QFileInfo::exists(fileName));
+
+        QFile file(cached);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), data);
+
+        ArchiveCache otherCache(m_cachePath);
+        QCOMPARE(otherCache.lookup(sha1(data)), cached);
+        QVERIFY(otherCache.lookup(sha1("other content")).isEmpty());
+        QVERIFY(otherCache.insert(QByteArray("invalid"), fileName).isEmpty());
+    }
+
+    void testInsertData()
+    {
+        const QByteArray data("in-memory archive");
+        ArchiveCache cache(m_cachePath);
+        const QString cached = cache.insert(sha1(data), data);
+        QVERIFY(!cached.isEmpty());
+        QCOMPARE(cache.insert(sha1(data), data), cached);
+
+        QFile file(cached);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), data);
+        QCOMPARE(QDir(m_cachePath).entryList(QDir::Files).count(), 1);
+    }
+
+    void testEvict()
+    {
+        const QByteArray first(100, 'a');
+        const QByteArray second(100, 'b');
+        const QByteArray third(100, 'c');
+
+        {
+            ArchiveCache cache(m_cachePath, 250);
+            QVERIFY(!cache.insert(sha1(first), first).isEmpty());
+            QVERIFY(!cache.insert(sha1(second), second).isEmpty());
+            QVERIFY(!cache.insert(sha1(third), third).isEmpty());
+
+            // all entries were used by this instance
+            cache.evict();
+            QCOMPARE(QDir(m_cachePath).entryList(QDir::Files).count(), 3);
+        }
+
+        ArchiveCache cache(m_cachePath, 250);
+        QVERIFY(!cache.lookup(sha1(third)).isEmpty());
+        cache.evict();
+
+        QCOMPARE(QDir(m_cachePath).entryList(QDir::Files).count(), 2);
+        QVERIFY(!cache.lookup(sha1(third)).isEmpty());
+    }
+
+    void cleanup()
+    {
+        QDir(m_cachePath).removeRecursively();
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    QString m_cachePath;
+};
+
+QTEST_MAIN(tst_archivecache)
+
+#include "tst_archivecache.moc"
@@ -0,0 +1,176 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivedelta.h"
+#include "errors.h"
+
+#include <lib7z_create.h>
+#include <lib7z_extract.h>
+#include <lib7z_facade.h>
+#include <lib7z_list.h>
+
+#include <QDir>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_archivedelta : public QObject
+{
+    Q_OBJECT
+
+private:
+    void writeFile(const QString &directory, const QString &path, const QByteArray &content)
+    {
+        const QString fileName = QDir(directory).filePath(path);
+        QVERIFY(QDir().mkpath(QFileInfo(fileName).path()));
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    }
+
+    QByteArray readFile(const QString &directory, const QString &path)
+    {
+        QFile file(QDir(directory).filePath(path));
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+    void createArchive(const QString &archive, const QString &directory)
+    {
+        QStringList sources;
+        const QDir dir(directory);
+        foreach (const QString &entry, dir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot))
+            sources.append(dir.absoluteFilePath(entry));
+        Lib7z::createArchive(archive, sources, Lib7z::TmpFile::No);
+    }
+
+    void extractArchive(const QString &archive, const QString &directory)
+    {
+        QVERIFY(QDir().mkpath(directory));
+        QFile file(archive);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        Lib7z::extractArchive(&file, directory);
+    }
+
+private slots:
+    void initTestCase()
+    {
+        Lib7z::initSevenZ();
+        QVERIFY(m_dir.isValid());
+
+        const QString baseDir = m_dir.path() + "/base";
+        writeFile(baseDir, "unchanged.txt", "This file is the same in both versions.");
+        writeFile(baseDir, "sub/changed.txt", "Old content.");
+        writeFile(baseDir, "sub/removed.txt", "Only in the old version.");
+        createArchive(baseArchive(), baseDir);
+
+        const QString newDir = m_dir.path() + "/new";
+        writeFile(newDir, "unchanged.txt", "This file is the same in both versions.");
+        writeFile(newDir, "sub/changed.txt", "New content.");
+        writeFile(newDir, "added.txt", "Only in the new version.");
+        QVERIFY(QDir().mkpath(newDir + "/empty"));
+        createArchive(newArchive(), newDir);
+
+        ArchiveDelta::create(baseArchive(), newArchive(), deltaArchive());
+    }
+
+    void init()
+    {
+        QDir(installDir()).removeRecursively();
+        extractArchive(baseArchive(), installDir());
+    }
+
+    void testFromString()
+    {
+        const QList<ArchiveDelta> deltas = ArchiveDelta::fromString(
+            "content.7z:1.0:0A1B2C, data.7z:0.9:d4e5f6,invalid,missing:sha1");
+        QCOMPARE(deltas.count(), 2);
+        QCOMPARE(deltas.at(0).archive(), QString("content.7z"));
+        QCOMPARE(deltas.at(0).baseVersion(), QString("1.0"));
+        QCOMPARE(deltas.at(0).sha1(), QByteArray("0a1b2c"));
+        QCOMPARE(deltas.at(0).suffix(), QString(".delta-1.0"));
+        QCOMPARE(deltas.at(1).archive(), QString("data.7z"));
+        QCOMPARE(ArchiveDelta::toString(deltas), QString("content.7z:1.0:0a1b2c,data.7z:0.9:d4e5f6"));
+    }
+
+    void testDeltaContent()
+    {
+        QFile file(deltaArchive());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        foreach (const Lib7z::File &entry, Lib7z::listArchive(&file))
+            QVERIFY(!entry.path.endsWith("unchanged.txt"));
+    }
+
+    void testReconstruct()
+    {
+        const QString archive = m_dir.path() + "/reconstructed.7z";
+        const QString checkDir = m_dir.path() + "/check";
+        try {
+            ArchiveDelta::reconstruct(deltaArchive(), installDir(), archive);
+        } catch (const Error &error) {
+            QFAIL(qPrintable(error.message()));
+        }
+        extractArchive(archive, checkDir);
+
+        QCOMPARE(readFile(checkDir, "unchanged.txt"), QByteArray("This file is the same in both versions."));
+        QCOMPARE(readFile(checkDir, "sub/changed.txt"), QByteArray("New content."));
+        QCOMPARE(readFile(checkDir, "added.txt"), QByteArray("Only in the new version."));
+        QVERIFY(!QFileInfo::exists(checkDir + "/sub/removed.txt"));
+        QVERIFY(QFileInfo(checkDir + "/empty").isDir());
+        QVERIFY(!QFileInfo::exists(checkDir + "/.installerfw-delta"));
+    }
+
+    void testReconstructModifiedInstallation()
+    {
+        writeFile(installDir(), "unchanged.txt", "Modified after the installation.");
+        QVERIFY_EXCEPTION_THROWN(ArchiveDelta::reconstruct(deltaArchive(), installDir(),
+            m_dir.path() + "/modified.7z"), Error);
+    }
+
+    void testReconstructMissingFile()
+    {
+        QVERIFY(QFile::remove(installDir() + "/unchanged.txt"));
+        QVERIFY_EXCEPTION_THROWN(ArchiveDelta::reconstruct(deltaArchive(), installDir(),
+            m_dir.path() + "/missing.7z"), Error);
+    }
+
+private:
+    QString baseArchive() const { return m_dir.path() + "/1.0content.7z"; }
+    QString newArchive() const { return m_dir.path() + "/1.1content.7z"; }
+    QString deltaArchive() const { return newArchive() + ".delta-1.0"; }
+    QString installDir() const { return m_dir.path() + "/install"; }
+
+    QTemporaryDir m_dir;
+};
+
+QTEST_MAIN(tst_archivedelta)
+
+#include "tst_archivedelta.moc"
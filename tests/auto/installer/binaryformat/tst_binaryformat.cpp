@@ -392,6 +392,133 @@ private slots:
         resource->close();
     }
 
+    void readResourceSegment()
+    {
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::blockingWrite(&file, QByteArray("Leading data."));
+        QInstaller::blockingWrite(&file, QByteArray("Resource data."));
+        QInstaller::blockingWrite(&file, QByteArray("Trailing data."));
+        file.close();
+
+        Resource resource(file.fileName(), Range<qint64>::fromStartAndLength(13, 14));
+        QCOMPARE(resource.open(), true);
+        QCOMPARE(resource.size(), 14LL);
+        QCOMPARE(resource.readAll(), QByteArray("Resource data."));
+        QCOMPARE(resource.seek(9), true);
+        QCOMPARE(resource.read(4), QByteArray("data"));
+        resource.close();
+    }
+
+    void readInMemoryResource()
+    {
+        Resource resource(QByteArray("Resource"), QByteArray("In-memory resource data."));
+        QCOMPARE(resource.name(), QByteArray("Resource"));
+        QCOMPARE(resource.size(), 24LL);
+        QCOMPARE(resource.open(), true);
+        QCOMPARE(resource.readAll(), QByteArray("In-memory resource data."));
+        QCOMPARE(resource.seek(10), true);
+        QCOMPARE(resource.read(8), QByteArray("resource"));
+        resource.close();
+        QCOMPARE(resource.isOpen(), false);
+    }
+
+    void writeReadOperationLog()
+    {
+        TestOperation op(QLatin1String("Operation 1"));
+        op.setArguments(QStringList() << QLatin1String("arg1") << QLatin1String("arg2"));
+        op.setValue(QLatin1String("component"), QLatin1String("A"));
+        op.setValue(QLatin1String("files"), QStringList() << QLatin1String("file1")
+            << QLatin1String("arg1"));
+        op.setValue(QLatin1String("admin"), true);
+        op.setValue(QLatin1String("size"), 42);
+
+        QStringList arguments;
+        QVariantMap values;
+        op.toBinary(&arguments, &values);
+
+        QList<OperationBlob> operations;
+        operations.append(OperationBlob(op.name(), arguments, values));
+        operations.append(m_operations.first()); // mixed with an operation saved as XML
+        operations.append(OperationBlob(QLatin1String("Operation 3"), QStringList(),
+            QVariantMap()));
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        BinaryContent::writeOperations(&file, operations);
+        QInstaller::appendInt64(&file, BinaryContent::MagicCookie);
+
+        QList<OperationBlob> read;
+        QVERIFY(file.seek(0));
+        BinaryContent::readOperations(&file, &read);
+        QCOMPARE(QInstaller::retrieveInt64(&file), qint64(BinaryContent::MagicCookie));
+
+        QCOMPARE(read.count(), operations.count());
+        QCOMPARE(read.at(0).isXml(), false);
+        QCOMPARE(read.at(0).name, op.name());
+        QCOMPARE(read.at(0).arguments, op.arguments());
+        QCOMPARE(read.at(0).values, values);
+        QCOMPARE(read.at(1).isXml(), true);
+        QCOMPARE(read.at(1).name, m_operations.first().name);
+        QCOMPARE(read.at(1).xml, m_operations.first().xml);
+        QCOMPARE(read.at(2).name, QLatin1String("Operation 3"));
+        QCOMPARE(read.at(2).arguments.isEmpty(), true);
+        QCOMPARE(read.at(2).values.isEmpty(), true);
+
+        TestOperation restored(read.at(0).name);
+        restored.fromBinary(read.at(0).arguments, read.at(0).values);
+        QCOMPARE(restored.arguments(), op.arguments());
+        QCOMPARE(restored.value(QLatin1String("files")), op.value(QLatin1String("files")));
+        QCOMPARE(restored.value(QLatin1String("admin")), QVariant(true));
+        QCOMPARE(restored.value(QLatin1String("size")), QVariant(42));
+    }
+
+    void benchmarkLoadOperations_data()
+    {
+        QTest::addColumn<bool>("xml");
+        QTest::newRow("XML") << true;
+        QTest::newRow("binary") << false;
+    }
+
+    void benchmarkLoadOperations()
+    {
+        QFETCH(bool, xml);
+
+        QList<OperationBlob> operations;
+        for (int i = 0; i < 10000; ++i) {
+            TestOperation op(QLatin1String("Copy"));
+            op.setArguments(QStringList() << QString::fromLatin1("/source/file%1").arg(i)
+                << QString::fromLatin1("/target/file%1").arg(i));
+            op.setValue(QLatin1String("component"), QString::fromLatin1("component%1").arg(i / 100));
+            op.setValue(QLatin1String("uninstall-only"), false);
+            if (xml) {
+                operations.append(OperationBlob(op.name(), op.toXml().toString()));
+            } else {
+                QStringList arguments;
+                QVariantMap values;
+                op.toBinary(&arguments, &values);
+                operations.append(OperationBlob(op.name(), arguments, values));
+            }
+        }
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        BinaryContent::writeOperations(&file, operations);
+
+        QBENCHMARK {
+            QList<OperationBlob> read;
+            QVERIFY(file.seek(0));
+            BinaryContent::readOperations(&file, &read);
+            foreach (const OperationBlob &operation, read) {
+                TestOperation op(operation.name);
+                if (operation.isXml())
+                    op.fromXml(operation.xml);
+                else
+                    op.fromBinary(operation.arguments, operation.values);
+            }
+        }
+    }
+
     void cleanupTestCase()
     {
         m_manager.clear();
@@ -139,6 +139,43 @@ private slots:
         }
     }
 
+    void sendReceiveBinaryPacket()
+    {
+        QByteArray packets;
+        {
+            QBuffer device(&packets);
+            device.open(QBuffer::WriteOnly);
+            QInstaller::sendPacket(&device, Protocol::Command::QSettingsSetValue, 42, "hello");
+            QInstaller::sendPacket(&device, Protocol::QAbstractFileEngineSize, "world");
+        }
+
+        QBuffer device(&packets);
+        device.open(QBuffer::ReadOnly);
+
+        Protocol::Command command;
+        quint32 requestId;
+        QByteArray data;
+        QCOMPARE(QInstaller::receivePacket(&device, &command, &requestId, &data), true);
+        QCOMPARE(command, Protocol::Command::QSettingsSetValue);
+        QCOMPARE(requestId, quint32(42));
+        QCOMPARE(data, QByteArray("hello"));
+
+        // packets sent by command name are understood as well
+        QCOMPARE(QInstaller::receivePacket(&device, &command, &requestId, &data), true);
+        QCOMPARE(command, Protocol::Command::QAbstractFileEngineSize);
+        QCOMPARE(requestId, quint32(0));
+        QCOMPARE(data, QByteArray("world"));
+        QCOMPARE(device.pos(), device.size());
+
+        QCOMPARE(Protocol::command(QLatin1String(Protocol::QProcessKill)),
+            Protocol::Command::QProcessKill);
+        QCOMPARE(Protocol::commandName(Protocol::Command::QProcessKill),
+            QByteArray(Protocol::QProcessKill));
+        QCOMPARE(Protocol::command(QLatin1String("Unknown::command")), Protocol::Command::Unknown);
+        QCOMPARE(Protocol::isDeferrable(Protocol::Command::QSettingsSetValue), true);
+        QCOMPARE(Protocol::isDeferrable(Protocol::Command::QSettingsSync), false);
+    }
+
     void localSocket()
     {
         //
@@ -515,6 +552,139 @@ private slots:
         QCOMPARE(file.atEnd(), true);
     }
 
+    void testRemoteFileEngineBatches()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QString filename;
+        {
+            QTemporaryFile file;
+            file.setAutoRemove(false);
+            QCOMPARE(file.open(), true);
+            filename = file.fileName();
+        }
+
+        QByteArray expected;
+        for (int i = 0; i < 50000; ++i)
+            expected.append(QByteArray::number(i)).append('\n');
+
+        RemoteFileEngineHandler handler;
+        {
+            // small unbuffered writes are sent to the server in batches
+            QFile file(filename);
+            QCOMPARE(file.open(QIODevice::WriteOnly | QIODevice::Unbuffered), true);
+            for (int i = 0; i < expected.size(); i += 100)
+                QCOMPARE(file.write(expected.mid(i, 100)), qint64(expected.mid(i, 100).size()));
+            QCOMPARE(file.pos(), qint64(expected.size()));
+            QCOMPARE(file.size(), qint64(expected.size()));
+            file.close();
+            QCOMPARE(file.error(), QFile::NoError);
+        }
+        {
+            // small unbuffered reads are served from data read ahead
+            QFile file(filename);
+            QCOMPARE(file.open(QIODevice::ReadWrite | QIODevice::Unbuffered), true);
+            QByteArray content;
+            while (content.size() < 1000) {
+                content.append(file.read(10));
+                QCOMPARE(file.pos(), qint64(content.size()));
+            }
+            // writing continues where reading stopped
+            QCOMPARE(file.write("x"), qint64(1));
+            QCOMPARE(file.seek(content.size()), true);
+            QCOMPARE(file.read(1), QByteArray("x"));
+            content.append('x');
+            content.append(file.readAll());
+            QCOMPARE(content.size(), expected.size());
+            QCOMPARE(content.left(1000), expected.left(1000));
+            QCOMPARE(content.mid(1001), expected.mid(1001));
+            QCOMPARE(file.atEnd(), true);
+        }
+        QFile::remove(filename);
+    }
+
+    void benchmarkFileEngineWrite_data()
+    {
+        QTest::addColumn<bool>("commandNames");
+        QTest::newRow("command names, one call per write") << true;
+        QTest::newRow("numeric commands, batched writes") << false;
+    }
+
+    void benchmarkFileEngineWrite()
+    {
+        QFETCH(bool, commandNames);
+
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QString filename;
+        {
+            QTemporaryFile file;
+            file.setAutoRemove(false);
+            QCOMPARE(file.open(), true);
+            filename = file.fileName();
+        }
+
+        const QByteArray chunk(4096, 'x');
+        const int chunks = 256;
+
+        if (commandNames) {
+            // the protocol as spoken before numeric commands: a round trip for every write
+            QLocalSocket socket;
+            socket.connectToServer(socketName);
+            QVERIFY2(socket.waitForConnected(), "Cannot connect to server.");
+
+            QByteArray command;
+            bool success;
+            sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("SomeKey"));
+            receiveCommand(&socket, &command, &success);
+            QCOMPARE(success, true);
+
+            sendCommand(&socket, Protocol::Create, QString::fromLatin1(Protocol::QAbstractFileEngine));
+            sendCommand(&socket, Protocol::QAbstractFileEngineSetFileName, filename);
+            sendCommand(&socket, Protocol::QAbstractFileEngineOpen,
+                qint32(QIODevice::WriteOnly | QIODevice::Unbuffered));
+            receiveCommand(&socket, &command, &success);
+            QCOMPARE(success, true);
+
+            QBENCHMARK {
+                for (int i = 0; i < chunks; ++i) {
+                    qint64 written;
+                    sendCommand(&socket, Protocol::QAbstractFileEngineWrite, chunk);
+                    receiveCommand(&socket, &command, &written);
+                    QCOMPARE(written, qint64(chunk.size()));
+                }
+            }
+
+            sendCommand(&socket, Protocol::QAbstractFileEngineClose, qint32(0));
+            receiveCommand(&socket, &command, &success);
+            QCOMPARE(success, true);
+        } else {
+            RemoteFileEngineHandler handler;
+            QFile file(filename);
+            QCOMPARE(file.open(QIODevice::WriteOnly | QIODevice::Unbuffered), true);
+
+            QBENCHMARK {
+                for (int i = 0; i < chunks; ++i)
+                    QCOMPARE(file.write(chunk), qint64(chunk.size()));
+                QCOMPARE(file.flush(), true);
+            }
+            file.close();
+        }
+        QFile::remove(filename);
+    }
+
     void cleanupTestCase()
     {
         RemoteClient::instance().setActive(false);
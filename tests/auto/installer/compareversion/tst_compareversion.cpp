@@ -28,8 +28,97 @@
 
 #include "updater.h"
 
+#include <QRegExp>
 #include <QTest>
 
+// The string based implementation VersionKey replaces, kept to check and measure against.
+static int legacyCompareVersion(const QString &v1, const QString &v2)
+{
+    if (v1 == v2)
+        return 0;
+
+    QStringList v1_comps = v1.split(QRegExp(QLatin1String( "\\.|-|_")));
+    QStringList v2_comps = v2.split(QRegExp(QLatin1String( "\\.|-|_")));
+
+    int index = 0;
+    while (true) {
+        bool v1_ok = false;
+        bool v2_ok = false;
+
+        if (index == v1_comps.count() && index < v2_comps.count()) {
+            v2_comps.at(index).toLongLong(&v2_ok);
+            return v2_ok ? -1 : +1;
+        }
+        if (index < v1_comps.count() && index == v2_comps.count()) {
+            v1_comps.at(index).toLongLong(&v1_ok);
+            return v1_ok ? +1 : -1;
+        }
+        if (index >= v1_comps.count() || index >= v2_comps.count())
+            break;
+
+        qlonglong v1_comp = v1_comps.at(index).toLongLong(&v1_ok);
+        qlonglong v2_comp = v2_comps.at(index).toLongLong(&v2_ok);
+
+        if (!v1_ok) {
+            if (v1_comps.at(index) == QLatin1String("x"))
+                return 0;
+        }
+        if (!v2_ok) {
+            if (v2_comps.at(index) == QLatin1String("x"))
+                return 0;
+        }
+        if (!v1_ok && !v2_ok) {
+            int i = 0;
+            while (i < v1_comps.at(index).size()
+                && i < v2_comps.at(index).size()
+                && v1_comps.at(index).at(i) == v2_comps.at(index).at(i)) {
+                ++i;
+            }
+            if (i > 0) {
+                v1_comps[index] = v1_comps.at(index).mid(i);
+                v2_comps[index] = v2_comps.at(index).mid(i);
+                continue;
+            }
+        }
+        if (!v1_ok || !v2_ok) {
+            int res = v1_comps.at(index).compare(v2_comps.at(index));
+            if (res == 0) {
+                ++index;
+                continue;
+            }
+            return res > 0 ? +1 : -1;
+        }
+
+        if (v1_comp < v2_comp)
+            return -1;
+
+        if (v1_comp > v2_comp)
+            return +1;
+
+        ++index;
+    }
+
+    if (index < v2_comps.count())
+        return +1;
+
+    if (index < v1_comps.count())
+        return -1;
+
+    return 0;
+}
+
+static QStringList versionCorpus()
+{
+    return QStringList() << "" << "1" << "2" << "x" << "2.0" << "2.1" << "2.x" << "2.0.0"
+        << "2.0.12.4" << "2.1.10.4" << "2.0.12.x" << "2.1.12.x" << "2.0.x" << "2.1-0"
+        << "2.1-201903190747" << "version-1" << "version-2" << "v2.0" << "v2.x"
+        << "v2.0-alpha" << "v2.0-beta" << "v2.0-rc1" << "v2.0-rc2" << "v2.0-rc11" << "v2.0-rc22"
+        << "OpenSSL_1_0_2k" << "OpenSSL_1_0_2l" << "OpenSSL_1_1_0f" << "1..2" << "1.2." << ".1"
+        << "1.0a" << "1.0b" << "1.0ab" << "1.0-a1" << "1.0-a10" << "-1" << "+1" << " 1"
+        << "99999999999999999999" << "1.02" << "1.2" << "abc" << "abd" << "ab" << "5.12.0-0-201812"
+        << "1.x.2" << "rc1x" << "rc1";
+}
+
 class tst_CompareVersion : public QObject
 {
     Q_OBJECT
@@ -39,6 +128,10 @@ private slots:
     void compareVersionX();
     void compareVersionAll();
     void compareVersionExtra();
+    void compareVersionKey();
+
+    void benchmarkCompareVersion_data();
+    void benchmarkCompareVersion();
 };
 
 void tst_CompareVersion::compareVersion()
@@ -92,6 +185,60 @@ void tst_CompareVersion::compareVersionExtra()
     QCOMPARE(KDUpdater::compareVersion("OpenSSL_1_1_0f", "OpenSSL_1_0_2k"), +1);
 }
 
+void tst_CompareVersion::compareVersionKey()
+{
+    const QStringList versions = versionCorpus();
+    QList<KDUpdater::VersionKey> keys;
+    foreach (const QString &version, versions)
+        keys.append(KDUpdater::VersionKey(version));
+
+    for (int i = 0; i < versions.count(); ++i) {
+        QCOMPARE(keys.at(i).toString(), versions.at(i));
+        for (int j = 0; j < versions.count(); ++j) {
+            const int expected = legacyCompareVersion(versions.at(i), versions.at(j));
+            if (KDUpdater::compareVersion(keys.at(i), keys.at(j)) != expected) {
+                QFAIL(qPrintable(QString::fromLatin1("\"%1\" <=> \"%2\" differs from %3.")
+                    .arg(versions.at(i), versions.at(j)).arg(expected)));
+            }
+            QCOMPARE(KDUpdater::compareVersion(versions.at(i), versions.at(j)), expected);
+        }
+    }
+    QCOMPARE(KDUpdater::VersionKey().compare(KDUpdater::VersionKey(QString())), 0);
+}
+
+void tst_CompareVersion::benchmarkCompareVersion_data()
+{
+    QTest::addColumn<int>("method");
+    QTest::newRow("legacy strings") << 0;
+    QTest::newRow("strings") << 1;
+    QTest::newRow("version keys") << 2;
+}
+
+void tst_CompareVersion::benchmarkCompareVersion()
+{
+    QFETCH(int, method);
+
+    const QStringList versions = versionCorpus();
+    QList<KDUpdater::VersionKey> keys;
+    foreach (const QString &version, versions)
+        keys.append(KDUpdater::VersionKey(version));
+
+    int sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < versions.count(); ++i) {
+            for (int j = 0; j < versions.count(); ++j) {
+                if (method == 0)
+                    sum += legacyCompareVersion(versions.at(i), versions.at(j));
+                else if (method == 1)
+                    sum += KDUpdater::compareVersion(versions.at(i), versions.at(j));
+                else
+                    sum += KDUpdater::compareVersion(keys.at(i), keys.at(j));
+            }
+        }
+    }
+    Q_UNUSED(sum)
+}
+
 QTEST_MAIN(tst_CompareVersion)
 
 #include "tst_compareversion.moc"
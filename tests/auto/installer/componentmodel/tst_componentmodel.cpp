@@ -333,6 +333,51 @@ private slots:
             delete component;
     }
 
+    void testCheckStateChangedOutsideOfModel()
+    {
+        setPackageManagerOptions(NoFlags);
+
+        Component *parent = new Component(&m_core);
+        parent->setValue("Name", "com.vendor.parent");
+        QList<Component *> children;
+        foreach (const QString &name, QStringList() << "a" << "b" << "c") {
+            Component *child = new Component(&m_core);
+            child->setValue("Name", "com.vendor.parent." + name);
+            parent->appendComponent(child);
+            children.append(child);
+        }
+        QVERIFY(parent->isTristate());
+
+        ComponentModel model(1, &m_core);
+        model.setRootComponents(QList<Component *>() << parent);
+        QCOMPARE(parent->checkState(), Qt::Unchecked);
+
+        model.setData(model.indexFromComponentName("com.vendor.parent.a"), Qt::Checked,
+            Qt::CheckStateRole);
+        QCOMPARE(parent->checkState(), Qt::PartiallyChecked);
+
+        // the model does not notice these, it has to count the children again on the next update
+        children.at(1)->setCheckState(Qt::Checked);
+        children.at(2)->setCheckState(Qt::Checked);
+
+        model.setData(model.indexFromComponentName("com.vendor.parent.a"), Qt::Unchecked,
+            Qt::CheckStateRole);
+        QCOMPARE(children.at(0)->checkState(), Qt::Unchecked);
+        QCOMPARE(parent->checkState(), Qt::PartiallyChecked);
+
+        model.setData(model.indexFromComponentName("com.vendor.parent.a"), Qt::Checked,
+            Qt::CheckStateRole);
+        QCOMPARE(parent->checkState(), Qt::Checked);
+
+        children.at(1)->setCheckState(Qt::Unchecked);
+        children.at(2)->setCheckState(Qt::Unchecked);
+        model.setData(model.indexFromComponentName("com.vendor.parent.a"), Qt::Unchecked,
+            Qt::CheckStateRole);
+        QCOMPARE(parent->checkState(), Qt::Unchecked);
+
+        delete parent;
+    }
+
     void testComponentsLocalization()
     {
         QStringList localesToTest = { "en_US", "ru_RU", "de_DE", "fr_FR" };
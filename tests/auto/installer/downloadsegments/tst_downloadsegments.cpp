@@ -0,0 +1,254 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "downloadsegments.h"
+
+#include <QCryptographicHash>
+#include <QObject>
+#include <QTest>
+
+using namespace KDUpdater;
+
+class tst_downloadsegments : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParseContentRange_data()
+    {
+        QTest::addColumn<QByteArray>("header");
+        QTest::addColumn<bool>("valid");
+        QTest::addColumn<qint64>("first");
+        QTest::addColumn<qint64>("last");
+        QTest::addColumn<qint64>("total");
+
+        QTest::newRow("first segment") << QByteArray("bytes 0-99/1000") << true
+            << qint64(0) << qint64(99) << qint64(1000);
+        QTest::newRow("surrounding space") << QByteArray("  bytes 100-199/1000 ") << true
+            << qint64(100) << qint64(199) << qint64(1000);
+        QTest::newRow("whole file") << QByteArray("bytes 0-999/1000") << true
+            << qint64(0) << qint64(999) << qint64(1000);
+        QTest::newRow("large file") << QByteArray("bytes 0-1048575/8589934592") << true
+            << qint64(0) << qint64(1048575) << Q_INT64_C(8589934592);
+
+        QTest::newRow("empty") << QByteArray() << false << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("no unit") << QByteArray("0-99/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("other unit") << QByteArray("items 0-99/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("no total") << QByteArray("bytes 0-99") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("unknown total") << QByteArray("bytes 0-99/*") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("unsatisfied range") << QByteArray("bytes */1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("no first") << QByteArray("bytes -99/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("no last") << QByteArray("bytes 0-/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("garbage") << QByteArray("bytes 0-9x/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("reversed range") << QByteArray("bytes 100-99/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("past the end") << QByteArray("bytes 0-1000/1000") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+        QTest::newRow("short total") << QByteArray("bytes 0-99/50") << false
+            << qint64(-1) << qint64(-1) << qint64(-1);
+    }
+
+    void testParseContentRange()
+    {
+        QFETCH(QByteArray, header);
+        QFETCH(bool, valid);
+        QFETCH(qint64, first);
+        QFETCH(qint64, last);
+        QFETCH(qint64, total);
+
+        qint64 parsedFirst = -1, parsedLast = -1, parsedTotal = -1;
+        QCOMPARE(DownloadSegments::parseContentRange(header, &parsedFirst, &parsedLast,
+            &parsedTotal), valid);
+        QCOMPARE(parsedFirst, first);
+        QCOMPARE(parsedLast, last);
+        QCOMPARE(parsedTotal, total);
+    }
+
+    void testPlan()
+    {
+        DownloadSegments segments;
+        segments.plan(100, 1000, 3, 50);
+        QCOMPARE(segments.totalSize(), qint64(1000));
+        QCOMPARE(segments.firstSegmentEnd(), qint64(100));
+        QCOMPARE(segments.segmentSize(), qint64(75));    // four segments per connection
+
+        const QUrl url(QLatin1String("http://www.example.com/archive.7z"));
+        qint64 begin = 100;
+        while (segments.hasNextSegment()) {
+            const int index = segments.takeNextSegment(url);
+            const DownloadSegments::Segment &segment = segments.at(index);
+            QCOMPARE(segment.begin, begin);
+            QCOMPARE(segment.end, qMin(begin + 75, qint64(1000)));
+            QCOMPARE(segment.url, url);
+            QCOMPARE(segment.received, qint64(0));
+            QVERIFY(!segment.reply);
+            begin = segment.end;
+        }
+        QCOMPARE(begin, qint64(1000));
+        QCOMPARE(segments.count(), 12);
+        QCOMPARE(segments.nextSegmentBegin(), qint64(1000));
+        QVERIFY(!segments.isComplete());
+    }
+
+    void testPlanMinimumSegmentSize()
+    {
+        DownloadSegments segments;
+        segments.plan(64, 400, 4, 64);
+        QCOMPARE(segments.segmentSize(), qint64(64));
+
+        const QUrl url(QLatin1String("http://www.example.com/archive.7z"));
+        QList<qint64> ends;
+        while (segments.hasNextSegment())
+            ends.append(segments.at(segments.takeNextSegment(url)).end);
+        // the last segment is cut at the end of the file
+        QCOMPARE(ends, QList<qint64>() << 128 << 192 << 256 << 320 << 384 << 400);
+    }
+
+    void testMatchesContentRange()
+    {
+        DownloadSegments segments;
+        segments.plan(100, 1000, 3, 50);
+        const QUrl mirror(QLatin1String("http://mirror.example.com/archive.7z"));
+        const int index = segments.takeNextSegment(mirror);
+
+        QVERIFY(segments.matchesContentRange(index, "bytes 100-174/1000"));
+        // a mirror serving another version of the file
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-174/2000"));
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-174/999"));
+        // a server sending another range than the one requested
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-199/1000"));
+        QVERIFY(!segments.matchesContentRange(index, "bytes 0-174/1000"));
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-174"));
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-174/*"));
+
+        // a segment requested again continues where the previous reply stopped
+        segments.at(index).received = 10;
+        QVERIFY(!segments.matchesContentRange(index, "bytes 100-174/1000"));
+        QVERIFY(segments.matchesContentRange(index, "bytes 110-174/1000"));
+    }
+
+    void testHashInFileOrder()
+    {
+        QByteArray data(1000, '\0');
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = char((i * 7 + i / 13) & 0xff);
+
+        DownloadSegments segments;
+        segments.plan(100, data.size(), 3, 50);
+        const QUrl url(QLatin1String("http://www.example.com/archive.7z"));
+        while (segments.hasNextSegment())
+            segments.takeNextSegment(url);
+        QCOMPARE(segments.count(), 12);
+
+        // the first segment is hashed while it is received
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(data.constData(), 100);
+        qint64 hashedSize = 100;
+
+        QByteArray received(data.size(), '\0');
+        received.replace(0, 100, data.left(100));
+
+        // the indexes refer to the plan, the segments move up as the first ones are dropped
+        const QList<int> order = QList<int>() << 5 << 11 << 1 << 0 << 3 << 2 << 4 << 10 << 6 << 9
+            << 8 << 7;
+        QList<qint64> begins;
+        for (int i = 0; i < segments.count(); ++i)
+            begins.append(segments.at(i).begin);
+
+        foreach (const int planned, order) {
+            const qint64 begin = begins.at(planned);
+            const qint64 size = (planned + 1 < begins.count() ? begins.at(planned + 1)
+                : qint64(data.size())) - begin;
+
+            // receive the segment in two parts, hashing after each of them
+            foreach (const qint64 part, QList<qint64>() << size / 2 << size) {
+                int index = -1;
+                for (int i = 0; i < segments.count(); ++i) {
+                    if (segments.at(i).begin == begin)
+                        index = i;
+                }
+                QVERIFY(index >= 0);
+
+                DownloadSegments::Segment &segment = segments.at(index);
+                received.replace(begin + segment.received, part - segment.received,
+                    data.mid(begin + segment.received, part - segment.received));
+                segment.received = part;
+
+                const qint64 end = segments.takeContiguousEnd();
+                QVERIFY(end >= hashedSize);
+                QCOMPARE(received.left(end), data.left(end));
+                hash.addData(received.constData() + hashedSize, end - hashedSize);
+                hashedSize = end;
+            }
+        }
+
+        QVERIFY(segments.isComplete());
+        QCOMPARE(segments.count(), 0);
+        QCOMPARE(hashedSize, qint64(data.size()));
+        QCOMPARE(segments.receivedSize(), qint64(900));
+        QCOMPARE(hash.result(), QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+    }
+
+    void testContiguousEndWaitsForGaps()
+    {
+        DownloadSegments segments;
+        segments.plan(100, 400, 2, 100);
+        const QUrl url(QLatin1String("http://www.example.com/archive.7z"));
+        while (segments.hasNextSegment())
+            segments.takeNextSegment(url);
+        QCOMPARE(segments.count(), 3);
+
+        segments.at(1).received = 100;
+        segments.at(2).received = 100;
+        QCOMPARE(segments.takeContiguousEnd(), qint64(100));
+        QCOMPARE(segments.count(), 3);
+        QCOMPARE(segments.receivedSize(), qint64(200));
+
+        segments.at(0).received = 40;
+        QCOMPARE(segments.takeContiguousEnd(), qint64(140));
+        QCOMPARE(segments.count(), 3);
+
+        segments.at(0).received = 100;
+        QCOMPARE(segments.takeContiguousEnd(), qint64(400));
+        QCOMPARE(segments.count(), 0);
+        QVERIFY(segments.isComplete());
+        QCOMPARE(segments.receivedSize(), qint64(300));
+    }
+};
+
+QTEST_MAIN(tst_downloadsegments)
+
+#include "tst_downloadsegments.moc"
@@ -27,10 +27,13 @@
 **************************************************************************/
 
 #include "init.h"
+#include "archivefilelist.h"
 #include "extractarchiveoperation.h"
 
+#include <QDataStream>
 #include <QDir>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTest>
 
 using namespace KDUpdater;
@@ -83,6 +86,89 @@ private slots:
         QCOMPARE(op.errorString(), QString("Error while extracting archive \":///data/invalid.7z\": "
                                            "Cannot open archive \":///data/invalid.7z\"."));
     }
+
+    void testUndoOperationsWithSharedDirectory()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QString shared = tempDir.path() + QLatin1String("/shared");
+        QVERIFY(QDir().mkpath(shared + QLatin1String("/sub")));
+
+        const QStringList files1 = QStringList() << shared + QLatin1String("/a.txt")
+            << shared + QLatin1String("/sub/c.txt");
+        const QStringList files2 = QStringList() << shared + QLatin1String("/b.txt");
+        foreach (const QString &fileName, files1 + files2) {
+            QFile file(fileName);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+        }
+
+        // both archives list the shared directory, only the first one its subdirectory
+        ExtractArchiveOperation op1(nullptr);
+        op1.setArguments(QStringList() << ":///data/valid.7z" << tempDir.path());
+        op1.setValue(QLatin1String("files"), QStringList() << shared + QLatin1String("/sub")
+            << shared << files1);
+        ExtractArchiveOperation op2(nullptr);
+        op2.setArguments(QStringList() << ":///data/valid.7z" << tempDir.path());
+        op2.setValue(QLatin1String("files"), QStringList() << files2 << shared);
+
+        QVERIFY(ExtractArchiveOperation::undoOperations(QList<ExtractArchiveOperation *>()
+            << &op1 << &op2));
+        QVERIFY(!QDir(shared).exists());
+    }
+
+    void testArchiveFileList()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QString fileName = tempDir.path() + QLatin1String("/files.txt");
+
+        const QStringList files = QStringList() << QLatin1String("/target/bin")
+            << QLatin1String("/target/bin/app") << QLatin1String("/target/bin/app.conf")
+            << QString::fromUtf8("/target/lib/libäö.so") << QLatin1String("/elsewhere/file");
+        {
+            ArchiveFileListWriter writer(QLatin1String("/target"));
+            QVERIFY(writer.open(fileName));
+            foreach (const QString &file, files)
+                writer.append(file);
+            QVERIFY(writer.close());
+        }
+
+        // relative paths follow the target directory
+        ArchiveFileListReader reader(QLatin1String("/moved"));
+        QVERIFY(reader.open(fileName));
+        QCOMPARE(reader.count(), quint32(files.count()));
+        QStringList result;
+        QString path;
+        while (reader.next(&path))
+            result.append(path);
+        QCOMPARE(result, QStringList() << QLatin1String("/moved/bin")
+            << QLatin1String("/moved/bin/app") << QLatin1String("/moved/bin/app.conf")
+            << QString::fromUtf8("/moved/lib/libäö.so") << QLatin1String("/elsewhere/file"));
+    }
+
+    void testLegacyArchiveFileList()
+    {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QString fileName = tempDir.path() + QLatin1String("/files.txt");
+        {
+            QFile file(fileName);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QDataStream out(&file);
+            out << (QStringList() << QLatin1String("@RELOCATABLE_PATH@/bin/app")
+                << QLatin1String("@RELOCATABLE_PATH@/bin"));
+        }
+
+        ArchiveFileListReader reader(QLatin1String("/target"));
+        QVERIFY(reader.open(fileName));
+        QCOMPARE(reader.count(), quint32(2));
+        QString path;
+        QVERIFY(reader.next(&path));
+        QCOMPARE(path, QLatin1String("/target/bin/app"));
+        QVERIFY(reader.next(&path));
+        QCOMPARE(path, QLatin1String("/target/bin"));
+        QVERIFY(!reader.next(&path));
+    }
 };
 
 QTEST_MAIN(tst_extractarchiveoperationtest)
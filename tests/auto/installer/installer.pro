@@ -23,7 +23,15 @@ SUBDIRS += \
     task \
     clientserver \
     factory \
-    brokeninstaller
+    brokeninstaller \
+    updatesinfo \
+    localpackagehub \
+    operationscheduler \
+    archivecache \
+    archivedelta \
+    metadatacache \
+    mirrorhealth \
+    downloadsegments
 
 win32 {
     SUBDIRS += registerfiletypeoperation
@@ -0,0 +1,148 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <localpackagehub.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDUpdater;
+
+class tst_LocalPackageHub : public QObject
+{
+    Q_OBJECT
+
+private:
+    void addPackage(LocalPackageHub *hub, const QString &name, const QString &version)
+    {
+        hub->addPackage(name, version, name + QLatin1String(" title"), QString(),
+            QStringList() << QLatin1String("A"), QStringList(), false, false, 1024, QString(),
+            true, false);
+    }
+
+private slots:
+    void writeJournal()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QLatin1String("/components.xml");
+        const QString journalName = fileName + QLatin1String(".journal");
+
+        LocalPackageHub hub;
+        hub.setFileName(fileName);
+        hub.setApplicationName(QLatin1String("Application"));
+        hub.setApplicationVersion(QLatin1String("1.0.0"));
+        addPackage(&hub, QLatin1String("A"), QLatin1String("1.0.0"));
+        addPackage(&hub, QLatin1String("B"), QLatin1String("1.0.0"));
+        hub.writeJournal();
+        addPackage(&hub, QLatin1String("C"), QLatin1String("2.0.0"));
+        hub.writeJournal();
+
+        QCOMPARE(QFile::exists(fileName), false);
+        QCOMPARE(QFile::exists(journalName), true);
+
+        // the packages written to the journal only are seen by a reader
+        {
+            LocalPackageHub reader;
+            reader.setFileName(fileName);
+            QCOMPARE(reader.error(), LocalPackageHub::NoError);
+            QCOMPARE(reader.applicationName(), QLatin1String("Application"));
+            QCOMPARE(reader.applicationVersion(), QLatin1String("1.0.0"));
+            QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("A")
+                << QLatin1String("B") << QLatin1String("C"));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).version, QLatin1String("2.0.0"));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).dependencies,
+                QStringList() << QLatin1String("A"));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).uncompressedSize, quint64(1024));
+            QCOMPARE(reader.packageInfo(QLatin1String("C")).checkable, true);
+        }
+
+        hub.writeToDisk();
+        QCOMPARE(QFile::exists(fileName), true);
+        QCOMPARE(QFile::exists(journalName), false);
+
+        // changes are journaled on top of the XML file
+        QVERIFY(hub.removePackage(QLatin1String("B")));
+        hub.writeJournal();
+        {
+            LocalPackageHub reader;
+            reader.setFileName(fileName);
+            QCOMPARE(reader.error(), LocalPackageHub::NoError);
+            QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("A")
+                << QLatin1String("C"));
+
+            // the replayed journal is compacted when the reader writes to disk
+            reader.writeToDisk();
+            QCOMPARE(QFile::exists(journalName), false);
+        }
+
+        hub.clearPackageInfos();
+        addPackage(&hub, QLatin1String("D"), QLatin1String("1.0.0"));
+        hub.writeJournal();
+        {
+            LocalPackageHub reader;
+            reader.setFileName(fileName);
+            QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("D"));
+        }
+    }
+
+    void ignoreIncompleteJournalEntry()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QLatin1String("/components.xml");
+
+        {
+            LocalPackageHub hub;
+            hub.setFileName(fileName);
+            addPackage(&hub, QLatin1String("A"), QLatin1String("1.0.0"));
+            hub.writeToDisk();
+            addPackage(&hub, QLatin1String("B"), QLatin1String("1.0.0"));
+            hub.writeJournal();
+
+            // simulate a crash while an entry was written
+            QFile journal(fileName + QLatin1String(".journal"));
+            QVERIFY(journal.open(QIODevice::WriteOnly | QIODevice::Append));
+            QDataStream stream(&journal);
+            stream << qint32(1000) << quint8(2);
+            journal.close();
+
+            LocalPackageHub reader;
+            reader.setFileName(fileName);
+            QCOMPARE(reader.error(), LocalPackageHub::NoError);
+            QCOMPARE(reader.packageNames(), QStringList() << QLatin1String("A")
+                << QLatin1String("B"));
+        }
+    }
+};
+
+QTEST_MAIN(tst_LocalPackageHub)
+
+#include "tst_localpackagehub.moc"
@@ -0,0 +1,147 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "archivecache.h"
+#include "metadatacache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_metadatacache : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString writeFile(const QString &name, const QByteArray &data)
+    {
+        QFile file(m_tempDir.path() + QLatin1Char('/') + name);
+        if (!file.open(QIODevice::WriteOnly))
+            return QString();
+        file.write(data);
+        return file.fileName();
+    }
+
+    static QByteArray readFile(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+    static QByteArray sha1(const QByteArray &data)
+    {
+        return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+    }
+
+private slots:
+    void init()
+    {
+        QVERIFY(m_tempDir.isValid());
+        m_cachePath = m_tempDir.path() + QLatin1String("/cache");
+    }
+
+    void testDisabled()
+    {
+        MetadataCache cache;
+        QVERIFY(!cache.isEnabled());
+        QVERIFY(cache.updatesXml(QLatin1String("http://example.com/Updates.xml")).isEmpty());
+        QVERIFY(cache.extractedMetadata(sha1("meta")).isEmpty());
+    }
+
+    void testUpdatesXml()
+    {
+        const QString url = QLatin1String("http://example.com/repository/Updates.xml");
+        const QByteArray data("<Updates/>");
+        const QString fileName = writeFile(QLatin1String("Updates.xml"), data);
+        QVERIFY(!fileName.isEmpty());
+
+        MetadataCache cache(m_cachePath);
+        QVERIFY(cache.insertUpdatesXml(url, fileName, "\"1234\"", QByteArray()));
+
+        QByteArray entityTag;
+        QByteArray lastModified("stale");
+        const QString cached = MetadataCache(m_cachePath).updatesXml(url, &entityTag,
+            &lastModified);
+        QVERIFY(!cached.isEmpty());
+        QCOMPARE(readFile(cached), data);
+        QCOMPARE(entityTag, QByteArray("\"1234\""));
+        QVERIFY(lastModified.isEmpty());
+        QVERIFY(cache.updatesXml(QLatin1String("http://example.com/other/Updates.xml")).isEmpty());
+
+        QVERIFY(cache.insertUpdatesXml(url, fileName, QByteArray(),
+            "Wed, 21 Oct 2015 07:28:00 GMT"));
+        QVERIFY(!cache.updatesXml(url, &entityTag, &lastModified).isEmpty());
+        QVERIFY(entityTag.isEmpty());
+        QCOMPARE(lastModified, QByteArray("Wed, 21 Oct 2015 07:28:00 GMT"));
+
+        // a file without validators cannot be revalidated, so it is dropped
+        QVERIFY(!cache.insertUpdatesXml(url, fileName, QByteArray(), QByteArray()));
+        QVERIFY(cache.updatesXml(url).isEmpty());
+    }
+
+    void testPrune()
+    {
+        const QByteArray archive("meta data archive");
+        const QByteArray orphan("removed archive");
+        QVERIFY(QDir().mkpath(m_cachePath + QLatin1String("/metadata/packages/")
+            + QString::fromLatin1(sha1(archive)) + QLatin1String("/package")));
+        QVERIFY(QDir().mkpath(m_cachePath + QLatin1String("/metadata/packages/")
+            + QString::fromLatin1(sha1(orphan)) + QLatin1String("/package")));
+
+        ArchiveCache archives(m_cachePath + QLatin1String("/archives"));
+        QVERIFY(!archives.insert(sha1(archive), archive).isEmpty());
+        QVERIFY(archives.contains(sha1(archive)));
+        QVERIFY(!archives.contains(sha1(orphan)));
+
+        MetadataCache cache(m_cachePath + QLatin1String("/metadata"));
+        QVERIFY(!cache.extractedMetadata(sha1(orphan)).isEmpty());
+        cache.prune(archives);
+        QVERIFY(!cache.extractedMetadata(sha1(archive)).isEmpty());
+        QVERIFY(cache.extractedMetadata(sha1(orphan)).isEmpty());
+    }
+
+    void cleanup()
+    {
+        QDir(m_cachePath).removeRecursively();
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    QString m_cachePath;
+};
+
+QTEST_MAIN(tst_metadatacache)
+
+#include "tst_metadatacache.moc"
@@ -0,0 +1,110 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "mirrorhealth.h"
+#include "repository.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_mirrorhealth : public QObject
+{
+    Q_OBJECT
+
+private:
+    static Repository repository()
+    {
+        Repository repo(QUrl(QLatin1String("http://primary.example.com/repo")), false);
+        repo.setMirrors(QList<QUrl>() << QUrl(QLatin1String("http://eu.example.com/repo"))
+            << QUrl(QLatin1String("http://us.example.com/repo")));
+        return repo;
+    }
+
+private slots:
+    void testConfiguredOrder()
+    {
+        MirrorHealth health;
+        const Repository repo = repository();
+        QCOMPARE(health.ranked(repo), QList<QUrl>() << repo.url() << repo.mirrors());
+        QCOMPARE(health.latency(repo.url()), qint64(-1));
+    }
+
+    void testLatency()
+    {
+        MirrorHealth health;
+        const Repository repo = repository();
+        health.addLatency(repo.url(), 400);
+        health.addLatency(repo.mirrors().at(0), 300);
+        health.addLatency(repo.mirrors().at(1), 50);
+
+        QCOMPARE(health.ranked(repo), QList<QUrl>() << repo.mirrors().at(1)
+            << repo.mirrors().at(0) << repo.url());
+
+        // a single slow answer does not outweigh the earlier ones
+        health.addLatency(repo.mirrors().at(1), 450);
+        QCOMPARE(health.latency(repo.mirrors().at(1)), qint64(150));
+        QCOMPARE(health.ranked(repo).first(), repo.mirrors().at(1));
+
+        // trailing slashes do not matter
+        QCOMPARE(health.latency(QUrl(QLatin1String("http://eu.example.com/repo/"))), qint64(300));
+    }
+
+    void testFailures()
+    {
+        MirrorHealth health;
+        const Repository repo = repository();
+        health.addLatency(repo.url(), 200);
+        health.addLatency(repo.mirrors().at(0), 100);
+        health.addLatency(repo.mirrors().at(1), 250);
+        QCOMPARE(health.ranked(repo).first(), repo.mirrors().at(0));
+
+        health.addFailure(repo.mirrors().at(0));
+        QCOMPARE(health.ranked(repo), QList<QUrl>() << repo.url() << repo.mirrors().at(1)
+            << repo.mirrors().at(0));
+
+        // successful downloads make up for the failure
+        for (int i = 0; i < 10; ++i)
+            health.addSuccess(repo.mirrors().at(0));
+        QCOMPARE(health.ranked(repo).first(), repo.mirrors().at(0));
+    }
+
+    void testUnmeasured()
+    {
+        MirrorHealth health;
+        const Repository repo = repository();
+        health.addFailure(repo.url());
+        QCOMPARE(health.ranked(repo), QList<QUrl>() << repo.mirrors() << repo.url());
+        QVERIFY(health.score(repo.url()) > health.score(repo.mirrors().at(0)));
+    }
+};
+
+QTEST_MAIN(tst_mirrorhealth)
+
+#include "tst_mirrorhealth.moc"
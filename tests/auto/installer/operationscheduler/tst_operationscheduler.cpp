@@ -0,0 +1,285 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "extractarchiveoperation.h"
+#include "init.h"
+#include "operationscheduler.h"
+#include "updateoperations.h"
+
+#include <lib7z_create.h>
+
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDUpdater;
+using namespace QInstaller;
+
+class tst_operationscheduler : public QObject
+{
+    Q_OBJECT
+
+private:
+    Operation *createMkdir(const QString &path)
+    {
+        Operation *operation = new MkdirOperation;
+        if (!path.isEmpty())
+            operation->setArguments(QStringList() << path);
+        m_operations.append(operation);
+        return operation;
+    }
+
+    Operation *createExtract(const QString &archive, const QString &targetDirectory)
+    {
+        Operation *operation = new ExtractArchiveOperation(nullptr);
+        operation->setArguments(QStringList() << archive << targetDirectory);
+        m_operations.append(operation);
+        return operation;
+    }
+
+    Operation *createCopy(const QString &source, const QString &destination)
+    {
+        Operation *operation = new CopyOperation;
+        operation->setArguments(QStringList() << source << destination);
+        m_operations.append(operation);
+        return operation;
+    }
+
+    QString createFile(const QString &fileName, const QByteArray &content)
+    {
+        QFile file(m_tempDir.path() + QLatin1Char('/') + fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return QString();
+        file.write(content);
+        return file.fileName();
+    }
+
+    QString createArchive(const QString &name)
+    {
+        const QString archive = m_tempDir.path() + QLatin1Char('/') + name + QLatin1String(".7z");
+        if (!QFileInfo(archive).exists()) {
+            Lib7z::createArchive(archive, QStringList() << createFile(name + QLatin1String(".txt"),
+                name.toUtf8()), Lib7z::TmpFile::No);
+        }
+        return archive;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QInstaller::init();
+    }
+
+    void init()
+    {
+        QVERIFY(m_tempDir.isValid());
+    }
+
+    void cleanup()
+    {
+        qDeleteAll(m_operations);
+        m_operations.clear();
+    }
+
+    void testCanSchedule()
+    {
+        OperationScheduler scheduler(2);
+        Operation *operation = createMkdir(m_tempDir.path() + QLatin1String("/canschedule"));
+        QVERIFY(scheduler.canSchedule(operation));
+        QVERIFY(!OperationScheduler::isSerializationPoint(operation));
+
+        operation->setValue(QLatin1String("admin"), true);
+        QVERIFY(!scheduler.canSchedule(operation));
+        QVERIFY(OperationScheduler::isSerializationPoint(operation));
+    }
+
+    void testTakeResultsInOrder()
+    {
+        const QString path = m_tempDir.path() + QLatin1String("/inorder");
+        OperationScheduler scheduler(2);
+        const OperationList operations = OperationList() << createMkdir(path)
+            << createMkdir(path + QLatin1String("/sub"));
+        scheduler.schedule(operations);
+        QCOMPARE(scheduler.pendingCount(), 2);
+
+        foreach (Operation *operation, operations) {
+            QVERIFY(scheduler.isScheduled(operation));
+            QCOMPARE(scheduler.takeResult(operation), OperationScheduler::Result::Performed);
+            QVERIFY(!scheduler.isScheduled(operation));
+        }
+        QCOMPARE(scheduler.pendingCount(), 0);
+        QVERIFY(QDir(path + QLatin1String("/sub")).exists());
+
+        QVERIFY(operations.at(1)->undoOperation());
+        QVERIFY(operations.at(0)->undoOperation());
+        QVERIFY(!QDir(path).exists());
+    }
+
+    void testFailureSkipsFollowingOperations()
+    {
+        const QString path = m_tempDir.path() + QLatin1String("/skipped");
+        OperationScheduler scheduler(2);
+        // missing arguments make the first operation fail
+        const OperationList operations = OperationList() << createMkdir(QString())
+            << createMkdir(path);
+        scheduler.schedule(operations);
+
+        QCOMPARE(scheduler.takeResult(operations.at(0)), OperationScheduler::Result::Failed);
+        QCOMPARE(scheduler.takeResult(operations.at(1)), OperationScheduler::Result::Skipped);
+        QVERIFY(!QDir(path).exists());
+    }
+
+    void testDiscard()
+    {
+        const QString path = m_tempDir.path() + QLatin1String("/discarded");
+        OperationScheduler scheduler(2);
+        const OperationList operations = OperationList() << createMkdir(path)
+            << createMkdir(path + QLatin1String("/sub"));
+        scheduler.schedule(operations);
+        scheduler.waitForScheduled();
+        QCOMPARE(scheduler.pendingCount(), 2);
+
+        // performed operations are returned in the order they need to be undone
+        const OperationList discarded = scheduler.discard();
+        QCOMPARE(discarded.count(), 2);
+        QCOMPARE(discarded.at(0), operations.at(1));
+        QCOMPARE(discarded.at(1), operations.at(0));
+        QCOMPARE(scheduler.pendingCount(), 0);
+
+        foreach (Operation *operation, discarded)
+            QVERIFY(operation->undoOperation());
+        QVERIFY(!QDir(path).exists());
+    }
+
+    void testExtractAndCopy()
+    {
+        const QString target = m_tempDir.path() + QLatin1String("/extracted");
+        QVERIFY(QDir().mkpath(target));
+        const QString source = createFile(QLatin1String("copied.txt"), "copied");
+
+        OperationScheduler scheduler(2);
+        // the extractions run side by side, the copy waits for both
+        const OperationList operations = OperationList()
+            << createExtract(createArchive(QLatin1String("first")), target)
+            << createExtract(createArchive(QLatin1String("second")), target)
+            << createCopy(source, target + QLatin1String("/copied.txt"));
+        foreach (Operation *operation, operations)
+            QVERIFY(scheduler.canSchedule(operation));
+        scheduler.schedule(operations);
+
+        foreach (Operation *operation, operations)
+            QCOMPARE(scheduler.takeResult(operation), OperationScheduler::Result::Performed);
+        QVERIFY(QFileInfo(target + QLatin1String("/first.txt")).isFile());
+        QVERIFY(QFileInfo(target + QLatin1String("/second.txt")).isFile());
+        QVERIFY(QFileInfo(target + QLatin1String("/copied.txt")).isFile());
+
+        for (int i = operations.count() - 1; i >= 0; --i)
+            QVERIFY(operations.at(i)->undoOperation());
+        QVERIFY(!QFileInfo(target + QLatin1String("/first.txt")).exists());
+        QVERIFY(!QFileInfo(target + QLatin1String("/second.txt")).exists());
+        QVERIFY(!QFileInfo(target + QLatin1String("/copied.txt")).exists());
+    }
+
+    void testOutputTextIsRecorded()
+    {
+        const QString target = m_tempDir.path() + QLatin1String("/output");
+        QVERIFY(QDir().mkpath(target));
+
+        OperationScheduler scheduler(1);
+        Operation *operation = createExtract(createArchive(QLatin1String("output")), target);
+        scheduler.schedule(OperationList() << operation);
+
+        QStringList outputText;
+        QCOMPARE(scheduler.takeResult(operation, &outputText),
+            OperationScheduler::Result::Performed);
+        QCOMPARE(outputText, QStringList() << QLatin1String("Extracting \"output.7z\""));
+        QVERIFY(operation->undoOperation());
+    }
+
+    void testExtractWaitsForArchive()
+    {
+        OperationScheduler scheduler(2);
+        Operation *operation = createExtract(m_tempDir.path() + QLatin1String("/missing.7z"),
+            m_tempDir.path());
+        // the archive might still be downloading
+        QVERIFY(!scheduler.canSchedule(operation));
+    }
+
+    void testCopyFailureSkipsExtract()
+    {
+        const QString target = m_tempDir.path() + QLatin1String("/copyfailure");
+        QVERIFY(QDir().mkpath(target));
+
+        OperationScheduler scheduler(2);
+        const OperationList operations = OperationList()
+            << createCopy(m_tempDir.path() + QLatin1String("/missing.txt"),
+                target + QLatin1String("/missing.txt"))
+            << createExtract(createArchive(QLatin1String("skipped")), target);
+        scheduler.schedule(operations);
+
+        QCOMPARE(scheduler.takeResult(operations.at(0)), OperationScheduler::Result::Failed);
+        QCOMPARE(scheduler.takeResult(operations.at(1)), OperationScheduler::Result::Skipped);
+        QVERIFY(!QFileInfo(target + QLatin1String("/skipped.txt")).exists());
+    }
+
+    void testDiscardExtractAndCopy()
+    {
+        const QString target = m_tempDir.path() + QLatin1String("/discardedextract");
+        QVERIFY(QDir().mkpath(target));
+        const QString source = createFile(QLatin1String("discarded.txt"), "discarded");
+
+        OperationScheduler scheduler(2);
+        const OperationList operations = OperationList()
+            << createExtract(createArchive(QLatin1String("third")), target)
+            << createCopy(source, target + QLatin1String("/discarded.txt"));
+        scheduler.schedule(operations);
+        scheduler.waitForScheduled();
+
+        // the discarded operations are undone like the installation does during a rollback
+        const OperationList discarded = scheduler.discard();
+        QCOMPARE(discarded.count(), 2);
+        QCOMPARE(discarded.at(0), operations.at(1));
+        QCOMPARE(discarded.at(1), operations.at(0));
+        foreach (Operation *operation, discarded)
+            QVERIFY(operation->undoOperation());
+        QVERIFY(!QFileInfo(target + QLatin1String("/third.txt")).exists());
+        QVERIFY(!QFileInfo(target + QLatin1String("/discarded.txt")).exists());
+        QVERIFY(QFileInfo(source).isFile());
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    OperationList m_operations;
+};
+
+QTEST_MAIN(tst_operationscheduler)
+
+#include "tst_operationscheduler.moc"
@@ -30,6 +30,8 @@
 #include <component.h>
 #include <errors.h>
 #include <fileutils.h>
+#include <init.h>
+#include <lib7z_create.h>
 #include <packagemanagercore.h>
 #include <progresscoordinator.h>
 
@@ -37,6 +39,7 @@
 #include <QFile>
 #include <QTemporaryFile>
 #include <QTest>
+#include <QUrl>
 
 using namespace QInstaller;
 
@@ -191,6 +194,20 @@ private slots:
 
             QCOMPARE(core.components(PackageManagerCore::ComponentType::Root).count(), 2);
             QCOMPARE(core.components(PackageManagerCore::ComponentType::All).count(), 6);
+
+            // the name index follows components added after the first lookup
+            QVERIFY(core.componentByName(QLatin1String("root1.foo.child")) != 0);
+            QVERIFY(core.componentByName(QLatin1String("root1.foo.virtual.child")) != 0);
+            QVERIFY(core.componentByName(QLatin1String("root2")) != 0);
+            QVERIFY(core.componentByName(QLatin1String("root1.foo-1.0.2")) == 0);
+
+            // and renamed or removed ones
+            v->setValue(scName, QLatin1String("root1.foo.renamed.child"));
+            QVERIFY(core.componentByName(QLatin1String("root1.foo.virtual.child")) == 0);
+            QCOMPARE(core.componentByName(QLatin1String("root1.foo.renamed.child")), v);
+            foo->removeComponent(v);
+            QVERIFY(core.componentByName(QLatin1String("root1.foo.renamed.child")) == 0);
+            delete v;
         }
 
         {
@@ -224,6 +241,63 @@ private slots:
         }
     }
 
+    void testComponentByNameWithSameNames()
+    {
+        PackageManagerCore core;
+        core.setUpdater();
+
+        // the updater keeps the remote and the installed component under the same name
+        Component *remote = new NamedComponent(&core, QLatin1String("root"), QLatin1String("1.0.0"));
+        Component *local = new NamedComponent(&core, QLatin1String("root"), QLatin1String("2.0.0"));
+        core.appendUpdaterComponent(remote);
+        core.appendUpdaterComponent(local);
+
+        QCOMPARE(core.componentByName(QLatin1String("root")), remote);
+        QCOMPARE(core.componentByName(QLatin1String("root->=2.0.0")), local);
+        QCOMPARE(core.componentByName(QLatin1String("root-<2.0.0")), remote);
+        QVERIFY(core.componentByName(QLatin1String("root->2.0.0")) == 0);
+
+        const QList<Component *> components = QList<Component *>() << remote << local;
+        const QHash<QString, QList<Component *> > index
+            = PackageManagerCore::componentIndex(components);
+        QCOMPARE(index.value(QLatin1String("root")), components);
+        foreach (const QString &name, QStringList() << QLatin1String("root")
+                << QLatin1String("root->=2.0.0") << QLatin1String("root-<2.0.0")
+                << QLatin1String("root->2.0.0")) {
+            QCOMPARE(PackageManagerCore::componentByName(name, index),
+                PackageManagerCore::componentByName(name, components));
+        }
+    }
+
+    void testDependees()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+
+        Component *a = new NamedComponent(&core, QLatin1String("A"), QLatin1String("1.0.0"));
+        Component *b = new NamedComponent(&core, QLatin1String("B"));
+        b->setValue(scDependencies, QLatin1String("A"));
+        Component *c = new NamedComponent(&core, QLatin1String("C"));
+        c->setValue(scDependencies, QLatin1String("A->=2.0, B"));
+        core.appendRootComponent(a);
+        core.appendRootComponent(b);
+        core.appendRootComponent(c);
+
+        QCOMPARE(b->dependencies(), QStringList() << QLatin1String("A"));
+        QCOMPARE(core.dependees(a), QList<Component *>() << b);
+        QCOMPARE(core.dependees(b), QList<Component *>() << c);
+        QVERIFY(core.dependees(c).isEmpty());
+
+        // changing the dependencies updates the index
+        c->addDependency(QLatin1String("A"));
+        QCOMPARE(c->dependencies(), QStringList() << QLatin1String("A->=2.0")
+            << QLatin1String("B") << QLatin1String("A"));
+        QCOMPARE(core.dependees(a), QList<Component *>() << b << c);
+
+        a->setValue(scVersion, QLatin1String("2.0.0"));
+        QCOMPARE(core.dependees(a), QList<Component *>() << b << c << c);
+    }
+
     void testRequiredDiskSpace()
     {
         // test installer
@@ -284,6 +358,68 @@ private slots:
 #endif
         QVERIFY(QDir().rmdir(testDirectory));
     }
+
+    void testPipelinedInstallationWithConcurrentExtraction()
+    {
+        QInstaller::init();
+
+        const QString repositoryDirectory = QInstaller::generateTemporaryFileName();
+        const QString tempDirectory = QInstaller::generateTemporaryFileName();
+        const QString testDirectory = QInstaller::generateTemporaryFileName();
+        const QStringList names = QStringList() << "pipelined.a" << "pipelined.b" << "pipelined.c";
+
+        PackageManagerCore core(QInstaller::BinaryContent::MagicInstallerMarker,
+            QList<QInstaller::OperationBlob>());
+        core.autoRejectMessageBoxes();
+        core.setValue(QLatin1String("TargetDir"), testDirectory);
+        core.setValue(scPipelinedInstallation, scTrue);
+        core.setValue(scMaxConcurrentExtractions, QLatin1String("2"));
+        // the archives are downloaded one after the other, so the components following the one
+        // being installed still wait for their archives while their operations are prefetched
+        core.setValue(scMaxConcurrentDownloads, QLatin1String("1"));
+
+        foreach (const QString &name, names) {
+            const QString dataDirectory = tempDirectory + "/data/" + name;
+            QVERIFY(QDir().mkpath(dataDirectory));
+            QFile data(dataDirectory + "/" + name + ".txt");
+            QVERIFY(data.open(QIODevice::WriteOnly));
+            data.write(name.toUtf8());
+            data.close();
+
+            QVERIFY(QDir().mkpath(repositoryDirectory + "/" + name));
+            Lib7z::createArchive(repositoryDirectory + "/" + name + "/1.0.0content.7z",
+                QStringList() << data.fileName(), Lib7z::TmpFile::No);
+
+            NamedComponent *component = new NamedComponent(&core, name);
+            component->setRepositoryUrl(QUrl::fromLocalFile(repositoryDirectory));
+            component->setLocalTempPath(tempDirectory);
+            QVERIFY(QDir().mkpath(tempDirectory + "/" + name));
+            component->addDownloadableArchive("content.7z");
+            component->setCheckState(Qt::Checked);
+            core.appendRootComponent(component);
+        }
+        QVERIFY(core.calculateComponentsToInstall());
+
+        // check the extracted files once all components are installed, writing the maintenance
+        // tool is not supported by the test binary and rolls the installation back
+        QStringList installedFiles;
+        connect(&core, &PackageManagerCore::titleMessageChanged, [&](const QString &title) {
+            if (title != QLatin1String("Creating Maintenance Tool"))
+                return;
+            foreach (const QString &name, names) {
+                if (QFileInfo(testDirectory + "/" + name + ".txt").isFile())
+                    installedFiles.append(name);
+            }
+        });
+
+        core.runInstaller();
+        QCOMPARE(installedFiles, names);
+
+        QInstaller::removeDirectory(repositoryDirectory, true);
+        QInstaller::removeDirectory(tempDirectory, true);
+        QInstaller::removeDirectory(testDirectory, true);
+        ProgressCoordinator::instance()->reset();
+    }
 };
 
 
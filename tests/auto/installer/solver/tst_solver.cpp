@@ -281,6 +281,79 @@ private slots:
                     << (QList<Component *>() << compA)
                     << (QList<Component *>() << compB)
                     << (QSet<Component *>() << compA << compB);
+
+        core = new PackageManagerCore();
+        core->setPackageManager();
+        NamedComponent *autoA = new NamedComponent(core, QLatin1String("A"));
+        NamedComponent *autoB = new NamedComponent(core, QLatin1String("B"));
+        NamedComponent *autoC = new NamedComponent(core, QLatin1String("C"));
+        NamedComponent *autoD = new NamedComponent(core, QLatin1String("D"));
+        NamedComponent *autoE = new NamedComponent(core, QLatin1String("E"));
+        autoC->addAutoDependOn(QLatin1String("A"));
+        autoC->addAutoDependOn(QLatin1String("B"));
+        autoD->addAutoDependOn(QLatin1String("C"));
+        autoE->addAutoDependOn(QLatin1String("B"));
+        core->appendRootComponent(autoD);
+        core->appendRootComponent(autoA);
+        core->appendRootComponent(autoB);
+        core->appendRootComponent(autoC);
+        core->appendRootComponent(autoE);
+        autoA->setInstalled();
+        autoB->setInstalled();
+        autoC->setInstalled();
+        autoD->setInstalled();
+        autoE->setInstalled();
+
+        QTest::newRow("Auto dependency cascade") << core
+                    << (QList<Component *>() << autoA)
+                    << (QList<Component *>() << autoD << autoB << autoC << autoE)
+                    << (QSet<Component *>() << autoA << autoC << autoD);
+
+        core = new PackageManagerCore();
+        core->setPackageManager();
+        NamedComponent *virtualA = new NamedComponent(core, QLatin1String("A"));
+        NamedComponent *virtualB = new NamedComponent(core, QLatin1String("B"));
+        NamedComponent *virtualC = new NamedComponent(core, QLatin1String("C"));
+        NamedComponent *virtualD = new NamedComponent(core, QLatin1String("D"));
+        virtualB->setValue(scVirtual, scTrue);
+        virtualC->setValue(scVirtual, scTrue);
+        virtualD->setValue(scVirtual, scTrue);
+        virtualA->addDependency(QLatin1String("B"));
+        virtualB->addDependency(QLatin1String("C"));
+        virtualD->setValue(QLatin1String("ForcedInstallation"), scTrue);
+        core->appendRootComponent(virtualA);
+        core->appendRootComponent(virtualB);
+        core->appendRootComponent(virtualC);
+        core->appendRootComponent(virtualD);
+        virtualA->setInstalled();
+        virtualB->setInstalled();
+        virtualC->setInstalled();
+        virtualD->setInstalled();
+
+        QTest::newRow("Unneeded virtual components") << core
+                    << (QList<Component *>() << virtualA)
+                    << (QList<Component *>() << virtualB << virtualC << virtualD)
+                    << (QSet<Component *>() << virtualA << virtualB << virtualC);
+
+        // A long auto dependency chain listed against the resolve order used to cost a full
+        // pass over all installed components per link.
+        core = new PackageManagerCore();
+        core->setPackageManager();
+        QList<Component *> chain;
+        for (int i = 0; i < 500; ++i) {
+            NamedComponent *component = new NamedComponent(core, QString::fromLatin1("Chain%1").arg(i));
+            if (i > 0)
+                component->addAutoDependOn(QString::fromLatin1("Chain%1").arg(i - 1));
+            component->setInstalled();
+            chain.prepend(component);
+        }
+        foreach (Component *component, chain)
+            core->appendRootComponent(component);
+
+        QTest::newRow("Long auto dependency chain") << core
+                    << (QList<Component *>() << chain.last())
+                    << chain.mid(0, chain.count() - 1)
+                    << chain.toSet();
     }
 
     void resolveUninstaller()
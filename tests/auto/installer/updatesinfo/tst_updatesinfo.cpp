@@ -0,0 +1,169 @@
+/**************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <updatesinfo_p.h>
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDUpdater;
+
+static const char scUpdatesXml[] =
+    "<Updates>\n"
+    " <ApplicationName>{AnyApplication}</ApplicationName>\n"
+    " <ApplicationVersion>1.0.0</ApplicationVersion>\n"
+    " <Checksum>false</Checksum>\n"
+    " <PackageUpdate>\n"
+    "  <Name>A</Name>\n"
+    "  <DisplayName>Package A</DisplayName>\n"
+    "  <Version inheritVersionFrom=\"B\">1.0.0-1</Version>\n"
+    "  <ReleaseDate>2020-01-01</ReleaseDate>\n"
+    "  <Dependencies>B</Dependencies>\n"
+    "  <UpdateFile CompressedSize=\"10\" UncompressedSize=\"20\"/>\n"
+    "  <Licenses>\n"
+    "   <License name=\"License\" file=\"license.txt\"/>\n"
+    "  </Licenses>\n"
+    " </PackageUpdate>\n"
+    " <PackageUpdate>\n"
+    "  <Name>B</Name>\n"
+    "  <Version>1.0.0-1</Version>\n"
+    "  <ReleaseDate>2020-01-01</ReleaseDate>\n"
+    " </PackageUpdate>\n"
+    " <RepositoryUpdate>\n"
+    "  <Repository action=\"add\" url=\"http://example.com/repo\"/>\n"
+    " </RepositoryUpdate>\n"
+    "</Updates>\n";
+
+class tst_UpdatesInfo : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString writeFile(const QString &name, const QByteArray &content)
+    {
+        QFile file(m_dir.filePath(name));
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+            return QString();
+        return file.fileName();
+    }
+
+    void verifyPackages(const UpdatesInfo &info)
+    {
+        QVERIFY(info.isValid());
+        QCOMPARE(info.applicationName(), QLatin1String("{AnyApplication}"));
+        QCOMPARE(info.applicationVersion(), QLatin1String("1.0.0"));
+        QCOMPARE(info.checksum(), false);
+        QCOMPARE(info.updateInfoCount(), 2);
+
+        const QHash<QString, QVariant> a = info.updateInfo(0).data;
+        QCOMPARE(a.value(QLatin1String("Name")).toString(), QLatin1String("A"));
+        QCOMPARE(a.value(QLatin1String("DisplayName")).toString(), QLatin1String("Package A"));
+        QCOMPARE(a.value(QLatin1String("Version")).toString(), QLatin1String("1.0.0-1"));
+        QCOMPARE(a.value(QLatin1String("inheritVersionFrom")).toString(), QLatin1String("B"));
+        QCOMPARE(a.value(QLatin1String("Dependencies")).toString(), QLatin1String("B"));
+        QCOMPARE(a.value(QLatin1String("CompressedSize")).toString(), QLatin1String("10"));
+        QCOMPARE(a.value(QLatin1String("UncompressedSize")).toString(), QLatin1String("20"));
+        const QVariantMap license = a.value(QLatin1String("Licenses")).toHash()
+            .value(QLatin1String("License")).toMap();
+        QCOMPARE(license.value(QLatin1String("file")).toString(), QLatin1String("license.txt"));
+        QCOMPARE(license.value(QLatin1String("priority")).toString(), QLatin1String("0"));
+
+        QCOMPARE(info.updateInfo(1).data.value(QLatin1String("Name")).toString(), QLatin1String("B"));
+
+        QCOMPARE(info.repositoryUpdates().count(), 1);
+        const RepositoryUpdateInfo repository = info.repositoryUpdates().first();
+        QCOMPARE(repository.attributes.value(QLatin1String("action")), QLatin1String("add"));
+        QCOMPARE(repository.attributes.value(QLatin1String("url")),
+            QLatin1String("http://example.com/repo"));
+        QCOMPARE(repository.lineNumber, qint64(22));
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void parseFile()
+    {
+        UpdatesInfo info;
+        info.setFileName(writeFile(QLatin1String("parse.xml"), scUpdatesXml));
+        verifyPackages(info);
+    }
+
+    void invalidXml()
+    {
+        UpdatesInfo info;
+        info.setFileName(writeFile(QLatin1String("invalid.xml"),
+            QByteArray("<Updates><PackageUpdate></Updates>")));
+        QVERIFY(!info.isValid());
+        QCOMPARE(info.error(), UpdatesInfo::InvalidXmlError);
+    }
+
+    void invalidContent()
+    {
+        UpdatesInfo info;
+        info.setFileName(writeFile(QLatin1String("content.xml"), QByteArray(scUpdatesXml)
+            .replace("<ReleaseDate>2020-01-01</ReleaseDate>\n </PackageUpdate>", "</PackageUpdate>")));
+        QVERIFY(!info.isValid());
+        QCOMPARE(info.error(), UpdatesInfo::InvalidContentError);
+        // the remaining packages are still available
+        QCOMPARE(info.updateInfoCount(), 1);
+    }
+
+    void diskCache()
+    {
+        const QString cacheDir = m_dir.filePath(QLatin1String("cache"));
+        UpdatesInfo::setCacheDirectory(cacheDir);
+
+        const QByteArray content = QByteArray(scUpdatesXml) + "<!-- cached -->\n";
+        UpdatesInfo first;
+        first.setFileName(writeFile(QLatin1String("first.xml"), content));
+        verifyPackages(first);
+        QCOMPARE(QDir(cacheDir).entryList(QDir::Files).count(), 1);
+
+        // drops the in-memory cache, the file is read back from the disk cache
+        UpdatesInfo::setCacheDirectory(QString());
+        UpdatesInfo::setCacheDirectory(cacheDir);
+        UpdatesInfo second;
+        second.setFileName(writeFile(QLatin1String("second.xml"), content));
+        verifyPackages(second);
+        QCOMPARE(second.fileName(), m_dir.filePath(QLatin1String("second.xml")));
+
+        UpdatesInfo::setCacheDirectory(QString());
+    }
+
+private:
+    QTemporaryDir m_dir;
+};
+
+QTEST_MAIN(tst_UpdatesInfo)
+
+#include "tst_updatesinfo.moc"
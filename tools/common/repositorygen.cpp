@@ -27,6 +27,7 @@
 **************************************************************************/
 #include "repositorygen.h"
 
+#include <archivedelta.h>
 #include <constants.h>
 #include <fileio.h>
 #include <fileutils.h>
@@ -429,6 +430,12 @@ void QInstallerTools::copyMetaData(const QString &_targetDir, const QString &met
                                                                                                          .createTextNode(realContentFiles.join(QChar::fromLatin1(','))));
             }
 
+            // advertise the delta archives created against previous versions
+            if (!info.deltaArchives.isEmpty()) {
+                update.appendChild(doc.createElement(scDeltaArchives)).appendChild(doc
+                    .createTextNode(info.deltaArchives.join(QChar::fromLatin1(','))));
+            }
+
             // copy user interfaces
             const QStringList uiFiles = copyFilesFromNode(QLatin1String("UserInterfaces"),
                                                           QLatin1String("UserInterface"), QString(), QLatin1String("user interface"), package, info,
@@ -912,3 +919,123 @@ void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QS
         }
     }
 }
+
+// Moves the full archives of up to count previous versions of packages out of the repository
+// repoDir into retainDir, before the component directories are replaced. The previous versions
+// are the version in the existing Updates.xml and the base versions of its delta archives,
+// newest first. Returns the versions retained for each package.
+QHash<QString, QStringList> QInstallerTools::retainPreviousArchives(const QString &repoDir,
+    const QString &retainDir, const PackageInfoVector &packages, int count)
+{
+    QHash<QString, QStringList> retained;
+
+    QDomDocument doc;
+    QFile updatesXml(QFileInfo(repoDir, QLatin1String("Updates.xml")).absoluteFilePath());
+    if (!updatesXml.open(QIODevice::ReadOnly) || !doc.setContent(&updatesXml))
+        return retained;
+
+    QHash<QString, QDomElement> previousPackages;
+    const QDomNodeList packageNodes = doc.documentElement().childNodes();
+    for (int i = 0; i < packageNodes.count(); ++i) {
+        const QDomElement element = packageNodes.at(i).toElement();
+        if (element.tagName() == QLatin1String("PackageUpdate"))
+            previousPackages.insert(element.firstChildElement(scName).text(), element);
+    }
+
+    foreach (const PackageInfo &info, packages) {
+        const QDomElement element = previousPackages.value(info.name);
+        if (element.isNull())
+            continue;
+
+        QStringList versions(element.firstChildElement(scVersion).text());
+        foreach (const ArchiveDelta &delta, ArchiveDelta::fromString(element
+            .firstChildElement(scDeltaArchives).text())) {
+                if (!versions.contains(delta.baseVersion()))
+                    versions.append(delta.baseVersion());
+        }
+        versions.removeAll(info.version);
+        versions.removeAll(QString());
+        std::sort(versions.begin(), versions.end(), [](const QString &lhs, const QString &rhs) {
+            return KDUpdater::compareVersion(lhs, rhs) > 0;
+        });
+
+        const QStringList archives = element.firstChildElement(scDownloadableArchives).text()
+            .split(QLatin1Char(','), QString::SkipEmptyParts);
+        const QDir namedRepoDir(QString::fromLatin1("%1/%2").arg(repoDir, info.name));
+        const QDir namedRetainDir(QString::fromLatin1("%1/%2").arg(retainDir, info.name));
+        foreach (const QString &version, versions.mid(0, count)) {
+            bool found = false;
+            foreach (const QString &archive, archives) {
+                const QString fileName = version + archive.trimmed();
+                if (!QFileInfo(namedRepoDir.filePath(fileName)).isFile())
+                    continue;
+
+                QInstaller::mkpath(namedRetainDir.path());
+                foreach (const QString &file, QStringList({ fileName, fileName + QLatin1String(".sha1") })) {
+                    if (QFileInfo::exists(namedRepoDir.filePath(file)))
+                        QFile::rename(namedRepoDir.filePath(file), namedRetainDir.filePath(file));
+                }
+                found = true;
+            }
+            if (found) {
+                qDebug() << "Keeping archives of version" << version << "of" << info.name;
+                retained[info.name].append(version);
+            }
+        }
+    }
+    return retained;
+}
+
+// Creates delta archives of the archives of infos against the previous versions baseVersions
+// kept in retainDir by retainPreviousArchives(), and moves the previous archives back into the
+// repository repoDir. A delta is only kept if it is smaller than the full archive.
+void QInstallerTools::createDeltaArchives(const QString &repoDir, const QString &retainDir,
+    const QHash<QString, QStringList> &baseVersions, PackageInfoVector *const infos)
+{
+    for (int i = 0; i < infos->count(); ++i) {
+        const PackageInfo info = infos->at(i);
+        const QStringList versions = baseVersions.value(info.name);
+        if (versions.isEmpty())
+            continue;
+
+        const QDir namedRepoDir(QString::fromLatin1("%1/%2").arg(repoDir, info.name));
+        const QDir namedRetainDir(QString::fromLatin1("%1/%2").arg(retainDir, info.name));
+        foreach (const QString &file, info.copiedFiles) {
+            // archive links point to archives outside of the repository
+            const QFileInfo fileInfo(file);
+            if (file.endsWith(QLatin1String(".sha1"), Qt::CaseInsensitive) || fileInfo.isSymLink())
+                continue;
+
+            const QString archive = fileInfo.fileName().mid(info.version.count());
+            const QString target = namedRepoDir.filePath(fileInfo.fileName());
+            foreach (const QString &version, versions) {
+                const QString baseArchive = namedRetainDir.filePath(version + archive);
+                if (!QFileInfo(baseArchive).isFile())
+                    continue;
+
+                const QString deltaArchive = target + ArchiveDelta(archive, version, QByteArray()).suffix();
+                qDebug() << "Creating delta archive" << deltaArchive << "against" << baseArchive;
+                try {
+                    ArchiveDelta::create(baseArchive, target, deltaArchive);
+                } catch (const QInstaller::Error &error) {
+                    qDebug().noquote() << "Cannot create delta archive:" << error.message();
+                    QFile::remove(deltaArchive);
+                    continue;
+                }
+
+                if (QFileInfo(deltaArchive).size() >= QFileInfo(target).size()) {
+                    qDebug() << "Delta archive is not smaller than the full archive, skipping it.";
+                    QFile::remove(deltaArchive);
+                    continue;
+                }
+
+                const QByteArray sha1 = QInstaller::calculateHash(deltaArchive,
+                    QCryptographicHash::Sha1).toHex();
+                (*infos)[i].deltaArchives.append(ArchiveDelta(archive, version, sha1).toString());
+            }
+        }
+
+        if (QFileInfo(namedRetainDir.path()).isDir())
+            QInstaller::moveDirectoryContents(namedRetainDir.path(), namedRepoDir.path());
+    }
+}
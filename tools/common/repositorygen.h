@@ -44,6 +44,7 @@ struct PackageInfo
     QString directory;
     QStringList dependencies;
     QStringList copiedFiles;
+    QStringList deltaArchives;
     QString metaFile;
     QString metaNode;
     quint64 linkedFilesUncompressedSize = 0;
@@ -75,6 +76,11 @@ void copyMetaData(const QString &outDir, const QString &dataDir, const PackageIn
     const QString &appName, const QString& appVersion);
 void copyComponentData(const QStringList &packageDir, const QString &repoDir, PackageInfoVector *const infos);
 
+QHash<QString, QStringList> retainPreviousArchives(const QString &repoDir, const QString &retainDir,
+    const PackageInfoVector &packages, int count);
+void createDeltaArchives(const QString &repoDir, const QString &retainDir,
+    const QHash<QString, QStringList> &baseVersions, PackageInfoVector *const infos);
+
 
 } // namespace QInstallerTools
 
@@ -66,6 +66,9 @@ static void printUsage()
     std::cout << "                            --include or --exclude) in the repository with all new components"
         << std::endl;
 
+    std::cout << "  --delta count             Keep the archives of up to count previous versions of the" << std::endl;
+    std::cout << "                            updated components and create delta archives against them" << std::endl;
+
     std::cout << "  -v|--verbose              Verbose output" << std::endl;
 
     std::cout << std::endl;
@@ -99,6 +102,7 @@ int main(int argc, char** argv)
         QInstallerTools::FilterType filterType = QInstallerTools::Exclude;
         bool remove = false;
         bool updateExistingRepositoryWithNewComponents = false;
+        int deltaCount = 0;
 
         //TODO: use a for loop without removing values from args like it is in binarycreator.cpp
         //for (QStringList::const_iterator it = args.begin(); it != args.end(); ++it) {
@@ -143,6 +147,15 @@ int main(int argc, char** argv)
             } else if (args.first() == QLatin1String("--update-new-components")) {
                 args.removeFirst();
                 updateExistingRepositoryWithNewComponents = true;
+            } else if (args.first() == QLatin1String("--delta")) {
+                args.removeFirst();
+                bool ok = false;
+                deltaCount = args.isEmpty() ? 0 : args.first().toInt(&ok);
+                if (!ok || deltaCount < 1) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Delta parameter missing or invalid argument"));
+                }
+                args.removeFirst();
             } else if (args.first() == QLatin1String("-p") || args.first() == QLatin1String("--packages")) {
                 args.removeFirst();
                 if (args.isEmpty()) {
@@ -266,6 +279,14 @@ int main(int argc, char** argv)
 
         QHash<QString, QString> pathToVersionMapping = QInstallerTools::buildPathToVersionMapping(packages);
 
+        // keep the previous archives to create the delta archives against
+        QTemporaryDir retainDir;
+        QHash<QString, QStringList> deltaBaseVersions;
+        if (deltaCount > 0 && update) {
+            deltaBaseVersions = QInstallerTools::retainPreviousArchives(repositoryDir, retainDir.path(),
+                packages, deltaCount);
+        }
+
         foreach (const QInstallerTools::PackageInfo &package, packages) {
             const QFileInfo fi(repositoryDir, package.name);
             if (fi.exists())
@@ -279,6 +300,8 @@ int main(int argc, char** argv)
         directories.append(packagesDirectories);
         directories.append(repositoryDirectories);
         QInstallerTools::copyComponentData(directories, repositoryDir, &packages);
+        if (!deltaBaseVersions.isEmpty())
+            QInstallerTools::createDeltaArchives(repositoryDir, retainDir.path(), deltaBaseVersions, &packages);
         QInstallerTools::copyMetaData(tmpMetaDir, repositoryDir, packages, QLatin1String("{AnyApplication}"),
             QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)));
         QInstallerTools::compressMetaDirectories(tmpMetaDir, tmpMetaDir, pathToVersionMapping);